@@ -0,0 +1,207 @@
+/*!
+	@author Arves100
+	@file DPBroadcastRing.h
+	@date 19/10/2026
+	@brief Buffer of the broadcasts that are sent to the spectators
+*/
+#pragma once
+
+#define DP_RING_DEFAULT_SIZE (4 * 1024 * 1024) // bytes of broadcasts kept for the spectators
+#define DP_RING_CHECKPOINT_INTERVAL 10000 // ms between two checkpoints
+#define DP_RING_CATCHUP_BYTES (32 * 1024) // bytes a late spectator gets on every service, much more than the game sends meanwhile
+
+/*!
+	@class DPBroadcastRing
+	Keeps the last broadcasts with the time they were sent, bounded in bytes. Every reader (a spectator
+	fed by us) has its own position: the broadcasts are handed to it once they are older than the
+	delay. A checkpoint is a block of messages with the whole roster, a spectator that joins late
+	starts from the closest checkpoint and gets the broadcasts after it faster than real time until
+	it reaches the others
+*/
+class DPBroadcastRing
+{
+public:
+	DPBroadcastRing() : m_nMaxBytes(DP_RING_DEFAULT_SIZE), m_ullFirst(0), m_nBytes(0), m_nPeakBytes(0), m_dwOverruns(0), m_dwCatchUps(0)
+	{
+	}
+
+	~DPBroadcastRing() { Clear(); }
+
+	void SetSize(size_t maxBytes) { m_nMaxBytes = maxBytes; }
+
+	/*!
+	* @brief Keeps a broadcast, the oldest ones are dropped when the buffer is full
+	* @param pk Relay message (a reference is taken)
+	* @param channel Channel of the message
+	* @param checkpoint true if the message is part of a checkpoint
+	*/
+	void Push(ENetPacket* pk, uint8_t channel, bool checkpoint)
+	{
+		if (checkpoint && (m_vEntries.empty() || !m_vEntries.back().checkpoint))
+			m_vCheckpoints.push_back(m_ullFirst + m_vEntries.size());
+
+		Entry e = { pk, GetTickCount64(), channel, checkpoint };
+		pk->referenceCount++;
+		m_vEntries.push_back(e);
+		m_nBytes += GetEntrySize(pk);
+
+		if (m_nBytes > m_nPeakBytes)
+			m_nPeakBytes = m_nBytes;
+
+		while (m_nBytes > m_nMaxBytes && !m_vEntries.empty())
+			Evict();
+	}
+
+	/*!
+	* @brief Checks if the last checkpoint is too old, or it was dropped
+	*/
+	bool NeedsCheckpoint() const
+	{
+		if (!m_vEntries.empty() && m_vEntries.back().checkpoint)
+			return false; // nothing was broadcasted after it, it's still good (and two checkpoints in a row would look like one)
+
+		return m_vCheckpoints.empty() || GetTickCount64() - At(m_vCheckpoints.back()).time >= DP_RING_CHECKPOINT_INTERVAL;
+	}
+
+	/*!
+	* @brief Adds a reader
+	* @param reader Key of the reader, passed back to the send function
+	* @param catchUp true if the reader just joined, it starts from a checkpoint, otherwise it
+	* already has the roster and starts from the broadcasts that are not delayed anymore
+	* @param delay ms the broadcasts are delayed by
+	*/
+	void AddReader(uintptr_t reader, bool catchUp, DWORD delay)
+	{
+		auto now = GetTickCount64();
+		auto next = m_ullFirst + m_vEntries.size();
+
+		while (next > m_ullFirst && At(next - 1).time + delay > now)
+			next--;
+
+		if (catchUp && !m_vCheckpoints.empty())
+		{ // the newest checkpoint already out of the delay, or the oldest one if none is
+			auto cp = m_vCheckpoints.front();
+
+			for (auto it = m_vCheckpoints.rbegin(); it != m_vCheckpoints.rend(); ++it)
+			{
+				if (At(*it).time + delay <= now)
+				{
+					cp = *it;
+					break;
+				}
+			}
+
+			next = cp;
+			m_dwCatchUps++;
+		}
+
+		m_vReaders[reader] = next;
+	}
+
+	void RemoveReader(uintptr_t reader) { m_vReaders.erase(reader); }
+	void ClearReaders() { m_vReaders.clear(); }
+
+	/*!
+	* @brief Hands the broadcasts that are due to the readers
+	* @param delay ms the broadcasts are delayed by
+	* @param send Function that sends a packet to a reader (reader, packet, channel), the packet is still owned by the buffer
+	*/
+	template <typename F>
+	void Pump(DWORD delay, F send)
+	{
+		auto now = GetTickCount64();
+		auto end = m_ullFirst + m_vEntries.size();
+
+		for (auto& r : m_vReaders)
+		{
+			size_t budget = DP_RING_CATCHUP_BYTES;
+
+			while (r.second < end && budget)
+			{
+				auto& e = At(r.second);
+
+				if (e.time + delay > now)
+					break;
+
+				send(r.first, e.pk, e.channel);
+				budget -= e.pk->dataLength < budget ? e.pk->dataLength : budget;
+				r.second++;
+			}
+		}
+	}
+
+	/*!
+	* @brief Gets the memory used by the buffered broadcasts
+	*/
+	size_t GetMemoryUse() const { return m_nBytes; }
+
+	void Clear()
+	{
+		while (!m_vEntries.empty())
+			Evict();
+
+		m_vReaders.clear();
+		m_ullFirst = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		if (!m_nPeakBytes)
+			return;
+
+		printf("[LOADER] Spectator buffer: %u msgs %u checkpoints over %u ms, %u/%u bytes (peak %u), %u readers %u caught up %u overrun\n", (DWORD)m_vEntries.size(),
+			(DWORD)m_vCheckpoints.size(), m_vEntries.empty() ? 0 : (DWORD)(m_vEntries.back().time - m_vEntries.front().time), (DWORD)m_nBytes, (DWORD)m_nMaxBytes,
+			(DWORD)m_nPeakBytes, (DWORD)m_vReaders.size(), m_dwCatchUps, m_dwOverruns);
+#endif
+	}
+
+private:
+	struct Entry
+	{
+		ENetPacket* pk;
+		ULONGLONG time;
+		uint8_t channel;
+		bool checkpoint;
+	};
+
+	static size_t GetEntrySize(ENetPacket* pk) { return pk->dataLength + sizeof(ENetPacket) + sizeof(Entry); }
+
+	const Entry& At(ULONGLONG index) const { return m_vEntries[(size_t)(index - m_ullFirst)]; }
+
+	void Evict()
+	{
+		auto pk = m_vEntries.front().pk;
+		m_nBytes -= GetEntrySize(pk);
+
+		if (--pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+
+		if (!m_vCheckpoints.empty() && m_vCheckpoints.front() <= m_ullFirst)
+			m_vCheckpoints.pop_front(); // a checkpoint without its first messages is useless
+
+		m_vEntries.pop_front();
+		m_ullFirst++;
+
+		for (auto& r : m_vReaders)
+		{
+			if (r.second < m_ullFirst)
+			{ // the reader is too slow, it loses what it did not get yet
+				r.second = m_ullFirst;
+				m_dwOverruns++;
+			}
+		}
+	}
+
+	std::deque<Entry> m_vEntries;
+	std::deque<ULONGLONG> m_vCheckpoints; // index of the first message of every checkpoint
+	std::unordered_map<uintptr_t, ULONGLONG> m_vReaders; // index of the next message of every reader
+	size_t m_nMaxBytes;
+	ULONGLONG m_ullFirst; // index of the oldest message
+	size_t m_nBytes;
+
+	// Statistics
+	size_t m_nPeakBytes;
+	DWORD m_dwOverruns;
+	DWORD m_dwCatchUps;
+};
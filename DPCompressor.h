@@ -0,0 +1,383 @@
+/*!
+	@author Arves100
+	@file DPCompressor.h
+	@date 19/10/2026
+	@brief Dictionary compression of the game payloads
+*/
+#pragma once
+
+#define DP_DICT_FILE L"ffnet.dict" // next to the game executable
+#define DP_DICT_MAX_SIZE (32 * 1024)
+#define DP_DICT_HASH_BITS 14
+#define DP_DICT_MSG_HASH_BITS 10
+#define DP_DICT_MIN_MATCH 4
+#define DP_DICT_MAX_OFFSET 0xFFFF
+#define DP_DICT_SEGMENT 8 // size of the fragments picked by the trainer
+#define DP_DICT_MAX_SAMPLES 4096
+
+/*!
+	@class DPCompressor
+	LZ77 compressor where the window starts with a dictionary of fragments that are common in the
+	game traffic, so even a small message finds long matches. The dictionary is trained from the
+	payloads captured in a previous session, both sides must use the same one
+*/
+class DPCompressor
+{
+public:
+	DPCompressor() : m_dwId(0), m_ullRawBytes(0), m_ullPackedBytes(0), m_dwEncoded(0), m_dwSkipped(0), m_dwDecoded(0), m_ullEncodeTicks(0), m_ullDecodeTicks(0)
+	{
+		m_vDictTable.assign((size_t)1 << DP_DICT_HASH_BITS, 0);
+	}
+
+	/*!
+	* @brief Loads a dictionary
+	* @param path Path of the dictionary
+	* @return false if the dictionary does not exist or it's invalid
+	*/
+	bool Load(const wchar_t* path)
+	{
+		auto hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		std::vector<BYTE> dict(DP_DICT_MAX_SIZE + 1);
+		DWORD readed = 0;
+		BOOL ok = ReadFile(hFile, dict.data(), (DWORD)dict.size(), &readed, nullptr);
+		CloseHandle(hFile);
+
+		if (!ok || readed < DP_DICT_MIN_MATCH || readed > DP_DICT_MAX_SIZE)
+			return false;
+
+		dict.resize(readed);
+		SetDictionary(dict);
+		return true;
+	}
+
+	/*!
+	* @brief Saves the dictionary
+	* @param path Path of the dictionary
+	*/
+	bool Save(const wchar_t* path) const
+	{
+		auto hFile = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, 0, nullptr);
+
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		DWORD written = 0;
+		BOOL ok = WriteFile(hFile, m_vDict.data(), (DWORD)m_vDict.size(), &written, nullptr);
+		CloseHandle(hFile);
+		return ok && written == m_vDict.size();
+	}
+
+	void SetDictionary(const std::vector<BYTE>& dict)
+	{
+		m_vDict = dict;
+
+		// FNV-1a, the id tells the peers if they have the same dictionary
+		m_dwId = 2166136261U;
+
+		for (auto b : m_vDict)
+			m_dwId = (m_dwId ^ b) * 16777619U;
+
+		if (!m_dwId)
+			m_dwId = 1;
+
+		std::fill(m_vDictTable.begin(), m_vDictTable.end(), 0);
+
+		for (size_t i = 0; i + DP_DICT_MIN_MATCH <= m_vDict.size(); i++)
+			m_vDictTable[Hash(&m_vDict[i], DP_DICT_HASH_BITS)] = (DWORD)i + 1;
+	}
+
+	DWORD GetId() const { return m_dwId; }
+
+	/*!
+	* @brief Compresses a payload
+	* @param src Data to compress
+	* @param len Size of the data
+	* @param out Compressed data
+	* @return false if the compressed data is not smaller
+	*/
+	bool Compress(const BYTE* src, size_t len, std::vector<BYTE>& out)
+	{
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+
+		bool packed = Encode(src, len, out) && out.size() < len;
+
+		QueryPerformanceCounter(&end);
+		m_ullEncodeTicks += end.QuadPart - start.QuadPart;
+		m_dwEncoded++;
+		m_ullRawBytes += len;
+		m_ullPackedBytes += packed ? out.size() : len;
+
+		if (!packed)
+			m_dwSkipped++;
+
+		return packed;
+	}
+
+	/*!
+	* @brief Decompresses a payload
+	* @param src Compressed data
+	* @param len Size of the compressed data
+	* @param out Buffer of the decompressed data
+	* @param outLen Size of the decompressed data
+	* @return false if the data is corrupted
+	*/
+	bool Decompress(const BYTE* src, size_t len, BYTE* out, size_t outLen)
+	{
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+
+		bool ok = Decode(src, len, out, outLen);
+
+		QueryPerformanceCounter(&end);
+		m_ullDecodeTicks += end.QuadPart - start.QuadPart;
+		m_dwDecoded++;
+		return ok;
+	}
+
+	/*!
+	* @brief Builds a dictionary from captured payloads: the fragments found in most of them are kept,
+	* the most common ones at the end so they are reached with small offsets
+	* @param samples Captured payloads
+	*/
+	static std::vector<BYTE> Train(const std::deque<std::vector<BYTE>>& samples)
+	{
+		std::unordered_map<ULONGLONG, DWORD> counts;
+
+		for (const auto& s : samples)
+		{
+			std::vector<ULONGLONG> seen;
+
+			for (size_t i = 0; i + DP_DICT_SEGMENT <= s.size(); i++)
+			{
+				ULONGLONG k;
+				memcpy(&k, &s[i], sizeof(k));
+				seen.push_back(k);
+			}
+
+			// every fragment is counted once per sample
+			std::sort(seen.begin(), seen.end());
+			seen.erase(std::unique(seen.begin(), seen.end()), seen.end());
+
+			for (auto k : seen)
+				counts[k]++;
+		}
+
+		std::vector<std::pair<DWORD, ULONGLONG>> best;
+
+		for (const auto& c : counts)
+		{
+			if (c.second > 1)
+				best.push_back({ c.second, c.first });
+		}
+
+		std::sort(best.begin(), best.end(), [](const std::pair<DWORD, ULONGLONG>& a, const std::pair<DWORD, ULONGLONG>& b) { return a.first > b.first; });
+
+		std::vector<BYTE> dict;
+
+		for (const auto& b : best)
+		{
+			if (dict.size() + DP_DICT_SEGMENT > DP_DICT_MAX_SIZE)
+				break;
+
+			auto p = (const BYTE*)&b.second;
+
+			if (std::search(dict.begin(), dict.end(), p, p + DP_DICT_SEGMENT) != dict.end())
+				continue; // already covered by another fragment
+
+			dict.insert(dict.begin(), p, p + DP_DICT_SEGMENT);
+		}
+
+		return dict;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+
+		if (!m_dwEncoded && !m_dwDecoded)
+			return;
+
+		printf("[LOADER] Compression dict %08x: %llu -> %llu bytes (%u%%), %u/%u skipped, encode %llu ns/msg, decode %llu ns/msg\n", m_dwId,
+			(unsigned long long)m_ullRawBytes, (unsigned long long)m_ullPackedBytes, m_ullRawBytes ? (DWORD)(m_ullPackedBytes * 100 / m_ullRawBytes) : 0, m_dwSkipped, m_dwEncoded,
+			m_dwEncoded ? (unsigned long long)(m_ullEncodeTicks * 1000000000 / freq.QuadPart / m_dwEncoded) : 0,
+			m_dwDecoded ? (unsigned long long)(m_ullDecodeTicks * 1000000000 / freq.QuadPart / m_dwDecoded) : 0);
+#endif
+	}
+
+private:
+	static size_t Hash(const BYTE* p, size_t bits)
+	{
+		DWORD v;
+		memcpy(&v, p, sizeof(v));
+		return (v * 2654435761U) >> (32 - bits);
+	}
+
+	// The window is the dictionary followed by the message
+	BYTE At(const BYTE* src, size_t pos) const
+	{
+		return pos < m_vDict.size() ? m_vDict[pos] : src[pos - m_vDict.size()];
+	}
+
+	static void PutLength(std::vector<BYTE>& out, size_t len)
+	{
+		while (len >= 255)
+		{
+			out.push_back(255);
+			len -= 255;
+		}
+
+		out.push_back((BYTE)len);
+	}
+
+	static bool GetLength(const BYTE*& p, const BYTE* end, size_t& len)
+	{
+		BYTE b;
+
+		do
+		{
+			if (p >= end)
+				return false;
+
+			b = *p++;
+			len += b;
+		} while (b == 255);
+
+		return true;
+	}
+
+	static void PutSequence(std::vector<BYTE>& out, const BYTE* lit, size_t litLen, size_t offset, size_t matchLen)
+	{
+		size_t m = matchLen ? matchLen - DP_DICT_MIN_MATCH : 0;
+		out.push_back((BYTE)((litLen < 15 ? litLen : 15) << 4 | (m < 15 ? m : 15)));
+
+		if (litLen >= 15)
+			PutLength(out, litLen - 15);
+
+		out.insert(out.end(), lit, lit + litLen);
+
+		if (!matchLen)
+			return; // last sequence
+
+		out.push_back((BYTE)(offset & 0xFF));
+		out.push_back((BYTE)(offset >> 8));
+
+		if (m >= 15)
+			PutLength(out, m - 15);
+	}
+
+	bool Encode(const BYTE* src, size_t len, std::vector<BYTE>& out)
+	{
+		DWORD table[(size_t)1 << DP_DICT_MSG_HASH_BITS] = { 0 };
+		size_t dictLen = m_vDict.size(), anchor = 0, i = 0;
+
+		out.clear();
+		out.reserve(len);
+
+		while (i + DP_DICT_MIN_MATCH <= len)
+		{
+			auto hm = Hash(src + i, DP_DICT_MSG_HASH_BITS);
+			size_t pos = dictLen + i, cand = 0, matchLen = 0;
+
+			if (table[hm])
+				cand = dictLen + table[hm] - 1;
+			else if (m_vDictTable[Hash(src + i, DP_DICT_HASH_BITS)])
+				cand = m_vDictTable[Hash(src + i, DP_DICT_HASH_BITS)] - 1;
+			else
+				cand = SIZE_MAX;
+
+			table[hm] = (DWORD)i + 1;
+
+			if (cand != SIZE_MAX && pos - cand <= DP_DICT_MAX_OFFSET)
+			{
+				while (i + matchLen < len && At(src, cand + matchLen) == src[i + matchLen])
+					matchLen++;
+			}
+
+			if (matchLen < DP_DICT_MIN_MATCH)
+			{
+				i++;
+				continue;
+			}
+
+			PutSequence(out, src + anchor, i - anchor, pos - cand, matchLen);
+			i += matchLen;
+			anchor = i;
+
+			if (out.size() >= len)
+				return false; // it will not pay off
+		}
+
+		PutSequence(out, src + anchor, len - anchor, 0, 0);
+		return true;
+	}
+
+	bool Decode(const BYTE* src, size_t len, BYTE* out, size_t outLen) const
+	{
+		auto p = src, end = src + len;
+		size_t dictLen = m_vDict.size(), o = 0;
+
+		while (p < end)
+		{
+			BYTE token = *p++;
+			size_t litLen = token >> 4, matchLen = token & 0xF;
+
+			if (litLen == 15 && !GetLength(p, end, litLen))
+				return false;
+
+			if (litLen > (size_t)(end - p) || litLen > outLen - o)
+				return false;
+
+			if (litLen)
+				memcpy(out + o, p, litLen);
+
+			p += litLen;
+			o += litLen;
+
+			if (p == end)
+				break; // last sequence
+
+			if (end - p < 2)
+				return false;
+
+			size_t offset = p[0] | (p[1] << 8);
+			p += 2;
+
+			if (matchLen == 15 && !GetLength(p, end, matchLen))
+				return false;
+
+			matchLen += DP_DICT_MIN_MATCH;
+
+			if (!offset || offset > dictLen + o || matchLen > outLen - o)
+				return false;
+
+			size_t from = dictLen + o - offset;
+
+			for (size_t k = 0; k < matchLen; k++, from++)
+				out[o + k] = from < dictLen ? m_vDict[from] : out[from - dictLen];
+
+			o += matchLen;
+		}
+
+		return o == outLen;
+	}
+
+	std::vector<BYTE> m_vDict;
+	std::vector<DWORD> m_vDictTable;
+	DWORD m_dwId;
+
+	// Statistics
+	ULONGLONG m_ullRawBytes;
+	ULONGLONG m_ullPackedBytes;
+	DWORD m_dwEncoded;
+	DWORD m_dwSkipped;
+	DWORD m_dwDecoded;
+	ULONGLONG m_ullEncodeTicks;
+	ULONGLONG m_ullDecodeTicks;
+};
@@ -0,0 +1,87 @@
+/*!
+	@author Arves100
+	@file DPContext.h
+	@date 19/10/2026
+	@brief Network state of one DirectPlay object
+*/
+#pragma once
+
+#include "DPMsgArena.h"
+#include "DPMsgPool.h"
+#include <mutex>
+
+#define DP_CONTEXT_ARENA_SIZE (1024 * 1024 * 20) // 20MB
+
+/*!
+	@class DPContext
+	Memory of the messages of one DirectPlay object: the arena that keeps the data of the system
+	messages the game reads and the buffers of the messages between its own players. Nothing is
+	shared with the other objects of the process but enet, that the first context initializes
+	and the last one releases, so a process can hold many sessions at once (a host and its
+	clients in a load test)
+*/
+class DPContext
+{
+public:
+	/*!
+	* @param arenaSize Bytes of the arena, it wraps when full
+	*/
+	explicit DPContext(size_t arenaSize = DP_CONTEXT_ARENA_SIZE) : m_arena(arenaSize)
+	{
+		std::lock_guard<std::mutex> lock(GetLock());
+
+		if (GetCount()++ == 0)
+		{
+			enet_initialize();
+			enet_time_get(); // the clock starts on the first call, not in a race between two contexts
+
+#ifdef _DEBUG
+			printf("[LOADER] Enet initialization\n");
+#endif
+		}
+	}
+
+	~DPContext()
+	{
+		std::lock_guard<std::mutex> lock(GetLock());
+
+		if (--GetCount() == 0)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Enet destruction\n");
+#endif
+			enet_deinitialize();
+		}
+	}
+
+	DPContext(const DPContext&) = delete;
+	DPContext& operator=(const DPContext&) = delete;
+
+	DPMsgArena* GetArena() { return &m_arena; }
+	DPMsgPool* GetPool() { return &m_pool; }
+
+	/*!
+	* @brief Contexts alive in the process
+	*/
+	static size_t GetContexts()
+	{
+		std::lock_guard<std::mutex> lock(GetLock());
+		return GetCount();
+	}
+
+private:
+	static std::mutex& GetLock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+
+	static size_t& GetCount()
+	{
+		static size_t count = 0;
+		return count;
+	}
+
+	DPMsgArena m_arena;
+	DPMsgPool m_pool;
+};
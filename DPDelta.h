@@ -0,0 +1,506 @@
+/*!
+	@author Arves100
+	@file DPDelta.h
+	@date 19/10/2026
+	@brief Delta encoding of the repeated game messages
+*/
+#pragma once
+
+#include <emmintrin.h>
+
+#define DP_DELTA_HISTORY 16 // messages kept by both sides of a stream, a base older than this is not used
+#define DP_DELTA_MAX_STREAMS 1024 // streams of a peer, the messages of the other ones are sent as they are
+#define DP_DELTA_MIN_SIZE 16 // smaller messages do not pay off
+#define DP_DELTA_MAX_SIZE 4096
+#define DP_DELTA_MIN_ZERO_RUN 4 // shorter unchanged runs are kept inside the literals
+#define DP_DELTA_ACK_INTERVAL 20 // ms between the acks of the unreliable streams
+
+enum DPDeltaFlags
+{
+	DP_DELTA_FULL = 0, // the payload is the message
+	DP_DELTA_XOR = 1, // the payload is the RLE of the XOR against the base message
+};
+
+struct DPDeltaInfo
+{
+	WORD stream;
+	WORD seq;
+	WORD base;
+	BYTE type;
+	BYTE flags;
+};
+
+struct DPDeltaAck
+{
+	WORD stream;
+	WORD seq;
+};
+
+/*!
+	@class DPDelta
+	Splits the game messages sent to a peer in streams of messages with the same sender, recipient,
+	type, size and reliability. A message is sent as the XOR against an older message of its stream
+	that the peer has, run length encoded, when it's smaller. The reliable streams use the previous
+	message, the unreliable ones the last message acknowledged by the peer, so a lost message is
+	never used as a base
+*/
+class DPDelta
+{
+public:
+	DPDelta() : m_ullLastAck(0), m_ullRawBytes(0), m_ullSentBytes(0), m_dwDeltas(0), m_dwFulls(0), m_dwDecoded(0), m_dwFailed(0), m_ullEncodeTicks(0), m_ullDecodeTicks(0)
+	{
+	}
+
+	/*!
+	* @brief Encodes a game message
+	* @param pk Message to send (ownership is not taken)
+	* @return Delta message, or nullptr if the message must be sent as it is
+	*/
+	ENetPacket* Encode(ENetPacket* pk)
+	{
+		if (pk->dataLength < DPMsg::GetHeaderSize() + DP_DELTA_MIN_SIZE || pk->dataLength > DPMsg::GetHeaderSize() + DP_DELTA_MAX_SIZE)
+			return nullptr;
+
+		DPMsg msg(pk, false);
+
+		if (msg.GetType() != DPMSG_TYPE_GAME && msg.GetType() != DPMSG_TYPE_REMOTEINFO)
+			return nullptr;
+
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+
+		Key key = { msg.GetFrom(), msg.GetTo(), (WORD)msg.GetRawSize(), msg.GetType(), msg.IsReliable() };
+		auto it = m_vStreamIds.find(key);
+
+		if (it == m_vStreamIds.end())
+		{
+			if (m_vStreams.size() >= DP_DELTA_MAX_STREAMS)
+				return nullptr;
+
+			it = m_vStreamIds.insert({ key, (WORD)m_vStreams.size() }).first;
+			m_vStreams.emplace_back();
+		}
+
+		auto& s = m_vStreams[it->second];
+		auto raw = msg.GetRaw();
+		auto size = msg.GetRawSize();
+
+		DPDeltaInfo info = { it->second, s.next++, 0, msg.GetType(), DP_DELTA_FULL };
+		bool hasBase;
+
+		if (key.reliable)
+			hasBase = s.sent > 0; // ordered, the peer has all of them
+		else
+			hasBase = s.hasAck && (WORD)(info.seq - s.acked) < DP_DELTA_HISTORY;
+
+		if (hasBase)
+		{
+			info.base = key.reliable ? (WORD)(info.seq - 1) : s.acked;
+
+			if (XorRle(raw, s.history[info.base % DP_DELTA_HISTORY].data(), size, m_vScratch))
+				info.flags = DP_DELTA_XOR;
+		}
+
+		s.history[info.seq % DP_DELTA_HISTORY].assign(raw, raw + size);
+		s.sent++;
+
+		DPMsg out(msg.GetFrom(), msg.GetTo(), DPMSG_TYPE_DELTA);
+		out.SetFlags(msg.GetFlags());
+		out.AddToSerialize(info);
+
+		if (info.flags == DP_DELTA_XOR)
+		{
+			out.AddToSerialize(m_vScratch.data(), m_vScratch.size());
+			m_dwDeltas++;
+		}
+		else
+		{
+			out.AddToSerialize(raw, size);
+			m_dwFulls++;
+		}
+
+		auto opk = out.Serialize(pk->flags & ENET_PACKET_FLAG_RELIABLE);
+
+		QueryPerformanceCounter(&end);
+		m_ullEncodeTicks += end.QuadPart - start.QuadPart;
+		m_ullRawBytes += pk->dataLength;
+		m_ullSentBytes += opk->dataLength;
+		return opk;
+	}
+
+	/*!
+	* @brief Decodes a delta message
+	* @param msg Delta message
+	* @return The game message, nullptr if the base is not known (lost, or too old)
+	*/
+	std::shared_ptr<DPMsg> Decode(DPMsg& msg)
+	{
+		auto info = (DPDeltaInfo*)msg.Read2(sizeof(DPDeltaInfo));
+
+		if (!info || info->stream >= DP_DELTA_MAX_STREAMS || (info->type != DPMSG_TYPE_GAME && info->type != DPMSG_TYPE_REMOTEINFO))
+			return nullptr;
+
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+
+		auto& s = m_vReceived[info->stream];
+		auto size = msg.GetRawSize() - sizeof(DPDeltaInfo);
+		auto payload = msg.Read2(size);
+		auto& slot = s.history[info->seq % DP_DELTA_HISTORY];
+
+		if (info->flags == DP_DELTA_XOR)
+		{
+			const auto& base = s.history[info->base % DP_DELTA_HISTORY];
+
+			if (!s.valid[info->base % DP_DELTA_HISTORY] || s.seq[info->base % DP_DELTA_HISTORY] != info->base ||
+				!UnXorRle(payload, size, base.data(), base.size(), m_vScratch))
+			{
+				m_dwFailed++;
+				return nullptr;
+			}
+
+			slot.swap(m_vScratch);
+		}
+		else if (info->flags == DP_DELTA_FULL && size <= DP_DELTA_MAX_SIZE)
+			slot.assign(payload, payload + size);
+		else
+		{
+			m_dwFailed++;
+			return nullptr;
+		}
+
+		s.seq[info->seq % DP_DELTA_HISTORY] = info->seq;
+		s.valid[info->seq % DP_DELTA_HISTORY] = true;
+
+		if (!msg.IsReliable() && (!s.hasLast || (short)(info->seq - s.last) > 0))
+		{ // acknowledged on the next UpdateAcks
+			s.last = info->seq;
+			s.hasLast = true;
+			s.dirty = true;
+		}
+
+		DPMsg out(msg.GetFrom(), msg.GetTo(), info->type);
+		out.SetFlags(msg.GetFlags());
+		out.AddToSerialize(slot.data(), slot.size());
+		auto m = std::make_shared<DPMsg>(out.Serialize(msg.IsReliable() ? ENET_PACKET_FLAG_RELIABLE : 0), true);
+
+		QueryPerformanceCounter(&end);
+		m_ullDecodeTicks += end.QuadPart - start.QuadPart;
+		m_dwDecoded++;
+		return m;
+	}
+
+	/*!
+	* @brief Sends the acks of the unreliable streams that received something new
+	* @param send Function that sends a packet to the peer
+	*/
+	template <typename F>
+	void UpdateAcks(F send)
+	{
+		auto now = GetTickCount64();
+
+		if (now - m_ullLastAck < DP_DELTA_ACK_INTERVAL)
+			return;
+
+		std::vector<DPDeltaAck> acks;
+
+		for (auto& s : m_vReceived)
+		{
+			if (!s.second.dirty)
+				continue;
+
+			acks.push_back({ s.first, s.second.last });
+			s.second.dirty = false;
+		}
+
+		if (acks.empty())
+			return;
+
+		m_ullLastAck = now;
+
+		DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_DELTA_ACK);
+		msg.AddToSerialize(acks.data(), acks.size() * sizeof(DPDeltaAck));
+		send(msg.Serialize(0));
+	}
+
+	/*!
+	* @brief Handles the acks sent by the peer
+	*/
+	void OnAck(DPMsg& msg)
+	{
+		DPDeltaAck* ack;
+
+		while ((ack = (DPDeltaAck*)msg.Read2(sizeof(DPDeltaAck))) != nullptr)
+		{
+			if (ack->stream >= m_vStreams.size())
+				continue;
+
+			auto& s = m_vStreams[ack->stream];
+
+			if ((WORD)(s.next - ack->seq) > DP_DELTA_HISTORY || ack->seq == s.next)
+				continue; // not sent yet, or too old to be useful
+
+			if (!s.hasAck || (short)(ack->seq - s.acked) > 0)
+			{
+				s.acked = ack->seq;
+				s.hasAck = true;
+			}
+		}
+	}
+
+	void Reset()
+	{
+		m_vStreamIds.clear();
+		m_vStreams.clear();
+		m_vReceived.clear();
+	}
+
+	void Dump(DPID id) const
+	{
+#ifdef _DEBUG
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+
+		if (!m_dwDeltas && !m_dwFulls && !m_dwDecoded)
+			return;
+
+		printf("[LOADER] Player %u delta: %u streams, %u delta %u full, %llu -> %llu bytes (%u%%), %u decoded %u failed, encode %llu ns/msg, decode %llu ns/msg\n", id,
+			(DWORD)m_vStreams.size(), m_dwDeltas, m_dwFulls, (unsigned long long)m_ullRawBytes, (unsigned long long)m_ullSentBytes,
+			m_ullRawBytes ? (DWORD)(m_ullSentBytes * 100 / m_ullRawBytes) : 0, m_dwDecoded, m_dwFailed,
+			(m_dwDeltas + m_dwFulls) ? (unsigned long long)(m_ullEncodeTicks * 1000000000 / freq.QuadPart / (m_dwDeltas + m_dwFulls)) : 0,
+			m_dwDecoded ? (unsigned long long)(m_ullDecodeTicks * 1000000000 / freq.QuadPart / m_dwDecoded) : 0);
+#endif
+	}
+
+private:
+	struct Key
+	{
+		DPID from;
+		DPID to;
+		WORD size;
+		BYTE type;
+		bool reliable;
+
+		bool operator==(const Key& k) const
+		{
+			return from == k.from && to == k.to && size == k.size && type == k.type && reliable == k.reliable;
+		}
+	};
+
+	struct KeyHasher
+	{
+		size_t operator()(const Key& k) const
+		{
+			return (size_t)k.from * 2654435761U ^ (size_t)k.to * 40503U ^ ((size_t)k.size << 9 | (size_t)k.type << 1 | k.reliable);
+		}
+	};
+
+	struct Stream
+	{
+		Stream() : next(0), sent(0), acked(0), hasAck(false) {}
+
+		WORD next;
+		DWORD sent;
+		WORD acked;
+		bool hasAck;
+		std::vector<BYTE> history[DP_DELTA_HISTORY];
+	};
+
+	struct ReceivedStream
+	{
+		ReceivedStream() : last(0), hasLast(false), dirty(false)
+		{
+			memset(seq, 0, sizeof(seq));
+			memset(valid, 0, sizeof(valid));
+		}
+
+		WORD seq[DP_DELTA_HISTORY];
+		bool valid[DP_DELTA_HISTORY];
+		std::vector<BYTE> history[DP_DELTA_HISTORY];
+		WORD last;
+		bool hasLast;
+		bool dirty;
+	};
+
+	// Length of the zero bytes at the start of p
+	static size_t ZeroRun(const BYTE* p, size_t len)
+	{
+		size_t i = 0;
+		auto zero = _mm_setzero_si128();
+
+		for (; i + 16 <= len; i += 16)
+		{
+			DWORD mask = (DWORD)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), zero)) ^ 0xFFFF;
+			unsigned long first;
+
+			if (_BitScanForward(&first, mask))
+				return i + first;
+		}
+
+		while (i < len && !p[i])
+			i++;
+
+		return i;
+	}
+
+	// Length of the non zero bytes at the start of p
+	static size_t NonZeroRun(const BYTE* p, size_t len)
+	{
+		size_t i = 0;
+		auto zero = _mm_setzero_si128();
+
+		for (; i + 16 <= len; i += 16)
+		{
+			DWORD mask = (DWORD)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), zero));
+			unsigned long first;
+
+			if (_BitScanForward(&first, mask))
+				return i + first;
+		}
+
+		while (i < len && p[i])
+			i++;
+
+		return i;
+	}
+
+	static void Xor(BYTE* dst, const BYTE* a, const BYTE* b, size_t len)
+	{
+		size_t i = 0;
+
+		for (; i + 16 <= len; i += 16)
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i))));
+
+		for (; i < len; i++)
+			dst[i] = a[i] ^ b[i];
+	}
+
+	static void PutVarint(BYTE*& p, size_t v)
+	{
+		while (v >= 0x80)
+		{
+			*p++ = (BYTE)(v | 0x80);
+			v >>= 7;
+		}
+
+		*p++ = (BYTE)v;
+	}
+
+	static bool GetVarint(const BYTE*& p, const BYTE* end, size_t& v)
+	{
+		v = 0;
+
+		for (size_t shift = 0; shift < 21; shift += 7)
+		{
+			if (p >= end)
+				return false;
+
+			BYTE b = *p++;
+			v |= (size_t)(b & 0x7F) << shift;
+
+			if (!(b & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+
+	/*
+		Encodes the XOR of cur and base as a list of (unchanged bytes, changed bytes, XOR of the changed bytes),
+		the unchanged bytes at the end are not written
+		@return false if it's not smaller than the message
+	*/
+	bool XorRle(const BYTE* cur, const BYTE* base, size_t len, std::vector<BYTE>& out)
+	{
+		m_vXor.resize(len);
+		Xor(m_vXor.data(), cur, base, len);
+		out.resize(len + 16);
+
+		auto d = m_vXor.data();
+		auto p = out.data(), limit = out.data() + len - 8; // room for the varints of the last run
+		size_t i = 0;
+
+		while (i < len)
+		{
+			size_t zeros = ZeroRun(d + i, len - i);
+
+			if (i + zeros == len)
+				break;
+
+			size_t lit = 0;
+
+			for (;;)
+			{ // short unchanged runs are cheaper as literals
+				lit += NonZeroRun(d + i + zeros + lit, len - i - zeros - lit);
+
+				if (i + zeros + lit == len)
+					break;
+
+				size_t z = ZeroRun(d + i + zeros + lit, len - i - zeros - lit);
+
+				if (z >= DP_DELTA_MIN_ZERO_RUN || i + zeros + lit + z == len)
+					break;
+
+				lit += z;
+			}
+
+			if (p + lit > limit)
+				return false;
+
+			PutVarint(p, zeros);
+			PutVarint(p, lit);
+			memcpy(p, d + i + zeros, lit);
+			p += lit;
+			i += zeros + lit;
+		}
+
+		out.resize(p - out.data());
+		return out.size() < len;
+	}
+
+	static bool UnXorRle(const BYTE* src, size_t len, const BYTE* base, size_t baseLen, std::vector<BYTE>& out)
+	{
+		out.assign(base, base + baseLen);
+
+		auto p = src, end = src + len;
+		size_t o = 0;
+
+		while (p < end)
+		{
+			size_t zeros, lit;
+
+			if (!GetVarint(p, end, zeros) || !GetVarint(p, end, lit))
+				return false;
+
+			if (zeros > baseLen - o || lit > baseLen - o - zeros || lit > (size_t)(end - p))
+				return false;
+
+			o += zeros;
+			Xor(out.data() + o, out.data() + o, p, lit);
+			o += lit;
+			p += lit;
+		}
+
+		return true;
+	}
+
+	// Sender
+	std::unordered_map<Key, WORD, KeyHasher> m_vStreamIds;
+	std::vector<Stream> m_vStreams;
+	std::vector<BYTE> m_vScratch;
+	std::vector<BYTE> m_vXor;
+
+	// Receiver
+	std::unordered_map<WORD, ReceivedStream> m_vReceived;
+	ULONGLONG m_ullLastAck;
+
+	// Statistics
+	ULONGLONG m_ullRawBytes;
+	ULONGLONG m_ullSentBytes;
+	DWORD m_dwDeltas;
+	DWORD m_dwFulls;
+	DWORD m_dwDecoded;
+	DWORD m_dwFailed;
+	ULONGLONG m_ullEncodeTicks;
+	ULONGLONG m_ullDecodeTicks;
+};
@@ -0,0 +1,391 @@
+/*!
+	@author Arves100
+	@file DPFec.h
+	@date 19/10/2026
+	@brief Forward error correction of the unreliable game messages
+*/
+#pragma once
+
+#define DP_FEC_MAX_GROUP 16 // data messages protected by one parity message, on clean links
+#define DP_FEC_MAX_PAYLOAD 1200 // bigger messages are fragmented by enet anyway, they are not protected
+#define DP_FEC_GROUP_TIME 50 // ms after an incomplete group gets its parity
+#define DP_FEC_LOSS_INTERVAL 1000 // how often the loss is reported and the group size is adapted
+#define DP_FEC_LOSS_SAMPLES 32 // packets the peer must receive before trusting the loss
+#define DP_FEC_GROUPS 16 // groups kept by the receiver
+
+/*!
+	@class DPFec
+	Wraps the unreliable game messages of a peer in groups followed by a XOR parity message, so a
+	single message lost in a group is rebuilt by the receiver without waiting for a retransmission.
+	The group gets smaller as the loss of the peer grows, and the parity is not sent at all on clean links.
+	enet only knows the loss of its reliable packets, so every receiver counts the gaps in the sequence of
+	the unreliable ones and reports them to the sender
+*/
+class DPFec
+{
+public:
+	DPFec() : m_wGroup(0), m_nIndex(0), m_nGroupSize(0), m_nNextGroupSize(0), m_wLengthXor(0), m_ullGroupStart(0),
+		m_ullNextLossCheck(0), m_dwLastReceived(0), m_dwLastLost(0), m_dwReportReceived(0), m_dwReportLost(0), m_bHasReport(false),
+		m_dwReportedReceived(0), m_wNewestGroup(0), m_bHasGroups(false),
+		m_ullDataBytes(0), m_ullOverheadBytes(0), m_dwReceived(0), m_dwRecovered(0), m_dwDuplicates(0)
+	{
+	}
+
+	/*!
+	* @brief Checks if a packet is an unreliable game message small enough to be protected
+	*/
+	static bool CanProtect(ENetPacket* pk)
+	{
+		if ((pk->flags & ENET_PACKET_FLAG_RELIABLE) || pk->dataLength > DP_FEC_MAX_PAYLOAD || pk->dataLength < DPMsg::GetHeaderSize())
+			return false;
+
+		DPMsg msg(pk, false);
+		return msg.GetType() == DPMSG_TYPE_GAME || msg.GetType() == DPMSG_TYPE_COMPRESSED || msg.GetType() == DPMSG_TYPE_DELTA;
+	}
+
+	/*!
+	* @brief Sends a message inside the current group, the parity of a full group goes out with the next update or message
+	* @param pk Message to protect (ownership is not taken)
+	* @param send Function that sends a packet to the peer
+	* @return false if the message was not sent because the protection is off
+	*/
+	template <typename F>
+	bool Protect(ENetPacket* pk, F send)
+	{
+		if (m_nIndex && m_nIndex >= m_nGroupSize)
+			SendParity(send);
+
+		if (m_nIndex == 0)
+		{
+			m_nGroupSize = m_nNextGroupSize;
+
+			if (!m_nGroupSize)
+				return false;
+
+			m_ullGroupStart = GetTickCount64();
+		}
+
+		DPMsg orig(pk, false);
+		DPFecInfo info = { m_wGroup, (BYTE)m_nIndex, (BYTE)m_nGroupSize };
+
+		DPMsg msg(orig.GetFrom(), orig.GetTo(), DPMSG_TYPE_FEC_DATA);
+		msg.AddToSerialize(info);
+		msg.AddToSerialize(pk->data, pk->dataLength);
+		auto out = msg.Serialize(0);
+
+		if (m_vParity.size() < pk->dataLength)
+			m_vParity.resize(pk->dataLength, 0);
+
+		for (size_t i = 0; i < pk->dataLength; i++)
+			m_vParity[i] ^= pk->data[i];
+
+		m_wLengthXor ^= (WORD)pk->dataLength;
+		m_nIndex++;
+		m_ullDataBytes += pk->dataLength;
+		m_ullOverheadBytes += out->dataLength - pk->dataLength;
+
+		send(out); // the parity waits, in the datagram of the last message a single loss would take both
+
+		return true;
+	}
+
+	/*!
+	* @brief Reports our loss to the peer, adapts the group size to the one it reported, and closes a group that is waiting for too long
+	* @param peer Peer to check
+	* @param send Function that sends a packet to the peer
+	*/
+	template <typename F>
+	void Update(ENetPeer* peer, F send)
+	{
+		auto now = GetTickCount64();
+
+		if (m_nIndex && (m_nIndex >= m_nGroupSize || now - m_ullGroupStart >= DP_FEC_GROUP_TIME))
+			SendParity(send); // full, or the game stopped sending and the last messages must not stay unprotected
+
+		if (now < m_ullNextLossCheck)
+			return;
+
+		m_ullNextLossCheck = now + DP_FEC_LOSS_INTERVAL;
+
+		auto received = (DWORD)enet_peer_get_unreliable_received(peer);
+
+		if (received != m_dwReportedReceived)
+		{ // nothing to say on an idle link
+			send(DPMsg::FecReport(received, (DWORD)enet_peer_get_unreliable_lost(peer)));
+			m_dwReportedReceived = received;
+		}
+
+		if (!m_bHasReport)
+			return;
+
+		if (m_dwReportReceived < m_dwLastReceived || m_dwReportLost < m_dwLastLost)
+		{ // the peer was reset
+			m_dwLastReceived = m_dwReportReceived;
+			m_dwLastLost = m_dwReportLost;
+			return;
+		}
+
+		auto got = m_dwReportReceived - m_dwLastReceived, lost = m_dwReportLost - m_dwLastLost;
+
+		if (got + lost < DP_FEC_LOSS_SAMPLES)
+			return;
+
+		auto loss = (ULONGLONG)lost * 1000 / (got + lost); // per mille
+		size_t size = 0;
+
+		if (loss >= 5)
+		{ // with a loss p about p * k of the lost messages share their group of k with another loss and are not rebuilt, keep it under a fourth
+			size = (size_t)(250 / loss);
+			size = size < 2 ? 2 : (size > DP_FEC_MAX_GROUP ? DP_FEC_MAX_GROUP : size);
+		}
+
+#ifdef _DEBUG
+		if (size != m_nNextGroupSize)
+			printf("[LOADER] Peer %u loss %u per mille, fec group %u\n", (DWORD)peer->data, (DWORD)loss, (DWORD)size);
+#endif
+
+		m_nNextGroupSize = size;
+		m_dwLastReceived = m_dwReportReceived;
+		m_dwLastLost = m_dwReportLost;
+	}
+
+	/*!
+	* @brief Stores the loss the peer reported, the group size follows it at the next update
+	* @param msg Report message
+	*/
+	void Report(DPMsg& msg)
+	{
+		auto report = (DPFecReport*)msg.Read2(sizeof(DPFecReport));
+
+		if (!report)
+			return;
+
+		if (!m_bHasReport)
+		{ // the loss is counted from here
+			m_dwLastReceived = report->received;
+			m_dwLastLost = report->lost;
+			m_bHasReport = true;
+		}
+
+		m_dwReportReceived = report->received;
+		m_dwReportLost = report->lost;
+	}
+
+	/*!
+	* @brief Unwraps a received fec message
+	* @param msg Data or parity message
+	* @param deliver Function that receives every game message, the received and the rebuilt ones
+	*/
+	template <typename F>
+	void Receive(DPMsg& msg, F deliver)
+	{
+		auto info = (DPFecInfo*)msg.Read2(sizeof(DPFecInfo));
+
+		if (!info || info->count > 32)
+			return;
+
+		auto g = GetGroup(info->group);
+
+		if (!g)
+			return; // too old
+
+		auto size = msg.GetRawSize() - sizeof(DPFecInfo);
+
+		if (msg.GetType() == DPMSG_TYPE_FEC_DATA)
+		{
+			auto data = msg.Read2(size);
+
+			if (info->index >= 32 || (g->received & (1U << info->index)) || size < DPMsg::GetHeaderSize())
+			{
+				m_dwDuplicates++;
+				return;
+			}
+
+			g->received |= 1U << info->index;
+			m_dwReceived++;
+
+			if (!g->done)
+				g->payloads.push_back(std::vector<BYTE>(data, data + size));
+
+			deliver(enet_packet_create(data, size, 0));
+		}
+		else
+		{
+			if (g->hasParity || size < sizeof(WORD))
+				return;
+
+			msg.Read(g->lengthXor);
+			auto data = msg.Read2(size - sizeof(WORD));
+			g->parity.assign(data, data + size - sizeof(WORD));
+			g->count = info->count;
+			g->hasParity = true;
+		}
+
+		Recover(g, deliver);
+	}
+
+	void Reset()
+	{
+		m_wGroup = 0;
+		m_nIndex = 0;
+		m_vParity.clear();
+		m_wLengthXor = 0;
+		m_vGroups.clear();
+		m_bHasGroups = false;
+		m_bHasReport = false;
+		m_dwReportedReceived = 0;
+	}
+
+	void Dump(DPID id) const
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Player %u fec: %u received %u recovered (%u per mille) %u duplicates, overhead %llu/%llu bytes\n", id, m_dwReceived, m_dwRecovered,
+			(m_dwReceived + m_dwRecovered) ? m_dwRecovered * 1000 / (m_dwReceived + m_dwRecovered) : 0, m_dwDuplicates,
+			(unsigned long long)m_ullOverheadBytes, (unsigned long long)m_ullDataBytes);
+#endif
+	}
+
+private:
+	struct Group
+	{
+		DWORD received;
+		size_t count;
+		bool hasParity;
+		bool done;
+		WORD lengthXor;
+		std::vector<BYTE> parity;
+		std::vector<std::vector<BYTE>> payloads;
+	};
+
+	template <typename F>
+	void SendParity(F send)
+	{
+		DPFecInfo info = { m_wGroup, (BYTE)m_nIndex, (BYTE)m_nIndex }; // real count, the group might be incomplete
+
+		DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_FEC_PARITY);
+		msg.AddToSerialize(info);
+		msg.AddToSerialize(m_wLengthXor);
+		msg.AddToSerialize(m_vParity.data(), m_vParity.size());
+		auto out = msg.Serialize(0);
+
+		m_ullOverheadBytes += out->dataLength;
+		send(out);
+
+		m_wGroup++;
+		m_nIndex = 0;
+		m_vParity.clear();
+		m_wLengthXor = 0;
+	}
+
+	Group* GetGroup(WORD group)
+	{
+		if (!m_bHasGroups || (short)(group - m_wNewestGroup) > 0)
+		{ // newer group, forget the ones out of the window
+			m_wNewestGroup = group;
+			m_bHasGroups = true;
+
+			for (auto it = m_vGroups.begin(); it != m_vGroups.end();)
+			{
+				if ((WORD)(m_wNewestGroup - it->first) >= DP_FEC_GROUPS)
+					it = m_vGroups.erase(it);
+				else
+					++it;
+			}
+		}
+		else if ((WORD)(m_wNewestGroup - group) >= DP_FEC_GROUPS)
+			return nullptr;
+
+		auto it = m_vGroups.find(group);
+
+		if (it == m_vGroups.end())
+		{
+			Group g;
+			g.received = 0;
+			g.count = 0;
+			g.hasParity = false;
+			g.done = false;
+			g.lengthXor = 0;
+			it = m_vGroups.insert({ group, g }).first;
+		}
+
+		return &it->second;
+	}
+
+	template <typename F>
+	void Recover(Group* g, F deliver)
+	{
+		if (!g->hasParity || g->done)
+			return;
+
+		size_t have = 0, missing = 0;
+
+		for (size_t i = 0; i < g->count; i++)
+		{
+			if (g->received & (1U << i))
+				have++;
+			else
+				missing = i;
+		}
+
+		if (have + 1 < g->count)
+			return; // wait for more, or lost for good
+
+		g->done = true;
+
+		if (have == g->count)
+		{ // nothing to rebuild
+			g->payloads.clear();
+			g->parity.clear();
+			return;
+		}
+
+		auto& buf = g->parity;
+		WORD len = g->lengthXor;
+
+		for (const auto& p : g->payloads)
+		{
+			len ^= (WORD)p.size();
+
+			for (size_t i = 0; i < p.size() && i < buf.size(); i++)
+				buf[i] ^= p[i];
+		}
+
+		if (len < DPMsg::GetHeaderSize() || len > buf.size())
+			return; // corrupted
+
+		g->received |= 1U << missing; // a late copy is a duplicate now
+		m_dwRecovered++;
+		deliver(enet_packet_create(buf.data(), len, 0));
+
+		g->payloads.clear();
+		g->parity.clear();
+	}
+
+	// Sender
+	WORD m_wGroup;
+	size_t m_nIndex;
+	size_t m_nGroupSize;
+	size_t m_nNextGroupSize;
+	std::vector<BYTE> m_vParity;
+	WORD m_wLengthXor;
+	ULONGLONG m_ullGroupStart;
+	ULONGLONG m_ullNextLossCheck;
+	DWORD m_dwLastReceived; // report the loss was last computed on
+	DWORD m_dwLastLost;
+	DWORD m_dwReportReceived; // newest report of the peer
+	DWORD m_dwReportLost;
+	bool m_bHasReport;
+
+	// Receiver
+	DWORD m_dwReportedReceived; // packets counted in our last report
+	std::unordered_map<WORD, Group> m_vGroups;
+	WORD m_wNewestGroup;
+	bool m_bHasGroups;
+
+	// Statistics
+	ULONGLONG m_ullDataBytes;
+	ULONGLONG m_ullOverheadBytes;
+	DWORD m_dwReceived;
+	DWORD m_dwRecovered;
+	DWORD m_dwDuplicates;
+};
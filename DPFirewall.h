@@ -0,0 +1,449 @@
+/*!
+	@author Arves100
+	@file DPFirewall.h
+	@date 19/10/2026
+	@brief Early drop of the datagrams that flood a host
+*/
+#pragma once
+
+#include "DPRendezvous.h"
+#include <cstddef>
+#include <random>
+
+#define DP_FIREWALL_SOURCES 1024 // addresses tracked, the least recent one is forgotten when a slot is needed
+#define DP_FIREWALL_PROBES 8 // slots looked at for an address
+#define DP_FIREWALL_DATA_RATE 2000 // datagrams per second from one address, players behind the same NAT share it
+#define DP_FIREWALL_DATA_BURST 4000
+#define DP_FIREWALL_CONNECT_RATE 4 // connects per second from one address, the session enumerations are connects too
+#define DP_FIREWALL_CONNECT_BURST 16
+#define DP_FIREWALL_COOKIE_TIME 10000 // ms a cookie is valid for, at least
+#define DP_FIREWALL_COOKIE_MAGIC 0x4B435044 // "DPCK"
+#define DP_FIREWALL_COOKIE_SHIFT 8 // the cookie goes in the connect data, over the connect type
+
+enum DPFirewallDrop
+{
+	DP_FIREWALL_DROP_MALFORMED, // enet header or commands that do not fit the datagram
+	DP_FIREWALL_DROP_MESSAGE, // a payload too small to be a message
+	DP_FIREWALL_DROP_DATA_RATE,
+	DP_FIREWALL_DROP_CONNECT_RATE,
+	DP_FIREWALL_DROP_COOKIE, // connect with a wrong or expired cookie, challenged again
+	DP_FIREWALL_DROP_CHALLENGED, // connect without a cookie, challenged
+	DP_FIREWALL_DROP_MAX
+};
+
+/*!
+	@class DPFirewall
+	Runs as the intercept callback of a host, before enet parses a datagram or takes a peer for it.
+	Every address has a token bucket for its datagrams and one for its connects, the datagrams that
+	cannot be valid are dropped, and a connect takes a peer only if it carries the cookie the host
+	answered to an earlier connect from the same address, so spoofed connects never take a peer
+	(only with the cookies on, the players of older builds cannot answer them).
+	The same object answers the challenges of the hosts we connect to and hands the datagrams of
+	the rendezvous service to its DPRendezvous.
+	Nothing is allocated after the construction
+*/
+class DPFirewall
+{
+public:
+	DPFirewall() : m_pRendezvous(nullptr), m_bTrustLoopback(false), m_bCookies(false)
+	{
+		std::random_device rd;
+		m_aullKey[0] = ((uint64_t)rd() << 32) | rd();
+		m_aullKey[1] = ((uint64_t)rd() << 32) | rd();
+		Reset();
+	}
+
+	/*!
+	* @brief Installs the firewall on a host
+	*/
+	void Install(ENetHost* host)
+	{
+		host->data = this;
+		enet_host_set_intercept_callback(host, Intercept);
+	}
+
+	/*!
+	* @brief Sets the object that handles the rendezvous datagrams, they are dropped without one
+	*/
+	void SetRendezvous(DPRendezvous* rendezvous) { m_pRendezvous = rendezvous; }
+
+	/*!
+	* @brief Lets the datagrams of this machine skip the rate limits, for the load tests that run many players on loopback
+	*/
+	void SetTrustLoopback(bool trust) { m_bTrustLoopback = trust; }
+
+	/*!
+	* @brief Challenges every connect with a cookie, the challenges of the hosts we connect to are answered anyway
+	*/
+	void SetCookies(bool cookies) { m_bCookies = cookies; }
+
+	void Reset()
+	{
+		memset(m_vSources, 0, sizeof(m_vSources));
+		memset(m_adwDrops, 0, sizeof(m_adwDrops));
+		m_dwPassed = 0;
+	}
+
+	DWORD GetDrops(DPFirewallDrop reason) const { return m_adwDrops[reason]; }
+	DWORD GetPassed() const { return m_dwPassed; }
+
+	static const char* GetDropName(DPFirewallDrop reason)
+	{
+		static const char* names[DP_FIREWALL_DROP_MAX] = { "malformed", "message", "data rate", "connect rate", "bad cookie", "challenged" };
+		return names[reason];
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Firewall: %u passed, dropped", m_dwPassed);
+
+		for (int i = 0; i < DP_FIREWALL_DROP_MAX; i++)
+			printf(" %u %s", m_adwDrops[i], GetDropName((DPFirewallDrop)i));
+
+		printf("\n");
+#endif
+	}
+
+private:
+	struct Source
+	{
+		in6_addr address;
+		uint32_t lastSeen;
+		uint32_t dataTokens; // thousandths
+		uint32_t connectTokens;
+		bool used;
+	};
+
+	struct Challenge
+	{
+		WORD peerID; // all ones, enet ignores it
+		WORD reserved;
+		DWORD magic;
+		DWORD connectID; // as on the wire
+		DWORD cookie;
+	};
+
+	static int ENET_CALLBACK Intercept(ENetHost* host, ENetEvent*, ENetAddress* address, uint8_t* data, int length)
+	{
+		return ((DPFirewall*)host->data)->Filter(host, address, data, (size_t)length) ? 0 : 1;
+	}
+
+	/*!
+	* @brief Checks a received datagram
+	* @return true if enet can parse it
+	*/
+	bool Filter(ENetHost* host, const ENetAddress* from, uint8_t* data, size_t length)
+	{
+		auto now = host->serviceTime; // set by enet before it receives
+
+		if (length == sizeof(Challenge) && ((Challenge*)data)->peerID == 0xFFFF && ((Challenge*)data)->magic == ENET_HOST_TO_NET_32(DP_FIREWALL_COOKIE_MAGIC))
+		{
+			Answer(host, from, (Challenge*)data);
+			return false;
+		}
+
+		// the players of this machine share the loopback address, a load test runs many of them
+		auto src = m_bTrustLoopback && IsLoopback(from) ? nullptr : GetSource(from, now);
+
+		if (src && !Take(src->dataTokens))
+			return Drop(DP_FIREWALL_DROP_DATA_RATE);
+
+		if (length == sizeof(DPRendezvousMsg) && ((DPRendezvousMsg*)data)->peerID == 0xFFFF && ((DPRendezvousMsg*)data)->magic == ENET_HOST_TO_NET_32(DP_RENDEZVOUS_MAGIC))
+		{
+			if (m_pRendezvous)
+				m_pRendezvous->Receive(host, from, (DPRendezvousMsg*)data);
+
+			return false;
+		}
+
+		if (length < offsetof(ENetProtocolHeader, sentTime))
+			return Drop(DP_FIREWALL_DROP_MALFORMED);
+
+		auto peerID = ENET_NET_TO_HOST_16(((ENetProtocolHeader*)data)->peerID);
+		size_t offset = (peerID & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME) ? sizeof(ENetProtocolHeader) : offsetof(ENetProtocolHeader, sentTime);
+
+		if (peerID & ENET_PROTOCOL_HEADER_FLAG_CHECKSUM)
+			offset += sizeof(uint32_t);
+
+		ENetProtocolConnect* connect = nullptr;
+
+		while (offset < length)
+		{
+			if (length - offset < sizeof(ENetProtocolCommandHeader))
+				return Drop(DP_FIREWALL_DROP_MALFORMED);
+
+			auto cmd = (ENetProtocol*)&data[offset];
+			auto size = GetCommandSize(cmd->header.command);
+
+			if (!size || length - offset < size)
+				return Drop(DP_FIREWALL_DROP_MALFORMED);
+
+			size_t payload = 0, total = 0;
+			bool message = true;
+
+			switch (cmd->header.command & ENET_PROTOCOL_COMMAND_MASK)
+			{
+			case ENET_PROTOCOL_COMMAND_CONNECT:
+				if (connect)
+					return Drop(DP_FIREWALL_DROP_MALFORMED); // one peer per datagram
+
+				connect = &cmd->connect;
+				message = false;
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_RELIABLE:
+				total = payload = ENET_NET_TO_HOST_16(cmd->sendReliable.dataLength);
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE:
+				total = payload = ENET_NET_TO_HOST_16(cmd->sendUnreliable.dataLength);
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED:
+				total = payload = ENET_NET_TO_HOST_16(cmd->sendUnsequenced.dataLength);
+				break;
+
+			case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT:
+			case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT:
+				payload = ENET_NET_TO_HOST_16(cmd->sendFragment.dataLength);
+				total = ENET_NET_TO_HOST_32(cmd->sendFragment.totalLength);
+
+				if (ENET_NET_TO_HOST_32(cmd->sendFragment.fragmentNumber) >= ENET_NET_TO_HOST_32(cmd->sendFragment.fragmentCount) ||
+					ENET_NET_TO_HOST_32(cmd->sendFragment.fragmentOffset) >= total || total - ENET_NET_TO_HOST_32(cmd->sendFragment.fragmentOffset) < payload)
+					return Drop(DP_FIREWALL_DROP_MALFORMED);
+
+				break;
+
+			default:
+				message = false;
+				break;
+			}
+
+			if (length - offset - size < payload)
+				return Drop(DP_FIREWALL_DROP_MALFORMED);
+
+			if (message && total < DPMsg::GetHeaderSize())
+				return Drop(DP_FIREWALL_DROP_MESSAGE); // every packet of the game is a message
+
+			offset += size + payload;
+		}
+
+		if (connect && (peerID & ENET_PROTOCOL_MAXIMUM_PEER_ID) == ENET_PROTOCOL_MAXIMUM_PEER_ID)
+		{
+			if (src && !Take(src->connectTokens))
+				return Drop(DP_FIREWALL_DROP_CONNECT_RATE);
+
+			if (!m_bCookies)
+			{
+				m_dwPassed++;
+				return true;
+			}
+
+			auto value = ENET_NET_TO_HOST_32(connect->data);
+			auto cookie = value >> DP_FIREWALL_COOKIE_SHIFT;
+			auto epoch = now / DP_FIREWALL_COOKIE_TIME;
+
+			if (cookie && (cookie == GetCookie(from, connect->connectID, epoch) || cookie == GetCookie(from, connect->connectID, epoch - 1)))
+			{ // the connect type goes to the game as it was sent
+				connect->data = ENET_HOST_TO_NET_32(value & ((1U << DP_FIREWALL_COOKIE_SHIFT) - 1));
+				m_dwPassed++;
+				return true;
+			}
+
+			// smaller than the connect, it cannot be used to amplify a flood toward a spoofed address
+			Challenge c;
+			c.peerID = 0xFFFF;
+			c.reserved = 0;
+			c.magic = ENET_HOST_TO_NET_32(DP_FIREWALL_COOKIE_MAGIC);
+			c.connectID = connect->connectID;
+			c.cookie = ENET_HOST_TO_NET_32(GetCookie(from, connect->connectID, epoch));
+
+			ENetBuffer buf;
+			buf.data = &c;
+			buf.dataLength = sizeof(c);
+			enet_socket_send(host->socket, from, &buf, 1);
+
+			return Drop(cookie ? DP_FIREWALL_DROP_COOKIE : DP_FIREWALL_DROP_CHALLENGED);
+		}
+
+		m_dwPassed++;
+		return true;
+	}
+
+	/*!
+	* @brief Connects again with the cookie a host challenged us with
+	*/
+	void Answer(ENetHost* host, const ENetAddress* from, const Challenge* c)
+	{
+		for (size_t i = 0; i < host->peerCount; i++)
+		{
+			auto peer = &host->peers[i];
+
+			if (peer->state != ENET_PEER_STATE_CONNECTING || peer->connectID != c->connectID || peer->address.port != from->port ||
+				memcmp(&peer->address.ipv6, &from->ipv6, sizeof(in6_addr)) != 0)
+				continue;
+
+#ifdef _DEBUG
+			printf("[LOADER] Connecting again with the cookie of the host\n");
+#endif
+			// the connect type stays in the low bits
+			enet_peer_resend_connect(peer, ~((1U << DP_FIREWALL_COOKIE_SHIFT) - 1), ENET_NET_TO_HOST_32(c->cookie) << DP_FIREWALL_COOKIE_SHIFT);
+			return;
+		}
+	}
+
+	bool Drop(DPFirewallDrop reason)
+	{
+		m_adwDrops[reason]++;
+		return false;
+	}
+
+	static bool Take(uint32_t& tokens)
+	{
+		if (tokens < 1000)
+			return false;
+
+		tokens -= 1000;
+		return true;
+	}
+
+	/*!
+	* @brief Checks for ::1 and 127.0.0.0/8, nobody outside the machine can send from them
+	*/
+	static bool IsLoopback(const ENetAddress* from)
+	{
+		static const uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+		static const uint8_t loopback[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+		auto a = (const uint8_t*)&from->ipv6;
+
+		if (!memcmp(a, mapped, sizeof(mapped)))
+			return a[12] == 127;
+
+		return !memcmp(a, loopback, sizeof(loopback));
+	}
+
+	/*!
+	* @brief Refills a bucket for the time elapsed since the last datagram of its address
+	*/
+	static void Refill(uint32_t& tokens, uint32_t rate, uint32_t burst, uint32_t elapsed)
+	{
+		uint64_t t = (uint64_t)tokens + (uint64_t)elapsed * rate; // the rate per second is thousandths per ms
+		tokens = (uint32_t)(t > burst * 1000ULL ? burst * 1000ULL : t);
+	}
+
+	Source* GetSource(const ENetAddress* from, uint32_t now)
+	{
+		uint64_t words[2];
+		memcpy(words, &from->ipv6, sizeof(in6_addr));
+
+		// keyed murmur mix, every bit of the address reaches the slot and the slot cannot be chosen without the key
+		auto h = ((words[0] ^ m_aullKey[0]) * 0x9E3779B97F4A7C15ULL) ^ words[1] ^ m_aullKey[1];
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		auto base = (size_t)h % DP_FIREWALL_SOURCES;
+		Source* victim = nullptr;
+
+		for (size_t i = 0; i < DP_FIREWALL_PROBES; i++)
+		{
+			auto s = &m_vSources[(base + i) % DP_FIREWALL_SOURCES];
+
+			if (s->used && memcmp(&s->address, &from->ipv6, sizeof(in6_addr)) == 0)
+			{
+				Refill(s->dataTokens, DP_FIREWALL_DATA_RATE, DP_FIREWALL_DATA_BURST, now - s->lastSeen);
+				Refill(s->connectTokens, DP_FIREWALL_CONNECT_RATE, DP_FIREWALL_CONNECT_BURST, now - s->lastSeen);
+				s->lastSeen = now;
+				return s;
+			}
+
+			if (!victim || (victim->used && (!s->used || (int32_t)(s->lastSeen - victim->lastSeen) < 0)))
+				victim = s;
+		}
+
+		// a new address starts with full buckets
+		victim->address = from->ipv6;
+		victim->lastSeen = now;
+		victim->dataTokens = DP_FIREWALL_DATA_BURST * 1000;
+		victim->connectTokens = DP_FIREWALL_CONNECT_BURST * 1000;
+		victim->used = true;
+		return victim;
+	}
+
+	/*!
+	* @brief Cookie of a connect, it changes every DP_FIREWALL_COOKIE_TIME and it is never zero
+	*/
+	uint32_t GetCookie(const ENetAddress* from, uint32_t connectID, uint32_t epoch) const
+	{
+		uint64_t words[4];
+		memcpy(words, &from->ipv6, sizeof(in6_addr));
+		words[2] = ((uint64_t)from->port << 32) | connectID;
+		words[3] = epoch;
+
+		auto cookie = (uint32_t)SipHash(words) & (0xFFFFFFFFU >> DP_FIREWALL_COOKIE_SHIFT);
+		return cookie ? cookie : 1;
+	}
+
+	/*!
+	* @brief SipHash-1-3 of 32 bytes with the key of the host, the cookies cannot be guessed from other cookies
+	*/
+	uint64_t SipHash(const uint64_t words[4]) const
+	{
+		uint64_t v0 = m_aullKey[0] ^ 0x736f6d6570736575ULL, v1 = m_aullKey[1] ^ 0x646f72616e646f6dULL;
+		uint64_t v2 = m_aullKey[0] ^ 0x6c7967656e657261ULL, v3 = m_aullKey[1] ^ 0x7465646279746573ULL;
+
+#define DP_SIPROUND v0 += v1; v1 = (v1 << 13) | (v1 >> 51); v1 ^= v0; v0 = (v0 << 32) | (v0 >> 32); \
+	v2 += v3; v3 = (v3 << 16) | (v3 >> 48); v3 ^= v2; \
+	v0 += v3; v3 = (v3 << 21) | (v3 >> 43); v3 ^= v0; \
+	v2 += v1; v1 = (v1 << 17) | (v1 >> 47); v1 ^= v2; v2 = (v2 << 32) | (v2 >> 32);
+
+		for (int i = 0; i < 4; i++)
+		{
+			v3 ^= words[i];
+			DP_SIPROUND
+			v0 ^= words[i];
+		}
+
+		uint64_t b = 32ULL << 56;
+		v3 ^= b;
+		DP_SIPROUND
+		v0 ^= b;
+		v2 ^= 0xff;
+		DP_SIPROUND
+		DP_SIPROUND
+		DP_SIPROUND
+#undef DP_SIPROUND
+
+		return v0 ^ v1 ^ v2 ^ v3;
+	}
+
+	static size_t GetCommandSize(uint8_t command)
+	{
+		switch (command & ENET_PROTOCOL_COMMAND_MASK)
+		{
+		case ENET_PROTOCOL_COMMAND_ACKNOWLEDGE: return sizeof(ENetProtocolAcknowledge);
+		case ENET_PROTOCOL_COMMAND_CONNECT: return sizeof(ENetProtocolConnect);
+		case ENET_PROTOCOL_COMMAND_VERIFY_CONNECT: return sizeof(ENetProtocolVerifyConnect);
+		case ENET_PROTOCOL_COMMAND_DISCONNECT: return sizeof(ENetProtocolDisconnect);
+		case ENET_PROTOCOL_COMMAND_PING: return sizeof(ENetProtocolPing);
+		case ENET_PROTOCOL_COMMAND_SEND_RELIABLE: return sizeof(ENetProtocolSendReliable);
+		case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE: return sizeof(ENetProtocolSendUnreliable);
+		case ENET_PROTOCOL_COMMAND_SEND_FRAGMENT: return sizeof(ENetProtocolSendFragment);
+		case ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED: return sizeof(ENetProtocolSendUnsequenced);
+		case ENET_PROTOCOL_COMMAND_BANDWIDTH_LIMIT: return sizeof(ENetProtocolBandwidthLimit);
+		case ENET_PROTOCOL_COMMAND_THROTTLE_CONFIGURE: return sizeof(ENetProtocolThrottleConfigure);
+		case ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE_FRAGMENT: return sizeof(ENetProtocolSendFragment);
+		default: return 0;
+		}
+	}
+
+	uint64_t m_aullKey[2];
+	DPRendezvous* m_pRendezvous;
+	bool m_bTrustLoopback;
+	bool m_bCookies;
+	Source m_vSources[DP_FIREWALL_SOURCES];
+	DWORD m_adwDrops[DP_FIREWALL_DROP_MAX];
+	DWORD m_dwPassed;
+};
@@ -0,0 +1,134 @@
+/*!
+	@author Arves100
+	@file DPFlushPolicy.h
+	@date 19/10/2026
+	@brief Decides when the queued outgoing messages are handed to the socket
+*/
+#pragma once
+
+#define DP_FLUSH_MAX_DELAY 16 // ms a message can wait for the end of the frame (the game stopped calling Receive)
+#define DP_FLUSH_URGENT_PRIORITY ((DPSEND_MAX_PRIORITY + 1) / DP_PRIORITY_CLASSES * (DP_PRIORITY_CLASSES - 1)) // first priority of the highest class
+
+enum DPFlushPolicies
+{
+	DP_FLUSH_SERVICE, // old behaviour, sent on the next Receive
+	DP_FLUSH_FRAME, // once per game frame, urgent messages immediately
+	DP_FLUSH_IMMEDIATE, // every message immediately
+	DP_FLUSH_MAX,
+};
+
+/*!
+	@class DPFlushPolicy
+	Coalesces the messages sent during a game frame in a single flush. A frame starts with the first
+	Receive after the game drained the receive queue (Receive returned DPERR_NOMESSAGES)
+*/
+class DPFlushPolicy
+{
+public:
+	DPFlushPolicy() : m_dwPolicy(DP_FLUSH_SERVICE), m_ullUnflushedSince(0), m_ullFrameStart(0), m_dwFramePeriod(0), m_bInFrame(false)
+	{
+		memset(m_aullDelay, 0, sizeof(m_aullDelay));
+		memset(m_adwMessages, 0, sizeof(m_adwMessages));
+		memset(m_adwFlushes, 0, sizeof(m_adwFlushes));
+	}
+
+	void SetPolicy(DWORD dwPolicy) { m_dwPolicy = dwPolicy < DP_FLUSH_MAX ? dwPolicy : DP_FLUSH_SERVICE; }
+	DWORD GetPolicy() const { return m_dwPolicy; }
+
+	/*!
+	* @brief Records a queued message
+	* @param dwPriority DirectPlay priority of the message
+	* @return true if the message must be flushed now
+	*/
+	bool OnSend(DWORD dwPriority)
+	{
+		if (!m_ullUnflushedSince)
+			m_ullUnflushedSince = GetTickCount64();
+
+		m_adwMessages[m_dwPolicy]++;
+
+		if (m_dwPolicy == DP_FLUSH_SERVICE)
+			return false;
+
+		if (m_dwPolicy == DP_FLUSH_IMMEDIATE || dwPriority >= DP_FLUSH_URGENT_PRIORITY)
+			return true;
+
+		return IsLate();
+	}
+
+	/*!
+	* @brief Called at the start of every Receive, tracks the frame boundaries
+	* @return true if the messages of the last frame must be flushed now
+	*/
+	bool OnReceive()
+	{
+		if (m_bInFrame)
+			return false;
+
+		auto now = GetTickCount64();
+
+		if (m_ullFrameStart)
+			m_dwFramePeriod = (m_dwFramePeriod * 7 + (DWORD)(now - m_ullFrameStart)) / 8;
+
+		m_ullFrameStart = now;
+		m_bInFrame = true;
+
+		return m_dwPolicy == DP_FLUSH_FRAME && m_ullUnflushedSince != 0;
+	}
+
+	/*!
+	* @brief Called when Receive has no more messages, the game is going to run the frame
+	*/
+	void OnDrained() { m_bInFrame = false; }
+
+	/*!
+	* @brief Checks if a message is waiting for too long (the game is not calling Receive)
+	*/
+	bool IsLate() const
+	{
+		return m_ullUnflushedSince && GetTickCount64() - m_ullUnflushedSince >= DP_FLUSH_MAX_DELAY;
+	}
+
+	/*!
+	* @brief Tells if the game queued messages after the last flush
+	*/
+	bool HasUnflushed() const { return m_ullUnflushedSince != 0; }
+
+	/*!
+	* @brief Records that everything queued so far was handed to enet
+	*/
+	void OnFlush()
+	{
+		if (!m_ullUnflushedSince)
+			return;
+
+		m_aullDelay[m_dwPolicy] += GetTickCount64() - m_ullUnflushedSince;
+		m_adwFlushes[m_dwPolicy]++;
+		m_ullUnflushedSince = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		static const char* names[DP_FLUSH_MAX] = { "service", "frame", "immediate" };
+
+		printf("[LOADER] Frame period %u ms\n", m_dwFramePeriod);
+
+		for (size_t p = 0; p < DP_FLUSH_MAX; p++)
+		{
+			if (m_adwFlushes[p])
+				printf("[LOADER] Flush %s: %u msgs %u flushes, oldest message waited %u ms on average\n", names[p], m_adwMessages[p], m_adwFlushes[p], (DWORD)(m_aullDelay[p] / m_adwFlushes[p]));
+		}
+#endif
+	}
+
+private:
+	DWORD m_dwPolicy;
+	ULONGLONG m_ullUnflushedSince;
+	ULONGLONG m_ullFrameStart;
+	DWORD m_dwFramePeriod;
+	bool m_bInFrame;
+	ULONGLONG m_aullDelay[DP_FLUSH_MAX];
+	DWORD m_adwMessages[DP_FLUSH_MAX];
+	DWORD m_adwFlushes[DP_FLUSH_MAX];
+};
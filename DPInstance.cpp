@@ -9,22 +9,83 @@
 #include "Globals.h"
 #include "DPMsg.h"
 
-#define ENET_BUFFER_SIZE 1024
-#define FURFIGHTERS_PORT 24900U
+#define DP_PLAYER_BANDWIDTH (64 * 1024) // expected bytes per second of a single player
+#define DP_BURST_TIME 500 // ms of traffic that the socket buffers must hold
+#define DP_MAX_WAITING_DATA (1024 * 1024) // incoming data that enet can hold for a single peer
+#define DP_MAX_MESSAGE_SIZE DP_RESUME_LOG_BYTES // largest game message, a guaranteed one can still be replayed after a resume
+#define DP_MAX_PACKET_SIZE (DP_MAX_MESSAGE_SIZE + 4096) // room for the headers added by the relay, compression and delta
+
+#define DP_PEER_MAX_PENDING (64 * 1024) // data queued in enet after a peer is congested
+#define DP_PEER_MIN_PENDING (2 * 1024)
+#define DP_PEER_PENDING_TIME 25 // ms of traffic at the pacing rate that can be queued in enet, more only delays the next messages
+#define DP_PEER_MAX_QUEUED (256 * 1024) // data waiting in the scheduler after Send returns DPERR_BUSY
+#define DP_PEER_DROP_QUEUED (1024 * 1024) // data waiting for an isolated peer before it's disconnected
+#define DP_SLOW_PEER_TIME 5000 // how much a peer can be congested before it's isolated
+#define DP_HOST_SEND_BUDGET (64 * 1024) // bytes handed to enet for all the peers in a service tick
+#define DP_DRR_QUANTUM 4096
 #define ENET_SERVICE_TIME 1000
 
-#define TIMEOUT1 32
-#define TIMEOUT2 5000
-#define TIMEOUT3 10000
+#define RESUME_GRACE_TIME 15000
+#define MIGRATE_RESUME_TIME 5000 // how much we try to resume before giving up on the host
+#define MIGRATE_REJOIN_TIME 10000
 
-enum ENetChannels
+/*!
+* @brief Checks if a message is part of the session handshake (not counted for resumption)
+*/
+static bool IsSessionControl(BYTE type)
+{
+	return type == DPMSG_TYPE_NEWID || type == DPMSG_TYPE_CALL_NEWID || type == DPMSG_TYPE_GAME_INFO || type == DPMSG_TYPE_RESUME || type == DPMSG_TYPE_RESUME_ACK || type == DPMSG_TYPE_REJOIN || type == DPMSG_TYPE_DICTIONARY;
+}
+
+static int SocketBufferSize(DWORD players)
+{
+	auto size = (ULONGLONG)players * DP_PLAYER_BANDWIDTH * DP_BURST_TIME / 1000;
+
+	if (size < ENET_HOST_BUFFER_SIZE_MIN)
+		return ENET_HOST_BUFFER_SIZE_MIN;
+	else if (size > ENET_HOST_BUFFER_SIZE_MAX)
+		return ENET_HOST_BUFFER_SIZE_MAX;
+
+	return (int)size;
+}
+
+static ENetHost* CreateHost(const ENetAddress* address, size_t peerCount, DWORD players, DPFirewall* firewall)
+{
+	auto host = enet_host_create(address, peerCount, ENET_CHANNEL_MAX, 0, 0, SocketBufferSize(players));
+
+	if (host)
+	{
+		enet_socket_set_option(host->socket, ENET_SOCKOPT_DONTFRAGMENT, 1); // oversized mtu probes must be dropped, not fragmented
+		host->maximumWaitingData = DP_MAX_WAITING_DATA;
+		host->maximumPacketSize = DP_MAX_PACKET_SIZE;
+		enet_host_congestion_control(host, Globals::Get()->NetCongestionControl); // pace before the uplink starts queueing
+
+		if (Globals::Get()->NetChecksum) // used with the peers that have it on too
+			enet_host_set_checksum_callback(host, enet_crc32c);
+
+		firewall->SetTrustLoopback(Globals::Get()->NetTrustLoopback);
+		firewall->SetCookies(Globals::Get()->NetFirewallCookie);
+		firewall->Install(host);
+	}
+
+	return host;
+}
+
+static ULONGLONG NewResumeToken()
 {
-	ENET_CHANNEL_NORMAL,
-	ENET_CHANNEL_CHAT,
-	ENET_CHANNEL_MAX,
-};
+	GUID g;
+	ULONGLONG r = 0;
+
+	while (r == 0)
+	{
+		CoCreateGuid(&g);
+		r = *(ULONGLONG*)&g ^ *((ULONGLONG*)&g + 1);
+	}
+
+	return r;
+}
 
-DPInstance::DPInstance(void)
+DPInstance::DPInstance(void) : m_context(Globals::Get()->NetArenaSize), m_pathMtu(ENET_CHANNEL_NORMAL), m_sendTracker(m_vMessages), m_resumeLog(DP_RESUME_LOG_PACKETS, DP_RESUME_LOG_BYTES)
 {
 	m_pHost = nullptr;
 	m_szGameName = "";
@@ -33,12 +94,37 @@ DPInstance::DPInstance(void)
 	m_bConnected = false;
 	m_pClientPeer = nullptr;
 	m_dwFlags = 0;
-
-	enet_initialize();
-
+	m_bResuming = false;
+	m_ullResumeDeadline = 0;
+	m_ullResumeToken = 0;
+	memset(m_adwReceived, 0, sizeof(m_adwReceived));
+	m_dwNextId = 1;
+	m_nDrrStart = 0;
+	m_bCanMigrate = false;
+	m_bMigrating = false;
+	m_ullMigrateDeadline = 0;
+	m_flushPolicy.SetPolicy(Globals::Get()->NetFlushPolicy);
+	m_bFec = Globals::Get()->NetFec;
+	m_dwHostDict = 0;
+	m_bDictTrain = Globals::Get()->NetDictTrain;
+	m_bDelta = Globals::Get()->NetDelta;
+	m_pRelayParent = nullptr;
+	m_dwRelayParent = DP_RELAY_HOST;
+	m_bRelaySynced = false;
+	m_bRelayHost = false;
+	m_bHostMsgFlags = false;
+	m_spectatorRing.SetSize(Globals::Get()->NetSpectatorBuffer);
+	m_firewall.SetRendezvous(&m_rendezvous);
+
+	m_szDictPath = Globals::Get()->GameDiskPath;
+	m_szDictPath = m_szDictPath.substr(0, m_szDictPath.find_last_of(L"\\/") + 1) + DP_DICT_FILE;
+
+	if (m_compressor.Load(m_szDictPath.c_str()))
+	{
 #ifdef _DEBUG
-	printf("[LOADER] Enet initialization\n");
+		printf("[LOADER] Loaded compression dictionary %08x\n", m_compressor.GetId());
 #endif
+	}
 }
 
 DPInstance::~DPInstance(void)
@@ -54,8 +140,8 @@ DPInstance::~DPInstance(void)
 		{ // SERVER
 			for (const auto& p : m_vPlayers)
 			{
-				p.second->ForceDisconnect();
-				enet_peer_reset(p.second->GetPeer());
+				if (p.second->GetPeer()) // not closed, the players time out like the client does
+					enet_peer_reset(p.second->GetPeer());
 			}
 		}
 		else
@@ -67,11 +153,6 @@ DPInstance::~DPInstance(void)
 		m_vPlayers.clear();
 		enet_host_destroy(m_pHost);
 	}
-
-#ifdef _DEBUG
-	printf("[LOADER] Enet destruction\n");
-#endif
-	enet_deinitialize();
 }
 
 HRESULT DPInstance::AddPlayerToGroup(DPID idGroup, DPID idPlayer)
@@ -90,7 +171,7 @@ HRESULT DPInstance::EnumSessions(LPDPSESSIONDESC2 lpsd, DWORD dwTimeout, LPDPENU
 #ifdef _DEBUG
 	printf("[LOADER] Start enum session %s:%d\n", addr, m_eConnectAddr.port);
 #endif
-	m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, 0);
+	m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, ENET_CONNECT_ENUM);
 
 	if (!m_pClientPeer)
 		return DPERR_INVALIDOBJECT;
@@ -147,41 +228,69 @@ HRESULT DPInstance::GetCaps(LPDPCAPS lpDPCaps, DWORD dwFlags)
 	lpDPCaps->dwSize = sizeof(DPCAPS);
 	lpDPCaps->dwFlags = 0;
 
-	if (m_bHost)
+	if (m_bHost || m_bRelayHost)
 		lpDPCaps->dwFlags |= DPCAPS_ISHOST;
 
-	lpDPCaps->dwMaxBufferSize = ENET_BUFFER_SIZE;
+	lpDPCaps->dwMaxBufferSize = DP_MAX_MESSAGE_SIZE;
 	lpDPCaps->dwMaxQueueSize = 0;
 	lpDPCaps->dwMaxPlayers = m_dwMaxPlayers;
 	lpDPCaps->dwHundredBaud = 24;
 	lpDPCaps->dwLatency = 0;
 	lpDPCaps->dwMaxLocalPlayers = m_dwMaxPlayers;
-	lpDPCaps->dwTimeout = 0;
+	lpDPCaps->dwTimeout = TIMEOUT3;
+
+	if (m_pHost)
+	{ // report what the connected peers are really using
+		DWORD peers = 0, rtt = 0, timeout = 0;
+
+		for (size_t i = 0; i < m_pHost->peerCount; i++)
+		{
+			auto peer = &m_pHost->peers[i];
+
+			if (peer->state != ENET_PEER_STATE_CONNECTED)
+				continue;
+
+			peers++;
+			rtt += enet_peer_get_rtt(peer);
+
+			if (peer->timeoutMaximum > timeout)
+				timeout = peer->timeoutMaximum;
+		}
+
+		if (peers)
+		{
+			lpDPCaps->dwLatency = rtt / peers / 2;
+			lpDPCaps->dwTimeout = timeout;
+		}
+	}
 
 	return DP_OK;
 }
 
 HRESULT DPInstance::SendEx(DPID idFrom, DPID idTo, DWORD dwFlags, LPVOID lpData, DWORD dwDataSize, DWORD dwPriority, DWORD dwTimeout, LPVOID lpContext, LPDWORD lpdwMsgID)
 {
-	HRESULT hr = Send(idFrom, idTo, dwFlags, lpData, dwDataSize);
+	if (!(dwFlags & DPSEND_ASYNC) || (dwFlags & DPSEND_NOSENDCOMPLETEMSG))
+		return Send(idFrom, idTo, dwFlags, lpData, dwDataSize);
 
-	if (FAILED(hr))
-		return hr;
+	if (dwDataSize > DP_MAX_MESSAGE_SIZE)
+		return DPERR_SENDTOOBIG;
 
-	if (dwFlags & DPSEND_ASYNC)
-	{
-		if (!(dwFlags & DPSEND_NOSENDCOMPLETEMSG))
-		{
-			if (lpdwMsgID)
-				*lpdwMsgID = m_vMessages.size() + 1; // unused operation here
+	auto pk = CreateGamePacket(idFrom, idTo, dwFlags, lpData, dwDataSize);
+	auto id = m_sendTracker.Track(pk, idFrom, idTo, dwFlags, dwPriority, dwTimeout, lpContext);
 
-			auto msg = std::make_shared<DPMsg>(DPMsg::CreateSendComplete(idFrom, idTo, dwFlags, dwPriority, dwTimeout, lpContext, 0, DP_OK, 0), true);
-			m_vMessages.push_back(msg); // Add internal msg
-			return DPERR_PENDING;
-		}
+	HRESULT hr = SendGamePacket(idFrom, idTo, dwFlags, pk, dwPriority, dwTimeout);
+
+	if (FAILED(hr))
+	{ // nothing was sent, so no completion
+		m_sendTracker.Forget(id);
+		enet_packet_destroy(pk);
+		return hr;
 	}
 
-	return hr;
+	if (lpdwMsgID)
+		*lpdwMsgID = id;
+
+	return DPERR_PENDING;
 }
 
 HRESULT DPInstance::SendChatMessage(DPID idFrom, DPID idTo, DWORD dwFlags, LPDPCHAT lpChatMessage)
@@ -201,17 +310,17 @@ HRESULT DPInstance::SendChatMessage(DPID idFrom, DPID idTo, DWORD dwFlags, LPDPC
 				return DPERR_INVALIDPLAYER;
 			}
 
-			enet_peer_send(p->second->GetPeer(), ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
+			SendToPlayer(p->second, ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
 		}
 		else
-			enet_host_broadcast(m_pHost, ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
+			Broadcast(ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
 	}
 	else
 	{
 		if (!m_pClientPeer)
 			return DPERR_CONNECTIONLOST;
 
-		enet_peer_send(m_pClientPeer, ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
+		SendToHost(ENET_CHANNEL_CHAT, DPMsg::ChatPacket(idFrom, idTo, dwFlags & DPSEND_GUARANTEED, lpChatMessage));
 	}
 
 	return DP_OK;
@@ -226,6 +335,26 @@ HRESULT DPInstance::SetSessionDesc(LPDPSESSIONDESC2 lpSessDesc, DWORD dwFlags)
 }
 
 HRESULT DPInstance::Send(DPID idFrom, DPID idTo, DWORD dwFlags, LPVOID lpData, DWORD dwDataSize)
+{
+	if (dwDataSize > DP_MAX_MESSAGE_SIZE)
+		return DPERR_SENDTOOBIG;
+
+	if (idTo != DPID_ALLPLAYERS && IsLocalPlayer(idTo))
+	{ // never leaves the process, no packet to build
+		DeliverLocal(idFrom, idTo, (dwFlags & DPSEND_GUARANTEED) != 0, lpData, dwDataSize);
+		return DP_OK;
+	}
+
+	auto pk = CreateGamePacket(idFrom, idTo, dwFlags, lpData, dwDataSize);
+	HRESULT hr = SendGamePacket(idFrom, idTo, dwFlags, pk, 0, 0);
+
+	if (FAILED(hr))
+		enet_packet_destroy(pk);
+
+	return hr;
+}
+
+ENetPacket* DPInstance::CreateGamePacket(DPID idFrom, DPID idTo, DWORD dwFlags, LPVOID lpData, DWORD dwDataSize)
 {
 	DPMsg msg(idFrom, idTo, DPMSG_TYPE_GAME);
 	msg.AddToSerialize(dwDataSize);
@@ -245,43 +374,240 @@ HRESULT DPInstance::Send(DPID idFrom, DPID idTo, DWORD dwFlags, LPVOID lpData, D
 		printf("\n");
 #endif
 	}
-	
+
+	auto pmng = (dwFlags & DPSEND_GUARANTEED) ? ENET_PACKET_FLAG_RELIABLE : 0;
+#if 1 // test
+	if (idTo == 0)
+		pmng = ENET_PACKET_FLAG_RELIABLE;
+#endif
+	if (dwFlags & DPSEND_GUARANTEED)
+		msg.SetFlags(DPMSG_FLAG_GUARANTEED); // the packet of a broadcast is reliable even when the message is not
+
+	return msg.Serialize(pmng);
+}
+
+HRESULT DPInstance::SendGamePacket(DPID idFrom, DPID idTo, DWORD dwFlags, ENetPacket* pk, DWORD dwPriority, DWORD dwTimeout)
+{
+	// updates that are not guaranteed can be merged when the peer is lagging
+	DWORD key = (dwFlags & DPSEND_GUARANTEED) ? 0 : (idFrom ? idFrom : DPID_SYSMSG);
+
 	if (m_bHost)
 	{
 		if (idTo == 0)
 		{
-			auto pmng = (dwFlags & DPSEND_GUARANTEED) ? ENET_PACKET_FLAG_RELIABLE : 0;
-#if 1 // test
-			pmng = ENET_PACKET_FLAG_RELIABLE;
-#endif
-			enet_host_broadcast(m_pHost, ENET_CHANNEL_NORMAL, msg.Serialize(pmng));
+			BroadcastLocal(idFrom, pk);
+
+			for (const auto& p : m_vPlayers)
+			{
+				if (p.second->IsLocal() || p.second->IsSpecator())
+					continue;
+
+				auto& s = p.second->GetScheduler();
+
+				if (key && s.IsIsolated())
+					continue; // do not make a slow peer even slower
+
+				s.Push(pk, ENET_CHANNEL_NORMAL, dwPriority, dwTimeout, key);
+			}
+
+			if (!m_relayTree.IsEmpty())
+				Relay(ENET_CHANNEL_NORMAL, pk); // the spectators get it through the relay tree, paced by the spectator buffer
+
+			if (pk->referenceCount == 0)
+			{ // nobody to deliver to
+				pk->flags |= ENET_PACKET_FLAG_SENT;
+				enet_packet_destroy(pk);
+			}
 		}
-		else if (idTo != 1)
+		else
 		{
 			auto p = m_vPlayers.find(idTo);
 
 			if (p == m_vPlayers.end())
 				return DPERR_INVALIDPLAYER;
 
-			enet_peer_send(p->second->GetPeer(), ENET_CHANNEL_NORMAL, msg.Serialize((dwFlags & DPSEND_GUARANTEED) ? ENET_PACKET_FLAG_RELIABLE : 0));
-		}
-		else
-		{ // send msg to self
-			auto sMsg = std::make_shared<DPMsg>(msg.Serialize(0), true);
-			m_vMessages.push_back(sMsg);
+			if (!p->second->IsLocal())
+			{
+				if (p->second->GetScheduler().GetQueuedBytes() >= DP_PEER_MAX_QUEUED)
+					return DPERR_BUSY;
+
+				p->second->GetScheduler().Push(pk, ENET_CHANNEL_NORMAL, dwPriority, dwTimeout, key);
+			}
+			else
+			{ // send msg to self
+				DeliverLocal(idFrom, idTo, pk);
+
+				// delivered, release the original so the send completes now and not when the queue is cleared
+				pk->flags |= ENET_PACKET_FLAG_SENT;
+				enet_packet_destroy(pk);
+			}
 		}
 	}
 	else
 	{
+		if (idTo != DPID_ALLPLAYERS && IsLocalPlayer(idTo))
+		{ // another player of ours, the host would never send it back
+			DeliverLocal(idFrom, idTo, pk);
+
+			pk->flags |= ENET_PACKET_FLAG_SENT;
+			enet_packet_destroy(pk);
+			return DP_OK;
+		}
+
 		if (!m_pClientPeer)
 			return DPERR_NOCONNECTION;
 
-		enet_peer_send(m_pClientPeer, ENET_CHANNEL_NORMAL, msg.Serialize((dwFlags & DPSEND_GUARANTEED) ? ENET_PACKET_FLAG_RELIABLE : 0));
+		if (m_hostScheduler.GetQueuedBytes() >= DP_PEER_MAX_QUEUED)
+			return DPERR_BUSY;
+
+		if (idTo == DPID_ALLPLAYERS)
+			BroadcastLocal(idFrom, pk);
+
+		m_hostScheduler.Push(pk, ENET_CHANNEL_NORMAL, dwPriority, dwTimeout, key);
 	}
 
+	if (m_flushPolicy.OnSend(dwPriority))
+		Flush();
+
 	return DP_OK;
 }
 
+void DPInstance::Flush()
+{
+	if (!m_pHost)
+		return;
+
+	DrainSchedulers();
+	enet_host_flush(m_pHost);
+	m_flushPolicy.OnFlush();
+}
+
+void DPInstance::ExpireSchedulers()
+{ // the tracked sends that timed out complete when their packet is released
+	m_hostScheduler.Expire();
+
+	for (const auto& p : m_vPlayers)
+		p.second->GetScheduler().Expire();
+}
+
+size_t DPInstance::GetPendingCap(ENetPeer* peer)
+{ // with congestion control the data queued in enet waits for the pacing, the messages queued after it wait even more
+	size_t cap = (size_t)enet_peer_get_pacing_rate(peer) * DP_PEER_PENDING_TIME / 1000;
+
+	if (cap == 0 || cap > DP_PEER_MAX_PENDING)
+		return DP_PEER_MAX_PENDING;
+
+	return cap < DP_PEER_MIN_PENDING ? DP_PEER_MIN_PENDING : cap;
+}
+
+void DPInstance::DrainSchedulers()
+{
+	if (!m_bHost)
+	{
+		if (!m_pClientPeer)
+			return;
+
+		m_hostScheduler.SetPending(enet_peer_get_pending_data(m_pClientPeer), GetPendingCap(m_pClientPeer));
+
+		if (!m_hostScheduler.IsCongested())
+		{
+			auto room = m_hostScheduler.GetPendingCap() - m_hostScheduler.GetPending();
+			m_hostScheduler.Drain(room < DP_SCHEDULER_BUDGET ? room : DP_SCHEDULER_BUDGET, [this](ENetPacket* pk, uint8_t channel) { SendToHost(channel, pk); });
+		}
+
+		return;
+	}
+
+	std::vector<std::shared_ptr<DPPlayer>> active;
+
+	for (const auto& p : m_vPlayers)
+	{
+		auto player = p.second;
+		auto& s = player->GetScheduler();
+
+		if (player->IsLocal())
+			continue;
+
+		if (!player->GetPeer())
+		{ // suspended, everything goes to the resume log
+			s.Drain(SIZE_MAX, [this, &player](ENetPacket* pk, uint8_t channel) { SendToPlayer(player, channel, pk); });
+			continue;
+		}
+
+		s.SetPending(enet_peer_get_pending_data(player->GetPeer()), GetPendingCap(player->GetPeer()));
+
+		if (s.IsCongested() && !s.IsIsolated() && s.GetCongestedTime() >= DP_SLOW_PEER_TIME)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Player %u is too slow, isolating it (%u bytes queued)\n", player->GetId(), (DWORD)s.GetQueuedBytes());
+#endif
+			s.SetIsolated(true);
+		}
+		else if (!s.IsCongested() && s.IsIsolated())
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Player %u caught up\n", player->GetId());
+#endif
+			s.SetIsolated(false);
+		}
+
+		if (s.IsIsolated() && s.GetQueuedBytes() >= DP_PEER_DROP_QUEUED)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Player %u cannot keep up with the session, disconnecting it\n", player->GetId());
+#endif
+			s.Dump(player->GetId());
+			s.Clear();
+			enet_peer_disconnect(player->GetPeer(), 0);
+			continue;
+		}
+
+		if (!s.IsCongested() && !s.IsEmpty())
+			active.push_back(player);
+	}
+
+	if (active.empty())
+		return;
+
+	// deficit round robin, starting from a different peer every tick
+	size_t budget = DP_HOST_SEND_BUDGET;
+	size_t start = m_nDrrStart++ % active.size();
+	bool more = true;
+
+	while (budget && more)
+	{
+		more = false;
+
+		for (size_t i = 0; i < active.size() && budget; i++)
+		{
+			auto& player = active[(start + i) % active.size()];
+			auto& s = player->GetScheduler();
+			size_t size;
+
+			if (s.GetPending() >= s.GetPendingCap() || (size = s.NextSize()) == 0)
+			{
+				s.SetDeficit(0);
+				continue;
+			}
+
+			s.SetDeficit(s.GetDeficit() + DP_DRR_QUANTUM);
+
+			while (size && size <= s.GetDeficit() && s.GetPending() < s.GetPendingCap())
+			{
+				s.SendNext([this, &player](ENetPacket* pk, uint8_t channel) { SendToPlayer(player, channel, pk); });
+				s.SetDeficit(s.GetDeficit() - size);
+				budget = size >= budget ? 0 : budget - size;
+				size = budget ? s.NextSize() : 0;
+			}
+
+			if (size)
+				more = true; // still something to send
+			else if (s.IsEmpty())
+				s.SetDeficit(0);
+		}
+	}
+}
+
 HRESULT DPInstance::CreateGroup(LPDPID lpidGroup, LPDPNAME lpGroupName, LPVOID lpData, DWORD dwDataSize, DWORD dwFlags)
 {
 #ifdef _DEBUG
@@ -292,9 +618,12 @@ HRESULT DPInstance::CreateGroup(LPDPID lpidGroup, LPDPNAME lpGroupName, LPVOID l
 
 HRESULT DPInstance::Receive(LPDPID lpidFrom, LPDPID lpidTo, DWORD dwFlags, LPVOID lpData, LPDWORD lpdwDataSize)
 {
+	if (m_flushPolicy.OnReceive() && m_pHost)
+		Flush(); // new frame, send what the game queued in the last one
+
 	Service(0); // Service enet then dispatch the messages
 
-	auto a = Globals::Get()->TheArena;
+	auto a = m_context.GetArena();
 
 	// we can't get the thing otherwise
 	//if (!m_bConnected && !m_bHost)
@@ -344,7 +673,7 @@ HRESULT DPInstance::Receive(LPDPID lpidFrom, LPDPID lpidTo, DWORD dwFlags, LPVOI
 
 		if (it->GetType() == DPMSG_TYPE_SYSTEM)
 		{
-			auto ret = it->FixSysMessage(lpData, lpdwDataSize);
+			auto ret = it->FixSysMessage(lpData, lpdwDataSize, a);
 
 			if (ret != DP_OK)
 				return ret;
@@ -374,15 +703,17 @@ HRESULT DPInstance::Receive(LPDPID lpidFrom, LPDPID lpidTo, DWORD dwFlags, LPVOI
 				newPlayer->Create(msg->dpId, msg->dpnName.lpszShortNameA, msg->dpnName.lpszLongNameA, nullptr, nullptr, 0, false, false);
 				m_vPlayers.insert_or_assign(newPlayer->GetId(), newPlayer);
 			}
+			else if (*(DWORD*)lpData == DPSYS_HOST && !m_bHost) // The relay server made us the game host
+				m_bRelayHost = true;
 		}
 		else if (it->GetType() == DPMSG_TYPE_NEWID)
 		{
 			if (!m_bHost)
 			{
-				m_pClientPeer->data = (LPVOID) * (DPID*)it->Read2(sizeof(DPID));
+				m_pClientPeer->data = (LPVOID)(uintptr_t)*(DPID*)it->Read2(sizeof(DPID));
 
 #ifdef _DEBUG
-				printf("[LOADER] New peer id %d", (DPID)m_pClientPeer->data);
+				printf("[LOADER] New peer id %d", (DPID)(uintptr_t)m_pClientPeer->data);
 #endif
 			}
 
@@ -391,6 +722,7 @@ HRESULT DPInstance::Receive(LPDPID lpidFrom, LPDPID lpidTo, DWORD dwFlags, LPVOI
 		}
 		else if (it->GetType() == DPMSG_TYPE_GAME)
 		{
+			it->ResetRead(); // the game calls us again with a larger buffer after DPERR_BUFFERTOOSMALL
 			*lpdwDataSize = *(DWORD*)it->Read2(sizeof(DWORD));
 
 			if (lastSize < *lpdwDataSize)
@@ -412,6 +744,7 @@ HRESULT DPInstance::Receive(LPDPID lpidFrom, LPDPID lpidTo, DWORD dwFlags, LPVOI
 		return DP_OK;
 	}
 
+	m_flushPolicy.OnDrained();
 	return DPERR_NOMESSAGES;
 }
 
@@ -430,7 +763,13 @@ HRESULT DPInstance::DestroyPlayer(DPID idPlayer)
 #endif
 
 	if (m_bHost && p->IsHostMade()) // Tell all the other players that a player disconnected
-		enet_host_broadcast(m_pHost, ENET_CHANNEL_CHAT, DPMsg::DestroyPlayer(p));
+		Broadcast(ENET_CHANNEL_CHAT, DPMsg::DestroyPlayer(p));
+
+	if (m_bHost)
+		DetachSpectator(p);
+
+	if (m_bHost)
+		ReplicateSession();
 
 	p->Disconnect();
 
@@ -441,7 +780,7 @@ HRESULT DPInstance::CreatePlayer(LPDPID lpidPlayer, LPDPNAME lpPlayerName, HANDL
 {
 	if (!m_bHost)
 	{
-		if (dwFlags & DPPLAYER_SERVERPLAYER)
+		if ((dwFlags & DPPLAYER_SERVERPLAYER) && !m_bRelayHost)
 			return DPERR_CANTCREATEPLAYER;
 
 		if (!m_bConnected)
@@ -449,10 +788,10 @@ HRESULT DPInstance::CreatePlayer(LPDPID lpidPlayer, LPDPNAME lpPlayerName, HANDL
 	}
 
 	if (m_bHost)
-		*lpidPlayer = (DWORD)m_vPlayers.size() + 1;
+		*lpidPlayer = m_dwNextId++;
 	else
 	{ // CLIENT: Ask the network for a new player id
-		enet_peer_send(m_pClientPeer, ENET_CHANNEL_NORMAL, DPMsg::CallNewId(lpPlayerName));
+		SendToHost(ENET_CHANNEL_NORMAL, DPMsg::CallNewId(lpPlayerName, dwFlags & DPPLAYER_SPECTATOR));
 
 #ifdef _DEBUG
 		printf("[LOADER] Getting peer id from server...\n");
@@ -472,7 +811,7 @@ HRESULT DPInstance::CreatePlayer(LPDPID lpidPlayer, LPDPNAME lpPlayerName, HANDL
 
 			if (m_pClientPeer->data != 0)
 			{
-				*lpidPlayer = (DPID)m_pClientPeer->data;
+				*lpidPlayer = (DPID)(uintptr_t)m_pClientPeer->data;
 				break;
 			}
 		}
@@ -484,11 +823,12 @@ HRESULT DPInstance::CreatePlayer(LPDPID lpidPlayer, LPDPNAME lpPlayerName, HANDL
 
 	const auto player = std::make_shared<DPPlayer>();
 	player->Create(*lpidPlayer, lpPlayerName->lpszShortNameA, lpPlayerName->lpszLongNameA, hEvent, lpData, dwDataSize, dwFlags & DPPLAYER_SPECTATOR, dwFlags & DPPLAYER_SERVERPLAYER);
+	player->SetLocal(true);
 
 	if (m_bHost && player->IsHostMade())
 	{
 		// Tell all the other peers that a new player is online
-		enet_host_broadcast(m_pHost, ENET_CHANNEL_CHAT, DPMsg::NewPlayer(player, (DWORD)m_vPlayers.size()));
+		Broadcast(ENET_CHANNEL_CHAT, DPMsg::NewPlayer(player, (DWORD)m_vPlayers.size()));
 	}
 
 	m_vPlayers.insert_or_assign(*lpidPlayer, player); // Add it to our local player list
@@ -498,57 +838,132 @@ HRESULT DPInstance::CreatePlayer(LPDPID lpidPlayer, LPDPNAME lpPlayerName, HANDL
 
 void DPInstance::Service(uint32_t timeout)
 {
+	if (m_bHost)
+		CheckSuspendedPlayers();
+	else if (m_bResuming)
+		CheckResume();
+	else if (m_bMigrating)
+		CheckMigration();
+
+	m_timeoutPolicy.Update(m_pHost);
+	m_pathMtu.Update(m_pHost);
+	m_rendezvous.Update(m_pHost);
+	ExpireSchedulers();
+	UpdateFec();
+	UpdateDelta();
+
+	if (m_bHost && !m_relayTree.IsEmpty() && m_spectatorRing.NeedsCheckpoint())
+		Checkpoint();
+
+	PumpSpectators();
+
+	if (m_flushPolicy.GetPolicy() != DP_FLUSH_FRAME || m_flushPolicy.IsLate())
+	{ // in frame mode the game messages wait for the end of the frame
+		DrainSchedulers();
+		m_flushPolicy.OnFlush();
+	}
+	else if (!m_flushPolicy.HasUnflushed())
+		DrainSchedulers(); // what the last flush left in a congested queue waits only for the window, not for the next frame
+
+	m_shared.Flush(); // the reliable messages that found a ring full
+
+	if (m_vMessages.IsFull())
+	{ // the guaranteed messages cannot be dropped: acks, pings and timeouts go on, the new events wait in enet and in the rings until the game reads
+		if (m_pHost)
+			enet_host_service(m_pHost, nullptr, 0);
+
+		return;
+	}
+
 	ENetEvent evt;
-	if (enet_host_service(m_pHost, &evt, timeout))
+	int got;
+
+	if (!m_shared.IsActive())
+		got = enet_host_service(m_pHost, &evt, timeout);
+	else
+	{ // the socket is not watched while we sleep on the rings, sleep in short steps until the timeout (Open and Close wait for their handshakes)
+		auto deadline = GetTickCount64() + timeout;
+
+		while (!(got = enet_host_service(m_pHost, &evt, 0)) && !(got = m_shared.Receive(&evt)))
+		{
+			auto now = GetTickCount64();
+
+			if (now >= deadline)
+				break;
+
+			m_shared.Wait(deadline - now < DP_SHARED_WAIT ? (uint32_t)(deadline - now) : DP_SHARED_WAIT);
+		}
+	}
+
+	if (got)
 	{
 		switch (evt.type)
 		{
 		case ENET_EVENT_TYPE_DISCONNECT:
 		case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+			m_vPeerDict.erase(evt.peer);
+			m_shared.Remove(evt.peer);
+
+			if (m_vDelta.count(evt.peer))
+			{
+				m_vDelta[evt.peer].Dump((DPID)(uintptr_t)evt.peer->data);
+				m_vDelta.erase(evt.peer);
+			}
+
 			if (!m_bHost)
 			{ // CLIENT
-#ifdef _DEBUG
-				printf("[LOADER] Disconnected! (timeout? %d)\n", evt.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT);
-#endif
+				if (m_pClientPeer && evt.peer != m_pClientPeer)
+				{
+					OnRelayDisconnect(evt.peer);
+					break;
+				}
 
-				enet_peer_reset(m_pClientPeer);
-				m_pClientPeer = nullptr;
-				m_bConnected = false;
-				m_vMessages.clear();
+				DPTimeoutPolicy::LogDisconnect(evt);
 
-				DPMSG_SESSIONLOST msg2;
-				msg2.dwType = DPSYS_SESSIONLOST;
+				if (!m_pClientPeer)
+					break; // session already lost
 
-				auto msg = std::make_shared<DPMsg>(0, 0, DPMSG_TYPE_SYSTEM);
-				msg->AddToSerialize(msg2);
+				if (m_bMigrating)
+				{
+					BeginMigration(); // the new host might not be ready yet
+					break;
+				}
+
+				if (m_bResuming || (evt.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT && m_ullResumeToken != 0))
+				{
+					BeginResume(); // transient failure, try to get our slot back
+					break;
+				}
+
+				if (m_bCanMigrate)
+				{
+					Migrate(); // the host left the game
+					break;
+				}
 
-				// Remove all messages and push the session lost one, telling the app the we lost the connection				m_vMessages.clear();
-				m_vMessages.push_back(msg);
+				SessionLost();
 			}
 			else
 			{ // SERVER
 				if (evt.peer->data) // authenticated player
 				{
-					auto id = (DPID)evt.peer->data;
+					auto id = (DPID)(uintptr_t)evt.peer->data;
 
-#ifdef _DEBUG
-					printf("[LOADER] Peer %d disconnected! (timeout? %d)\n", id, evt.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT);
-#endif
-
-					auto it = m_vPlayers.find(id);
+					DPTimeoutPolicy::LogDisconnect(evt);
 
-					if (it == m_vPlayers.end())
-						break; // how?
+					evt.peer->data = nullptr; // the peer slot can be reused by a new connection
 
-					auto p = it->second;
-
-					// tell all the peers that a player disconnected
+					auto it = m_vPlayers.find(id);
 
-					auto r = std::make_shared<DPMsg>(DPMsg::DestroyPlayer(p), true);
+					if (it == m_vPlayers.end() || it->second->GetPeer() != evt.peer)
+						break; // how? (or an old connection of a resumed player)
 
-					m_vMessages.push_back(r); // tell ourself that someone died
+					if (evt.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT)
+						SuspendPlayer(it->second); // give the player some time to come back
+					else
+						DestroyRemotePlayer(it->second);
 
-					enet_host_broadcast(m_pHost, ENET_CHANNEL_CHAT, DPMsg::DestroyPlayer(p));
+					ReplicateSession();
 				}
 
 				break;
@@ -559,12 +974,60 @@ void DPInstance::Service(uint32_t timeout)
 		case ENET_EVENT_TYPE_CONNECT:
 			if (!m_bHost)
 			{
+				if (m_pClientPeer && evt.peer != m_pClientPeer)
+				{
+					if (evt.peer == m_pRelayParent)
+					{
+#ifdef _DEBUG
+						printf("[LOADER] Connected to the relay parent %u\n", m_dwRelayParent);
+#endif
+					}
+					else if ((evt.data == ENET_CONNECT_RELAY || evt.data == ENET_CONNECT_RELAY_CATCHUP) && m_vRelayChildren.size() < DP_RELAY_FANOUT)
+					{ // a spectator that wants our stream
+						m_vRelayChildren.push_back(evt.peer);
+						m_spectatorRing.AddReader((uintptr_t)evt.peer, evt.data == ENET_CONNECT_RELAY_CATCHUP, 0);
+						PumpSpectators();
+					}
+					else
+						enet_peer_disconnect(evt.peer, 0);
+
+					break;
+				}
+
+				// tell the host which dictionary we have, it goes before anything else on the channel
+				m_dwHostDict = 0;
+				m_hostDelta.Dump(0);
+				m_hostDelta.Reset();
+
+				if (m_compressor.GetId())
+					enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::Dictionary(m_compressor.GetId()));
+
+				if (m_bResuming)
+				{
+#ifdef _DEBUG
+					printf("[LOADER] Reconnected, resuming session...\n");
+#endif
+					enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::Resume((DPID)(uintptr_t)evt.peer->data, m_ullResumeToken, m_adwReceived));
+					break;
+				}
+				else if (m_bMigrating)
+				{
+#ifdef _DEBUG
+					printf("[LOADER] Connected to the new host, rejoining...\n");
+#endif
+					enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::Rejoin((DPID)(uintptr_t)evt.peer->data, m_ullResumeToken));
+					break;
+				}
+
 #ifdef _DEBUG
 				printf("[LOADER] Client connected\n");
 #endif
 				m_bConnected = true;
+
+				if (Globals::Get()->NetSharedMemory)
+					m_shared.Offer(evt.peer);
 			}
-			else if (evt.data == 0)
+			else if (evt.data == ENET_CONNECT_ENUM)
 			{
 #ifdef _DEBUG
 				printf("[LOADER] Sending game info to peer\n");
@@ -579,10 +1042,13 @@ void DPInstance::Service(uint32_t timeout)
 #ifdef _DEBUG
 				printf("[LOADER] New peer connect\n");
 #endif
+				if (Globals::Get()->NetSharedMemory)
+					m_shared.Offer(evt.peer);
+
 				break; // Do not add this internal message to the queue
 			}
 
-			enet_peer_timeout(evt.peer, TIMEOUT1, TIMEOUT2, TIMEOUT3);
+			m_timeoutPolicy.Initial(evt.peer);
 
 			break;
 
@@ -594,81 +1060,1202 @@ void DPInstance::Service(uint32_t timeout)
 			printf("[LOADER] Received %u\n", evt.packet->dataLength);
 #endif
 
-			if (m_bHost)
-			{
-				// Setup peer id and send it back
-				if (msg->GetType() == DPMSG_TYPE_CALL_NEWID)
-				{
-					DPPlayerInfo* pInfo = (DPPlayerInfo*)msg->Read2(sizeof(DPPlayerInfo));
+			msg = Decompress(msg);
 
-					DPID id = (DPID)m_vPlayers.size() + 1;
-					enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::NewId(id));
-					evt.peer->data = (LPVOID)id; // set id which means the player is authenticated
+			if (msg)
+				msg = DecodeDelta(evt.peer, msg);
 
-#ifdef _DEBUG
-					printf("[LOADER] New peer id %u\n", id);
-#endif
+			if (!msg)
+				break; // corrupted, made with another dictionary, or the base of the delta was lost
 
-					for (const auto& pp : m_vPlayers)
-					{
-						auto pinfo = pp.second;
-						enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::NewPlayer(pinfo, (DWORD)m_vPlayers.size()));
-					}
+			if (msg->GetType() == DPMSG_TYPE_FEC_DATA || msg->GetType() == DPMSG_TYPE_FEC_PARITY)
+			{ // unwrap the game messages, rebuilding the lost ones
+				DPFec* fec = m_bHost ? (evt.peer->data ? &m_vFec[(DPID)(uintptr_t)evt.peer->data] : nullptr) : &m_hostFec;
 
-					auto pp = std::make_shared<DPPlayer>();
-					pp->Create(id, pInfo->name[0] ? pInfo->name : nullptr, pInfo->longName[0] ? pInfo->longName : nullptr, nullptr, pInfo->dwDataSize ? msg->Read2(pInfo->dwDataSize) : nullptr, pInfo->dwDataSize, false, false);
-					pp->SetPeer(evt.peer);
+				if (fec)
+				{
+					fec->Receive(*msg, [this, &evt](ENetPacket* pk) {
+						auto m = Decompress(std::make_shared<DPMsg>(pk, true));
 
-					auto sMsg = std::make_shared<DPMsg>(DPMsg::NewPlayer(pp, m_vPlayers.size()), true);
-					m_vMessages.push_back(sMsg);
+						if (m)
+							m = DecodeDelta(evt.peer, m);
 
+						if (m)
+							QueueReceived(evt.peer, m);
+					});
+				}
 
-					m_vPlayers.insert_or_assign(id, pp);
+				break; // Do not add this internal message to the queue
+			}
+			else if (msg->GetType() == DPMSG_TYPE_FEC_REPORT)
+			{ // the loss of what we send, as the peer sees it
+				DPFec* fec = m_bHost ? (evt.peer->data ? &m_vFec[(DPID)(uintptr_t)evt.peer->data] : nullptr) : &m_hostFec;
+
+				if (fec)
+					fec->Report(*msg);
+
+				break;
+			}
+			else if (msg->GetType() == DPMSG_TYPE_MTU_PROBE)
+			{ // the probe reached us unfragmented
+				DWORD mtu = 0;
+				msg->Read(mtu);
+				enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::MtuProbeAck(mtu));
+				break; // Do not add this internal message to the queue
+			}
+			else if (msg->GetType() == DPMSG_TYPE_MTU_PROBE_ACK)
+			{
+				DWORD mtu = 0;
+				msg->Read(mtu);
+				m_pathMtu.OnAck(evt.peer, mtu);
+				break; // Do not add this internal message to the queue
+			}
+			else if (msg->GetType() == DPMSG_TYPE_SHARED)
+			{
+				auto info = (DPSharedInfo*)msg->Read2(sizeof(DPSharedInfo));
+
+				if (info)
+					m_shared.OnMessage(evt.peer, *info);
+
+				break; // Do not add this internal message to the queue
+			}
+			else if (msg->GetType() == DPMSG_TYPE_DELTA_ACK)
+			{
+				(m_bHost ? m_vDelta[evt.peer] : m_hostDelta).OnAck(*msg);
+				break; // Do not add this internal message to the queue
+			}
+
+			if ((evt.packet->flags & ENET_PACKET_FLAG_RELIABLE) && !IsSessionControl(msg->GetType()))
+			{ // keep track of what we got, so only the missing packets are replayed on resume
+				if (!m_bHost)
+				{
+					if (evt.peer == m_pClientPeer) // not what the relay tree passes down
+						m_adwReceived[evt.channelID]++;
+				}
+				else if (evt.peer->data)
+				{
+					auto p = m_vPlayers.find((DPID)(uintptr_t)evt.peer->data);
+
+					if (p != m_vPlayers.end())
+						p->second->CountReceived(evt.channelID);
+				}
+			}
+
+			if (msg->GetType() == DPMSG_TYPE_RELAY)
+			{ // a broadcast of the host, passed down the relay tree
+				if (m_bHost)
+					break;
+
+				msg = ForwardRelay(evt.packet, *msg);
+
+				if (!msg)
+					break;
+			}
+			else if (!m_bHost && evt.peer != m_pClientPeer)
+				break; // only the broadcasts come from the relay tree
+
+			if (m_bHost)
+			{
+				// Setup peer id and send it back
+				if (msg->GetType() == DPMSG_TYPE_CALL_NEWID)
+				{
+					DPPlayerInfo* pInfo = (DPPlayerInfo*)msg->Read2(sizeof(DPPlayerInfo));
+
+					DPID id = m_dwNextId++;
+					auto pp = std::make_shared<DPPlayer>();
+					pp->Create(id, pInfo->name[0] ? pInfo->name : nullptr, pInfo->longName[0] ? pInfo->longName : nullptr, nullptr, pInfo->dwDataSize ? msg->Read2(pInfo->dwDataSize) : nullptr, pInfo->dwDataSize, (pInfo->dwFlags & DPPLAYER_SPECTATOR) != 0, false);
+					pp->SetPeer(evt.peer);
+					pp->SetResumeToken(NewResumeToken());
+
+					auto caps = (DWORD*)msg->Read2(sizeof(DWORD)); // not sent by the older builds
+					pp->SetMsgFlags(caps && (*caps & DP_CAPS_MSG_FLAGS));
+
+					SendToPeer(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::NewId(id, pp->GetResumeToken())); // behind what we already wrote to its ring
+					evt.peer->data = (LPVOID)(uintptr_t)id; // set id which means the player is authenticated
+
+#ifdef _DEBUG
+					printf("[LOADER] New peer id %u\n", id);
+#endif
+
+					if (!pp->IsSpecator())
+					{ // the spectators get the roster from a checkpoint, in line with the delayed broadcasts
+						for (const auto& ppi : m_vPlayers)
+						{
+							auto pinfo = ppi.second;
+							SendToPlayer(pp, ENET_CHANNEL_NORMAL, DPMsg::NewPlayer(pinfo, (DWORD)m_vPlayers.size()));
+						}
+					}
+
+					for (const auto& ppi : m_vPlayers)
+					{ // the other players must know it too, any of them can take our place
+						if (!ppi.second->IsLocal() && ppi.second->GetPeer() && !ppi.second->IsSpecator())
+							SendToPlayer(ppi.second, ENET_CHANNEL_CHAT, DPMsg::NewPlayer(pp, (DWORD)m_vPlayers.size()));
+					}
+
+					auto sMsg = std::make_shared<DPMsg>(DPMsg::NewPlayer(pp, m_vPlayers.size()), true);
+					m_vMessages.push_back(sMsg);
+
+					m_vPlayers.insert_or_assign(id, pp);
+					ReplicateSession();
+
+					if (pp->IsSpecator())
+						AttachSpectator(pp, true);
+
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_RELAY_ATTACH)
+				{ // a spectator lost its parent and is now fed by us
+					auto info = (DPRelayAttachInfo*)msg->Read2(sizeof(DPRelayAttachInfo));
+
+					if (info && evt.peer->data && m_relayTree.FallBack((DPID)(uintptr_t)evt.peer->data, info->parent))
+					{
+#ifdef _DEBUG
+						printf("[LOADER] Spectator %u lost the relay parent %u\n", (DPID)(uintptr_t)evt.peer->data, info->parent);
+#endif
+						m_spectatorRing.AddReader((DPID)(uintptr_t)evt.peer->data, false, Globals::Get()->NetSpectatorDelay);
+					}
+
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_DICTIONARY)
+				{
+					auto id = (DWORD*)msg->Read2(sizeof(DWORD));
+
+					if (id)
+						m_vPeerDict.insert_or_assign(evt.peer, *id);
+
+					if (m_compressor.GetId())
+						enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, DPMsg::Dictionary(m_compressor.GetId()));
 
 					break; // Do not add this internal message to the queue
 				}
+				else if (msg->GetType() == DPMSG_TYPE_RESUME)
+				{
+					ResumePlayer(evt.peer, (DPResumeInfo*)msg->Read2(sizeof(DPResumeInfo)));
+					ReplicateSession();
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_REJOIN)
+				{
+					RejoinPlayer(evt.peer, (DPMigrateRosterEntry*)msg->Read2(sizeof(DPMigrateRosterEntry)));
+					ReplicateSession();
+					break; // Do not add this internal message to the queue
+				}
+
+				if (IsSpectatorPeer(evt.peer) && (msg->GetType() == DPMSG_TYPE_GAME || msg->GetType() == DPMSG_TYPE_CHAT))
+					break; // spectators only watch the game
 			}
 			else
 			{
 				if (msg->GetType() == DPMSG_TYPE_NEWID)
 				{
-					evt.peer->data = (LPVOID)msg->Read2(sizeof(DPID)); // Assign the readed id
+					evt.peer->data = (LPVOID)(uintptr_t)*(DPID*)msg->Read2(sizeof(DPID)); // Assign the readed id
 					m_pClientPeer->data = evt.peer->data;
+
+					// From now on the session can be resumed
+					msg->Read(m_ullResumeToken);
+
+					auto caps = (DWORD*)msg->Read2(sizeof(DWORD)); // not sent by the older builds
+					m_bHostMsgFlags = caps && (*caps & DP_CAPS_MSG_FLAGS);
+					memset(m_adwReceived, 0, sizeof(m_adwReceived));
+					m_resumeLog.Reset();
+#ifdef _DEBUG
+					printf("[LOADER] Assigned peer id from server %u\n", (DPID)(uintptr_t)m_pClientPeer->data);
+#endif
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_DICTIONARY)
+				{
+					auto id = (DWORD*)msg->Read2(sizeof(DWORD));
+
+					if (id)
+						m_dwHostDict = *id;
+
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_RESUME_ACK)
+				{
+					auto info = (DPResumeAckInfo*)msg->Read2(sizeof(DPResumeAckInfo));
+
+					if (!info || info->accepted == DP_RESUME_REFUSED)
+					{
+#ifdef _DEBUG
+						printf("[LOADER] Session resume refused by the server\n");
+#endif
+						if (m_bResuming && m_bCanMigrate)
+							Migrate(); // the successor already took the address of the old host, the session goes on with it
+						else
+							SessionLost();
+
+						break;
+					}
+
+#ifdef _DEBUG
+					printf("[LOADER] Session %s\n", info->accepted == DP_RESUME_REJOINED ? "rejoined" : "resumed");
+#endif
+					m_bResuming = false;
+					m_bMigrating = false;
+					m_bHostMsgFlags = true; // the older builds do not resume
+					m_resumeLog.Replay(evt.peer, info->received); // after a rejoin this is only what we sent while migrating
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_MIGRATE_INFO)
+				{
+					auto info = (DPMigrateInfo*)msg->Read2(sizeof(DPMigrateInfo));
+
+					if (info)
+					{ // keep a copy of the session, so we can carry on if the host leaves
+						m_migrate = *info;
+						m_bCanMigrate = true;
+						m_gSession = info->session.session;
+						m_dwMaxPlayers = info->session.maxPlayers;
+						m_szGameName = info->session.sessionName;
+						memcpy_s(m_adwUser, sizeof(m_adwUser), info->session.user, sizeof(info->session.user));
+						m_dwFlags = info->session.flags;
+					}
+
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_RELAY_ATTACH)
+				{
+					auto info = (DPRelayAttachInfo*)msg->Read2(sizeof(DPRelayAttachInfo));
+
+					if (info)
+						OnRelayAttach(info);
+
+					break; // Do not add this internal message to the queue
+				}
+				else if (msg->GetType() == DPMSG_TYPE_MIGRATE_ROSTER)
+				{
+					auto count = (DWORD*)msg->Read2(sizeof(DWORD));
+
+					if (!count || *count > m_dwMaxPlayers || *count > msg->GetRawSize() / sizeof(DPMigrateRosterEntry))
+						break; // from the network, the size below would wrap on 32 bit
+
+					auto entries = (DPMigrateRosterEntry*)msg->Read2(*count * sizeof(DPMigrateRosterEntry));
+
+					if (entries)
+						m_vMigrateRoster.assign(entries, entries + *count);
+
+					break; // Do not add this internal message to the queue
+				}
+			}
+
+			if (msg->GetType() == DPMSG_TYPE_REMOTEINFO)
+			{
+				auto p = m_vPlayers.find(msg->GetFrom());
+
+				if (p != m_vPlayers.end())
+				{
+					DWORD len;
+					msg->Read(len);
+					p->second->SetRemoteData(msg->Read2(len), len);
+					break; // Do not add this internal message to the queue
+				}
+			}
+
+			QueueReceived(evt.peer, msg);
+			break;
+		}
+
+		case ENET_EVENT_TYPE_NONE:
+			break;
+		}
+	}
+}
+
+ENetPacket* DPInstance::CompressPacket(ENetPacket* pk, DWORD dwPeerDict)
+{
+	if (pk->dataLength <= DPMsg::GetHeaderSize() || pk->dataLength - DPMsg::GetHeaderSize() > UINT16_MAX)
+		return pk;
+
+	DPMsg msg(pk, false);
+
+	if (msg.GetType() != DPMSG_TYPE_GAME && msg.GetType() != DPMSG_TYPE_REMOTEINFO && msg.GetType() != DPMSG_TYPE_DELTA)
+		return pk;
+
+	if (m_bDictTrain && m_vDictSamples.size() < DP_DICT_MAX_SAMPLES && msg.GetType() != DPMSG_TYPE_DELTA)
+		m_vDictSamples.push_back(std::vector<BYTE>(msg.GetRaw(), msg.GetRaw() + msg.GetRawSize()));
+
+	std::vector<BYTE> packed;
+
+	if (!dwPeerDict || dwPeerDict != m_compressor.GetId() || !m_compressor.Compress(msg.GetRaw(), msg.GetRawSize(), packed))
+		return pk; // the peer cannot read it, or it does not pay off
+
+	BYTE type = msg.GetType();
+	WORD size = (WORD)msg.GetRawSize();
+
+	DPMsg out(msg.GetFrom(), msg.GetTo(), DPMSG_TYPE_COMPRESSED);
+	out.SetFlags(msg.GetFlags());
+	out.AddToSerialize(type);
+	out.AddToSerialize(size);
+	out.AddToSerialize(packed.data(), packed.size());
+	return ReplacePacket(pk, out.Serialize(pk->flags & ENET_PACKET_FLAG_RELIABLE));
+}
+
+ENetPacket* DPInstance::ReplacePacket(ENetPacket* pk, ENetPacket* out)
+{
+	if (pk->freeCallback && pk->referenceCount <= 1)
+	{ // the send completion follows the packet that reaches the wire
+		out->userData = pk->userData;
+		out->freeCallback = pk->freeCallback;
+		pk->freeCallback = nullptr;
+	}
+	else
+		pk->flags |= ENET_PACKET_FLAG_SENT;
+
+	if (pk->referenceCount == 0)
+		enet_packet_destroy(pk);
+
+	return out;
+}
+
+ENetPacket* DPInstance::EncodeDelta(ENetPacket* pk, DPDelta& delta)
+{
+	auto out = delta.Encode(pk);
+	return out ? ReplacePacket(pk, out) : pk;
+}
+
+std::shared_ptr<DPMsg> DPInstance::DecodeDelta(ENetPeer* peer, const std::shared_ptr<DPMsg>& msg)
+{
+	if (msg->GetType() != DPMSG_TYPE_DELTA)
+		return msg;
+
+	auto m = (m_bHost ? m_vDelta[peer] : m_hostDelta).Decode(*msg);
+
+#ifdef _DEBUG
+	if (!m)
+		printf("[LOADER] Cannot decode a delta message from %u\n", msg->GetFrom());
+#endif
+
+	return m;
+}
+
+void DPInstance::UpdateDelta()
+{
+	auto send = [](ENetPeer* peer) {
+		return [peer](ENetPacket* pk) {
+			if (enet_peer_send(peer, ENET_CHANNEL_NORMAL, pk) != 0)
+				enet_packet_destroy(pk);
+		};
+	};
+
+	if (!m_bHost)
+	{
+		if (m_pClientPeer && !m_bResuming && !m_bMigrating)
+			m_hostDelta.UpdateAcks(send(m_pClientPeer));
+
+		return;
+	}
+
+	for (auto& d : m_vDelta)
+		d.second.UpdateAcks(send(d.first));
+}
+
+std::shared_ptr<DPMsg> DPInstance::Decompress(const std::shared_ptr<DPMsg>& msg)
+{
+	if (msg->GetType() != DPMSG_TYPE_COMPRESSED)
+		return msg;
+
+	auto type = msg->Read2(sizeof(BYTE));
+	auto size = (WORD*)msg->Read2(sizeof(WORD));
+
+	if (!type || !size)
+		return nullptr;
+
+	auto packedSize = msg->GetRawSize() - sizeof(BYTE) - sizeof(WORD);
+	std::vector<BYTE> raw(*size);
+
+	if (!m_compressor.Decompress(msg->Read2(packedSize), packedSize, raw.data(), raw.size()))
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Cannot decompress a message from %u\n", msg->GetFrom());
+#endif
+		return nullptr;
+	}
+
+	DPMsg out(msg->GetFrom(), msg->GetTo(), *type);
+	out.SetFlags(msg->GetFlags());
+	out.AddToSerialize(raw.data(), raw.size());
+	return std::make_shared<DPMsg>(out.Serialize(msg->IsReliable() ? ENET_PACKET_FLAG_RELIABLE : 0), true);
+}
+
+void DPInstance::QueueReceived(ENetPeer* peer, const std::shared_ptr<DPMsg>& msg)
+{
+	bool flags = !m_bHost && (peer != m_pClientPeer || m_bHostMsgFlags); // the relay tree is made of our builds
+
+	if (peer->data != 0)
+	{
+		auto p = m_vPlayers[(DPID)(uintptr_t)peer->data];
+		if (p.get())
+		{
+			if (msg->GetTo() == p->GetId())
+				p->FireEvent(); // Fire handle event as specified by DirectPlay
+
+			flags = flags || (m_bHost && p->HasMsgFlags());
+		}
+	}
+
+	if (!flags)
+		msg->SetLegacyFlags();
+
+	m_vMessages.push_back(msg);
+}
+
+bool DPInstance::IsLocalPlayer(DPID id) const
+{
+	auto p = m_vPlayers.find(id);
+	return p != m_vPlayers.end() && p->second->IsLocal();
+}
+
+void DPInstance::DeliverLocal(DPID idFrom, DPID idTo, bool reliable, LPCVOID lpData, DWORD dwDataSize)
+{
+	m_vMessages.push_back(std::make_shared<DPMsg>(idFrom, idTo, reliable, lpData, dwDataSize, m_context.GetPool()));
+
+	auto p = m_vPlayers.find(idTo);
+
+	if (p != m_vPlayers.end())
+		p->second->FireEvent(); // Fire handle event as specified by DirectPlay
+}
+
+void DPInstance::DeliverLocal(DPID idFrom, DPID idTo, ENetPacket* pk)
+{ // a packet of CreateGamePacket, the payload is copied out of it
+	DPMsg msg(pk, false);
+	DWORD size = 0;
+	msg.Read(size);
+	DeliverLocal(idFrom, idTo, msg.IsGuaranteed(), msg.Read2(size), size);
+}
+
+void DPInstance::BroadcastLocal(DPID idFrom, ENetPacket* pk)
+{
+	for (const auto& p : m_vPlayers)
+	{ // every player but the one that sends, like DirectPlay does
+		if (p.second->IsLocal() && p.first != idFrom)
+			DeliverLocal(idFrom, p.first, pk);
+	}
+}
+
+void DPInstance::UpdateFec()
+{
+	if (!m_bFec)
+		return;
+
+	auto send = [](ENetPeer* peer) {
+		return [peer](ENetPacket* pk) {
+			if (enet_peer_send(peer, ENET_CHANNEL_NORMAL, pk) != 0)
+				enet_packet_destroy(pk);
+		};
+	};
+
+	if (!m_bHost)
+	{
+		if (m_pClientPeer && !m_bResuming && !m_bMigrating)
+			m_hostFec.Update(m_pClientPeer, send(m_pClientPeer));
+
+		return;
+	}
+
+	for (const auto& p : m_vPlayers)
+	{
+		if (!p.second->IsLocal() && p.second->GetPeer())
+			m_vFec[p.first].Update(p.second->GetPeer(), send(p.second->GetPeer()));
+	}
+}
+
+bool DPInstance::SendToPlayer(const std::shared_ptr<DPPlayer>& player, uint8_t channel, ENetPacket* pk)
+{
+	if (player->GetResumeToken() != 0)
+		player->GetResumeLog().Store(pk, channel); // as it is, the peer that gets the replay might not have our dictionary or delta streams
+
+	if (player->GetPeer() && m_shared.Send(player->GetPeer(), channel, pk))
+	{ // copied as it is, a peer on this machine has nothing to gain from the delta, the compression or the fec
+		if (pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+		return true;
+	}
+
+	if (player->GetPeer())
+	{
+		if (m_bDelta && channel == ENET_CHANNEL_NORMAL)
+			pk = EncodeDelta(pk, m_vDelta[player->GetPeer()]);
+
+		auto dict = m_vPeerDict.find(player->GetPeer());
+		pk = CompressPacket(pk, dict != m_vPeerDict.end() ? dict->second : 0);
+	}
+
+	if (m_bFec && channel == ENET_CHANNEL_NORMAL && player->GetPeer() && DPFec::CanProtect(pk))
+	{
+		auto peer = player->GetPeer();
+
+		if (m_vFec[player->GetId()].Protect(pk, [peer, channel](ENetPacket* out) { if (enet_peer_send(peer, channel, out) != 0) enet_packet_destroy(out); }))
+		{
+			pk->flags |= ENET_PACKET_FLAG_SENT; // handed to enet inside the fec message
+			if (pk->referenceCount == 0)
+				enet_packet_destroy(pk);
+			return true;
+		}
+	}
+
+	if (!player->GetPeer() || enet_peer_send(player->GetPeer(), channel, pk) != 0)
+	{
+		if (pk->referenceCount == 0) // still held by a scheduler otherwise
+			enet_packet_destroy(pk);
+		return player->IsSuspended(); // a suspended player will get it once resumed
+	}
+
+	return true;
+}
+
+void DPInstance::Broadcast(uint8_t channel, ENetPacket* pk)
+{
+	for (const auto& p : m_vPlayers)
+	{
+		if (p.second->GetResumeToken() != 0 && !p.second->IsSpecator()) // remote player
+			p.second->GetResumeLog().Store(pk, channel);
+	}
+
+	if (m_relayTree.IsEmpty() && (channel != ENET_CHANNEL_NORMAL || !m_shared.IsActive()))
+	{
+		enet_host_broadcast(m_pHost, channel, pk);
+		return;
+	}
+
+	for (size_t i = 0; i < m_pHost->peerCount; i++)
+	{ // the spectators get it through the relay tree
+		auto peer = &m_pHost->peers[i];
+
+		if (peer->state == ENET_PEER_STATE_CONNECTED && !IsSpectatorPeer(peer) && !m_shared.Send(peer, channel, pk))
+			enet_peer_send(peer, channel, pk);
+	}
+
+	if (!m_relayTree.IsEmpty())
+		Relay(channel, pk);
+
+	if (pk->referenceCount == 0)
+		enet_packet_destroy(pk);
+}
+
+void DPInstance::Relay(uint8_t channel, ENetPacket* pk, BYTE flags)
+{
+	m_spectatorRing.Push(DPMsg::Relay(channel, pk, flags), channel, (flags & DP_RELAY_CHECKPOINT) != 0);
+	PumpSpectators();
+}
+
+void DPInstance::Checkpoint()
+{
+	for (const auto& p : m_vPlayers)
+	{
+		auto pk = DPMsg::NewPlayer(p.second, (DWORD)m_vPlayers.size());
+		Relay(ENET_CHANNEL_NORMAL, pk, DP_RELAY_CHECKPOINT);
+		enet_packet_destroy(pk);
+
+		if (p.second->GetRemoteDataSize())
+		{
+			pk = DPMsg::CreatePlayerRemote(p.second, true);
+			Relay(ENET_CHANNEL_NORMAL, pk, DP_RELAY_CHECKPOINT);
+			enet_packet_destroy(pk);
+		}
+	}
+}
+
+void DPInstance::PumpSpectators()
+{
+	if (!m_bHost)
+	{
+		m_spectatorRing.Pump(0, [](uintptr_t reader, ENetPacket* pk, uint8_t channel) { enet_peer_send((ENetPeer*)reader, channel, pk); });
+		return;
+	}
+
+	m_spectatorRing.Pump(Globals::Get()->NetSpectatorDelay, [this](uintptr_t reader, ENetPacket* pk, uint8_t channel)
+	{
+		auto p = m_vPlayers.find((DPID)reader);
+
+		if (p != m_vPlayers.end())
+			SendToPlayer(p->second, channel, pk);
+	});
+}
+
+bool DPInstance::IsSpectatorPeer(ENetPeer* peer) const
+{
+	if (!peer->data)
+		return false;
+
+	auto p = m_vPlayers.find((DPID)(uintptr_t)peer->data);
+	return p != m_vPlayers.end() && p->second->IsSpecator();
+}
+
+void DPInstance::AttachSpectator(const std::shared_ptr<DPPlayer>& player, bool catchUp)
+{
+	auto parent = m_relayTree.Attach(player->GetId());
+
+	if (parent == DP_RELAY_HOST)
+	{
+		if (catchUp && m_spectatorRing.NeedsCheckpoint())
+			Checkpoint();
+
+		m_spectatorRing.AddReader(player->GetId(), catchUp, Globals::Get()->NetSpectatorDelay);
+	}
+	else
+		m_spectatorRing.RemoveReader(player->GetId());
+
+	ENetAddress addr;
+	memset(&addr, 0, sizeof(addr));
+
+	if (parent != DP_RELAY_HOST)
+	{
+		auto p = m_vPlayers.find(parent);
+
+		if (p != m_vPlayers.end() && p->second->GetPeer())
+			addr = p->second->GetPeer()->address; // the spectators connect to the address they use with us
+	}
+
+#ifdef _DEBUG
+	printf("[LOADER] Spectator %u attached to %u\n", player->GetId(), parent);
+#endif
+
+	SendToPlayer(player, ENET_CHANNEL_NORMAL, DPMsg::RelayAttach(parent, addr));
+	PumpSpectators();
+}
+
+void DPInstance::DetachSpectator(const std::shared_ptr<DPPlayer>& player)
+{
+	if (!player->IsSpecator())
+		return;
+
+	m_spectatorRing.RemoveReader(player->GetId());
+
+	for (auto id : m_relayTree.Detach(player->GetId()))
+	{
+		auto p = m_vPlayers.find(id);
+
+		if (p != m_vPlayers.end())
+			AttachSpectator(p->second, false);
+	}
+}
+
+std::shared_ptr<DPMsg> DPInstance::ForwardRelay(ENetPacket* pk, DPMsg& msg)
+{
+	auto channel = msg.Read2(sizeof(uint8_t));
+	auto flags = msg.Read2(sizeof(BYTE));
+
+	if (!channel || !flags || *channel >= ENET_CHANNEL_MAX || msg.GetRawSize() - sizeof(uint8_t) - sizeof(BYTE) < DPMsg::GetHeaderSize())
+		return nullptr;
+
+	// a copy, the received packet is released with the message. It's kept even without children, a late one starts from our checkpoints
+	m_spectatorRing.Push(enet_packet_create(pk->data, pk->dataLength, pk->flags & ENET_PACKET_FLAG_RELIABLE), *channel, (*flags & DP_RELAY_CHECKPOINT) != 0);
+	PumpSpectators();
+
+	if (*flags & DP_RELAY_CHECKPOINT)
+	{
+		if (m_bRelaySynced)
+			return nullptr; // we already have the roster
+	}
+	else
+		m_bRelaySynced = true;
+
+	auto size = msg.GetRawSize() - sizeof(uint8_t) - sizeof(BYTE);
+	return std::make_shared<DPMsg>(enet_packet_create(msg.Read2(size), size, pk->flags & ENET_PACKET_FLAG_RELIABLE), true);
+}
+
+void DPInstance::OnRelayAttach(const DPRelayAttachInfo* info)
+{
+	if (m_pRelayParent && m_pRelayParent != m_pClientPeer)
+		enet_peer_disconnect(m_pRelayParent, 0);
+
+	m_dwRelayParent = info->parent;
+
+	if (info->parent == DP_RELAY_HOST)
+	{
+		m_pRelayParent = m_pClientPeer;
+		return;
+	}
+
+#ifdef _DEBUG
+	char addr[40];
+	enet_address_get_ip(&info->parentAddr, addr, 40);
+	printf("[LOADER] Joining the relay tree under %u (%s:%u)\n", info->parent, addr, info->parentAddr.port);
+#endif
+
+	m_pRelayParent = enet_host_connect(m_pHost, &info->parentAddr, ENET_CHANNEL_MAX, m_bRelaySynced ? ENET_CONNECT_RELAY : ENET_CONNECT_RELAY_CATCHUP);
+
+	if (!m_pRelayParent)
+		RelayParentLost();
+	else
+		m_timeoutPolicy.Initial(m_pRelayParent);
+}
+
+void DPInstance::OnRelayDisconnect(ENetPeer* peer)
+{
+	m_vRelayChildren.erase(std::remove(m_vRelayChildren.begin(), m_vRelayChildren.end(), peer), m_vRelayChildren.end());
+	m_spectatorRing.RemoveReader((uintptr_t)peer);
+
+	if (peer == m_pRelayParent)
+		RelayParentLost();
+}
+
+void DPInstance::RelayParentLost()
+{
+#ifdef _DEBUG
+	printf("[LOADER] Lost the relay parent %u, asking the host for the stream\n", m_dwRelayParent);
+#endif
+
+	ENetAddress none;
+	memset(&none, 0, sizeof(none));
+	SendToHost(ENET_CHANNEL_NORMAL, DPMsg::RelayAttach(m_dwRelayParent, none));
+
+	m_pRelayParent = m_pClientPeer;
+	m_dwRelayParent = DP_RELAY_HOST;
+}
+
+void DPInstance::ResetRelay()
+{
+	for (auto child : m_vRelayChildren)
+		enet_peer_disconnect(child, 0);
+
+	if (m_pRelayParent && m_pRelayParent != m_pClientPeer)
+		enet_peer_disconnect(m_pRelayParent, 0);
+
+	m_vRelayChildren.clear();
+	m_spectatorRing.ClearReaders(); // the buffer is kept, the checkpoints are still good for the next children
+	m_pRelayParent = nullptr;
+	m_dwRelayParent = DP_RELAY_HOST;
+}
+
+bool DPInstance::SendToHost(uint8_t channel, ENetPacket* pk)
+{
+	if (m_ullResumeToken != 0)
+		m_resumeLog.Store(pk, channel); // as it is, the host that gets the replay might not have our dictionary or delta streams
+
+	if (!m_bResuming && !m_bMigrating && m_shared.Send(m_pClientPeer, channel, pk))
+	{
+		if (pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+		return true;
+	}
+
+	if (!m_bResuming && !m_bMigrating)
+	{
+		if (m_bDelta && channel == ENET_CHANNEL_NORMAL)
+			pk = EncodeDelta(pk, m_hostDelta);
+
+		pk = CompressPacket(pk, m_dwHostDict);
+	}
+
+	if (m_bFec && channel == ENET_CHANNEL_NORMAL && !m_bResuming && !m_bMigrating && DPFec::CanProtect(pk))
+	{
+		auto peer = m_pClientPeer;
+
+		if (m_hostFec.Protect(pk, [peer, channel](ENetPacket* out) { if (enet_peer_send(peer, channel, out) != 0) enet_packet_destroy(out); }))
+		{
+			pk->flags |= ENET_PACKET_FLAG_SENT; // handed to enet inside the fec message
+			if (pk->referenceCount == 0)
+				enet_packet_destroy(pk);
+			return true;
+		}
+	}
+
+	if (m_bResuming || m_bMigrating || enet_peer_send(m_pClientPeer, channel, pk) != 0)
+	{
+		if (pk->referenceCount == 0) // still held by a scheduler otherwise
+			enet_packet_destroy(pk);
+		return m_bResuming || m_bMigrating; // will be replayed once the session is resumed
+	}
+
+	return true;
+}
+
+void DPInstance::SendToPeer(ENetPeer* peer, uint8_t channel, ENetPacket* pk)
+{
+	if (m_shared.Send(peer, channel, pk) || enet_peer_send(peer, channel, pk) != 0)
+	{ // copied to the ring, or refused by enet
+		if (pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+	}
+}
+
+void DPInstance::SuspendPlayer(const std::shared_ptr<DPPlayer>& player)
+{
 #ifdef _DEBUG
-					printf("[LOADER] Assigned peer id from server %u\n", (DPID)m_pClientPeer->data);
+	printf("[LOADER] Player %u timed out, keeping the slot for %u ms\n", player->GetId(), RESUME_GRACE_TIME);
 #endif
-					break; // Do not add this internal message to the queue
-				}
-			}
 
-			if (msg->GetType() == DPMSG_TYPE_REMOTEINFO)
-			{
-				auto p = m_vPlayers.find(msg->GetFrom());
+	player->Suspend(GetTickCount64() + RESUME_GRACE_TIME);
+	DetachSpectator(player); // its children need another parent meanwhile
+}
 
-				if (p != m_vPlayers.end())
-				{
-					DWORD len;
-					msg->Read(len);
-					p->second->SetRemoteData(msg->Read2(len), len);
-					break; // Do not add this internal message to the queue
-				}
-			}
+void DPInstance::DestroyRemotePlayer(const std::shared_ptr<DPPlayer>& player)
+{
+	player->SetResumeToken(0); // no way back
+	player->ClearSuspend();
+	player->GetScheduler().Dump(player->GetId());
+	player->GetScheduler().Clear();
+	DetachSpectator(player);
 
-			if (evt.peer->data != 0)
-			{
-				auto p = m_vPlayers[(DPID)evt.peer->data];
-				if (p.get())
-				{
-					if (msg->GetTo() == p->GetId())
-						p->FireEvent(); // Fire handle event as specified by DirectPlay
-				}
-			}
+	auto fec = m_vFec.find(player->GetId());
 
-			m_vMessages.push_back(msg);
-			break;
+	if (fec != m_vFec.end())
+	{
+		fec->second.Dump(player->GetId());
+		m_vFec.erase(fec);
+	}
+
+	// tell all the peers that a player disconnected
+
+	auto r = std::make_shared<DPMsg>(DPMsg::DestroyPlayer(player), true);
+
+	m_vMessages.push_back(r); // tell ourself that someone died
+
+	Broadcast(ENET_CHANNEL_CHAT, DPMsg::DestroyPlayer(player));
+}
+
+void DPInstance::CheckSuspendedPlayers()
+{
+	auto now = GetTickCount64();
+
+	for (const auto& p : m_vPlayers)
+	{
+		if (!p.second->IsSuspended() || now < p.second->GetSuspendDeadline())
+			continue;
+
+#ifdef _DEBUG
+		printf("[LOADER] Player %u did not come back in time\n", p.second->GetId());
+#endif
+		DestroyRemotePlayer(p.second);
+	}
+}
+
+void DPInstance::ResumePlayer(ENetPeer* peer, const DPResumeInfo* info)
+{
+	auto it = info ? m_vPlayers.find(info->id) : m_vPlayers.end();
+
+	// a player of the old host may still try to resume on our address, its counters are for the old host and only a rejoin can bring it back
+	if (it == m_vPlayers.end() || it->second->IsRejoining() || it->second->GetResumeToken() == 0 || it->second->GetResumeToken() != info->token || !it->second->GetResumeLog().CanReplay(info->received))
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Refused session resume\n");
+#endif
+		DWORD none[DP_RESUME_LOG_CHANNELS] = { 0 };
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::ResumeAck(DP_RESUME_REFUSED, none));
+		enet_peer_disconnect_later(peer, 0);
+		return;
+	}
+
+	auto p = it->second;
+
+	if (p->GetPeer() && p->GetPeer() != peer)
+	{ // the old connection did not time out yet on our side
+		p->GetPeer()->data = nullptr;
+		enet_peer_reset(p->GetPeer());
+	}
+
+#ifdef _DEBUG
+	printf("[LOADER] Player %u resumed the session\n", p->GetId());
+#endif
+
+	peer->data = (LPVOID)(uintptr_t)p->GetId();
+	m_timeoutPolicy.Initial(peer);
+	enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::ResumeAck(DP_RESUME_RESUMED, p->GetReceived()));
+	p->Resume(peer, info->received);
+
+	if (p->IsSpecator())
+		AttachSpectator(p, false);
+}
+
+void DPInstance::BeginResume()
+{
+	auto id = m_pClientPeer->data;
+
+	if (!m_bResuming)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Connection timed out, trying to resume the session...\n");
+#endif
+		m_bResuming = true;
+		m_ullResumeDeadline = GetTickCount64() + (m_bCanMigrate ? MIGRATE_RESUME_TIME : RESUME_GRACE_TIME);
+		ResetRelay(); // the host gives us a new place in the tree once resumed
+	}
+
+	enet_peer_reset(m_pClientPeer);
+	m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, ENET_CONNECT_RESUME);
+
+	if (!m_pClientPeer)
+	{
+		SessionLost();
+		return;
+	}
+
+	m_pClientPeer->data = id;
+	m_timeoutPolicy.Initial(m_pClientPeer);
+}
+
+void DPInstance::CheckResume()
+{
+	if (GetTickCount64() < m_ullResumeDeadline)
+		return;
+
+#ifdef _DEBUG
+	printf("[LOADER] Unable to resume the session in time\n");
+#endif
+
+	if (m_bCanMigrate)
+		Migrate(); // the host is gone, carry on without it
+	else
+		SessionLost();
+}
+
+void DPInstance::SessionLost()
+{
+	ResetRelay();
+
+	if (m_pClientPeer)
+		enet_peer_reset(m_pClientPeer);
+
+	m_pClientPeer = nullptr;
+	m_bConnected = false;
+	m_bResuming = false;
+	m_ullResumeToken = 0;
+	m_resumeLog.Reset();
+	m_bCanMigrate = false;
+	m_bMigrating = false;
+	m_hostScheduler.Clear();
+
+	DPMSG_SESSIONLOST msg2;
+	msg2.dwType = DPSYS_SESSIONLOST;
+
+	DPMsg lost(0, 0, DPMSG_TYPE_SYSTEM);
+	lost.AddToSerialize(msg2);
+	auto msg = std::make_shared<DPMsg>(lost.Serialize(), true);
+
+	// Remove all messages and push the session lost one, telling the app the we lost the connection
+	m_vMessages.clear();
+	m_vMessages.push_back(msg);
+}
+
+std::shared_ptr<DPPlayer> DPInstance::FindSuccessor()
+{
+	std::shared_ptr<DPPlayer> successor;
+
+	for (const auto& p : m_vPlayers)
+	{
+		if (p.second->IsLocal() || !p.second->GetPeer() || p.second->IsSuspended() || p.second->IsSpecator())
+			continue;
+
+		if (!successor || p.second->GetId() < successor->GetId())
+			successor = p.second;
+	}
+
+	return successor;
+}
+
+void DPInstance::ReplicateSession()
+{
+	auto successor = FindSuccessor();
+
+	if (!successor)
+		return; // nobody can take our place
+
+	DPMigrateInfo info = { 0 };
+	info.session.session = m_gSession;
+	info.session.maxPlayers = m_dwMaxPlayers;
+	info.session.currPlayers = (DWORD)m_vPlayers.size();
+	strncpy_s(info.session.sessionName, _countof(info.session.sessionName), m_szGameName.c_str(), 100);
+	memcpy_s(info.session.user, sizeof(info.session.user), m_adwUser, sizeof(m_adwUser));
+	info.session.flags = m_dwFlags;
+	info.successor = successor->GetId();
+	info.nextId = m_dwNextId;
+	info.successorAddr = successor->GetPeer()->address;
+	info.successorAddr.port = (uint16_t)FURFIGHTERS_PORT; // the successor will listen to the game port, not the one it used to connect to us
+
+	Broadcast(ENET_CHANNEL_NORMAL, DPMsg::MigrateInfo(info));
+
+	// only the successor needs the tokens to accept the other players
+	std::vector<DPMigrateRosterEntry> roster;
+
+	for (const auto& p : m_vPlayers)
+	{
+		if (p.second->IsLocal() || p.second->GetResumeToken() == 0)
+			continue;
+
+		DPMigrateRosterEntry e;
+		e.id = p.second->GetId();
+		e.token = p.second->GetResumeToken();
+		roster.push_back(e);
+	}
+
+	SendToPlayer(successor, ENET_CHANNEL_NORMAL, DPMsg::MigrateRoster(roster));
+}
+
+void DPInstance::RejoinPlayer(ENetPeer* peer, const DPMigrateRosterEntry* info)
+{
+	auto it = info ? m_vPlayers.find(info->id) : m_vPlayers.end();
+
+	if (it == m_vPlayers.end() || !it->second->IsSuspended() || it->second->GetResumeToken() == 0 || it->second->GetResumeToken() != info->token)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Refused player rejoin\n");
+#endif
+		DWORD none[DP_RESUME_LOG_CHANNELS] = { 0 };
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::ResumeAck(DP_RESUME_REFUSED, none));
+		enet_peer_disconnect_later(peer, 0);
+		return;
+	}
+
+	auto p = it->second;
+
+#ifdef _DEBUG
+	printf("[LOADER] Player %u rejoined the session\n", p->GetId());
+#endif
+
+	// numbering starts again from the new host, nothing was received yet from us
+	DWORD none[DP_RESUME_LOG_CHANNELS] = { 0 };
+
+	peer->data = (LPVOID)(uintptr_t)p->GetId();
+	m_timeoutPolicy.Initial(peer);
+	enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::ResumeAck(DP_RESUME_REJOINED, none));
+	p->ResetReceived();
+	p->Resume(peer, none);
+	p->SetMsgFlags(true); // the older builds do not migrate
+
+	if (p->IsSpecator())
+		AttachSpectator(p, false);
+}
+
+void DPInstance::Migrate()
+{
+	if (m_migrate.successor == (DPID)(uintptr_t)m_pClientPeer->data)
+		BecomeHost();
+	else
+		BeginMigration();
+}
+
+void DPInstance::BecomeHost()
+{
+#ifdef _DEBUG
+	printf("[LOADER] The host left the game, we are the new host\n");
+#endif
+
+	ENetAddress addr;
+	addr.port = (uint16_t)FURFIGHTERS_PORT;
+
+	addr.ipv6 = ENET_HOST_ANY; // ipv4 and ipv6, like Open
+
+	auto host = CreateHost(&addr, m_dwMaxPlayers, m_dwMaxPlayers, &m_firewall);
+
+	if (!host)
+	{ // the old host can still hold the port while it closes on this machine, CheckMigration tries again
+		if (!m_bMigrating)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Cannot listen for the other players yet\n");
+#endif
+			m_bResuming = false;
+			m_bMigrating = true;
+			m_ullMigrateDeadline = GetTickCount64() + MIGRATE_REJOIN_TIME;
 		}
+
+		return;
+	}
+
+	ResetRelay();
+	enet_peer_reset(m_pClientPeer);
+	m_pClientPeer = nullptr;
+	enet_host_destroy(m_pHost);
+	m_pHost = host;
+	m_relayTree.Clear();
+	m_spectatorRing.Clear(); // the stream of the old host
+	m_pathMtu.Reset();
+
+	m_bHost = true;
+	m_bResuming = false;
+	m_bMigrating = false;
+	m_bCanMigrate = false;
+	m_ullResumeToken = 0;
+	m_resumeLog.Reset();
+	memset(m_adwReceived, 0, sizeof(m_adwReceived));
+	m_hostScheduler.Clear(); // they were for the old host
+	m_dwNextId = m_migrate.nextId;
+
+	auto deadline = GetTickCount64() + MIGRATE_REJOIN_TIME;
+	std::vector<std::shared_ptr<DPPlayer>> gone;
+
+	for (const auto& p : m_vPlayers)
+	{
+		if (p.second->IsLocal())
+			continue;
+
+		auto e = std::find_if(m_vMigrateRoster.begin(), m_vMigrateRoster.end(), [&p](const DPMigrateRosterEntry& r) { return r.id == p.first; });
+
+		if (e == m_vMigrateRoster.end())
+		{ // players of the old host left with it
+			gone.push_back(p.second);
+			continue;
 		}
+
+		// wait for the player to connect to us
+		p.second->SetResumeToken(e->token);
+		p.second->GetResumeLog().Reset();
+		p.second->ResetReceived();
+		p.second->Suspend(deadline, true);
+	}
+
+	for (const auto& p : gone)
+		DestroyRemotePlayer(p);
+
+	m_vMigrateRoster.clear();
+
+	auto msg = std::make_shared<DPMsg>(DPMsg::HostChanged(), true);
+	m_vMessages.push_back(msg);
+}
+
+void DPInstance::BeginMigration()
+{
+	auto id = m_pClientPeer->data;
+
+	if (!m_bMigrating)
+	{
+		char addr[40];
+		enet_address_get_ip(&m_migrate.successorAddr, addr, 40);
+
+#ifdef _DEBUG
+		printf("[LOADER] The host left the game, migrating to %s:%u...\n", addr, m_migrate.successorAddr.port);
+#endif
+		m_bResuming = false;
+		m_bMigrating = true;
+		m_ullMigrateDeadline = GetTickCount64() + MIGRATE_REJOIN_TIME;
+		m_eConnectAddr = m_migrate.successorAddr;
+		m_resumeLog.Reset();
+		ResetRelay();
+		memset(m_adwReceived, 0, sizeof(m_adwReceived));
+	}
+
+	// a refused resume can leave the link up, the host must forget it or it keeps disconnecting the next connect of this peer
+	enet_peer_disconnect_now(m_pClientPeer, 0);
+	m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, ENET_CONNECT_REJOIN);
+
+	if (!m_pClientPeer)
+	{
+		SessionLost();
+		return;
+	}
+
+	m_pClientPeer->data = id;
+	m_timeoutPolicy.Initial(m_pClientPeer);
+}
+
+void DPInstance::CheckMigration()
+{
+	if (GetTickCount64() < m_ullMigrateDeadline)
+	{
+		if (m_pClientPeer && m_migrate.successor == (DPID)(uintptr_t)m_pClientPeer->data)
+			BecomeHost();
+
+		return;
 	}
+
+#ifdef _DEBUG
+	printf("[LOADER] Unable to reach the new host in time\n");
+#endif
+	SessionLost();
 }
 
 HRESULT DPInstance::SetPlayerData(DPID idPlayer, LPVOID lpData, DWORD dwDataSize, DWORD dwFlags)
@@ -687,11 +2274,11 @@ HRESULT DPInstance::SetPlayerData(DPID idPlayer, LPVOID lpData, DWORD dwDataSize
 	
 	if (!m_bHost)
 	{
-		enet_peer_send(m_pClientPeer, ENET_CHANNEL_NORMAL, DPMsg::CreatePlayerRemote(p->second, dwFlags & DPSET_GUARANTEED));
+		SendToHost(ENET_CHANNEL_NORMAL, DPMsg::CreatePlayerRemote(p->second, dwFlags & DPSET_GUARANTEED));
 	}
 	else
 	{
-		enet_host_broadcast(m_pHost, ENET_CHANNEL_NORMAL, DPMsg::CreatePlayerRemote(p->second, dwFlags & DPSET_GUARANTEED));
+		Broadcast(ENET_CHANNEL_NORMAL, DPMsg::CreatePlayerRemote(p->second, dwFlags & DPSET_GUARANTEED));
 	}
 
 	return DP_OK;
@@ -707,6 +2294,9 @@ HRESULT DPInstance::Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags)
 		if (m_pHost)
 			return DPERR_ALREADYINITIALIZED;
 
+		if (Globals::Get()->NetRelayServer[0])
+			return OpenRelay(lpsd);
+
 #ifdef _DEBUG
 		printf("[LOADER] Creating new match...\n");
 #endif
@@ -716,12 +2306,12 @@ HRESULT DPInstance::Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags)
 		ENetAddress addr;
 		addr.port = (uint16_t)FURFIGHTERS_PORT;
 
-		enet_address_set_ip(&addr, "0.0.0.0");
+		addr.ipv6 = ENET_HOST_ANY; // the socket takes ipv4 and ipv6 players
 
 		if (FAILED(CoCreateGuid(&m_gSession)))
 			return DPERR_CANNOTCREATESERVER;
 
-		m_pHost = enet_host_create(&addr, lpsd->dwMaxPlayers, ENET_CHANNEL_MAX, 0, 0, ENET_BUFFER_SIZE);
+		m_pHost = CreateHost(&addr, lpsd->dwMaxPlayers, lpsd->dwMaxPlayers, &m_firewall);
 
 		if (!m_pHost)
 			return DPERR_CANNOTCREATESERVER;
@@ -732,9 +2322,21 @@ HRESULT DPInstance::Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags)
 
 		m_vMessages.clear();
 		m_bHost = true;
+		m_dwNextId = 1;
 		m_szGameName = lpsd->lpszSessionNameA;
 		m_dwMaxPlayers = lpsd->dwMaxPlayers;
 		m_dwFlags = lpsd->dwFlags;
+
+		if (Globals::Get()->NetRendezvousServer[0] && Globals::Get()->NetSessionCode[0])
+		{ // the players behind other NATs join with the code, the service tells us where they are
+			if (m_rendezvous.SetServer(Globals::Get()->NetRendezvousServer))
+			{
+#ifdef _DEBUG
+				printf("[LOADER] Registering the session code %s on %s\n", Globals::Get()->NetSessionCode, Globals::Get()->NetRendezvousServer);
+#endif
+				m_rendezvous.Register(m_pHost, Globals::Get()->NetSessionCode);
+			}
+		}
 	}
 	else if (dwFlags == DPOPEN_JOIN)
 	{
@@ -761,15 +2363,15 @@ HRESULT DPInstance::Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags)
 		if (it == m_vEnumAddr.end())
 			return DPERR_INVALIDPARAMS;
 
-		m_pClientPeer = enet_host_connect(m_pHost, &it->second, ENET_CHANNEL_MAX, 1);
+		m_pClientPeer = enet_host_connect(m_pHost, &it->second, ENET_CHANNEL_MAX, ENET_CONNECT_JOIN);
 #else
-		m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, 1);
+		m_pClientPeer = enet_host_connect(m_pHost, &m_eConnectAddr, ENET_CHANNEL_MAX, ENET_CONNECT_JOIN);
 #endif
 
 		if (!m_pClientPeer)
 			return DPERR_NOCONNECTION;
 
-		enet_peer_timeout(m_pClientPeer, TIMEOUT1, TIMEOUT2, TIMEOUT3);
+		m_timeoutPolicy.Initial(m_pClientPeer);
 
 		m_vMessages.clear();
 
@@ -799,6 +2401,46 @@ HRESULT DPInstance::Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags)
 	return DP_OK;
 }
 
+HRESULT DPInstance::OpenRelay(LPDPSESSIONDESC2 lpsd)
+{
+#ifdef _DEBUG
+	printf("[LOADER] Creating new match on the relay server %s...\n", Globals::Get()->NetRelayServer);
+#endif
+
+	char server[sizeof(Globals::Get()->NetRelayServer)];
+	strcpy_s(server, sizeof(server), Globals::Get()->NetRelayServer);
+
+	memset(&m_eConnectAddr, 0, sizeof(m_eConnectAddr));
+	m_eConnectAddr.port = (uint16_t)FURFIGHTERS_PORT;
+	auto host = DPSplitAddress(server, &m_eConnectAddr.port);
+
+	if (!host || enet_address_set_hostname(&m_eConnectAddr, host) != 0)
+		return DPERR_CANNOTCREATESERVER;
+
+	if (FAILED(CoCreateGuid(&m_gSession)))
+		return DPERR_CANNOTCREATESERVER;
+
+	m_pHost = CreateHost(nullptr, DP_RELAY_PEERS, 1, &m_firewall);
+
+	if (!m_pHost)
+		return DPERR_CANNOTCREATESERVER;
+
+	m_szGameName = lpsd->lpszSessionNameA;
+	m_dwMaxPlayers = lpsd->dwMaxPlayers;
+	m_dwFlags = lpsd->dwFlags;
+	m_bDelta = false; // the relay server only forwards, it cannot rebuild the delta streams
+
+	auto hr = Open(lpsd, DPOPEN_JOIN);
+
+	if (FAILED(hr))
+		return hr;
+
+	// we are the first player, the server takes the session from us and makes us the game host
+	m_bRelayHost = true;
+	SendToHost(ENET_CHANNEL_NORMAL, DPMsg::CreateRoomInfo(m_gSession, m_dwMaxPlayers, 0, m_szGameName.c_str(), m_adwUser, m_dwFlags));
+	return DP_OK;
+}
+
 HRESULT DPInstance::Close(void)
 {
 	m_bService = false;
@@ -812,6 +2454,8 @@ HRESULT DPInstance::Close(void)
 
 	if (m_pHost)
 	{
+		Flush(); // deliver what the game queued in the last frame
+
 		if (m_bHost)
 		{ // SERVER
 			for (const auto& dp : m_vPlayers)
@@ -821,6 +2465,8 @@ HRESULT DPInstance::Close(void)
 		}
 		else
 		{ // CLIENT
+			ResetRelay();
+
 			if (m_pClientPeer)
 				enet_peer_disconnect(m_pClientPeer, 0);
 		}
@@ -841,10 +2487,65 @@ HRESULT DPInstance::Close(void)
 
 		enet_host_destroy(m_pHost);
 		m_pHost = nullptr;
+		m_pathMtu.Reset();
 	}
 
 	m_bConnected = false;
 	m_bHost = false;
+	m_bResuming = false;
+	m_ullResumeToken = 0;
+	m_resumeLog.Reset();
+	m_bCanMigrate = false;
+	m_bMigrating = false;
+	m_vMigrateRoster.clear();
+	m_hostScheduler.Dump(0);
+	m_hostScheduler.Clear();
+	m_vMessages.Dump();
+	m_flushPolicy.Dump();
+
+	for (const auto& f : m_vFec)
+		f.second.Dump(f.first);
+
+	m_vFec.clear();
+	m_hostFec.Dump(0);
+	m_hostFec.Reset();
+	m_vPeerDict.clear();
+	m_dwHostDict = 0;
+	m_compressor.Dump();
+
+	for (const auto& d : m_vDelta)
+		d.second.Dump((DPID)(uintptr_t)d.first->data);
+
+	m_vDelta.clear();
+	m_relayTree.Dump();
+	m_relayTree.Clear();
+	m_spectatorRing.Dump();
+	m_spectatorRing.Clear();
+	m_bRelaySynced = false;
+	m_bRelayHost = false;
+	m_hostDelta.Dump(0);
+	m_hostDelta.Reset();
+	m_firewall.Dump();
+	m_firewall.Reset();
+	m_rendezvous.Dump();
+	m_rendezvous.Reset();
+	m_shared.Dump();
+	m_shared.Reset();
+	m_context.GetPool()->Dump();
+	m_context.GetPool()->Reset();
+
+	if (m_bDictTrain && !m_vDictSamples.empty())
+	{ // the next sessions will use it
+		DPCompressor trained;
+		trained.SetDictionary(DPCompressor::Train(m_vDictSamples));
+
+#ifdef _DEBUG
+		printf("[LOADER] Trained compression dictionary %08x from %zu messages\n", trained.GetId(), m_vDictSamples.size());
+#endif
+
+		trained.Save(m_szDictPath.c_str());
+		m_vDictSamples.clear();
+	}
 
 	return DP_OK;
 }
@@ -866,15 +2567,28 @@ HRESULT DPInstance::InitializeConnection(LPVOID lpConnection, DWORD dwFlags)
 			return DPERR_ALREADYINITIALIZED;
 
 		// Client needs host created immidiatly so we can connect and query game info
-		m_pHost = enet_host_create(nullptr, 1, ENET_CHANNEL_MAX, 0, 0, ENET_BUFFER_SIZE);
+		m_pHost = CreateHost(nullptr, DP_RELAY_PEERS, 1, &m_firewall); // buffers resized when we know the size of the session, the other peers are the spectator relays
 
 		if (!m_pHost)
 			return DPERR_UNINITIALIZED;
 
 		ENetAddress eAddr;
-		if (!GetAddressFromDPAddress(addr, &eAddr))
+		char code[DP_SESSION_CODE_SIZE + 1];
+
+		if (!GetAddressFromDPAddress(addr, &eAddr, code))
 			return DPERR_UNINITIALIZED;
 
+		if (code[0])
+		{ // punch through the NATs before enet connects, the service tells us the endpoint of the game host
+#ifdef _DEBUG
+			printf("[LOADER] Looking up the session code %s on %s\n", code, Globals::Get()->NetRendezvousServer);
+#endif
+
+			if (!Globals::Get()->NetRendezvousServer[0] || !m_rendezvous.SetServer(Globals::Get()->NetRendezvousServer) ||
+				!m_rendezvous.Lookup(m_pHost, code, &eAddr))
+				return DPERR_UNINITIALIZED;
+		}
+
 		char addr4[40];
 		enet_address_get_ip(&eAddr, addr4, 40);
 
@@ -888,8 +2602,10 @@ HRESULT DPInstance::InitializeConnection(LPVOID lpConnection, DWORD dwFlags)
 	return DP_OK;
 }
 
-bool DPInstance::GetAddressFromDPAddress(LPVOID lpConnection, ENetAddress* out)
+bool DPInstance::GetAddressFromDPAddress(LPVOID lpConnection, ENetAddress* out, char* code)
 {
+	code[0] = 0;
+
 	LPBYTE b = (LPBYTE)lpConnection;
 	LPDPADDRESS addr = (LPDPADDRESS)lpConnection;
 	b += sizeof(DPADDRESS);
@@ -906,10 +2622,25 @@ bool DPInstance::GetAddressFromDPAddress(LPVOID lpConnection, ENetAddress* out)
 
 			if (InlineIsEqualGUID(addr2->guidDataType, DPAID_INet))
 			{
-				char ip[20];
-				memcpy(ip, b + i + sizeof(DPADDRESS), addr2->dwDataSize);
-				enet_address_set_ip(out, ip);
+				char ip[64] = { 0 };
+				memcpy(ip, b + i + sizeof(DPADDRESS), addr2->dwDataSize < sizeof(ip) ? addr2->dwDataSize : sizeof(ip) - 1);
+				ip[sizeof(ip) - 1] = 0;
+
+				// ip:port, for the sessions of a relay server that are not on the game port
 				out->port = (uint16_t)FURFIGHTERS_PORT;
+				auto host = DPSplitAddress(ip, &out->port);
+
+				if (!host)
+					break;
+
+				if (enet_address_set_ip(out, host) != 0)
+				{ // not an ip, it is the session code of a game host behind a NAT
+					if (!host[0] || strlen(host) > DP_SESSION_CODE_SIZE || host != ip)
+						break;
+
+					strcpy_s(code, DP_SESSION_CODE_SIZE + 1, host);
+				}
+
 				setIp = true;
 				break; // possible fix for addr2 point derefence
 			}
@@ -1000,6 +2731,51 @@ HRESULT DPInstance::GetPlayerData(DPID idPlayer, LPVOID lpData, LPDWORD lpdwData
 	return DP_OK;
 }
 
+HRESULT DPInstance::GetMessageQueue(DPID idFrom, DPID idTo, DWORD dwFlags, LPDWORD lpdwNumMsgs, LPDWORD lpdwNumBytes)
+{
+	DWORD msgs = 0, bytes = 0;
+
+	if (!dwFlags || (dwFlags & DPMESSAGEQUEUE_RECEIVE))
+	{
+		for (const auto& m : m_vMessages)
+		{
+			if ((idFrom && m->GetFrom() != idFrom) || (idTo && m->GetTo() != idTo))
+				continue;
+
+			msgs++;
+			bytes += (DWORD)DPMsgQueue::GetSize(m);
+		}
+	}
+
+	if (dwFlags & DPMESSAGEQUEUE_SEND)
+	{
+		if (m_bHost)
+		{
+			for (const auto& p : m_vPlayers)
+			{
+				if (p.second->IsLocal() || (idTo && p.first != idTo))
+					continue;
+
+				msgs += (DWORD)p.second->GetScheduler().GetQueuedCount();
+				bytes += (DWORD)p.second->GetScheduler().GetQueuedBytes();
+			}
+		}
+		else
+		{
+			msgs += (DWORD)m_hostScheduler.GetQueuedCount();
+			bytes += (DWORD)m_hostScheduler.GetQueuedBytes();
+		}
+	}
+
+	if (lpdwNumMsgs)
+		*lpdwNumMsgs = msgs;
+
+	if (lpdwNumBytes)
+		*lpdwNumBytes = bytes;
+
+	return DP_OK;
+}
+
 void DPInstance::SetupThreadedService(bool infinite)
 {
 #ifdef _DEBUG
@@ -1043,7 +2819,7 @@ HRESULT DPInstance::EnumSessionOut(LPDPENUMSESSIONSCALLBACK2 cb, LPVOID ctx)
 		if (it->GetType() == DPMSG_TYPE_GAME_INFO)
 		{
 			DWORD r = 0;
-			it->FixSysMessage(nullptr, &r);
+			it->FixSysMessage(nullptr, &r, m_context.GetArena());
 
 			DPGameInfo* info = (DPGameInfo*)it->Read2(sizeof(DPGameInfo));
 			DPSESSIONDESC2 desc;
@@ -1067,6 +2843,10 @@ HRESULT DPInstance::EnumSessionOut(LPDPENUMSESSIONSCALLBACK2 cb, LPVOID ctx)
 			m_szGameName = info->sessionName;
 			m_dwFlags = info->flags;
 
+			// every message of the session passes from the host
+			enet_socket_set_option(m_pHost->socket, ENET_SOCKOPT_RCVBUF, SocketBufferSize(m_dwMaxPlayers));
+			enet_socket_set_option(m_pHost->socket, ENET_SOCKOPT_SNDBUF, SocketBufferSize(m_dwMaxPlayers));
+
 #ifdef _DEBUG
 			printf("[LOADER] EnumSession got lobby %s\n", info->sessionName);
 #endif
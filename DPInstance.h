@@ -8,8 +8,22 @@
 
 #include "DPPlayer.h"
 #include "DPMsg.h"
+#include "DPFec.h"
+#include "DPCompressor.h"
+#include "DPDelta.h"
+#include "DPRelayTree.h"
+#include "DPBroadcastRing.h"
+#include "DPTimeoutPolicy.h"
+#include "DPPathMtu.h"
+#include "DPFlushPolicy.h"
+#include "DPMsgQueue.h"
+#include "DPSendTracker.h"
+#include "DPFirewall.h"
+#include "DPRendezvous.h"
+#include "DPSharedMemory.h"
+#include "DPContext.h"
 
-using QueueMsg = std::vector<std::shared_ptr<DPMsg>>;
+using QueueMsg = DPMsgQueue;
 
 class DPInstance final
 {
@@ -31,18 +45,79 @@ public:
 	HRESULT SetPlayerData(DPID idPlayer, LPVOID lpData, DWORD dwDataSize, DWORD dwFlags);
 	HRESULT Open(LPDPSESSIONDESC2 lpsd, DWORD dwFlags);
 	HRESULT Close(void);
+	HRESULT OpenRelay(LPDPSESSIONDESC2 lpsd);
 	HRESULT InitializeConnection(LPVOID lpConnection, DWORD dwFlags);
 	HRESULT EnumConnections(LPCGUID lpguidApplication, LPDPENUMCONNECTIONSCALLBACK lpEnumCallback, LPVOID lpContext, DWORD dwFlags);
 	HRESULT GetSessionDesc(LPVOID lpData, LPDWORD lpdwDataSize);
 	HRESULT GetPlayerData(DPID idPlayer, LPVOID lpData, LPDWORD lpdwDataSize, DWORD dwFlags);
+	HRESULT GetMessageQueue(DPID idFrom, DPID idTo, DWORD dwFlags, LPDWORD lpdwNumMsgs, LPDWORD lpdwNumBytes);
 
 private:
-	bool GetAddressFromDPAddress(LPVOID lpConnection, ENetAddress* addr);
+	bool GetAddressFromDPAddress(LPVOID lpConnection, ENetAddress* addr, char* code);
 	void Service(uint32_t time);
 	void SetupThreadedService(bool infinite);
 	HRESULT EnumSessionOut(LPDPENUMSESSIONSCALLBACK2 cb, LPVOID ctx);
 
+	ENetPacket* CreateGamePacket(DPID idFrom, DPID idTo, DWORD dwFlags, LPVOID lpData, DWORD dwDataSize);
+	HRESULT SendGamePacket(DPID idFrom, DPID idTo, DWORD dwFlags, ENetPacket* pk, DWORD dwPriority, DWORD dwTimeout);
+	static size_t GetPendingCap(ENetPeer* peer);
+	void DrainSchedulers();
+	void ExpireSchedulers();
+	void Flush();
+	void UpdateFec();
+	void QueueReceived(ENetPeer* peer, const std::shared_ptr<DPMsg>& msg);
+	bool IsLocalPlayer(DPID id) const;
+	void DeliverLocal(DPID idFrom, DPID idTo, bool reliable, LPCVOID lpData, DWORD dwDataSize);
+	void DeliverLocal(DPID idFrom, DPID idTo, ENetPacket* pk);
+	void BroadcastLocal(DPID idFrom, ENetPacket* pk);
+	ENetPacket* CompressPacket(ENetPacket* pk, DWORD dwPeerDict);
+	std::shared_ptr<DPMsg> Decompress(const std::shared_ptr<DPMsg>& msg);
+	static ENetPacket* ReplacePacket(ENetPacket* pk, ENetPacket* out);
+	ENetPacket* EncodeDelta(ENetPacket* pk, DPDelta& delta);
+	std::shared_ptr<DPMsg> DecodeDelta(ENetPeer* peer, const std::shared_ptr<DPMsg>& msg);
+	void UpdateDelta();
+	void Relay(uint8_t channel, ENetPacket* pk, BYTE flags = 0);
+	void Checkpoint();
+	void PumpSpectators();
+	bool IsSpectatorPeer(ENetPeer* peer) const;
+	void AttachSpectator(const std::shared_ptr<DPPlayer>& player, bool catchUp);
+	void DetachSpectator(const std::shared_ptr<DPPlayer>& player);
+	std::shared_ptr<DPMsg> ForwardRelay(ENetPacket* pk, DPMsg& msg);
+	void OnRelayAttach(const DPRelayAttachInfo* info);
+	void OnRelayDisconnect(ENetPeer* peer);
+	void RelayParentLost();
+	void ResetRelay();
+	bool SendToPlayer(const std::shared_ptr<DPPlayer>& player, uint8_t channel, ENetPacket* pk);
+	void Broadcast(uint8_t channel, ENetPacket* pk);
+	bool SendToHost(uint8_t channel, ENetPacket* pk);
+	void SendToPeer(ENetPeer* peer, uint8_t channel, ENetPacket* pk);
+
+	// Session resumption
+	void SuspendPlayer(const std::shared_ptr<DPPlayer>& player);
+	void DestroyRemotePlayer(const std::shared_ptr<DPPlayer>& player);
+	void CheckSuspendedPlayers();
+	void ResumePlayer(ENetPeer* peer, const DPResumeInfo* info);
+	void BeginResume();
+	void CheckResume();
+	void SessionLost();
+
+	// Host migration
+	std::shared_ptr<DPPlayer> FindSuccessor();
+	void ReplicateSession();
+	void RejoinPlayer(ENetPeer* peer, const DPMigrateRosterEntry* info);
+	void Migrate();
+	void BecomeHost();
+	void BeginMigration();
+	void CheckMigration();
+
+	DPContext m_context; // first in, last out: enet lives as long as the members that use it
 	ENetHost* m_pHost;
+	DPTimeoutPolicy m_timeoutPolicy;
+	DPPathMtu m_pathMtu;
+	DPFlushPolicy m_flushPolicy;
+	DPFirewall m_firewall; // shared by the hosts of the instance, one at a time except while we become the host
+	DPRendezvous m_rendezvous;
+	DPSharedTransport m_shared; // normal channel of the peers on this machine
 
 	// Shared
 	std::string m_szGameName;
@@ -50,11 +125,29 @@ private:
 	bool m_bHost;
 	GUID m_gSession;
 	QueueMsg m_vMessages; // we need a queue due to how DPlay works...
+	DPSendTracker m_sendTracker;
+	DPScheduler m_hostScheduler; // client only, messages for the host
+	bool m_bFec;
+	std::unordered_map<DPID, DPFec> m_vFec; // host only, fec state of every remote player
+	DPFec m_hostFec; // client only
+	DPCompressor m_compressor;
+	std::wstring m_szDictPath;
+	std::unordered_map<ENetPeer*, DWORD> m_vPeerDict; // host only, dictionary of every peer
+	DWORD m_dwHostDict; // client only
+	bool m_bDictTrain;
+	std::deque<std::vector<BYTE>> m_vDictSamples;
+	bool m_bDelta;
+	std::unordered_map<ENetPeer*, DPDelta> m_vDelta; // host only, delta streams of every peer
+	DPDelta m_hostDelta; // client only
 	DWORD m_adwUser[4];
+	DPBroadcastRing m_spectatorRing; // host: broadcasts for the spectators, client: stream for our relay children
 
 	// Server
 	DWORD m_dwMaxPlayers;
 	DWORD m_dwFlags;
+	DWORD m_dwNextId;
+	size_t m_nDrrStart;
+	DPRelayTree m_relayTree;
 
 	// Client
 	bool m_bConnected;
@@ -62,6 +155,22 @@ private:
 	std::unordered_map<GUID, ENetAddress, GUIDHasher> m_vEnumAddr;
 	ENetAddress m_eConnectAddr;
 	GUID m_guidFF;
+	bool m_bResuming;
+	ULONGLONG m_ullResumeDeadline;
+	ULONGLONG m_ullResumeToken;
+	DPResumeLog m_resumeLog;
+	DWORD m_adwReceived[DP_RESUME_LOG_CHANNELS];
+	bool m_bCanMigrate;
+	bool m_bMigrating;
+	ULONGLONG m_ullMigrateDeadline;
+	DPMigrateInfo m_migrate;
+	std::vector<DPMigrateRosterEntry> m_vMigrateRoster;
+	ENetPeer* m_pRelayParent; // spectator only, m_pClientPeer when the host feeds us
+	DPID m_dwRelayParent;
+	std::vector<ENetPeer*> m_vRelayChildren; // spectator only
+	bool m_bRelaySynced; // spectator only, the roster is known and the checkpoints are just kept for the children
+	bool m_bRelayHost; // client only, the relay server made us the game host
+	bool m_bHostMsgFlags; // client only, the build of the host fills the flags of the message header
 
 	// ENet Thread
 	std::thread m_thread;
@@ -6,72 +6,26 @@
 */
 #include "stdafx.h"
 #include "DPMsg.h"
-#include "Globals.h"
-
-struct DPNameNet
-{
-	char shortName[30];
-	char longName[100];
-};
+#include "DPMsgArena.h"
 
 ENetPacket* DPMsg::DestroyPlayer(const std::shared_ptr<DPPlayer>& player)
 {
-	DPMSG_DESTROYPLAYERORGROUP msg;
-
-	msg.dwType = DPSYS_DESTROYPLAYERORGROUP;
-	msg.dwPlayerType = DPPLAYERTYPE_PLAYER;
-	msg.dpId = player->GetId();
-	msg.lpLocalData = nullptr; // See above
-	msg.dwLocalDataSize = player->GetLocalDataSize();
-	msg.dwRemoteDataSize = player->GetRemoteDataSize();
-	msg.lpRemoteData = nullptr; // See avobe
-	msg.dpIdParent = 0;
-	msg.dwFlags = player->IsSpecator() ? DPPLAYER_SPECTATOR : 0;
-	msg.dwFlags |= player->IsMadeByHost() ? DPPLAYER_SERVERPLAYER : 0;
-
-	DPMsg dpMsg(player->GetId(), DPID_SYSMSG, DPMSG_TYPE_SYSTEM);
-	dpMsg.AddToSerialize(msg);
-	return dpMsg.Serialize();
+	DWORD flags = player->IsSpecator() ? DPPLAYER_SPECTATOR : 0;
+	flags |= player->IsMadeByHost() ? DPPLAYER_SERVERPLAYER : 0;
+
+	return DestroyPlayer(player->GetId(), player->GetLocalDataSize(), player->GetRemoteDataSize(), flags); // the data is added by the receiver
 }
 
 ENetPacket* DPMsg::NewPlayer(const std::shared_ptr<DPPlayer>& player, DWORD oldPlayer)
 {
-	DPMSG_CREATEPLAYERORGROUP msg;
-	msg.dwType = DPSYS_CREATEPLAYERORGROUP;
-	msg.dwPlayerType = DPPLAYERTYPE_PLAYER;
-	msg.dpId = player->GetId();
-	msg.dwCurrentPlayers = oldPlayer;
-	msg.lpData = nullptr;
-	msg.dwDataSize = player->GetLocalDataSize();
-
-	DPNAME name;
-	name.dwSize = sizeof(name);
-	name.dwFlags = 0;
-	name.lpszLongNameA = nullptr;
-	name.lpszShortNameA = nullptr;
-	msg.dpnName = name;
-
-	msg.dpIdParent = 0;
-	msg.dwFlags = 0;
-
-	DPMsg dpMsg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_SYSTEM);
-	dpMsg.AddToSerialize(msg);
-
-	DPNameNet netName;
-	strcpy_s(netName.shortName, _countof(netName.shortName), player->GetShortName());
-	strcpy_s(netName.longName, _countof(netName.longName), player->GetLongName());
-	dpMsg.AddToSerialize(netName);
-
-	if (msg.dwDataSize)
-		dpMsg.AddToSerialize(player->GetLocalData(), msg.dwDataSize);
-
-	return dpMsg.Serialize();
+	return NewPlayer(player->GetId(), player->GetShortName(), player->GetLongName(), player->GetLocalData(), player->GetLocalDataSize(), oldPlayer);
 }
 
-ENetPacket* DPMsg::CallNewId(LPDPNAME lpData)
+ENetPacket* DPMsg::CallNewId(LPDPNAME lpData, DWORD dwFlags)
 {
 	DPMsg msg(0, 0, DPMSG_TYPE_CALL_NEWID);
 	DPPlayerInfo nfo = { 0 };
+	nfo.dwFlags = dwFlags;
 
 	if (lpData->lpszLongNameA)
 		strncpy_s(nfo.longName, 100, lpData->lpszLongNameA, 100);
@@ -79,31 +33,12 @@ ENetPacket* DPMsg::CallNewId(LPDPNAME lpData)
 		strncpy_s(nfo.name, 40, lpData->lpszShortNameA, 40);
 	
 	msg.AddToSerialize(nfo);
+	DWORD caps = DP_CAPS;
+	msg.AddToSerialize(caps);
 
 	return msg.Serialize();
 }
 
-ENetPacket* DPMsg::NewId(DPID id)
-{
-	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_NEWID);
-	msg.AddToSerialize(id);
-	return msg.Serialize();
-}
-
-ENetPacket* DPMsg::CreateRoomInfo(GUID roomId, DWORD maxPlayers, DWORD currPlayers, const char* sessionName, DWORD user[4], DWORD dwFlags)
-{
-	DPGameInfo info;
-	info.session = roomId;
-	info.maxPlayers = maxPlayers;
-	info.currPlayers = currPlayers;
-	strncpy_s(info.sessionName, _countof(info.sessionName), sessionName, 100);
-	memcpy_s(info.user, sizeof(info.user), user, sizeof(info.user));
-	info.flags = dwFlags;
-	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_GAME_INFO);
-	msg.AddToSerialize(info);
-	return msg.Serialize();
-}
-
 ENetPacket* DPMsg::ChatPacket(DPID from, DPID to, bool reliable, LPDPCHAT chatMsg)
 {
 	DPMSG_CHAT chat;
@@ -159,8 +94,9 @@ ENetPacket* DPMsg::CreateSendComplete(DPID idFrom, DPID idTo, DWORD dwFlags, DWO
 * @return HResult error code or DP_OK in case of success
 * @param lpData Pointer of the data to store
 * @param lpDataSize Pointer of the size of the data to store
+* @param arena Arena of the DirectPlay object, it keeps the data the message points to
 */
-HRESULT_INT DPMsg::FixSysMessage(LPVOID lpData, LPDWORD lpDataSize)
+HRESULT_INT DPMsg::FixSysMessage(LPVOID lpData, LPDWORD lpDataSize, DPMsgArena* arena)
 {
 	ResetRead();
 
@@ -171,36 +107,80 @@ HRESULT_INT DPMsg::FixSysMessage(LPVOID lpData, LPDWORD lpDataSize)
 	if (!p)
 		return DPERR_GENERIC;
 
-	auto arena = Globals::Get()->TheArena;
+	DPMSG_CREATEPLAYERORGROUP create;
+	DPMSG_DESTROYPLAYERORGROUP destroy;
 
 	switch (p->dwType)
 	{
 	case DPSYS_SENDCOMPLETE:
 	{
-		DPMSG_SENDCOMPLETE* msg = (DPMSG_SENDCOMPLETE*)Read2(sizeof(DPMSG_SENDCOMPLETE));
+		Read2(sizeof(DPMSG_SENDCOMPLETE));
 		reqSize = sizeof(DPMSG_SENDCOMPLETE);
 		break;
 	}
 	case DPSYS_CREATEPLAYERORGROUP:
 	{
-		DPMSG_CREATEPLAYERORGROUP* msg = (DPMSG_CREATEPLAYERORGROUP*)Read2(sizeof(DPMSG_CREATEPLAYERORGROUP));
-		DPNameNet* nm = (DPNameNet*)arena->Store(Read2(sizeof(DPNameNet)), sizeof(DPNameNet));
+		auto wire = (DPWireCreatePlayer*)Read2(sizeof(DPWireCreatePlayer));
+		auto name = Read2(sizeof(DPNameNet));
+
+		if (!wire || !name)
+			return DPERR_GENERIC;
+
+		memset(&create, 0, sizeof(create));
+		create.dwType = wire->dwType;
+		create.dwPlayerType = wire->dwPlayerType;
+		create.dpId = wire->dpId;
+		create.dwCurrentPlayers = wire->dwCurrentPlayers;
+		create.dwDataSize = wire->dwDataSize;
+		create.dpnName.dwSize = sizeof(DPNAME);
+		create.dpnName.dwFlags = wire->dpnName.dwFlags;
+		create.dpIdParent = wire->dpIdParent;
+		create.dwFlags = wire->dwFlags;
 
-		if (msg->dwDataSize)
-			msg->lpData = arena->Store(Read2(msg->dwDataSize), msg->dwDataSize);
+		DPNameNet* nm = (DPNameNet*)arena->Store(name, sizeof(DPNameNet));
 
-		msg->dpnName.lpszLongNameA = nm->longName;
-		msg->dpnName.lpszShortNameA = nm->shortName;
+		if (create.dwDataSize)
+			create.lpData = arena->Store(Read2(create.dwDataSize), create.dwDataSize);
 
+		create.dpnName.lpszLongNameA = nm->longName;
+		create.dpnName.lpszShortNameA = nm->shortName;
+
+		p = (DPMSG_GENERIC*)&create;
 		reqSize = sizeof(DPMSG_CREATEPLAYERORGROUP);
 		break;
 	}
 	case DPSYS_DESTROYPLAYERORGROUP:
 	{
-		DPMSG_DESTROYPLAYERORGROUP* msg = (DPMSG_DESTROYPLAYERORGROUP*)Read2(sizeof(DPMSG_DESTROYPLAYERORGROUP));
+		auto wire = (DPWireDestroyPlayer*)Read2(sizeof(DPWireDestroyPlayer));
+
+		if (!wire)
+			return DPERR_GENERIC;
+
+		// the data is added by DPInstance::Receive
+		memset(&destroy, 0, sizeof(destroy));
+		destroy.dwType = wire->dwType;
+		destroy.dwPlayerType = wire->dwPlayerType;
+		destroy.dpId = wire->dpId;
+		destroy.dwLocalDataSize = wire->dwLocalDataSize;
+		destroy.dwRemoteDataSize = wire->dwRemoteDataSize;
+		destroy.dpnName.dwSize = sizeof(DPNAME);
+		destroy.dpIdParent = wire->dpIdParent;
+		destroy.dwFlags = wire->dwFlags;
+
+		p = (DPMSG_GENERIC*)&destroy;
 		reqSize = sizeof(DPMSG_DESTROYPLAYERORGROUP);
 		break;
 	}
+	case DPSYS_SESSIONLOST:
+	{
+		reqSize = sizeof(DPMSG_SESSIONLOST);
+		break;
+	}
+	case DPSYS_HOST:
+	{
+		reqSize = sizeof(DPMSG_HOST);
+		break;
+	}
 	case DPSYS_CHAT:
 	{
 		DPMSG_CHAT* msg = (DPMSG_CHAT*)Read2(sizeof(DPMSG_CHAT));
@@ -6,37 +6,14 @@
 */
 #pragma once
 
-#include "DPPlayer.h"
-
-enum DPMsgTypes
-{
-	DPMSG_TYPE_SYSTEM = 0,
-	DPMSG_TYPE_NEWID = 1,
-	DPMSG_TYPE_CALL_NEWID = 2,
-	DPMSG_TYPE_GAME_INFO = 3,
-	DPMSG_TYPE_CHAT = 4,
-	DPMSG_TYPE_GAME = 5,
-	DPMSG_TYPE_REMOTEINFO = 6,
-};
+#include "DPProtocol.h"
+#include "DPMsgPool.h"
 
-struct DPGameInfo
-{
-	GUID session;
-	DWORD maxPlayers;
-	DWORD currPlayers;
-	char sessionName[100];
-	DWORD user[4];
-	DWORD flags;
-};
+#ifndef DP_RELAY_SERVER
+#include "DPPlayer.h"
 
-struct DPPlayerInfo
-{
-	DPID id;
-	char name[40];
-	char longName[100];
-	DWORD curr;
-	DWORD dwDataSize;
-};
+class DPMsgArena;
+#endif
 
 /*!
 	@class DPMsg
@@ -50,34 +27,63 @@ public:
 		m_header.from = from;
 		m_header.to = to;
 		m_header.type = type;
+		m_header.flags = 0;
 		m_lpRaw = nullptr;
 		m_nRawTotalSize = 0;
 		m_pPk = nullptr;
+		m_pPool = nullptr;
 		m_nOffset = 0;
+		m_bReliable = true;
 	}
 
 	// Deserialize
 	DPMsg(ENetPacket* ref, bool hold)
 	{
 		m_pPk = nullptr;
+		m_pPool = nullptr;
 		m_nRawTotalSize = 0;
 		m_nOffset = 0;
 
 		Deserialize(ref, hold);
 	}
 
+	// Game message delivered inside the process, read like a received one
+	DPMsg(DPID from, DPID to, bool reliable, const void* data, DWORD dataSize, DPMsgPool* pool)
+	{
+		m_header.from = from;
+		m_header.to = to;
+		m_header.type = DPMSG_TYPE_GAME;
+		m_header.flags = reliable ? DPMSG_FLAG_GUARANTEED : 0;
+		m_vLocal = pool->Get(sizeof(dataSize) + dataSize);
+		memcpy(m_vLocal.data(), &dataSize, sizeof(dataSize));
+
+		if (data)
+			memcpy(m_vLocal.data() + sizeof(dataSize), data, dataSize);
+
+		m_lpRaw = m_vLocal.data();
+		m_nRawTotalSize = m_vLocal.size();
+		m_nOffset = 0;
+		m_pPk = nullptr;
+		m_pPool = pool;
+		m_bReliable = reliable;
+	}
+
 	~DPMsg()
 	{
 		if (m_pPk)
 		{
 			enet_packet_destroy(m_pPk);
 		}
+
+		if (m_pPool)
+			m_pPool->Put(std::move(m_vLocal));
 	}
 
 	void Deserialize(ENetPacket* ref, bool hold)
 	{
 		m_header = *(Header*)ref->data;
 		m_lpRaw = ref->data + sizeof(Header);
+		m_bReliable = (ref->flags & ENET_PACKET_FLAG_RELIABLE) != 0;
 
 		if (hold)
 			m_pPk = ref;
@@ -101,7 +107,7 @@ public:
 
 	ENetPacket* Serialize(uint32_t flag = ENET_PACKET_FLAG_RELIABLE)
 	{
-		auto pk = enet_packet_create(nullptr, sizeof(Header) + m_nRawTotalSize, ENET_PACKET_FLAG_RELIABLE);
+		auto pk = enet_packet_create(nullptr, sizeof(Header) + m_nRawTotalSize, flag);
 		size_t cnt = sizeof(m_header);
 
 		memcpy_s(pk->data, pk->dataLength, &m_header, sizeof(m_header));
@@ -139,25 +145,64 @@ public:
 	DPID GetFrom() const { return m_header.from; }
 	DPID GetTo() const { return m_header.to; }
 	BYTE GetType() const { return m_header.type; }
+	bool IsReliable() const { return m_bReliable; }
+	bool IsGuaranteed() const { return (m_header.flags & DPMSG_FLAG_GUARANTEED) != 0; }
+	BYTE GetFlags() const { return m_header.flags; }
+	void SetFlags(BYTE flags) { m_header.flags = flags; }
+
+	/*!
+	* @brief Sets the flags of a message from a build that does not fill them, from the reliability of its packet like those builds do
+	*/
+	void SetLegacyFlags() { m_header.flags = m_bReliable ? DPMSG_FLAG_GUARANTEED : 0; }
+
+	/*!
+	* @brief Same as SetLegacyFlags, on a packet that is forwarded as is
+	*/
+	static void SetLegacyFlags(ENetPacket* pk)
+	{
+		if (pk->dataLength >= sizeof(Header))
+			((Header*)pk->data)->flags = (pk->flags & ENET_PACKET_FLAG_RELIABLE) ? DPMSG_FLAG_GUARANTEED : 0;
+	}
 	size_t GetRawSize() const { return m_nRawTotalSize; }
 	LPBYTE GetRaw() const { return m_lpRaw; }
+	static size_t GetHeaderSize() { return sizeof(Header); }
 
+#ifndef DP_RELAY_SERVER
 	/*!
 	* @brief Translates internal network messages to DirectPlay messages
 	* @return HResult error code or DP_OK in case of success
 	* @param lpData Pointer of the data to store
 	* @param lpDataSize Pointer of the size of the data to store
+	* @param arena Arena of the DirectPlay object, it keeps the data the message points to
 	*/
-	HRESULT_INT FixSysMessage(LPVOID lpData, LPDWORD lpDataSize);
+	HRESULT_INT FixSysMessage(LPVOID lpData, LPDWORD lpDataSize, DPMsgArena* arena);
 
 	static ENetPacket* NewPlayer(const std::shared_ptr<DPPlayer>& player, DWORD oldPlayer);
 	static ENetPacket* DestroyPlayer(const std::shared_ptr<DPPlayer>& player);
-	static ENetPacket* CallNewId(LPDPNAME lpData);
-	static ENetPacket* NewId(DPID id);
-	static ENetPacket* CreateRoomInfo(GUID roomId, DWORD maxPlayers, DWORD currPlayers, const char* sessionName, DWORD user[4], DWORD dwFlags);
+	static ENetPacket* CallNewId(LPDPNAME lpData, DWORD dwFlags);
 	static ENetPacket* ChatPacket(DPID from, DPID to, bool reliable, LPDPCHAT data);
 	static ENetPacket* CreatePlayerRemote(const std::shared_ptr<DPPlayer>& player, bool reliable);
 	static ENetPacket* CreateSendComplete(DPID idFrom, DPID idTo, DWORD dwFlags, DWORD dwPriority, DWORD dwTimeout, LPVOID lpContext, DWORD lpdwMsgID, HRESULT hr, DWORD dwSendTime);
+#endif
+
+	// Wire protocol, shared with the relay server (DPProtocol.cpp)
+	static ENetPacket* NewPlayer(DPID id, const char* shortName, const char* longName, const void* data, DWORD dataSize, DWORD oldPlayer);
+	static ENetPacket* DestroyPlayer(DPID id, DWORD localDataSize, DWORD remoteDataSize, DWORD flags);
+	static ENetPacket* NewId(DPID id, ULONGLONG resumeToken);
+	static ENetPacket* Resume(DPID id, ULONGLONG resumeToken, const DWORD received[DP_RESUME_LOG_CHANNELS]);
+	static ENetPacket* ResumeAck(DWORD accepted, const DWORD received[DP_RESUME_LOG_CHANNELS]);
+	static ENetPacket* Rejoin(DPID id, ULONGLONG resumeToken);
+	static ENetPacket* MigrateInfo(const DPMigrateInfo& info);
+	static ENetPacket* MigrateRoster(const std::vector<DPMigrateRosterEntry>& roster);
+	static ENetPacket* HostChanged();
+	static ENetPacket* MtuProbe(DWORD mtu);
+	static ENetPacket* MtuProbeAck(DWORD mtu);
+	static ENetPacket* Dictionary(DWORD id);
+	static ENetPacket* FecReport(DWORD received, DWORD lost);
+	static ENetPacket* Relay(uint8_t channel, ENetPacket* pk, BYTE flags);
+	static ENetPacket* RelayAttach(DPID parent, const ENetAddress& parentAddr);
+	static ENetPacket* Shared(DWORD op, const char* name);
+	static ENetPacket* CreateRoomInfo(GUID roomId, DWORD maxPlayers, DWORD currPlayers, const char* sessionName, const DWORD user[4], DWORD dwFlags);
 
 private:
 	struct RefData
@@ -171,6 +216,7 @@ private:
 		DPID from;
 		DPID to;
 		BYTE type;
+		BYTE flags; // DPMsgFlags, in what was the padding of the header
 	} m_header;
 
 	// Used for serliazation
@@ -185,4 +231,7 @@ private:
 	// Used for memory cleanup
 
 	ENetPacket* m_pPk;
+	std::vector<BYTE> m_vLocal;
+	DPMsgPool* m_pPool; // owner of m_vLocal
+	bool m_bReliable;
 };
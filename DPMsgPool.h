@@ -0,0 +1,71 @@
+/*!
+	@author Arves100
+	@file DPMsgPool.h
+	@date 19/10/2026
+	@brief Recycled buffers of the messages delivered inside the process
+*/
+#pragma once
+
+#include <vector>
+#include <cstdio>
+
+#define DP_MSG_POOL_BUFFERS 256 // free buffers kept for the next messages
+#define DP_MSG_POOL_MAX_SIZE (64 * 1024) // bigger buffers go back to the heap
+
+/*!
+	@class DPMsgPool
+	Buffers of the game messages that a player sends to the players of the same instance, the
+	message goes straight to the receive queue and its buffer comes back here once the game read it
+*/
+class DPMsgPool
+{
+public:
+	DPMsgPool() : m_dwAllocated(0), m_dwReused(0) {}
+
+	/*!
+	* @brief Takes a buffer
+	* @param size Bytes the buffer must hold
+	*/
+	std::vector<BYTE> Get(size_t size)
+	{
+		std::vector<BYTE> buf;
+
+		if (!m_vFree.empty())
+		{
+			buf = std::move(m_vFree.back());
+			m_vFree.pop_back();
+			m_dwReused++;
+		}
+		else
+			m_dwAllocated++;
+
+		buf.resize(size);
+		return buf;
+	}
+
+	void Put(std::vector<BYTE>&& buf)
+	{
+		if (m_vFree.size() < DP_MSG_POOL_BUFFERS && buf.capacity() <= DP_MSG_POOL_MAX_SIZE)
+			m_vFree.push_back(std::move(buf));
+	}
+
+	void Reset()
+	{
+		m_dwAllocated = 0;
+		m_dwReused = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Local messages: %u buffers allocated, %u reused, %u free\n", m_dwAllocated, m_dwReused, (DWORD)m_vFree.size());
+#endif
+	}
+
+private:
+	std::vector<std::vector<BYTE>> m_vFree;
+
+	// Statistics
+	DWORD m_dwAllocated;
+	DWORD m_dwReused;
+};
@@ -0,0 +1,152 @@
+/*!
+	@author Arves100
+	@file DPMsgQueue.h
+	@date 19/10/2026
+	@brief Bounded queue of the received messages
+*/
+#pragma once
+
+#define DP_QUEUE_MAX_MSGS 8192 // all the messages
+#define DP_QUEUE_MAX_BYTES (8 * 1024 * 1024)
+#define DP_QUEUE_MAX_UNRELIABLE_MSGS 256 // unreliable game messages
+#define DP_QUEUE_MAX_UNRELIABLE_BYTES (256 * 1024)
+#define DP_QUEUE_MAX_GUARANTEED_MSGS 4096 // guaranteed game messages before the session stops reading from enet
+#define DP_QUEUE_MAX_GUARANTEED_BYTES (4 * 1024 * 1024)
+
+enum DPMsgCategories
+{
+	DP_MSG_CATEGORY_SYSTEM, // system and internal messages, always kept
+	DP_MSG_CATEGORY_RELIABLE, // game messages sent with DPSEND_GUARANTEED, always kept
+	DP_MSG_CATEGORY_UNRELIABLE, // game messages that can be dropped, even if their packet was reliable
+	DP_MSG_CATEGORY_MAX,
+};
+
+/*!
+	@class DPMsgQueue
+	Queue of the messages waiting for Receive, when the limits are hit the oldest unreliable
+	game messages are dropped to make room. The guaranteed ones are never dropped: once they
+	hit DP_QUEUE_MAX_GUARANTEED_MSGS or _BYTES the queue is full, and the session still services enet
+	but leaves the new events in it until the game reads
+*/
+class DPMsgQueue
+{
+public:
+	using List = std::list<std::shared_ptr<DPMsg>>;
+	using iterator = List::iterator;
+
+	DPMsgQueue()
+	{
+		memset(m_anCount, 0, sizeof(m_anCount));
+		memset(m_anBytes, 0, sizeof(m_anBytes));
+		memset(m_adwDropped, 0, sizeof(m_adwDropped));
+	}
+
+	static size_t GetCategory(const std::shared_ptr<DPMsg>& msg)
+	{
+		if (msg->GetType() != DPMSG_TYPE_GAME)
+			return DP_MSG_CATEGORY_SYSTEM;
+
+		return msg->IsGuaranteed() ? DP_MSG_CATEGORY_RELIABLE : DP_MSG_CATEGORY_UNRELIABLE;
+	}
+
+	static size_t GetSize(const std::shared_ptr<DPMsg>& msg)
+	{
+		return DPMsg::GetHeaderSize() + msg->GetRawSize();
+	}
+
+	void push_back(const std::shared_ptr<DPMsg>& msg)
+	{
+		auto c = GetCategory(msg);
+		auto size = GetSize(msg);
+
+		m_vMsgs.push_back(msg);
+		m_anCount[c]++;
+		m_anBytes[c] += size;
+
+		if (c == DP_MSG_CATEGORY_UNRELIABLE)
+			m_vUnreliable.insert_or_assign(msg.get(), m_vDroppable.insert(m_vDroppable.end(), std::prev(m_vMsgs.end())));
+
+		// drop the stale updates, oldest first, without walking the messages that are kept
+		while (IsOverLimit() && !m_vDroppable.empty())
+		{
+			m_adwDropped[DP_MSG_CATEGORY_UNRELIABLE]++;
+			erase(m_vDroppable.front());
+		}
+	}
+
+	iterator erase(iterator it)
+	{
+		auto c = GetCategory(*it);
+		m_anCount[c]--;
+		m_anBytes[c] -= GetSize(*it);
+
+		if (c == DP_MSG_CATEGORY_UNRELIABLE)
+		{
+			auto u = m_vUnreliable.find(it->get());
+			m_vDroppable.erase(u->second);
+			m_vUnreliable.erase(u);
+		}
+
+		return m_vMsgs.erase(it);
+	}
+
+	void clear()
+	{
+		m_vMsgs.clear();
+		m_vDroppable.clear();
+		m_vUnreliable.clear();
+		memset(m_anCount, 0, sizeof(m_anCount));
+		memset(m_anBytes, 0, sizeof(m_anBytes));
+	}
+
+	/*!
+	* @brief Tells if the game stopped reading the guaranteed messages, nothing can be dropped to make room for them
+	*/
+	bool IsFull() const
+	{
+		return m_anCount[DP_MSG_CATEGORY_RELIABLE] >= DP_QUEUE_MAX_GUARANTEED_MSGS || m_anBytes[DP_MSG_CATEGORY_RELIABLE] >= DP_QUEUE_MAX_GUARANTEED_BYTES;
+	}
+
+	iterator begin() { return m_vMsgs.begin(); }
+	iterator end() { return m_vMsgs.end(); }
+	size_t size() const { return m_vMsgs.size(); }
+	bool empty() const { return m_vMsgs.empty(); }
+
+	size_t GetCount(size_t c) const { return m_anCount[c]; }
+	size_t GetBytes(size_t c) const { return m_anBytes[c]; }
+	DWORD GetDropped(size_t c) const { return m_adwDropped[c]; }
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		for (size_t c = 0; c < DP_MSG_CATEGORY_MAX; c++)
+			printf("[LOADER] Receive queue category %u: %u msgs %u bytes, %u dropped\n", (DWORD)c, (DWORD)m_anCount[c], (DWORD)m_anBytes[c], m_adwDropped[c]);
+#endif
+	}
+
+	size_t GetTotalBytes() const
+	{
+		size_t n = 0;
+
+		for (size_t c = 0; c < DP_MSG_CATEGORY_MAX; c++)
+			n += m_anBytes[c];
+
+		return n;
+	}
+
+private:
+	bool IsOverLimit() const
+	{
+		if (m_anCount[DP_MSG_CATEGORY_UNRELIABLE] > DP_QUEUE_MAX_UNRELIABLE_MSGS || m_anBytes[DP_MSG_CATEGORY_UNRELIABLE] > DP_QUEUE_MAX_UNRELIABLE_BYTES)
+			return true;
+
+		return m_vMsgs.size() > DP_QUEUE_MAX_MSGS || GetTotalBytes() > DP_QUEUE_MAX_BYTES;
+	}
+
+	List m_vMsgs;
+	std::list<iterator> m_vDroppable; // the unreliable messages, oldest first
+	std::unordered_map<const DPMsg*, std::list<iterator>::iterator> m_vUnreliable; // where they are in m_vDroppable
+	size_t m_anCount[DP_MSG_CATEGORY_MAX];
+	size_t m_anBytes[DP_MSG_CATEGORY_MAX];
+	DWORD m_adwDropped[DP_MSG_CATEGORY_MAX];
+};
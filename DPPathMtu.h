@@ -0,0 +1,130 @@
+/*!
+	@author Arves100
+	@file DPPathMtu.h
+	@date 19/10/2026
+	@brief Per-peer path MTU discovery
+*/
+#pragma once
+
+#define DP_MTU_MAX 1472 // ethernet mtu without ip and udp headers
+#define DP_MTU_PROBE_STEP 16 // stop when we are this close to the real value
+#define DP_MTU_PROBE_TIMEOUT 1000
+#define DP_MTU_PROBE_TRIES 2
+
+/*!
+	@class DPPathMtu
+	Raises the ENet mtu of every connected peer by sending unfragmented probes of increasing size,
+	so large messages are split in less fragments where the path allows
+*/
+class DPPathMtu
+{
+public:
+	DPPathMtu(uint8_t channel) : m_nChannel(channel) {}
+
+	/*!
+	* @brief Sends the next probe to every connected peer, and gives up on the lost ones
+	* @param host Host to check
+	*/
+	void Update(ENetHost* host)
+	{
+		auto now = GetTickCount64();
+
+		// forget the peers that are gone
+		for (auto it = m_vPeers.begin(); it != m_vPeers.end();)
+		{
+			if (it->first->state != ENET_PEER_STATE_CONNECTED || it->first->connectID != it->second.connectID)
+				it = m_vPeers.erase(it);
+			else
+				++it;
+		}
+
+		for (size_t i = 0; i < host->peerCount; i++)
+		{
+			auto peer = &host->peers[i];
+
+			if (peer->state != ENET_PEER_STATE_CONNECTED)
+				continue;
+
+			auto it = m_vPeers.find(peer);
+
+			if (it == m_vPeers.end())
+			{
+				State s;
+				s.connectID = peer->connectID;
+				s.low = peer->mtu;
+				s.high = DP_MTU_MAX;
+				s.probe = 0;
+				s.tries = 0;
+				s.deadline = 0;
+				it = m_vPeers.insert({ peer, s }).first;
+			}
+
+			auto& s = it->second;
+
+			if (s.probe && now < s.deadline)
+				continue; // waiting for the ack
+
+			if (s.probe && s.tries >= DP_MTU_PROBE_TRIES)
+			{ // too big for the path
+				s.high = s.probe - 1;
+				s.probe = 0;
+				s.tries = 0;
+			}
+
+			if (s.high < s.low + DP_MTU_PROBE_STEP)
+				continue; // done
+
+			if (!s.probe)
+				s.probe = (s.low + s.high + 1) / 2;
+
+			auto pk = DPMsg::MtuProbe(s.probe);
+			enet_peer_send_probe(peer, m_nChannel, pk->data, pk->dataLength, s.probe);
+			enet_packet_destroy(pk);
+
+			s.tries++;
+			s.deadline = now + DP_MTU_PROBE_TIMEOUT;
+		}
+	}
+
+	/*!
+	* @brief Handles the ack of a probe, raising the mtu of the peer
+	* @param peer Peer that received the probe
+	* @param mtu Size of the received probe
+	*/
+	void OnAck(ENetPeer* peer, DWORD mtu)
+	{
+		auto it = m_vPeers.find(peer);
+
+		if (it == m_vPeers.end() || it->second.probe != mtu)
+			return; // old probe
+
+		auto& s = it->second;
+		s.low = mtu;
+		s.probe = 0;
+		s.tries = 0;
+
+		if (mtu > peer->mtu)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] Peer %u mtu raised to %u\n", (DWORD)peer->data, mtu);
+#endif
+			peer->mtu = mtu;
+		}
+	}
+
+	void Reset() { m_vPeers.clear(); }
+
+private:
+	struct State
+	{
+		uint32_t connectID;
+		uint32_t low;
+		uint32_t high;
+		uint32_t probe;
+		uint32_t tries;
+		ULONGLONG deadline;
+	};
+
+	std::unordered_map<ENetPeer*, State> m_vPeers;
+	uint8_t m_nChannel;
+};
@@ -7,7 +7,11 @@
 #include "stdafx.h"
 #include "DPPlayer.h"
 
-DPPlayer::DPPlayer() : m_dwId(0), m_hEvent(INVALID_HANDLE_VALUE), m_lpData(nullptr), m_dwDataSize(0), m_bIsSpectator(false), m_bMadeByHost(false), m_lpRemoteData(nullptr), m_dwRemoteDataSize(0), m_pPeer(nullptr) {}
+DPPlayer::DPPlayer() : m_dwId(0), m_hEvent(INVALID_HANDLE_VALUE), m_lpData(nullptr), m_dwDataSize(0), m_bIsSpectator(false), m_bMadeByHost(false), m_lpRemoteData(nullptr), m_dwRemoteDataSize(0), m_bLocal(false), m_pPeer(nullptr), m_bMsgFlags(false), m_ullResumeToken(0), m_ullSuspendDeadline(0), m_bRejoining(false), m_resumeLog(DP_RESUME_LOG_PACKETS, DP_RESUME_LOG_BYTES)
+{
+	ResetReceived();
+}
+
 DPPlayer::~DPPlayer()
 {
 	SetLocalData(nullptr, 0);
@@ -52,3 +56,18 @@ void DPPlayer::ForceDisconnect()
 	enet_peer_disconnect_now(m_pPeer, 0);
 	m_pPeer = nullptr;
 }
+
+void DPPlayer::Suspend(ULONGLONG deadline, bool rejoin)
+{
+	m_pPeer = nullptr; // the peer is already reset by ENet
+	m_ullSuspendDeadline = deadline;
+	m_bRejoining = rejoin;
+}
+
+void DPPlayer::Resume(ENetPeer* p, const DWORD received[DP_RESUME_LOG_CHANNELS])
+{
+	m_pPeer = p;
+	m_ullSuspendDeadline = 0;
+	m_bRejoining = false;
+	m_resumeLog.Replay(p, received);
+}
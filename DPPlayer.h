@@ -6,6 +6,9 @@
 */
 #pragma once
 
+#include "DPResumeLog.h"
+#include "DPScheduler.h"
+
 class DPPlayer
 {
 public:
@@ -24,6 +27,7 @@ public:
 	DWORD GetRemoteDataSize() const { return m_dwRemoteDataSize; }
 	bool IsSpecator() const { return m_bIsSpectator; }
 	bool IsMadeByHost() const { return m_bMadeByHost; }
+	bool IsLocal() const { return m_bLocal; }
 	const char* GetLongName() const { return m_szLongName.c_str(); }
 	const char* GetShortName() const { return m_szShortName.c_str(); }
 
@@ -66,6 +70,25 @@ public:
 	void FireEvent();
 	void Create(DPID id, const char* shortName, const char* longName, HANDLE hEvent, LPVOID lpData, DWORD dwDataSize, bool spectator, bool madeByHost);
 	void SetPeer(ENetPeer* p) { m_pPeer = p; }
+	void SetLocal(bool local) { m_bLocal = local; }
+	bool HasMsgFlags() const { return m_bMsgFlags; } // its build fills the flags of the message header
+	void SetMsgFlags(bool flags) { m_bMsgFlags = flags; }
+
+	// Session resumption
+	ULONGLONG GetResumeToken() const { return m_ullResumeToken; }
+	void SetResumeToken(ULONGLONG token) { m_ullResumeToken = token; }
+	bool IsSuspended() const { return m_ullSuspendDeadline != 0; }
+	bool IsRejoining() const { return m_bRejoining; } // suspended by a host migration, it can only come back with a rejoin
+	ULONGLONG GetSuspendDeadline() const { return m_ullSuspendDeadline; }
+	DPResumeLog& GetResumeLog() { return m_resumeLog; }
+	const DWORD* GetReceived() const { return m_adwReceived; }
+	void CountReceived(uint8_t channel) { if (channel < DP_RESUME_LOG_CHANNELS) m_adwReceived[channel]++; }
+	void ResetReceived() { memset(m_adwReceived, 0, sizeof(m_adwReceived)); }
+	void Suspend(ULONGLONG deadline, bool rejoin = false);
+	void ClearSuspend() { m_ullSuspendDeadline = 0; m_bRejoining = false; }
+	void Resume(ENetPeer* p, const DWORD received[DP_RESUME_LOG_CHANNELS]);
+
+	DPScheduler& GetScheduler() { return m_scheduler; }
 
 private:
 	DPID m_dwId;
@@ -78,7 +101,19 @@ private:
 	bool m_bMadeByHost;
 	LPBYTE m_lpRemoteData;
 	DWORD m_dwRemoteDataSize;
+	bool m_bLocal;
 
 	// ENet specific
 	ENetPeer* m_pPeer;
+	bool m_bMsgFlags;
+
+	// Session resumption
+	ULONGLONG m_ullResumeToken;
+	ULONGLONG m_ullSuspendDeadline;
+	bool m_bRejoining;
+	DPResumeLog m_resumeLog;
+	DWORD m_adwReceived[DP_RESUME_LOG_CHANNELS];
+
+	// Outgoing messages
+	DPScheduler m_scheduler;
 };
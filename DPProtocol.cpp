@@ -0,0 +1,249 @@
+/*!
+	@author Arves100
+	@file DPProtocol.cpp
+	@date 19/10/2026
+	@brief NetLib wire protocol messages, shared by the game and the relay server
+*/
+#ifndef DP_RELAY_SERVER
+#include "StdAfx.h"
+#endif
+#include "DPMsg.h"
+
+/*!
+* @brief Copies a string, truncated if it does not fit
+*/
+static void CopyName(char* dest, size_t size, const char* src)
+{
+	size_t len = src ? strlen(src) : 0;
+
+	if (len >= size)
+		len = size - 1;
+
+	if (len)
+		memcpy(dest, src, len);
+
+	dest[len] = 0;
+}
+
+char* DPSplitAddress(char* address, uint16_t* port)
+{
+	char* sep;
+
+	if (address[0] == '[')
+	{
+		auto end = strchr(address, ']');
+
+		if (!end)
+			return nullptr;
+
+		*end = 0;
+		sep = end[1] == ':' ? end + 1 : nullptr;
+		address++;
+	}
+	else
+	{
+		sep = strchr(address, ':');
+
+		if (sep && sep != strrchr(address, ':'))
+			sep = nullptr; // ipv6
+	}
+
+	if (sep)
+	{
+		*sep = 0;
+		*port = (uint16_t)atoi(sep + 1);
+	}
+
+	return address;
+}
+
+ENetPacket* DPMsg::NewPlayer(DPID id, const char* shortName, const char* longName, const void* data, DWORD dataSize, DWORD oldPlayer)
+{
+	DPWireCreatePlayer msg;
+	memset(&msg, 0, sizeof(msg)); // the pointers are set by the receiver
+	msg.dwType = DPSYS_CREATEPLAYERORGROUP;
+	msg.dwPlayerType = DPPLAYERTYPE_PLAYER;
+	msg.dpId = id;
+	msg.dwCurrentPlayers = oldPlayer;
+	msg.dwDataSize = dataSize;
+	msg.dpnName.dwSize = sizeof(DPWireName);
+
+	DPMsg dpMsg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_SYSTEM);
+	dpMsg.AddToSerialize(msg);
+
+	DPNameNet netName;
+	CopyName(netName.shortName, sizeof(netName.shortName), shortName);
+	CopyName(netName.longName, sizeof(netName.longName), longName);
+	dpMsg.AddToSerialize(netName);
+
+	if (dataSize)
+		dpMsg.AddToSerialize((LPVOID)data, dataSize);
+
+	return dpMsg.Serialize();
+}
+
+ENetPacket* DPMsg::DestroyPlayer(DPID id, DWORD localDataSize, DWORD remoteDataSize, DWORD flags)
+{
+	DPWireDestroyPlayer msg;
+	memset(&msg, 0, sizeof(msg)); // the data is added by the receiver
+	msg.dwType = DPSYS_DESTROYPLAYERORGROUP;
+	msg.dwPlayerType = DPPLAYERTYPE_PLAYER;
+	msg.dpId = id;
+	msg.dwLocalDataSize = localDataSize;
+	msg.dwRemoteDataSize = remoteDataSize;
+	msg.dwFlags = flags;
+
+	DPMsg dpMsg(id, DPID_SYSMSG, DPMSG_TYPE_SYSTEM);
+	dpMsg.AddToSerialize(msg);
+	return dpMsg.Serialize();
+}
+
+ENetPacket* DPMsg::NewId(DPID id, ULONGLONG resumeToken)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_NEWID);
+	msg.AddToSerialize(id);
+	msg.AddToSerialize(resumeToken);
+	DWORD caps = DP_CAPS;
+	msg.AddToSerialize(caps);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::Resume(DPID id, ULONGLONG resumeToken, const DWORD received[DP_RESUME_LOG_CHANNELS])
+{
+	DPResumeInfo info;
+	info.id = id;
+	info.token = resumeToken;
+	memcpy_s(info.received, sizeof(info.received), received, sizeof(info.received));
+
+	DPMsg msg(id, DPID_SYSMSG, DPMSG_TYPE_RESUME);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::ResumeAck(DWORD accepted, const DWORD received[DP_RESUME_LOG_CHANNELS])
+{
+	DPResumeAckInfo info;
+	info.accepted = accepted;
+	memcpy_s(info.received, sizeof(info.received), received, sizeof(info.received));
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_RESUME_ACK);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::Rejoin(DPID id, ULONGLONG resumeToken)
+{
+	DPMigrateRosterEntry info;
+	info.id = id;
+	info.token = resumeToken;
+
+	DPMsg msg(id, DPID_SYSMSG, DPMSG_TYPE_REJOIN);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::MigrateInfo(const DPMigrateInfo& info)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_MIGRATE_INFO);
+	msg.AddToSerialize((LPVOID)&info, sizeof(info));
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::MigrateRoster(const std::vector<DPMigrateRosterEntry>& roster)
+{
+	DWORD count = (DWORD)roster.size();
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_MIGRATE_ROSTER);
+	msg.AddToSerialize(count);
+
+	if (count)
+		msg.AddToSerialize((LPVOID)roster.data(), count * sizeof(DPMigrateRosterEntry));
+
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::HostChanged()
+{
+	DPWireHost host;
+	host.dwType = DPSYS_HOST;
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_SYSTEM);
+	msg.AddToSerialize(host);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::MtuProbe(DWORD mtu)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_MTU_PROBE);
+	msg.AddToSerialize(mtu);
+	return msg.Serialize(); // padded up to the probed size when sent
+}
+
+ENetPacket* DPMsg::MtuProbeAck(DWORD mtu)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_MTU_PROBE_ACK);
+	msg.AddToSerialize(mtu);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::Dictionary(DWORD id)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_DICTIONARY);
+	msg.AddToSerialize(id);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::FecReport(DWORD received, DWORD lost)
+{
+	DPFecReport report = { received, lost };
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_FEC_REPORT);
+	msg.AddToSerialize(report);
+	return msg.Serialize(0); // the totals are sent again, a lost report costs nothing
+}
+
+ENetPacket* DPMsg::Relay(uint8_t channel, ENetPacket* pk, BYTE flags)
+{
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_RELAY);
+	msg.AddToSerialize(channel);
+	msg.AddToSerialize(flags);
+	msg.AddToSerialize(pk->data, pk->dataLength);
+	return msg.Serialize(pk->flags & ENET_PACKET_FLAG_RELIABLE);
+}
+
+ENetPacket* DPMsg::RelayAttach(DPID parent, const ENetAddress& parentAddr)
+{
+	DPRelayAttachInfo info;
+	info.parent = parent;
+	info.parentAddr = parentAddr;
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_RELAY_ATTACH);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::Shared(DWORD op, const char* name)
+{
+	DPSharedInfo info;
+	memset(&info, 0, sizeof(info));
+	info.op = op;
+	CopyName(info.name, sizeof(info.name), name);
+
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_SHARED);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
+
+ENetPacket* DPMsg::CreateRoomInfo(GUID roomId, DWORD maxPlayers, DWORD currPlayers, const char* sessionName, const DWORD user[4], DWORD dwFlags)
+{
+	DPGameInfo info;
+	info.session = roomId;
+	info.maxPlayers = maxPlayers;
+	info.currPlayers = currPlayers;
+	CopyName(info.sessionName, sizeof(info.sessionName), sessionName);
+	memcpy_s(info.user, sizeof(info.user), user, sizeof(info.user));
+	info.flags = dwFlags;
+	DPMsg msg(DPID_SYSMSG, DPID_SYSMSG, DPMSG_TYPE_GAME_INFO);
+	msg.AddToSerialize(info);
+	return msg.Serialize();
+}
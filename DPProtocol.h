@@ -0,0 +1,293 @@
+/*!
+	@author Arves100
+	@file DPProtocol.h
+	@date 19/10/2026
+	@brief NetLib wire protocol, shared by the game and the relay server
+*/
+#pragma once
+
+#ifndef DP_RELAY_SERVER
+#include <Windows.h>
+#include <dplay.h>
+#else
+// the relay server builds without the Windows and DirectPlay headers
+#include <cstdint>
+#include <cstring>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t ULONGLONG;
+typedef BYTE* LPBYTE;
+typedef void* LPVOID;
+typedef DWORD DPID;
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+
+#define DPID_SYSMSG 0
+#define DPID_ALLPLAYERS 0
+#define DPSYS_CREATEPLAYERORGROUP 0x0003
+#define DPSYS_DESTROYPLAYERORGROUP 0x0005
+#define DPSYS_HOST 0x0101
+#define DPPLAYERTYPE_PLAYER 0x00000001
+#define DPPLAYER_SERVERPLAYER 0x00000100
+#define DPPLAYER_SPECTATOR 0x00000200
+
+inline int memcpy_s(void* dest, size_t destSize, const void* src, size_t count)
+{
+	if (count > destSize)
+		return 1;
+
+	memcpy(dest, src, count);
+	return 0;
+}
+#endif
+
+#include <vector>
+#include "enet.h"
+
+#define FURFIGHTERS_PORT 24900U
+#define DP_RENDEZVOUS_PORT 24899U // rendezvous service of the relay server, below the ports of its sessions
+#define DP_RENDEZVOUS_MAGIC 0x5A524450 // "DPRZ"
+#define DP_SESSION_CODE_SIZE 8 // characters of a session code, a player joins with it in place of the address of the game host
+#define DP_RESUME_LOG_CHANNELS 4 // the received counters of every channel are part of the resume messages
+
+enum ENetChannels
+{
+	ENET_CHANNEL_NORMAL,
+	ENET_CHANNEL_CHAT,
+	ENET_CHANNEL_MAX,
+};
+
+static_assert(ENET_CHANNEL_MAX <= DP_RESUME_LOG_CHANNELS, "Resume log cannot track all the channels");
+
+/*!
+* @brief Splits "host", "host:port", "[ipv6]" or "[ipv6]:port", a bare ipv6 address has many colons and no port
+* @param address Address to split, changed in place
+* @param port Set when the address has one
+* @return The host, nullptr if a bracket is not closed
+*/
+char* DPSplitAddress(char* address, uint16_t* port);
+
+enum ENetConnectTypes
+{
+	ENET_CONNECT_ENUM,
+	ENET_CONNECT_JOIN,
+	ENET_CONNECT_RESUME,
+	ENET_CONNECT_REJOIN,
+	ENET_CONNECT_RELAY,
+	ENET_CONNECT_RELAY_CATCHUP, // the spectator just joined, it needs a checkpoint
+};
+
+enum DPMsgTypes
+{
+	DPMSG_TYPE_SYSTEM = 0,
+	DPMSG_TYPE_NEWID = 1,
+	DPMSG_TYPE_CALL_NEWID = 2,
+	DPMSG_TYPE_GAME_INFO = 3,
+	DPMSG_TYPE_CHAT = 4,
+	DPMSG_TYPE_GAME = 5,
+	DPMSG_TYPE_REMOTEINFO = 6,
+	DPMSG_TYPE_RESUME = 7,
+	DPMSG_TYPE_RESUME_ACK = 8,
+	DPMSG_TYPE_MIGRATE_INFO = 9,
+	DPMSG_TYPE_MIGRATE_ROSTER = 10,
+	DPMSG_TYPE_REJOIN = 11,
+	DPMSG_TYPE_MTU_PROBE = 12,
+	DPMSG_TYPE_MTU_PROBE_ACK = 13,
+	DPMSG_TYPE_FEC_DATA = 14,
+	DPMSG_TYPE_FEC_PARITY = 15,
+	DPMSG_TYPE_DICTIONARY = 16,
+	DPMSG_TYPE_COMPRESSED = 17,
+	DPMSG_TYPE_DELTA = 18,
+	DPMSG_TYPE_DELTA_ACK = 19,
+	DPMSG_TYPE_RELAY = 20,
+	DPMSG_TYPE_RELAY_ATTACH = 21,
+	DPMSG_TYPE_SHARED = 22,
+	DPMSG_TYPE_FEC_REPORT = 23,
+};
+
+enum DPMsgFlags
+{
+	DPMSG_FLAG_GUARANTEED = 1, // the game sent it with DPSEND_GUARANTEED, the receiver never drops it
+};
+
+enum DPCapabilities
+{
+	DP_CAPS_MSG_FLAGS = 1, // fills the flags of the message header, the older builds send that byte uninitialized
+};
+
+#define DP_CAPS (DP_CAPS_MSG_FLAGS) // sent at the end of CALL_NEWID and NEWID, the older builds do not read it
+
+enum DPResumeAckTypes
+{
+	DP_RESUME_REFUSED = 0,
+	DP_RESUME_RESUMED = 1,
+	DP_RESUME_REJOINED = 2,
+};
+
+struct DPGameInfo
+{
+	GUID session;
+	DWORD maxPlayers;
+	DWORD currPlayers;
+	char sessionName[100];
+	DWORD user[4];
+	DWORD flags;
+};
+
+struct DPPlayerInfo
+{
+	DPID id;
+	char name[40];
+	char longName[100];
+	DWORD curr;
+	DWORD dwDataSize;
+	DWORD dwFlags;
+};
+
+struct DPResumeInfo
+{
+	DPID id;
+	ULONGLONG token;
+	DWORD received[DP_RESUME_LOG_CHANNELS];
+};
+
+struct DPResumeAckInfo
+{
+	DWORD accepted;
+	DWORD received[DP_RESUME_LOG_CHANNELS];
+};
+
+struct DPMigrateInfo
+{
+	DPGameInfo session;
+	DPID successor;
+	DPID nextId;
+	ENetAddress successorAddr;
+};
+
+struct DPMigrateRosterEntry
+{
+	DPID id;
+	ULONGLONG token;
+};
+
+#define DP_RELAY_CHECKPOINT 1 // the message is part of a checkpoint, only a spectator that is catching up uses it
+
+struct DPRelayAttachInfo
+{
+	DPID parent;
+	ENetAddress parentAddr;
+};
+
+#define DP_SHARED_NAME_SIZE 64
+
+enum DPSharedOps
+{
+	DP_SHARED_OFFER, // the name of the ring we write to the peer
+	DP_SHARED_ACCEPT, // the peer mapped our ring
+	DP_SHARED_SWITCH, // our next messages to the peer are in the ring, the last one on enet
+};
+
+struct DPSharedInfo
+{
+	DWORD op;
+	char name[DP_SHARED_NAME_SIZE];
+};
+
+struct DPFecInfo
+{
+	WORD group;
+	BYTE index;
+	BYTE count;
+};
+
+struct DPFecReport
+{
+	DWORD received; // unreliable packets received from the peer since it connected
+	DWORD lost; // gaps in their sequence
+};
+
+struct DPNameNet
+{
+	char shortName[30];
+	char longName[100];
+};
+
+enum DPRendezvousTypes
+{
+	DP_RENDEZVOUS_REGISTER, // game host -> service, the service learns its public endpoint
+	DP_RENDEZVOUS_LOOKUP, // player -> service
+	DP_RENDEZVOUS_PEER, // service -> both, the public endpoint of the other one
+	DP_RENDEZVOUS_UNKNOWN, // service -> player, no game host has that code
+	DP_RENDEZVOUS_RELAY, // player -> service, the punching failed and the service forwards for us
+	DP_RENDEZVOUS_PUNCH, // between the two, opens the mappings of their NATs
+};
+
+#define DP_RENDEZVOUS_FLAG_HOST 1 // the punch comes from the game host, a relay learns its two ends from the punches
+
+// plain datagram on the socket of the enet host, every field in network order
+struct DPRendezvousMsg
+{
+	WORD peerID; // all ones, enet ignores it
+	WORD type;
+	DWORD magic;
+	char code[DP_SESSION_CODE_SIZE];
+	BYTE address[16]; // all zeros is the address of the service itself
+	WORD port;
+	WORD flags;
+};
+
+// DirectPlay system messages as they are on the wire (32 bit pointers), the relay server cannot use the DirectPlay ones
+// and the receiver copies them to the DirectPlay ones, that are bigger when the pointers are 64 bit (the tests)
+
+struct DPWireName
+{
+	DWORD dwSize;
+	DWORD dwFlags;
+	DWORD lpszShortName;
+	DWORD lpszLongName;
+};
+
+struct DPWireCreatePlayer
+{
+	DWORD dwType;
+	DWORD dwPlayerType;
+	DPID dpId;
+	DWORD dwCurrentPlayers;
+	DWORD lpData;
+	DWORD dwDataSize;
+	DPWireName dpnName;
+	DPID dpIdParent;
+	DWORD dwFlags;
+};
+
+struct DPWireDestroyPlayer
+{
+	DWORD dwType;
+	DWORD dwPlayerType;
+	DPID dpId;
+	DWORD lpLocalData;
+	DWORD dwLocalDataSize;
+	DWORD lpRemoteData;
+	DWORD dwRemoteDataSize;
+	DPWireName dpnName;
+	DPID dpIdParent;
+	DWORD dwFlags;
+};
+
+struct DPWireHost
+{
+	DWORD dwType;
+};
+
+static_assert(sizeof(DPWireCreatePlayer) == 48, "Wire layout of DPMSG_CREATEPLAYERORGROUP changed");
+static_assert(sizeof(DPWireDestroyPlayer) == 52, "Wire layout of DPMSG_DESTROYPLAYERORGROUP changed");
+static_assert(sizeof(DPWireHost) == 4, "Wire layout of DPMSG_HOST changed");
@@ -0,0 +1,233 @@
+/*!
+	@author Arves100
+	@file DPRelayTree.h
+	@date 19/10/2026
+	@brief Tree of the spectators that relay the broadcasts of the host
+*/
+#pragma once
+
+#define DP_RELAY_HOST 0 // parent of the spectators fed directly by the host
+#define DP_RELAY_HOST_FANOUT 2 // spectators fed by the host
+#define DP_RELAY_FANOUT 3 // spectators fed by every spectator
+#define DP_RELAY_PEERS (DP_RELAY_FANOUT + 3) // peers of a spectator: the host, the parent, the children and an old parent that is disconnecting
+
+/*!
+	@class DPRelayTree
+	Keeps the spectators in a tree, the host sends the broadcasts only to the first ones and every
+	spectator forwards them to its children, so the upload of the host does not grow with the
+	spectators. New spectators are attached to the free slot closest to the host
+*/
+class DPRelayTree
+{
+public:
+	DPRelayTree() : m_nHostChildren(0)
+	{
+	}
+
+	/*!
+	* @brief Attaches a spectator, or moves an orphan, to the free slot closest to the host
+	* @param id Spectator
+	* @return The new parent of the spectator
+	*/
+	DPID Attach(DPID id)
+	{
+		auto it = m_vNodes.find(id);
+
+		if (it == m_vNodes.end())
+		{
+			it = m_vNodes.insert({ id, Node() }).first;
+			m_vOrder.push_back(id);
+		}
+		else if (it->second.attached)
+			return it->second.parent;
+
+		auto parent = FindParent(id);
+		it->second.parent = parent;
+		it->second.attached = true;
+		AddChild(parent, 1);
+		return parent;
+	}
+
+	/*!
+	* @brief Removes a spectator
+	* @param id Spectator
+	* @return Children of the spectator, they must be attached again
+	*/
+	std::vector<DPID> Detach(DPID id)
+	{
+		std::vector<DPID> orphans;
+		auto it = m_vNodes.find(id);
+
+		if (it == m_vNodes.end())
+			return orphans;
+
+		if (it->second.attached)
+			AddChild(it->second.parent, -1);
+
+		m_vNodes.erase(it);
+		m_vOrder.erase(std::remove(m_vOrder.begin(), m_vOrder.end(), id), m_vOrder.end());
+
+		for (auto& n : m_vNodes)
+		{
+			if (!n.second.attached || n.second.parent != id)
+				continue;
+
+			n.second.attached = false;
+			orphans.push_back(n.first);
+		}
+
+		return orphans;
+	}
+
+	/*!
+	* @brief Moves a spectator that lost its parent to the host
+	* @param id Spectator
+	* @param lost Parent that the spectator lost
+	* @return false if the spectator was already moved somewhere else
+	*/
+	bool FallBack(DPID id, DPID lost)
+	{
+		auto it = m_vNodes.find(id);
+
+		if (it == m_vNodes.end() || !it->second.attached || it->second.parent != lost || lost == DP_RELAY_HOST)
+			return false;
+
+		AddChild(lost, -1);
+		it->second.parent = DP_RELAY_HOST;
+		AddChild(DP_RELAY_HOST, 1);
+		return true;
+	}
+
+	std::vector<DPID> GetChildren(DPID parent) const
+	{
+		std::vector<DPID> children;
+
+		for (auto id : m_vOrder)
+		{
+			auto& n = m_vNodes.at(id);
+
+			if (n.attached && n.parent == parent)
+				children.push_back(id);
+		}
+
+		return children;
+	}
+
+	bool IsEmpty() const { return m_vNodes.empty(); }
+
+	void Clear()
+	{
+		m_vNodes.clear();
+		m_vOrder.clear();
+		m_nHostChildren = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		size_t depth = 0;
+
+		for (auto id : m_vOrder)
+		{
+			auto d = GetDepth(id);
+
+			if (d != SIZE_MAX && d > depth)
+				depth = d;
+		}
+
+		printf("[LOADER] Relay tree: %u spectators, %u fed by the host, depth %u\n", (DWORD)m_vNodes.size(), (DWORD)m_nHostChildren, (DWORD)depth);
+#endif
+	}
+
+private:
+	struct Node
+	{
+		Node() : parent(DP_RELAY_HOST), children(0), attached(false) {}
+
+		DPID parent;
+		size_t children;
+		bool attached;
+	};
+
+	void AddChild(DPID parent, int n)
+	{
+		if (parent == DP_RELAY_HOST)
+			m_nHostChildren += n;
+		else
+		{
+			auto it = m_vNodes.find(parent);
+
+			if (it != m_vNodes.end())
+				it->second.children += n;
+		}
+	}
+
+	// Distance from the host, SIZE_MAX if the spectator is not reachable (one of its parents is an orphan)
+	size_t GetDepth(DPID id) const
+	{
+		size_t depth = 1;
+
+		for (;;)
+		{
+			auto it = m_vNodes.find(id);
+
+			if (it == m_vNodes.end() || !it->second.attached || depth > m_vNodes.size())
+				return SIZE_MAX;
+
+			if (it->second.parent == DP_RELAY_HOST)
+				return depth;
+
+			id = it->second.parent;
+			depth++;
+		}
+	}
+
+	bool IsInSubtree(DPID id, DPID root) const
+	{
+		for (size_t i = 0; i <= m_vNodes.size(); i++)
+		{
+			if (id == root)
+				return true;
+
+			auto it = m_vNodes.find(id);
+
+			if (it == m_vNodes.end() || !it->second.attached || it->second.parent == DP_RELAY_HOST)
+				return false;
+
+			id = it->second.parent;
+		}
+
+		return false;
+	}
+
+	DPID FindParent(DPID id) const
+	{
+		if (m_nHostChildren < DP_RELAY_HOST_FANOUT)
+			return DP_RELAY_HOST;
+
+		DPID best = DP_RELAY_HOST;
+		size_t bestDepth = SIZE_MAX;
+
+		for (auto n : m_vOrder)
+		{
+			auto& node = m_vNodes.at(n);
+
+			if (node.children >= DP_RELAY_FANOUT || IsInSubtree(n, id))
+				continue;
+
+			auto depth = GetDepth(n);
+
+			if (depth < bestDepth)
+			{
+				best = n;
+				bestDepth = depth;
+			}
+		}
+
+		return best; // the host takes it when the tree is full, or broken
+	}
+
+	std::unordered_map<DPID, Node> m_vNodes;
+	std::vector<DPID> m_vOrder; // join order, older spectators are closer to the host
+	size_t m_nHostChildren;
+};
@@ -0,0 +1,358 @@
+/*!
+	@author Arves100
+	@file DPRendezvous.h
+	@date 19/10/2026
+	@brief UDP hole punching through the rendezvous service of a relay server
+*/
+#pragma once
+
+#include "DPProtocol.h"
+#include <string>
+
+#define DP_RENDEZVOUS_REFRESH 15000 // ms between two registrations of the game host, the NATs keep an idle UDP mapping for 30 s at least
+#define DP_RENDEZVOUS_RETRY 250 // ms between two requests to the service while we wait for its answer
+#define DP_RENDEZVOUS_WAIT 1500 // ms the service has to answer
+#define DP_RENDEZVOUS_PUNCH_INTERVAL 50
+#define DP_RENDEZVOUS_PUNCH_TIME 2000 // ms of punching before falling back to the relay of the service
+#define DP_RENDEZVOUS_TARGETS 16 // players the game host punches toward at the same time
+
+/*!
+	@class DPRendezvous
+	Finds the public endpoint of the other side of a connection through the rendezvous service and
+	opens the NATs of both sides with datagrams sent from the socket of the enet host, so enet connects
+	to a mapping that already exists. The game host registers its session code and punches toward
+	every player the service tells it about, a player looks the code up and punches back; when the
+	punches do not meet the service forwards the datagrams between the two.
+	The datagrams of the service reach us through the firewall of the host
+*/
+class DPRendezvous
+{
+public:
+	DPRendezvous()
+	{
+		memset(&m_eServer, 0, sizeof(m_eServer));
+		Reset();
+	}
+
+	/*!
+	* @brief Sets the service
+	* @param server "host[:port]" of the service
+	* @return false if the host cannot be resolved
+	*/
+	bool SetServer(const char* server)
+	{
+		std::vector<char> s(server, server + strlen(server) + 1);
+
+		memset(&m_eServer, 0, sizeof(m_eServer));
+		m_eServer.port = (uint16_t)DP_RENDEZVOUS_PORT;
+		auto host = DPSplitAddress(s.data(), &m_eServer.port);
+		return host && enet_address_set_hostname(&m_eServer, host) == 0;
+	}
+
+	/*!
+	* @brief Registers the session of a game host, the registration is renewed by Update
+	* @param code Session code the players join with
+	*/
+	void Register(ENetHost* host, const char* code)
+	{
+		SetCode(code);
+		m_bRegistered = true;
+		m_dwNextRegister = enet_time_get();
+		Update(host);
+	}
+
+	/*!
+	* @brief Renews the registration and sends the punches that are due
+	*/
+	void Update(ENetHost* host)
+	{
+		auto now = enet_time_get();
+
+		if (m_bRegistered && (int32_t)(now - m_dwNextRegister) >= 0)
+		{
+			Send(host, &m_eServer, DP_RENDEZVOUS_REGISTER);
+			m_dwNextRegister = now + DP_RENDEZVOUS_REFRESH;
+		}
+
+		for (auto& t : m_vTargets)
+		{
+			if (!t.used)
+				continue;
+
+			if ((int32_t)(now - t.until) >= 0)
+				t.used = false;
+			else if ((int32_t)(now - t.next) >= 0)
+			{
+				Send(host, &t.address, DP_RENDEZVOUS_PUNCH);
+				t.next = now + DP_RENDEZVOUS_PUNCH_INTERVAL;
+			}
+		}
+	}
+
+	/*!
+	* @brief Finds the game host of a session code and punches toward it, blocks until it is done
+	* @param code Session code of the game host
+	* @param out Endpoint enet connects to, the game host or the relay of the service
+	* @return false if the code is unknown or the service does not answer
+	*/
+	bool Lookup(ENetHost* host, const char* code, ENetAddress* out)
+	{
+		SetCode(code);
+
+		if (!Punch(host, DP_RENDEZVOUS_LOOKUP))
+		{
+			if (m_state == STATE_FAILED)
+			{
+				m_state = STATE_IDLE;
+				return false;
+			}
+
+			// symmetric NATs map every destination to its own port, the endpoint we learnt is not the one that answers us
+			m_dwRelayed++;
+
+#ifdef _DEBUG
+			printf("[LOADER] Hole punching failed, connecting through the relay of the service\n");
+#endif
+
+			if (!Punch(host, DP_RENDEZVOUS_RELAY))
+			{
+				m_state = STATE_IDLE;
+				return false;
+			}
+		}
+
+		*out = m_ePeer;
+		return true;
+	}
+
+	/*!
+	* @brief Handles a datagram of the service or of the other side
+	* @param from Source of the datagram
+	*/
+	void Receive(ENetHost* host, const ENetAddress* from, const DPRendezvousMsg* msg)
+	{
+		auto type = ENET_NET_TO_HOST_16(msg->type);
+
+		if (type == DP_RENDEZVOUS_PUNCH)
+		{
+			m_dwPunches++;
+
+			if (m_state == STATE_PUNCHING && IsSameHost(from, &m_ePeer))
+			{ // the port can differ from the one the service saw when the NAT of the game host maps again
+				m_ePeer = *from;
+				m_state = STATE_PUNCHED;
+				Send(host, from, DP_RENDEZVOUS_PUNCH);
+				return;
+			}
+
+			for (auto& t : m_vTargets)
+			{
+				if (t.used && IsSameHost(from, &t.address))
+				{ // the player is through, answer until it stops punching
+					Send(host, from, DP_RENDEZVOUS_PUNCH);
+					return;
+				}
+			}
+
+			return;
+		}
+
+		if (!IsSameHost(from, &m_eServer) || from->port != m_eServer.port || memcmp(msg->code, m_szCode, DP_SESSION_CODE_SIZE) != 0)
+			return; // only the service tells us about a peer
+
+		if (type == DP_RENDEZVOUS_UNKNOWN)
+		{
+			if (m_state == STATE_WAITING)
+				m_state = STATE_FAILED;
+
+			return;
+		}
+
+		if (type != DP_RENDEZVOUS_PEER)
+			return;
+
+		ENetAddress peer;
+		GetAddress(msg, &peer);
+
+		if (m_state == STATE_WAITING)
+		{
+			m_ePeer = peer;
+			m_state = STATE_PUNCHING;
+			return;
+		}
+
+		if (!m_bRegistered)
+			return;
+
+		// a player joins, punch toward it until it answers
+		Target* slot = nullptr;
+
+		for (auto& t : m_vTargets)
+		{
+			if (t.used && IsSameHost(&t.address, &peer) && t.address.port == peer.port)
+			{
+				slot = &t;
+				break;
+			}
+
+			if (!t.used && !slot)
+				slot = &t;
+		}
+
+		if (!slot)
+			return;
+
+		slot->address = peer;
+		slot->next = host->serviceTime;
+		slot->until = host->serviceTime + DP_RENDEZVOUS_PUNCH_TIME;
+		slot->used = true;
+		Send(host, &peer, DP_RENDEZVOUS_PUNCH);
+	}
+
+	void Reset()
+	{
+		m_bRegistered = false;
+		m_state = STATE_IDLE;
+		memset(m_szCode, 0, sizeof(m_szCode));
+		memset(m_vTargets, 0, sizeof(m_vTargets));
+		memset(&m_ePeer, 0, sizeof(m_ePeer));
+		m_dwNextRegister = 0;
+		m_dwPunches = 0;
+		m_dwRelayed = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Rendezvous: %u punches received, %u relayed connections\n", m_dwPunches, m_dwRelayed);
+#endif
+	}
+
+private:
+	enum State
+	{
+		STATE_IDLE,
+		STATE_WAITING, // for the service
+		STATE_PUNCHING,
+		STATE_PUNCHED,
+		STATE_FAILED,
+	};
+
+	struct Target
+	{
+		ENetAddress address;
+		uint32_t next;
+		uint32_t until;
+		bool used;
+	};
+
+	/*!
+	* @brief Asks the service for the other side and punches toward it
+	* @param type DP_RENDEZVOUS_LOOKUP or DP_RENDEZVOUS_RELAY
+	* @return true when the punches of the other side reach us, the state is STATE_FAILED when the service gave us no peer
+	*/
+	bool Punch(ENetHost* host, WORD type)
+	{
+		m_state = STATE_WAITING;
+
+		auto start = enet_time_get();
+		auto next = start;
+
+		while (m_state == STATE_WAITING && (int32_t)(enet_time_get() - start) < DP_RENDEZVOUS_WAIT)
+		{
+			if ((int32_t)(enet_time_get() - next) >= 0)
+			{
+				Send(host, &m_eServer, type);
+				next += DP_RENDEZVOUS_RETRY;
+			}
+
+			Wait(host);
+		}
+
+		if (m_state != STATE_PUNCHING)
+		{
+#ifdef _DEBUG
+			printf("[LOADER] The rendezvous service does not know the session %.8s\n", m_szCode);
+#endif
+			m_state = STATE_FAILED;
+			return false;
+		}
+
+		start = next = enet_time_get();
+
+		while (m_state == STATE_PUNCHING && (int32_t)(enet_time_get() - start) < DP_RENDEZVOUS_PUNCH_TIME)
+		{
+			if ((int32_t)(enet_time_get() - next) >= 0)
+			{
+				Send(host, &m_ePeer, DP_RENDEZVOUS_PUNCH);
+				next += DP_RENDEZVOUS_PUNCH_INTERVAL;
+			}
+
+			Wait(host);
+		}
+
+		auto punched = m_state == STATE_PUNCHED;
+		m_state = STATE_IDLE;
+		return punched;
+	}
+
+	/*!
+	* @brief Lets the host receive, the firewall hands our datagrams to Receive
+	*/
+	static void Wait(ENetHost* host)
+	{
+		ENetEvent evt;
+		enet_host_service(host, &evt, 10); // no peer yet, nothing else can happen
+	}
+
+	void SetCode(const char* code)
+	{ // not terminated on the wire when it is DP_SESSION_CODE_SIZE long
+		memset(m_szCode, 0, sizeof(m_szCode));
+		memcpy(m_szCode, code, strnlen(code, DP_SESSION_CODE_SIZE));
+	}
+
+	void Send(ENetHost* host, const ENetAddress* to, WORD type)
+	{
+		DPRendezvousMsg msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.peerID = 0xFFFF;
+		msg.type = ENET_HOST_TO_NET_16(type);
+		msg.magic = ENET_HOST_TO_NET_32(DP_RENDEZVOUS_MAGIC);
+		memcpy(msg.code, m_szCode, DP_SESSION_CODE_SIZE);
+		msg.flags = ENET_HOST_TO_NET_16(m_bRegistered ? DP_RENDEZVOUS_FLAG_HOST : 0);
+
+		ENetBuffer buf;
+		buf.data = &msg;
+		buf.dataLength = sizeof(msg);
+		enet_socket_send(host->socket, to, &buf, 1);
+	}
+
+	/*!
+	* @brief Endpoint of a message, all zeros is the service with the port of the message
+	*/
+	void GetAddress(const DPRendezvousMsg* msg, ENetAddress* out) const
+	{
+		static const BYTE zeros[sizeof(msg->address)] = { 0 };
+
+		memset(out, 0, sizeof(*out));
+		memcpy(&out->ipv6, memcmp(msg->address, zeros, sizeof(zeros)) ? (const void*)msg->address : (const void*)&m_eServer.ipv6, sizeof(msg->address));
+		out->port = ENET_NET_TO_HOST_16(msg->port);
+	}
+
+	static bool IsSameHost(const ENetAddress* a, const ENetAddress* b)
+	{
+		return memcmp(&a->ipv6, &b->ipv6, sizeof(in6_addr)) == 0;
+	}
+
+	ENetAddress m_eServer;
+	ENetAddress m_ePeer; // the other side while we punch
+	char m_szCode[DP_SESSION_CODE_SIZE];
+	bool m_bRegistered; // we are a game host
+	State m_state;
+	uint32_t m_dwNextRegister;
+	Target m_vTargets[DP_RENDEZVOUS_TARGETS];
+
+	// Statistics
+	DWORD m_dwPunches;
+	DWORD m_dwRelayed;
+};
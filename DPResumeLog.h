@@ -0,0 +1,113 @@
+/*!
+	@author Arves100
+	@file DPResumeLog.h
+	@date 19/10/2026
+	@brief Bounded retransmit log for session resumption
+*/
+#pragma once
+
+#include "DPProtocol.h"
+
+#define DP_RESUME_LOG_PACKETS 512
+#define DP_RESUME_LOG_BYTES (256 * 1024)
+
+/*!
+	@class DPResumeLog
+	Keeps a copy of the last reliable packets sent to a peer, numbered per channel,
+	so the ones the peer did not receive can be replayed when it resumes the session
+*/
+class DPResumeLog
+{
+public:
+	DPResumeLog(size_t maxPackets, size_t maxBytes) : m_nMaxPackets(maxPackets), m_nMaxBytes(maxBytes), m_nBytes(0)
+	{
+		Reset();
+	}
+
+	/*!
+	* @brief Stores a copy of a reliable packet, older packets are dropped when the log is full
+	* @param pk Packet to store (ownership is not taken)
+	* @param channel ENet channel where the packet is sent
+	*/
+	void Store(const ENetPacket* pk, uint8_t channel)
+	{
+		if (!(pk->flags & ENET_PACKET_FLAG_RELIABLE) || channel >= DP_RESUME_LOG_CHANNELS)
+			return;
+
+		while (!m_vEntries.empty() && (m_vEntries.size() >= m_nMaxPackets || (m_nBytes + pk->dataLength) > m_nMaxBytes))
+		{
+			const auto& e = m_vEntries.front();
+			m_adwTrimmed[e.channel] = e.seq;
+			m_nBytes -= e.data.size();
+			m_vEntries.pop_front();
+		}
+
+		Entry e;
+		e.channel = channel;
+		e.seq = ++m_adwSent[channel];
+		e.data.assign(pk->data, pk->data + pk->dataLength);
+
+		m_nBytes += pk->dataLength;
+		m_vEntries.push_back(std::move(e));
+	}
+
+	/*!
+	* @brief Checks if all the packets the peer did not receive are still in the log
+	* @param received Number of reliable packets received by the peer for every channel
+	*/
+	bool CanReplay(const DWORD received[DP_RESUME_LOG_CHANNELS]) const
+	{
+		for (size_t i = 0; i < DP_RESUME_LOG_CHANNELS; i++)
+		{
+			if (received[i] < m_adwTrimmed[i] || received[i] > m_adwSent[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	/*!
+	* @brief Sends again the packets that the peer did not receive, in the original order
+	* @param peer Peer that will receive the packets
+	* @param received Number of reliable packets received by the peer for every channel
+	*/
+	void Replay(ENetPeer* peer, const DWORD received[DP_RESUME_LOG_CHANNELS])
+	{
+		for (const auto& e : m_vEntries)
+		{
+			if (e.seq <= received[e.channel])
+				continue;
+
+			auto pk = enet_packet_create(e.data.data(), e.data.size(), ENET_PACKET_FLAG_RELIABLE);
+
+			if (enet_peer_send(peer, e.channel, pk) != 0)
+				enet_packet_destroy(pk);
+		}
+	}
+
+	void Reset()
+	{
+		m_vEntries.clear();
+		m_nBytes = 0;
+		memset(m_adwSent, 0, sizeof(m_adwSent));
+		memset(m_adwTrimmed, 0, sizeof(m_adwTrimmed));
+	}
+
+	size_t GetCount() const { return m_vEntries.size(); }
+	size_t GetBytes() const { return m_nBytes; }
+
+private:
+	struct Entry
+	{
+		uint8_t channel;
+		DWORD seq;
+		std::vector<BYTE> data;
+	};
+
+	std::deque<Entry> m_vEntries;
+	size_t m_nMaxPackets;
+	size_t m_nMaxBytes;
+	size_t m_nBytes;
+	DWORD m_adwSent[DP_RESUME_LOG_CHANNELS];
+	DWORD m_adwTrimmed[DP_RESUME_LOG_CHANNELS];
+};
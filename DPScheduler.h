@@ -0,0 +1,294 @@
+/*!
+	@author Arves100
+	@file DPScheduler.h
+	@date 19/10/2026
+	@brief Outbound priority and deadline scheduler of a peer
+*/
+#pragma once
+
+#define DP_PRIORITY_CLASSES 4 // DirectPlay priorities (0 - DPSEND_MAX_PRIORITY) are split in this many classes
+#define DP_SCHEDULER_BUDGET (16 * 1024) // bytes handed to enet for every peer in a service tick
+
+/*!
+	@class DPScheduler
+	Holds the outgoing messages of a peer, sends the higher priority ones first and drops the ones
+	that passed their deadline before they reach the wire
+*/
+class DPScheduler
+{
+public:
+	DPScheduler() : m_nBytes(0), m_nDeficit(0), m_nPending(0), m_nPendingCap(0), m_ullCongestedSince(0), m_bIsolated(false)
+	{
+		memset(m_aullDelay, 0, sizeof(m_aullDelay));
+		memset(m_adwSent, 0, sizeof(m_adwSent));
+		memset(m_adwDropped, 0, sizeof(m_adwDropped));
+		memset(m_adwMerged, 0, sizeof(m_adwMerged));
+	}
+
+	~DPScheduler()
+	{
+		Clear();
+	}
+
+	static size_t GetClass(DWORD dwPriority)
+	{
+		if (dwPriority > DPSEND_MAX_PRIORITY)
+			dwPriority = DPSEND_MAX_PRIORITY;
+
+		return (size_t)dwPriority * DP_PRIORITY_CLASSES / (DPSEND_MAX_PRIORITY + 1);
+	}
+
+	/*!
+	* @brief Queues a packet, a reference is held until it's sent or dropped
+	* @param pk Packet to send
+	* @param channel ENet channel
+	* @param dwPriority DirectPlay priority (higher is sent first)
+	* @param dwTimeout Milliseconds after the message is dropped, 0 for never
+	* @param key When not 0 the message is not guaranteed, and replaces an older message with the same key while the peer is congested
+	*/
+	void Push(ENetPacket* pk, uint8_t channel, DWORD dwPriority, DWORD dwTimeout, DWORD key = 0)
+	{
+		auto c = GetClass(dwPriority);
+		auto now = GetTickCount64();
+
+		pk->referenceCount++;
+
+		if (key && IsCongested())
+		{ // only the latest update matters
+			for (auto& e : m_aQueues[c])
+			{
+				if (e.key != key || e.channel != channel)
+					continue;
+
+				m_nBytes -= e.pk->dataLength;
+				Release(e.pk);
+
+				e.pk = pk;
+				e.deadline = dwTimeout ? now + dwTimeout : 0;
+				m_nBytes += pk->dataLength;
+				m_adwMerged[c]++;
+				return;
+			}
+		}
+
+		Entry e;
+		e.pk = pk;
+		e.channel = channel;
+		e.key = key;
+		e.queued = now;
+		e.deadline = dwTimeout ? now + dwTimeout : 0;
+
+		m_nBytes += pk->dataLength;
+		m_aQueues[c].push_back(e);
+	}
+
+	/*!
+	* @brief Drops the expired packets and returns the size of the next one
+	* @return Size of the next packet, 0 if the queue is empty
+	*/
+	size_t NextSize()
+	{
+		auto now = GetTickCount64();
+
+		for (size_t c = DP_PRIORITY_CLASSES; c-- > 0;)
+		{
+			auto& q = m_aQueues[c];
+
+			while (!q.empty() && q.front().deadline && now >= q.front().deadline)
+			{
+				m_nBytes -= q.front().pk->dataLength;
+				m_adwDropped[c]++;
+				Release(q.front().pk);
+				q.pop_front();
+			}
+
+			if (!q.empty())
+				return q.front().pk->dataLength;
+		}
+
+		return 0;
+	}
+
+	/*!
+	* @brief Sends the next packet, call NextSize first
+	* @param send Function that sends a packet to the peer
+	*/
+	template <typename F>
+	void SendNext(F send)
+	{
+		for (size_t c = DP_PRIORITY_CLASSES; c-- > 0;)
+		{
+			auto& q = m_aQueues[c];
+
+			if (q.empty())
+				continue;
+
+			auto e = q.front();
+			q.pop_front();
+
+			m_nBytes -= e.pk->dataLength;
+			m_nPending += e.pk->dataLength;
+			m_aullDelay[c] += GetTickCount64() - e.queued;
+			m_adwSent[c]++;
+
+			send(e.pk, e.channel);
+			Release(e.pk);
+			return;
+		}
+	}
+
+	/*!
+	* @brief Hands the queued packets to enet, from the highest priority, until the budget is spent
+	* @param budget Bytes that can be sent (at least one packet is always sent)
+	* @param send Function that sends a packet to the peer
+	*/
+	template <typename F>
+	void Drain(size_t budget, F send)
+	{
+		size_t spent = 0, size;
+
+		while ((size = NextSize()) != 0)
+		{
+			if (spent && spent + size > budget)
+				return;
+
+			spent += size;
+			SendNext(send);
+		}
+	}
+
+	/*!
+	* @brief Drops the packets that passed their deadline anywhere in the queues, not only at the front
+	*/
+	void Expire()
+	{
+		auto now = GetTickCount64();
+
+		for (size_t c = 0; c < DP_PRIORITY_CLASSES; c++)
+		{
+			auto& q = m_aQueues[c];
+
+			for (auto it = q.begin(); it != q.end();)
+			{
+				if (!it->deadline || now < it->deadline)
+				{
+					++it;
+					continue;
+				}
+
+				m_nBytes -= it->pk->dataLength;
+				m_adwDropped[c]++;
+				Release(it->pk);
+				it = q.erase(it);
+			}
+		}
+	}
+
+	/*!
+	* @brief Drops all the queued packets
+	*/
+	void Clear()
+	{
+		for (auto& q : m_aQueues)
+		{
+			for (const auto& e : q)
+				Release(e.pk);
+
+			q.clear();
+		}
+
+		m_nBytes = 0;
+		m_nDeficit = 0;
+	}
+
+	bool IsEmpty() const
+	{
+		for (const auto& q : m_aQueues)
+		{
+			if (!q.empty())
+				return false;
+		}
+
+		return true;
+	}
+
+	size_t GetQueuedBytes() const { return m_nBytes; }
+
+	size_t GetQueuedCount() const
+	{
+		size_t n = 0;
+
+		for (const auto& q : m_aQueues)
+			n += q.size();
+
+		return n;
+	}
+
+	// Fairness between peers
+	size_t GetDeficit() const { return m_nDeficit; }
+	void SetDeficit(size_t deficit) { m_nDeficit = deficit; }
+	size_t GetPending() const { return m_nPending; }
+	size_t GetPendingCap() const { return m_nPendingCap; }
+
+	/*!
+	* @brief Updates the data that enet did not deliver yet to the peer
+	* @param pending Bytes queued in enet
+	* @param cap Limit after the peer is considered congested
+	*/
+	void SetPending(size_t pending, size_t cap)
+	{
+		m_nPending = pending;
+		m_nPendingCap = cap;
+
+		if (pending < cap)
+			m_ullCongestedSince = 0;
+		else if (!m_ullCongestedSince)
+			m_ullCongestedSince = GetTickCount64();
+	}
+
+	bool IsCongested() const { return m_ullCongestedSince != 0; }
+	ULONGLONG GetCongestedTime() const { return m_ullCongestedSince ? GetTickCount64() - m_ullCongestedSince : 0; }
+	bool IsIsolated() const { return m_bIsolated; }
+	void SetIsolated(bool isolated) { m_bIsolated = isolated; }
+
+	DWORD GetSent(size_t c) const { return m_adwSent[c]; }
+	DWORD GetDropped(size_t c) const { return m_adwDropped[c]; }
+	DWORD GetMerged(size_t c) const { return m_adwMerged[c]; }
+	DWORD GetAverageDelay(size_t c) const { return m_adwSent[c] ? (DWORD)(m_aullDelay[c] / m_adwSent[c]) : 0; }
+
+	void Dump(DPID id) const
+	{
+#ifdef _DEBUG
+		for (size_t c = 0; c < DP_PRIORITY_CLASSES; c++)
+			printf("[LOADER] Player %u priority %u: sent %u dropped %u merged %u delay %u ms\n", id, (DWORD)c, GetSent(c), GetDropped(c), GetMerged(c), GetAverageDelay(c));
+#endif
+	}
+
+private:
+	struct Entry
+	{
+		ENetPacket* pk;
+		uint8_t channel;
+		DWORD key;
+		ULONGLONG queued;
+		ULONGLONG deadline;
+	};
+
+	static void Release(ENetPacket* pk)
+	{
+		if (--pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+	}
+
+	std::deque<Entry> m_aQueues[DP_PRIORITY_CLASSES];
+	size_t m_nBytes;
+	size_t m_nDeficit;
+	size_t m_nPending;
+	size_t m_nPendingCap;
+	ULONGLONG m_ullCongestedSince;
+	bool m_bIsolated;
+	ULONGLONG m_aullDelay[DP_PRIORITY_CLASSES];
+	DWORD m_adwSent[DP_PRIORITY_CLASSES];
+	DWORD m_adwDropped[DP_PRIORITY_CLASSES];
+	DWORD m_adwMerged[DP_PRIORITY_CLASSES];
+};
@@ -0,0 +1,114 @@
+/*!
+	@author Arves100
+	@file DPSendTracker.h
+	@date 19/10/2026
+	@brief Completion tracking of asynchronous sends
+*/
+#pragma once
+
+/*!
+	@class DPSendTracker
+	Queues a DPSYS_SENDCOMPLETE message when ENet releases a tracked packet: after the ack of a
+	reliable packet, after an unreliable one is handed to the socket, or when the scheduler drops it
+	because the send timeout expired. Once ENet has the packet the timeout no longer applies, it can
+	still be delivered, so the completion waits for the real result
+*/
+class DPSendTracker
+{
+public:
+	DPSendTracker(DPMsgQueue& queue) : m_vQueue(queue), m_dwNextId(1) {}
+
+	~DPSendTracker()
+	{
+		for (const auto& r : m_vPending)
+			r.second->owner = nullptr; // packets still alive must not call us back
+	}
+
+	/*!
+	* @brief Starts tracking a packet
+	* @return Unique id of the message
+	*/
+	DWORD Track(ENetPacket* pk, DPID idFrom, DPID idTo, DWORD dwFlags, DWORD dwPriority, DWORD dwTimeout, LPVOID lpContext)
+	{
+		auto r = new Record();
+		r->owner = this;
+		r->id = m_dwNextId++;
+		r->from = idFrom;
+		r->to = idTo;
+		r->flags = dwFlags;
+		r->priority = dwPriority;
+		r->timeout = dwTimeout;
+		r->context = lpContext;
+		r->start = GetTickCount64();
+		r->deadline = dwTimeout ? r->start + dwTimeout : 0;
+
+		if (!m_dwNextId)
+			m_dwNextId = 1; // zero is not a valid id
+
+		pk->userData = r;
+		pk->freeCallback = OnPacketFree;
+		m_vPending.insert_or_assign(r->id, r);
+		return r->id;
+	}
+
+	/*!
+	* @brief Stops tracking a message without completing it (the send failed immediately)
+	* @param id Id of the message
+	*/
+	void Forget(DWORD id)
+	{
+		auto it = m_vPending.find(id);
+
+		if (it == m_vPending.end())
+			return;
+
+		it->second->owner = nullptr;
+		m_vPending.erase(it);
+	}
+
+	size_t GetPending() const { return m_vPending.size(); }
+
+private:
+	struct Record
+	{
+		DPSendTracker* owner;
+		DWORD id;
+		DPID from;
+		DPID to;
+		DWORD flags;
+		DWORD priority;
+		DWORD timeout;
+		LPVOID context;
+		ULONGLONG start;
+		ULONGLONG deadline;
+	};
+
+	void Complete(const Record* r, HRESULT hr)
+	{
+		auto msg = std::make_shared<DPMsg>(DPMsg::CreateSendComplete(r->from, r->to, r->flags, r->priority, r->timeout, r->context, r->id, hr, (DWORD)(GetTickCount64() - r->start)), true);
+		m_vQueue.push_back(msg);
+	}
+
+	static void ENET_CALLBACK OnPacketFree(void* p)
+	{
+		auto pk = (ENetPacket*)p;
+		auto r = (Record*)pk->userData;
+
+		if (r->owner)
+		{
+			HRESULT hr = DP_OK;
+
+			if (!(pk->flags & ENET_PACKET_FLAG_SENT)) // dropped by the scheduler or by a peer reset
+				hr = (r->deadline && GetTickCount64() >= r->deadline) ? DPERR_TIMEOUT : DPERR_CONNECTIONLOST;
+
+			r->owner->Complete(r, hr);
+			r->owner->m_vPending.erase(r->id);
+		}
+
+		delete r;
+	}
+
+	DPMsgQueue& m_vQueue;
+	std::unordered_map<DWORD, Record*> m_vPending;
+	DWORD m_dwNextId;
+};
@@ -0,0 +1,715 @@
+/*!
+	@author Arves100
+	@file DPSharedMemory.h
+	@date 19/10/2026
+	@brief Shared-memory transport between the games on the same machine
+*/
+#pragma once
+
+#include "DPMsg.h"
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+
+#ifndef __NR_futex_waitv
+#define __NR_futex_waitv 449 // Linux 5.16, the same number on every architecture
+#endif
+
+#ifndef FUTEX_WAITV_MAX // older headers
+#define FUTEX_32 2
+#define FUTEX_WAITV_MAX 128
+
+struct futex_waitv
+{
+	uint64_t val;
+	uint64_t uaddr;
+	uint32_t flags;
+	uint32_t __reserved;
+};
+#endif
+#endif
+
+#define DP_SHARED_RING_SIZE (1024 * 1024) // bytes of a ring, a power of two
+#define DP_SHARED_MAGIC 0x4D485344 // "DSHM"
+#define DP_SHARED_SKIP 0xFFFFFFFF // record length that sends the reader back to the start of the ring
+#define DP_SHARED_WAIT 1 // ms the service sleeps on the rings, the socket of the other peers waits meanwhile
+
+/*!
+	@class DPSharedRing
+	Ring of messages in a named shared-memory mapping, with one writer and one reader in two
+	processes. The writer only moves the head and the reader only moves the tail, so neither
+	takes a lock; a reader that sleeps is woken by an event (a futex on Linux) that the writer
+	signals only when the reader said it sleeps
+*/
+class DPSharedRing
+{
+public:
+	DPSharedRing() : m_pHeader(nullptr), m_pData(nullptr), m_bOwner(false)
+	{
+#ifdef _WIN32
+		m_hMap = nullptr;
+		m_hEvent = nullptr;
+#endif
+		m_szName[0] = 0;
+	}
+
+	~DPSharedRing() { Close(); }
+
+	DPSharedRing(const DPSharedRing&) = delete;
+	DPSharedRing& operator=(const DPSharedRing&) = delete;
+
+	/*!
+	* @brief Creates the mapping, we are the writer
+	* @return false if the name is taken or the mapping cannot be created
+	*/
+	bool Create(const char* name)
+	{
+		if (!Map(name, true))
+			return false;
+
+		m_pHeader->size = DP_SHARED_RING_SIZE;
+		m_pHeader->head.store(0);
+		m_pHeader->tail.store(0);
+		m_pHeader->sleeping.store(0);
+		m_pHeader->magic = DP_SHARED_MAGIC;
+		return true;
+	}
+
+	/*!
+	* @brief Maps the ring of a peer, we are the reader
+	* @return false if the peer is not on this machine
+	*/
+	bool Open(const char* name)
+	{
+		if (!Map(name, false))
+			return false;
+
+		if (m_pHeader->magic != DP_SHARED_MAGIC || m_pHeader->size != DP_SHARED_RING_SIZE)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+		if (!m_pHeader)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_pHeader);
+		CloseHandle(m_hMap);
+		CloseHandle(m_hEvent);
+		m_hMap = nullptr;
+		m_hEvent = nullptr;
+#else
+		munmap(m_pHeader, sizeof(Header) + DP_SHARED_RING_SIZE);
+
+		if (m_bOwner)
+			shm_unlink(m_szName);
+#endif
+		m_pHeader = nullptr;
+		m_pData = nullptr;
+		m_bOwner = false;
+	}
+
+	bool IsOpen() const { return m_pHeader != nullptr; }
+	bool IsEmpty() const { return m_pHeader->head.load(std::memory_order_acquire) == m_pHeader->tail.load(std::memory_order_relaxed); }
+	const char* GetName() const { return m_szName; }
+
+	/*!
+	* @brief Appends a message
+	* @return false if the ring is full
+	*/
+	bool Write(uint8_t channel, uint8_t flags, const void* data, uint32_t length)
+	{
+		auto need = Align(sizeof(Record) + length);
+
+		if (need > DP_SHARED_RING_SIZE / 2)
+			return false;
+
+		auto head = m_pHeader->head.load(std::memory_order_relaxed);
+		auto offset = head & (DP_SHARED_RING_SIZE - 1);
+		auto room = DP_SHARED_RING_SIZE - offset;
+		auto total = room < need ? room + need : need; // a message is never split, the rest of the ring is skipped
+
+		if (head + total - m_pHeader->tail.load(std::memory_order_acquire) > DP_SHARED_RING_SIZE)
+			return false;
+
+		if (room < need)
+		{
+			((Record*)(m_pData + offset))->length = DP_SHARED_SKIP;
+			head += room;
+			offset = 0;
+		}
+
+		auto rec = (Record*)(m_pData + offset);
+		rec->length = length;
+		rec->channel = channel;
+		rec->flags = flags;
+		rec->reserved = 0;
+		memcpy(rec + 1, data, length);
+
+		m_pHeader->head.store(head + need, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // the reader sets the flag before it looks at the head
+
+		if (m_pHeader->sleeping.load(std::memory_order_relaxed))
+			Wake();
+
+		return true;
+	}
+
+	/*!
+	* @brief Takes the oldest message
+	* @param channel Channel the message was sent on
+	* @return the message as a packet, nullptr if the ring is empty
+	*/
+	ENetPacket* Read(uint8_t* channel)
+	{
+		auto tail = m_pHeader->tail.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			if (m_pHeader->head.load(std::memory_order_acquire) == tail)
+				return nullptr;
+
+			auto offset = tail & (DP_SHARED_RING_SIZE - 1);
+			auto rec = (const Record*)(m_pData + offset);
+
+			if (rec->length == DP_SHARED_SKIP)
+			{
+				tail += DP_SHARED_RING_SIZE - offset;
+				continue;
+			}
+
+			auto pk = enet_packet_create(rec + 1, rec->length, rec->flags);
+			*channel = rec->channel;
+			m_pHeader->tail.store(tail + Align(sizeof(Record) + rec->length), std::memory_order_release);
+			return pk;
+		}
+	}
+
+	/*!
+	* @brief Marks the reader as sleeping, the writer wakes it from now on
+	* @return false if a message arrived meanwhile, the reader must not sleep
+	*/
+	bool PrepareWait()
+	{
+		m_pHeader->sleeping.store(1);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (!IsEmpty())
+		{
+			m_pHeader->sleeping.store(0);
+			return false;
+		}
+
+		return true;
+	}
+
+	void EndWait() { m_pHeader->sleeping.store(0, std::memory_order_relaxed); }
+
+#ifdef _WIN32
+	HANDLE GetEvent() const { return m_hEvent; }
+#else
+	/*!
+	* @brief Sleeps until the writer wakes us or the timeout expires, after PrepareWait
+	*/
+	void Wait(uint32_t timeout)
+	{
+		timespec ts;
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (long)(timeout % 1000) * 1000000;
+		syscall(SYS_futex, &m_pHeader->sleeping, FUTEX_WAIT, 1, &ts, nullptr, 0); // shared, not FUTEX_PRIVATE_FLAG
+	}
+
+	/*!
+	* @brief Fills the wait of our futex for futex_waitv, after PrepareWait
+	*/
+	void GetWait(futex_waitv* w) const
+	{
+		w->val = 1;
+		w->uaddr = (uintptr_t)&m_pHeader->sleeping;
+		w->flags = FUTEX_32; // shared, not FUTEX2_PRIVATE
+		w->__reserved = 0;
+	}
+#endif
+
+private:
+	struct Header
+	{
+		DWORD magic;
+		DWORD size;
+		alignas(64) std::atomic<uint32_t> head; // next byte the writer fills
+		alignas(64) std::atomic<uint32_t> tail; // next byte the reader takes
+		std::atomic<uint32_t> sleeping; // the reader waits for a wake, the futex word on Linux
+	};
+
+	struct Record
+	{
+		uint32_t length;
+		uint8_t channel;
+		uint8_t flags;
+		uint16_t reserved;
+	};
+
+	static uint32_t Align(size_t size) { return (uint32_t)((size + 7) & ~(size_t)7); }
+
+	bool Map(const char* name, bool create)
+	{
+		auto len = strnlen(name, sizeof(m_szName) - 1);
+		memcpy(m_szName, name, len);
+		m_szName[len] = 0;
+
+		const DWORD size = sizeof(Header) + DP_SHARED_RING_SIZE;
+		std::string eventName = std::string(name) + "_Wake";
+
+#ifdef _WIN32
+		if (create)
+		{
+			m_hMap = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, name);
+
+			if (m_hMap && GetLastError() == ERROR_ALREADY_EXISTS)
+			{
+				CloseHandle(m_hMap);
+				m_hMap = nullptr;
+			}
+
+			m_hEvent = CreateEventA(nullptr, FALSE, FALSE, eventName.c_str());
+		}
+		else
+		{
+			m_hMap = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+			m_hEvent = OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, eventName.c_str());
+		}
+
+		void* view = m_hMap ? MapViewOfFile(m_hMap, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+
+		if (!view || !m_hEvent)
+		{
+			if (view)
+				UnmapViewOfFile(view);
+
+			if (m_hMap)
+				CloseHandle(m_hMap);
+
+			if (m_hEvent)
+				CloseHandle(m_hEvent);
+
+			m_hMap = nullptr;
+			m_hEvent = nullptr;
+			return false;
+		}
+#else
+		auto fd = shm_open(name, create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+
+		if (fd < 0)
+			return false;
+
+		if (create && ftruncate(fd, size) != 0)
+		{
+			close(fd);
+			shm_unlink(name);
+			return false;
+		}
+
+		void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (view == MAP_FAILED)
+		{
+			if (create)
+				shm_unlink(name);
+
+			return false;
+		}
+#endif
+
+		m_pHeader = (Header*)view;
+		m_pData = (uint8_t*)view + sizeof(Header);
+		m_bOwner = create;
+		return true;
+	}
+
+	void Wake()
+	{
+		m_pHeader->sleeping.store(0, std::memory_order_relaxed);
+#ifdef _WIN32
+		SetEvent(m_hEvent);
+#else
+		syscall(SYS_futex, &m_pHeader->sleeping, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#endif
+	}
+
+	Header* m_pHeader;
+	uint8_t* m_pData;
+	bool m_bOwner; // the writer, it removes the name
+	char m_szName[DP_SHARED_NAME_SIZE];
+#ifdef _WIN32
+	HANDLE m_hMap;
+	HANDLE m_hEvent;
+#endif
+};
+
+/*!
+	@class DPSharedTransport
+	Moves the messages of the normal channel of the peers on this machine from the loopback socket
+	to a pair of DPSharedRing, one for each direction. The rings are negotiated on the enet
+	connection: we offer the ring we write, the peer maps it and accepts, then we send the switch
+	as our last enet message on the channel, so the peer reads the ring only after everything that
+	came before it. The connection itself, the chat and the disconnects stay on enet.
+	A reliable message that finds the ring full waits in the queue of its link, flushed by every
+	service, so the game thread never blocks on a late reader
+*/
+class DPSharedTransport
+{
+public:
+	DPSharedTransport() : m_pNext(nullptr) { Reset(); }
+
+	/*!
+	* @brief Checks if an address is on this machine
+	*/
+	static bool IsLocal(const ENetAddress& address)
+	{
+		static const in6_addr loopback = IN6ADDR_LOOPBACK_INIT;
+		auto b = (const BYTE*)&address.ipv6;
+
+		if (!memcmp(&address.ipv6, &loopback, sizeof(loopback)))
+			return true;
+
+		// ::ffff:127.0.0.0/8
+		static const BYTE mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+		return !memcmp(b, mapped, sizeof(mapped)) && b[12] == 127;
+	}
+
+	/*!
+	* @brief Offers a ring to a peer on this machine
+	*/
+	void Offer(ENetPeer* peer)
+	{
+		if (!IsLocal(peer->address))
+			return;
+
+		static std::atomic<DWORD> next(0); // the names are unique in the process, it can hold many sessions
+
+		char name[DP_SHARED_NAME_SIZE];
+#ifdef _WIN32
+		snprintf(name, sizeof(name), "Local\\FFLoader%u_%u", (DWORD)GetCurrentProcessId(), (DWORD)next++);
+#else
+		snprintf(name, sizeof(name), "/ffloader%u_%u", (DWORD)getpid(), (DWORD)next++);
+#endif
+
+		auto& link = m_vLinks[peer];
+		link.out.Close();
+		link.switched = false;
+
+		for (auto pk : link.pending)
+			Release(pk);
+
+		link.pending.clear();
+
+		if (!link.out.Create(name))
+			return;
+
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::Shared(DP_SHARED_OFFER, name));
+	}
+
+	/*!
+	* @brief Handles a DPMSG_TYPE_SHARED message
+	*/
+	void OnMessage(ENetPeer* peer, const DPSharedInfo& info)
+	{
+		auto& link = m_vLinks[peer];
+
+		switch (info.op)
+		{
+		case DP_SHARED_OFFER:
+		{
+			char name[DP_SHARED_NAME_SIZE];
+			memcpy(name, info.name, sizeof(name));
+			name[sizeof(name) - 1] = 0;
+
+			link.in.Close();
+			link.reading = false;
+
+			// a peer on another machine behind the same address cannot be mapped, it stays on enet
+			if (IsLocal(peer->address) && link.in.Open(name))
+				enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::Shared(DP_SHARED_ACCEPT, name));
+
+			break;
+		}
+
+		case DP_SHARED_ACCEPT:
+			if (!link.out.IsOpen() || strncmp(info.name, link.out.GetName(), DP_SHARED_NAME_SIZE) != 0)
+				break;
+
+			enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::Shared(DP_SHARED_SWITCH, link.out.GetName()));
+			link.switched = true;
+			m_dwLinks++;
+
+#ifdef _DEBUG
+			printf("[LOADER] Messages to peer %u moved to shared memory\n", (DWORD)(uintptr_t)peer->data);
+#endif
+			break;
+
+		case DP_SHARED_SWITCH:
+			link.reading = link.in.IsOpen();
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/*!
+	* @brief Sends a message through the ring of a peer
+	* @return false if the peer has no ring, the message goes through enet
+	*/
+	bool Send(ENetPeer* peer, uint8_t channel, ENetPacket* pk)
+	{
+		if (channel != ENET_CHANNEL_NORMAL)
+			return false;
+
+		auto it = m_vLinks.find(peer);
+
+		if (it == m_vLinks.end() || !it->second.switched)
+			return false;
+
+		auto& link = it->second;
+		auto flags = (uint8_t)(pk->flags & ENET_PACKET_FLAG_RELIABLE);
+
+		if (!link.pending.empty() || !link.out.Write(channel, flags, pk->data, (uint32_t)pk->dataLength))
+		{ // the reader is late, only what must arrive waits for it, behind what already waits
+			if (flags)
+			{
+				pk->referenceCount++;
+				link.pending.push_back(pk);
+				m_dwQueued++;
+			}
+			else
+				m_dwDropped++;
+		}
+
+		pk->flags |= ENET_PACKET_FLAG_SENT;
+		m_ullSent++;
+		return true;
+	}
+
+	/*!
+	* @brief Writes the messages that waited for room in the rings
+	*/
+	void Flush()
+	{
+		for (auto& l : m_vLinks)
+		{
+			auto& pending = l.second.pending;
+
+			while (!pending.empty() && l.second.out.Write(ENET_CHANNEL_NORMAL, ENET_PACKET_FLAG_RELIABLE, pending.front()->data, (uint32_t)pending.front()->dataLength))
+			{
+				Release(pending.front());
+				pending.pop_front();
+			}
+		}
+	}
+
+	/*!
+	* @brief Takes a message from the rings, the peers take turns
+	* @param evt Filled like an enet receive event
+	* @return false if every ring is empty
+	*/
+	bool Receive(ENetEvent* evt)
+	{
+		if (m_vLinks.empty())
+			return false;
+
+		auto it = m_vLinks.upper_bound(m_pNext);
+
+		for (size_t i = 0; i < m_vLinks.size(); i++, it++)
+		{
+			if (it == m_vLinks.end())
+				it = m_vLinks.begin();
+
+			if (!it->second.reading)
+				continue;
+
+			uint8_t channel;
+			auto pk = it->second.in.Read(&channel);
+
+			if (!pk)
+				continue;
+
+			evt->type = ENET_EVENT_TYPE_RECEIVE;
+			evt->peer = it->first;
+			evt->channelID = channel;
+			evt->data = 0;
+			evt->packet = pk;
+			m_pNext = it->first;
+			m_ullReceived++;
+			return true;
+		}
+
+		return false;
+	}
+
+	/*!
+	* @brief Sleeps until a ring gets a message or the timeout expires
+	*/
+	void Wait(uint32_t timeout)
+	{
+#ifdef _WIN32
+		HANDLE events[MAXIMUM_WAIT_OBJECTS];
+		DWORD count = 0;
+		bool sleep = true;
+
+		for (auto& l : m_vLinks)
+		{
+			if (!l.second.reading || count == MAXIMUM_WAIT_OBJECTS)
+				continue;
+
+			sleep = l.second.in.PrepareWait() && sleep;
+			events[count++] = l.second.in.GetEvent();
+		}
+
+		if (sleep && count)
+			WaitForMultipleObjects(count, events, FALSE, timeout);
+
+		for (auto& l : m_vLinks)
+		{
+			if (l.second.reading)
+				l.second.in.EndWait();
+		}
+#else
+		futex_waitv waits[FUTEX_WAITV_MAX];
+		DWORD count = 0;
+		bool sleep = true;
+		DPSharedRing* first = nullptr;
+
+		for (auto& l : m_vLinks)
+		{
+			if (!l.second.reading || count == FUTEX_WAITV_MAX)
+				continue;
+
+			sleep = l.second.in.PrepareWait() && sleep;
+			l.second.in.GetWait(&waits[count++]);
+
+			if (!first)
+				first = &l.second.in;
+		}
+
+		if (sleep && count)
+		{
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts); // futex_waitv takes an absolute time
+			ts.tv_sec += timeout / 1000;
+			ts.tv_nsec += (long)(timeout % 1000) * 1000000;
+
+			if (ts.tv_nsec >= 1000000000)
+			{
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000;
+			}
+
+			if (syscall(__NR_futex_waitv, waits, count, 0, &ts, CLOCK_MONOTONIC) < 0 && errno == ENOSYS)
+				first->Wait(timeout); // before Linux 5.16, the other rings are checked by the next call
+		}
+
+		for (auto& l : m_vLinks)
+		{
+			if (l.second.reading)
+				l.second.in.EndWait();
+		}
+#endif
+	}
+
+	/*!
+	* @brief Checks if a peer reads or writes a ring
+	*/
+	bool IsActive() const
+	{
+		for (const auto& l : m_vLinks)
+		{
+			if (l.second.reading || l.second.switched)
+				return true;
+		}
+
+		return false;
+	}
+
+	void Remove(ENetPeer* peer)
+	{
+		auto it = m_vLinks.find(peer);
+
+		if (it == m_vLinks.end())
+			return;
+
+		for (auto pk : it->second.pending)
+			Release(pk);
+
+		m_vLinks.erase(it);
+
+		if (m_pNext == peer)
+			m_pNext = nullptr;
+	}
+
+	void Reset()
+	{
+		for (auto& l : m_vLinks)
+		{
+			for (auto pk : l.second.pending)
+				Release(pk);
+		}
+
+		m_vLinks.clear();
+		m_pNext = nullptr;
+		m_ullSent = 0;
+		m_ullReceived = 0;
+		m_dwDropped = 0;
+		m_dwQueued = 0;
+		m_dwLinks = 0;
+	}
+
+	void Dump() const
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Shared memory: %u links, %llu msgs sent %llu received, %u waited for room, %u unreliable dropped\n", m_dwLinks, m_ullSent, m_ullReceived, m_dwQueued, m_dwDropped);
+#endif
+	}
+
+private:
+	struct Link
+	{
+		DPSharedRing out;
+		DPSharedRing in;
+		bool switched = false; // we write to out
+		bool reading = false; // we read from in
+		std::deque<ENetPacket*> pending; // reliable messages that wait for room in out, we hold a reference
+	};
+
+	static void Release(ENetPacket* pk)
+	{
+		if (--pk->referenceCount == 0)
+			enet_packet_destroy(pk);
+	}
+
+	std::map<ENetPeer*, Link> m_vLinks;
+	ENetPeer* m_pNext; // the last peer we read from
+
+	// Statistics
+	ULONGLONG m_ullSent;
+	ULONGLONG m_ullReceived;
+	DWORD m_dwDropped; // unreliable, the ring was full
+	DWORD m_dwQueued; // reliable, waited in a queue
+	DWORD m_dwLinks;
+};
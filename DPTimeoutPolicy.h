@@ -0,0 +1,120 @@
+/*!
+	@author Arves100
+	@file DPTimeoutPolicy.h
+	@date 19/10/2026
+	@brief Per-peer keepalive and timeout tuning from the measured round trip time
+*/
+#pragma once
+
+// Values used until we have enough samples of the peer, the policy never goes below them
+#define TIMEOUT1 32
+#define TIMEOUT2 5000
+#define TIMEOUT3 10000
+
+#define DP_TIMEOUT_POLICY_INTERVAL 1000 // how often the peers are checked
+#define DP_TIMEOUT_POLICY_WARMUP 16 // packets to send before trusting the rtt
+#define DP_PING_INTERVAL_MIN 100
+#define DP_PING_INTERVAL_MAX 1000
+#define DP_TIMEOUT_MIN_HIGH 10000
+#define DP_TIMEOUT_MAX_HIGH 30000
+
+/*!
+	@class DPTimeoutPolicy
+	Adapts the ENet ping interval and timeouts of every connected peer to its rtt mean and variance,
+	so slow links are not dropped. The timeouts are only raised: the game does not service the host
+	while it loads a level, a fast link must survive that stall as it did before
+*/
+class DPTimeoutPolicy
+{
+public:
+	DPTimeoutPolicy() : m_ullNextCheck(0) {}
+
+	/*!
+	* @brief Applies the default values to a new peer
+	* @param peer Peer to setup
+	*/
+	void Initial(ENetPeer* peer)
+	{
+		enet_peer_ping_interval(peer, ENET_PEER_PING_INTERVAL);
+		enet_peer_timeout(peer, TIMEOUT1, TIMEOUT2, TIMEOUT3);
+	}
+
+	/*!
+	* @brief Updates the timeouts of all the connected peers of an host
+	* @param host Host to check
+	*/
+	void Update(ENetHost* host)
+	{
+		auto now = GetTickCount64();
+
+		if (now < m_ullNextCheck)
+			return;
+
+		m_ullNextCheck = now + DP_TIMEOUT_POLICY_INTERVAL;
+
+		for (size_t i = 0; i < host->peerCount; i++)
+		{
+			auto peer = &host->peers[i];
+
+			if (peer->state == ENET_PEER_STATE_CONNECTED)
+				Apply(peer);
+		}
+	}
+
+	/*!
+	* @brief Logs why a peer disconnected and the values it was using
+	* @param evt Disconnect event
+	*/
+	static void LogDisconnect(const ENetEvent& evt)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Peer %u %s: rtt %u var %u ping %u timeout %u/%u/%u sent %llu lost %llu\n", (DWORD)evt.peer->data,
+			evt.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT ? "timed out" : "disconnected",
+			enet_peer_get_rtt(evt.peer), enet_peer_get_rtt_variance(evt.peer), evt.peer->pingInterval,
+			evt.peer->timeoutLimit, evt.peer->timeoutMinimum, evt.peer->timeoutMaximum,
+			(unsigned long long)enet_peer_get_packets_sent(evt.peer), (unsigned long long)enet_peer_get_packets_lost(evt.peer));
+		printf("[LOADER] Peer %u queue delay %u ms, bottleneck %u B/s, pacing %u B/s\n", (DWORD)evt.peer->data,
+			enet_peer_get_queue_delay(evt.peer), enet_peer_get_bottleneck_bandwidth(evt.peer), enet_peer_get_pacing_rate(evt.peer));
+#endif
+	}
+
+private:
+	static uint32_t Clamp(uint32_t v, uint32_t lo, uint32_t hi)
+	{
+		return v < lo ? lo : (v > hi ? hi : v);
+	}
+
+	/*!
+	* @brief Tells if a value moved by 20% or more from the one the peer is using
+	*/
+	static bool Changed(uint32_t v, uint32_t current)
+	{
+		auto diff = v > current ? v - current : current - v;
+		return diff * 5 >= current;
+	}
+
+	void Apply(ENetPeer* peer)
+	{
+		if (enet_peer_get_packets_sent(peer) < DP_TIMEOUT_POLICY_WARMUP)
+			return; // rtt is not meaningful yet
+
+		auto rto = enet_peer_get_rtt(peer) + 4 * enet_peer_get_rtt_variance(peer);
+
+		auto ping = Clamp(rto * 2, DP_PING_INTERVAL_MIN, DP_PING_INTERVAL_MAX);
+		auto timeoutMin = Clamp(rto * 8, TIMEOUT2, DP_TIMEOUT_MIN_HIGH);
+		auto timeoutMax = Clamp(rto * 32, timeoutMin * 2 > TIMEOUT3 ? timeoutMin * 2 : TIMEOUT3, DP_TIMEOUT_MAX_HIGH);
+
+		// do not touch the peer for small changes
+		if (!Changed(timeoutMin, peer->timeoutMinimum) && !Changed(ping, peer->pingInterval))
+			return;
+
+#ifdef _DEBUG
+		printf("[LOADER] Peer %u rtt %u var %u qdelay %u: ping %u timeout %u/%u\n", (DWORD)peer->data, enet_peer_get_rtt(peer), enet_peer_get_rtt_variance(peer), enet_peer_get_queue_delay(peer), ping, timeoutMin, timeoutMax);
+#endif
+
+		enet_peer_ping_interval(peer, ping);
+		enet_peer_timeout(peer, TIMEOUT1, timeoutMin, timeoutMax);
+	}
+
+	ULONGLONG m_ullNextCheck;
+};
@@ -118,3 +118,8 @@ HRESULT_INT FakeDP::GetPlayerData(DPID idPlayer, LPVOID lpData, LPDWORD lpdwData
 {
 	return m_dp->GetPlayerData(idPlayer, lpData, lpdwDataSize, dwFlags);
 }
+
+HRESULT_INT FakeDP::GetMessageQueue(DPID idFrom, DPID idTo, DWORD dwFlags, LPDWORD lpdwNumMsgs, LPDWORD lpdwNumBytes)
+{
+	return m_dp->GetMessageQueue(idFrom, idTo, dwFlags, lpdwNumMsgs, lpdwNumBytes);
+}
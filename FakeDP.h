@@ -39,6 +39,7 @@ public:
 	HRESULT_INT EnumConnections(LPCGUID lpguidApplication, LPDPENUMCONNECTIONSCALLBACK lpEnumCallback, LPVOID lpContext, DWORD dwFlags);
 	HRESULT_INT GetSessionDesc(LPVOID lpData, LPDWORD lpdwDataSize);
 	HRESULT_INT GetPlayerData(DPID idPlayer, LPVOID lpData, LPDWORD lpdwDataSize, DWORD dwFlags);
+	HRESULT_INT GetMessageQueue(DPID idFrom, DPID idTo, DWORD dwFlags, LPDWORD lpdwNumMsgs, LPDWORD lpdwNumBytes);
 
 private:
 	DPInstance* m_dp;
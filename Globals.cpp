@@ -26,9 +26,23 @@ Globals::Globals()
 	memset(GameDiskPath, 0, sizeof(GameDiskPath));
 	BaseAddress = nullptr;
 	WindowedMode = false;
-	TheArena = new DPMsgArena(1024 * 1024 * 20); // 20MB
+	NetFlushPolicy = 0; // DP_FLUSH_SERVICE
+	NetCongestionControl = false;
+	NetFec = false;
+	NetDictTrain = false;
+	NetDelta = false;
+	NetSpectatorDelay = 0;
+	NetSpectatorBuffer = 4 * 1024 * 1024; // DP_RING_DEFAULT_SIZE
+	memset(NetRelayServer, 0, sizeof(NetRelayServer));
+	NetChecksum = false;
+	memset(NetRendezvousServer, 0, sizeof(NetRendezvousServer));
+	memset(NetSessionCode, 0, sizeof(NetSessionCode));
+	NetSharedMemory = false;
+	NetTrustLoopback = false;
+	NetFirewallCookie = false;
+	NetArenaSize = 1024 * 1024 * 20; // DP_CONTEXT_ARENA_SIZE
 
-	if (!TheLoader || !TheArena)
+	if (!TheLoader)
 		FATAL("Unable to allocate loader memory");
 }
 
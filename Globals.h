@@ -7,7 +7,6 @@
 #pragma once
 
 #include "Loader.h"
-#include "DPMsgArena.h"
 
 class Globals
 {
@@ -36,7 +35,21 @@ public:
 	TCHAR GameDiskPath[MAX_PATH + 1];
 	LPVOID BaseAddress;
 	bool WindowedMode;
-	DPMsgArena* TheArena;
+	DWORD NetArenaSize; // of every DirectPlay object, the load tests that run many in one process make it smaller
+	DWORD NetFlushPolicy;
+	bool NetCongestionControl;
+	bool NetFec;
+	bool NetDictTrain;
+	bool NetDelta;
+	DWORD NetSpectatorDelay;
+	DWORD NetSpectatorBuffer;
+	char NetRelayServer[256];
+	bool NetChecksum;
+	char NetRendezvousServer[256];
+	char NetSessionCode[9]; // DP_SESSION_CODE_SIZE and the terminator
+	bool NetSharedMemory;
+	bool NetTrustLoopback; // the firewall does not limit the datagrams of this machine
+	bool NetFirewallCookie; // the players of older builds cannot join a host that challenges them
 
 private:
 	static Globals* ms_pSingleton;
@@ -395,6 +395,127 @@ void Loader::CreateOrLoadSettings()
 	else
 		m_bNoCd = true; // default is true
 
+	if (RegQueryValueEx(regKey, L"NetFlush", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded network flush setting %u\n", data);
+#endif
+		Globals::Get()->NetFlushPolicy = data;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetPacing", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded network pacing setting %u\n", data);
+#endif
+		Globals::Get()->NetCongestionControl = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetFec", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded forward error correction setting %u\n", data);
+#endif
+		Globals::Get()->NetFec = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetDictTrain", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded dictionary training setting %u\n", data);
+#endif
+		Globals::Get()->NetDictTrain = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetDelta", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded delta encoding setting %u\n", data);
+#endif
+		Globals::Get()->NetDelta = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetSpectatorDelay", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded spectator delay setting %u ms\n", data);
+#endif
+		Globals::Get()->NetSpectatorDelay = data;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetSpectatorBuffer", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded spectator buffer setting %u bytes\n", data);
+#endif
+		Globals::Get()->NetSpectatorBuffer = data;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetChecksum", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded checksum setting %u\n", data);
+#endif
+		Globals::Get()->NetChecksum = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetSharedMemory", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded shared memory setting %u\n", data);
+#endif
+		Globals::Get()->NetSharedMemory = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetTrustLoopback", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded trust loopback setting %u\n", data);
+#endif
+		Globals::Get()->NetTrustLoopback = data > 0;
+	}
+
+	if (RegQueryValueEx(regKey, L"NetFirewallCookie", nullptr, nullptr, (LPBYTE)&data, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded firewall cookie setting %u\n", data);
+#endif
+		Globals::Get()->NetFirewallCookie = data > 0;
+	}
+
+	sz = sizeof(Globals::Get()->NetRelayServer) - 1;
+
+	if (RegQueryValueExA(regKey, "NetRelayServer", nullptr, nullptr, (LPBYTE)Globals::Get()->NetRelayServer, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded relay server setting %s\n", Globals::Get()->NetRelayServer);
+#endif
+	}
+	else
+		Globals::Get()->NetRelayServer[0] = 0;
+
+	sz = sizeof(Globals::Get()->NetRendezvousServer) - 1;
+
+	if (RegQueryValueExA(regKey, "NetRendezvousServer", nullptr, nullptr, (LPBYTE)Globals::Get()->NetRendezvousServer, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded rendezvous server setting %s\n", Globals::Get()->NetRendezvousServer);
+#endif
+	}
+	else
+		Globals::Get()->NetRendezvousServer[0] = 0;
+
+	sz = sizeof(Globals::Get()->NetSessionCode) - 1;
+
+	if (RegQueryValueExA(regKey, "NetSessionCode", nullptr, nullptr, (LPBYTE)Globals::Get()->NetSessionCode, &sz) == ERROR_SUCCESS)
+	{
+#ifdef _DEBUG
+		printf("[LOADER] Loaded session code setting %s\n", Globals::Get()->NetSessionCode);
+#endif
+	}
+	else
+		Globals::Get()->NetSessionCode[0] = 0;
+
 	RegCloseKey(regKey);
 }
 
@@ -51,9 +51,12 @@ DEFINE_GUID(GUID_ENetAddress, 0x68dcdbff, 0xba9c, 0x4776, 0xbc, 0x9b, 0xbb, 0x98
 // C++
 #include <string>
 #include <vector>
+#include <deque>
+#include <list>
 #include <unordered_map>
 #include <memory>
 #include <thread>
+#include <algorithm>
 
 // REVERSED: CONTENT OF ARRAY AT 0x005B1DA8
 struct avail_display_info
@@ -24,6 +24,10 @@
 #ifndef ENET_H
 #define ENET_H
 
+#if defined(ENET_USE_MMSG) && !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // recvmmsg and sendmmsg
+#endif
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -113,6 +117,7 @@ typedef struct {
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <string.h>
@@ -150,6 +155,39 @@ typedef struct {
 #define ENET_BUFFER_MAXIMUM (1 + 2 * ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS)
 #endif
 
+#if defined(ENET_USE_MMSG) && defined(_WIN32)
+#undef ENET_USE_MMSG // Linux only
+#endif
+
+#ifdef ENET_USE_MMSG
+#define ENET_MMSG_BATCH 32 // datagrams received or sent with one system call
+#define ENET_MMSG_GSO_SEGMENTS 16 // datagrams of a peer sent as one segmentation offload
+#define ENET_MMSG_GSO_BYTES 65000 // bytes of a segmentation offload, within the limit of a udp packet
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103 // older headers, the kernel refuses it if it does not know it
+#endif
+
+#ifndef SOL_UDP
+#define SOL_UDP IPPROTO_UDP
+#endif
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define ENET_CRC32C_SSE42 // detected at runtime
+#define ENET_CRC32C_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define ENET_CRC32C_SSE42 // detected at runtime
+#define ENET_CRC32C_TARGET __attribute__((target("sse4.2")))
+#elif defined(_M_ARM64) || defined(__ARM_FEATURE_CRC32)
+#ifndef _MSC_VER
+#include <arm_acle.h>
+#endif
+#define ENET_CRC32C_ARMV8 // only when the compiler targets it
+#define ENET_CRC32C_TARGET
+#endif
+
 #define ENET_HOST_ANY in6addr_any
 #define ENET_PORT_ANY 0
 #define ENET_HOST_SIZE 1025
@@ -260,8 +298,10 @@ extern "C" {
 	typedef enum _ENetProtocolFlag {
 		ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE = (1 << 7),
 		ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED = (1 << 6),
+		ENET_PROTOCOL_COMMAND_FLAG_CHECKSUM = (1 << 5), /* on connect and verify connect, the side wants or accepts checksums */
+		ENET_PROTOCOL_HEADER_FLAG_CHECKSUM = (1 << 15), /* the header is followed by the checksum of the datagram */
 		ENET_PROTOCOL_HEADER_FLAG_SENT_TIME = (1 << 14),
-		ENET_PROTOCOL_HEADER_FLAG_MASK = ENET_PROTOCOL_HEADER_FLAG_SENT_TIME,
+		ENET_PROTOCOL_HEADER_FLAG_MASK = ENET_PROTOCOL_HEADER_FLAG_CHECKSUM | ENET_PROTOCOL_HEADER_FLAG_SENT_TIME,
 		ENET_PROTOCOL_HEADER_SESSION_MASK = (3 << 12),
 		ENET_PROTOCOL_HEADER_SESSION_SHIFT = 12
 	} ENetProtocolFlag;
@@ -423,7 +463,8 @@ extern "C" {
 		ENET_SOCKOPT_SNDTIMEO = 7,
 		ENET_SOCKOPT_ERROR = 8,
 		ENET_SOCKOPT_NODELAY = 9,
-		ENET_SOCKOPT_IPV6_V6ONLY = 10
+		ENET_SOCKOPT_IPV6_V6ONLY = 10,
+		ENET_SOCKOPT_DONTFRAGMENT = 11
 	} ENetSocketOption;
 
 	typedef enum _ENetSocketShutdown {
@@ -510,6 +551,12 @@ extern "C" {
 		ENET_PEER_STATE_ZOMBIE = 9
 	} ENetPeerState;
 
+	typedef enum _ENetPeerActivity {
+		ENET_PEER_ACTIVITY_NONE = 0,
+		ENET_PEER_ACTIVITY_BUSY = 1, // in the active list of the host, serviced on every pass
+		ENET_PEER_ACTIVITY_IDLE = 2 // in the idle wheel of the host until its deadline or new work
+	} ENetPeerActivity;
+
 	enum {
 		ENET_HOST_BUFFER_SIZE_MIN = 256 * 1024,
 		ENET_HOST_BUFFER_SIZE_MAX = 1024 * 1024,
@@ -517,6 +564,8 @@ extern "C" {
 		ENET_HOST_DEFAULT_MTU = 1280,
 		ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE = 32 * 1024 * 1024,
 		ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA = 32 * 1024 * 1024,
+		ENET_HOST_IDLE_WHEEL_SLOTS = 1024,
+		ENET_HOST_IDLE_WHEEL_RESOLUTION = 1,
 		ENET_PEER_DEFAULT_ROUND_TRIP_TIME = 1,
 		ENET_PEER_DEFAULT_PACKET_THROTTLE = 32,
 		ENET_PEER_PACKET_THROTTLE_THRESHOLD = 40,
@@ -535,7 +584,14 @@ extern "C" {
 		ENET_PEER_FREE_UNSEQUENCED_WINDOWS = 32,
 		ENET_PEER_RELIABLE_WINDOWS = 16,
 		ENET_PEER_RELIABLE_WINDOW_SIZE = 0x1000,
-		ENET_PEER_FREE_RELIABLE_WINDOWS = 8
+		ENET_PEER_FREE_RELIABLE_WINDOWS = 8,
+		ENET_PEER_CC_MIN_RTT_WINDOW = 10000,
+		ENET_PEER_CC_SAMPLE_INTERVAL = 50,
+		ENET_PEER_CC_SAMPLE_RTTS = 2,
+		ENET_PEER_CC_BANDWIDTH_SAMPLES = 8,
+		ENET_PEER_CC_TARGET_DELAY = 25,
+		ENET_PEER_CC_MIN_RATE = 16 * 1024,
+		ENET_PEER_CC_BURST_TIME = 20
 	};
 
 	typedef struct _ENetChannel {
@@ -545,6 +601,8 @@ extern "C" {
 		uint16_t reliableWindows[ENET_PEER_RELIABLE_WINDOWS];
 		uint16_t incomingReliableSequenceNumber;
 		uint16_t incomingUnreliableSequenceNumber;
+		uint16_t lastUnreliableReliableSequenceNumber;
+		uint16_t lastUnreliableSequenceNumber;
 		ENetList incomingReliableCommands;
 		ENetList incomingUnreliableCommands;
 	} ENetChannel;
@@ -576,6 +634,8 @@ extern "C" {
 		uint32_t earliestTimeout;
 		uint64_t totalPacketsSent;
 		uint64_t totalPacketsLost;
+		uint64_t unreliablePacketsReceived;
+		uint64_t unreliablePacketsLost;
 		uint32_t packetThrottle;
 		uint32_t packetThrottleThreshold;
 		uint32_t packetThrottleLimit;
@@ -609,6 +669,28 @@ extern "C" {
 		uint32_t unsequencedWindow[ENET_PEER_UNSEQUENCED_WINDOW_SIZE / 32];
 		uint32_t eventData;
 		size_t totalWaitingData;
+		uint32_t ccMinRoundTripTime;
+		uint32_t ccNextMinRoundTripTime;
+		uint32_t ccMinRoundTripTimeEpoch;
+		uint32_t ccQueueDelay;
+		uint32_t ccSampleEpoch;
+		uint32_t ccSampleAcked;
+		uint32_t ccSampleSent;
+		uint32_t ccSampleQueueDelay;
+		uint32_t ccSampleMinRoundTripTime;
+		uint32_t ccSampleRoundTripTimes;
+		uint32_t ccSampleLimited;
+		uint32_t ccBandwidthSamples[ENET_PEER_CC_BANDWIDTH_SAMPLES];
+		uint32_t ccBandwidthSample;
+		uint32_t ccBottleneckBandwidth;
+		uint32_t ccPacingRate;
+		int32_t ccPacingBudget;
+		uint32_t ccPacingEpoch;
+		ENetListNode activeList;
+		ENetPeerActivity activity;
+		uint32_t activityDeadline;
+		uint8_t checksum; /* both sides asked for checksums when connecting */
+		uint8_t timedOut; /* the zombie waiting for dispatch timed out, it is reported as a timeout */
 	} ENetPeer;
 
 	typedef enum _ENetEventType {
@@ -629,7 +711,7 @@ extern "C" {
 
 	typedef uint64_t(ENET_CALLBACK* ENetChecksumCallback)(const ENetBuffer* buffers, int bufferCount);
 
-	typedef int (ENET_CALLBACK* ENetInterceptCallback)(ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength);
+	typedef int (ENET_CALLBACK* ENetInterceptCallback)(struct _ENetHost* host, ENetEvent* event, ENetAddress* address, uint8_t* receivedData, int receivedDataLength);
 
 	typedef struct _ENetHost {
 		ENetSocket socket;
@@ -668,6 +750,14 @@ extern "C" {
 		size_t duplicatePeers;
 		size_t maximumPacketSize;
 		size_t maximumWaitingData;
+		int congestionControl;
+		ENetList activePeers;
+		ENetList idleWheel[ENET_HOST_IDLE_WHEEL_SLOTS];
+		uint32_t idleWheelTime;
+		void* data; /* application private data, may be freely modified */
+#ifdef ENET_USE_MMSG
+		struct _ENetMmsg* mmsg;
+#endif
 	} ENetHost;
 
 	/*
@@ -685,12 +775,15 @@ extern "C" {
 	ENET_API int enet_array_is_zeroed(const uint8_t*, int);
 	ENET_API uint32_t enet_time_get(void);
 	ENET_API uint64_t enet_crc64(const ENetBuffer*, int);
+	ENET_API uint64_t enet_crc32c(const ENetBuffer*, int);
 
 	ENET_API ENetPacket* enet_packet_create(const void*, size_t, uint32_t);
 	ENET_API ENetPacket* enet_packet_create_offset(const void*, size_t, size_t, uint32_t);
 	ENET_API void enet_packet_destroy(ENetPacket*);
 
 	ENET_API int enet_peer_send(ENetPeer*, uint8_t, ENetPacket*);
+	ENET_API int enet_peer_send_probe(ENetPeer*, uint8_t, const void*, size_t, uint32_t);
+	ENET_API int enet_peer_resend_connect(ENetPeer*, uint32_t, uint32_t);
 	ENET_API ENetPacket* enet_peer_receive(ENetPeer*, uint8_t*);
 	ENET_API void enet_peer_ping(ENetPeer*);
 	ENET_API void enet_peer_ping_interval(ENetPeer*, uint32_t);
@@ -713,6 +806,7 @@ extern "C" {
 	ENET_API void enet_host_broadcast_selective(ENetHost*, uint8_t, ENetPacket*, ENetPeer**, size_t);
 	ENET_API void enet_host_channel_limit(ENetHost*, size_t);
 	ENET_API void enet_host_bandwidth_limit(ENetHost*, uint32_t, uint32_t);
+	ENET_API void enet_host_congestion_control(ENetHost*, int);
 
 	ENET_API int enet_address_set_ip(ENetAddress*, const char*);
 	ENET_API int enet_address_set_hostname(ENetAddress*, const char*);
@@ -759,13 +853,20 @@ extern "C" {
 	ENET_API ENetPeerState enet_peer_get_state(const ENetPeer*);
 	ENET_API uint32_t enet_peer_get_rtt(const ENetPeer*);
 	ENET_API uint32_t enet_peer_get_last_rtt(const ENetPeer* peer);
+	ENET_API uint32_t enet_peer_get_rtt_variance(const ENetPeer*);
 	ENET_API uint32_t enet_peer_get_lastsendtime(const ENetPeer*);
 	ENET_API uint32_t enet_peer_get_lastreceivetime(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_packets_sent(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_packets_lost(const ENetPeer*);
+	ENET_API uint64_t enet_peer_get_unreliable_received(const ENetPeer*);
+	ENET_API uint64_t enet_peer_get_unreliable_lost(const ENetPeer*);
 	ENET_API float enet_peer_get_packets_throttle(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_bytes_sent(const ENetPeer*);
 	ENET_API uint64_t enet_peer_get_bytes_received(const ENetPeer*);
+	ENET_API size_t enet_peer_get_pending_data(const ENetPeer*);
+	ENET_API uint32_t enet_peer_get_queue_delay(const ENetPeer*);
+	ENET_API uint32_t enet_peer_get_bottleneck_bandwidth(const ENetPeer*);
+	ENET_API uint32_t enet_peer_get_pacing_rate(const ENetPeer*);
 	ENET_API void* enet_peer_get_data(const ENetPeer*);
 	ENET_API void enet_peer_set_data(ENetPeer*, const void*);
 
@@ -781,6 +882,8 @@ extern "C" {
 	extern uint64_t enet_host_random_seed(void);
 
 	extern int enet_peer_throttle(ENetPeer*, uint32_t);
+	extern void enet_peer_congestion_update(ENetPeer*, uint32_t);
+	extern void enet_peer_pacing_refill(ENetPeer*);
 	extern void enet_peer_reset_queues(ENetPeer*);
 	extern void enet_peer_setup_outgoing_command(ENetPeer*, ENetOutgoingCommand*);
 	extern ENetOutgoingCommand* enet_peer_queue_outgoing_command(ENetPeer*, const ENetProtocol*, ENetPacket*, uint32_t, uint16_t);
@@ -790,6 +893,9 @@ extern "C" {
 	extern void enet_peer_dispatch_incoming_reliable_commands(ENetPeer*, ENetChannel*, ENetIncomingCommand*);
 	extern void enet_peer_on_connect(ENetPeer*);
 	extern void enet_peer_on_disconnect(ENetPeer*);
+	extern void enet_peer_activate(ENetPeer*);
+	extern void enet_peer_deactivate(ENetPeer*);
+	extern void enet_peer_idle(ENetPeer*, uint32_t);
 
 	extern size_t enet_protocol_command_size(uint8_t);
 
@@ -1249,7 +1355,7 @@ uint32_t enet_time_get(void) {
 =======================================================================
 */
 
-typedef uint64_t enet_checksum;
+typedef uint32_t enet_checksum; /* the callbacks return 64 bits, only the low half goes on the wire */
 
 static const uint64_t crcTable[256] = {
 	UINT64_C(0x0000000000000000), UINT64_C(0x7ad870c830358979),
@@ -1399,6 +1505,118 @@ uint64_t enet_crc64(const ENetBuffer* buffers, int bufferCount) {
 	return ENET_HOST_TO_NET_64(~crc);
 }
 
+/* CRC32C (Castagnoli) is the polynomial of the SSE4.2 and ARMv8 crc instructions, the tables are the fallback */
+static uint32_t enet_crc32c_table[8][256];
+static uint32_t(*enet_crc32c_update)(uint32_t crc, const uint8_t* data, size_t dataLength);
+
+/* slicing-by-8: eight table lookups for eight bytes, with no dependency between them */
+static uint32_t enet_crc32c_update_tables(uint32_t crc, const uint8_t* data, size_t dataLength) {
+	while (dataLength >= 8) {
+		uint32_t low = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+		uint32_t high = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+
+		crc = enet_crc32c_table[7][low & 0xFF] ^ enet_crc32c_table[6][(low >> 8) & 0xFF] ^ enet_crc32c_table[5][(low >> 16) & 0xFF] ^ enet_crc32c_table[4][low >> 24] ^
+			enet_crc32c_table[3][high & 0xFF] ^ enet_crc32c_table[2][(high >> 8) & 0xFF] ^ enet_crc32c_table[1][(high >> 16) & 0xFF] ^ enet_crc32c_table[0][high >> 24];
+
+		data += 8;
+		dataLength -= 8;
+	}
+
+	while (dataLength-- > 0)
+		crc = (crc >> 8) ^ enet_crc32c_table[0][(crc ^ *data++) & 0xFF];
+
+	return crc;
+}
+
+#ifdef ENET_CRC32C_SSE42
+static ENET_CRC32C_TARGET uint32_t enet_crc32c_update_hardware(uint32_t crc, const uint8_t* data, size_t dataLength) {
+#if defined(_M_X64) || defined(__x86_64__)
+	uint64_t crc64 = crc;
+
+	for (; dataLength >= 8; data += 8, dataLength -= 8) {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		crc64 = _mm_crc32_u64(crc64, value);
+	}
+
+	crc = (uint32_t)crc64;
+#else
+	for (; dataLength >= 4; data += 4, dataLength -= 4) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		crc = _mm_crc32_u32(crc, value);
+	}
+#endif
+
+	while (dataLength-- > 0)
+		crc = _mm_crc32_u8(crc, *data++);
+
+	return crc;
+}
+#elif defined(ENET_CRC32C_ARMV8)
+static uint32_t enet_crc32c_update_hardware(uint32_t crc, const uint8_t* data, size_t dataLength) {
+	for (; dataLength >= 8; data += 8, dataLength -= 8) {
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		crc = __crc32cd(crc, value);
+	}
+
+	while (dataLength-- > 0)
+		crc = __crc32cb(crc, *data++);
+
+	return crc;
+}
+#endif
+
+static void enet_crc32c_initialize(void) {
+	uint32_t i, bit, slice;
+
+	for (i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+
+		for (bit = 0; bit < 8; ++bit)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+
+		enet_crc32c_table[0][i] = crc;
+	}
+
+	for (i = 0; i < 256; ++i) {
+		for (slice = 1; slice < 8; ++slice)
+			enet_crc32c_table[slice][i] = (enet_crc32c_table[slice - 1][i] >> 8) ^ enet_crc32c_table[0][enet_crc32c_table[slice - 1][i] & 0xFF];
+	}
+
+	enet_crc32c_update = enet_crc32c_update_tables;
+
+#if defined(ENET_CRC32C_SSE42) && defined(_MSC_VER)
+	{
+		int info[4];
+		__cpuid(info, 1);
+
+		if (info[2] & (1 << 20))
+			enet_crc32c_update = enet_crc32c_update_hardware;
+	}
+#elif defined(ENET_CRC32C_SSE42)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse4.2"))
+		enet_crc32c_update = enet_crc32c_update_hardware;
+#elif defined(ENET_CRC32C_ARMV8)
+	enet_crc32c_update = enet_crc32c_update_hardware;
+#endif
+}
+
+/* checksum callback, it needs enet_initialize */
+uint64_t enet_crc32c(const ENetBuffer* buffers, int bufferCount) {
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (bufferCount-- > 0) {
+		crc = enet_crc32c_update(crc, (const uint8_t*)buffers->data, buffers->dataLength);
+		++buffers;
+	}
+
+	return ENET_HOST_TO_NET_32(~crc);
+}
+
 /*
 =======================================================================
 
@@ -1546,7 +1764,7 @@ static int enet_protocol_dispatch_incoming_commands(ENetHost* host, ENetEvent* e
 
 		case ENET_PEER_STATE_ZOMBIE:
 			host->recalculateBandwidthLimits = 1;
-			event->type = ENET_EVENT_TYPE_DISCONNECT;
+			event->type = peer->timedOut ? ENET_EVENT_TYPE_DISCONNECT_TIMEOUT : ENET_EVENT_TYPE_DISCONNECT;
 			event->peer = peer;
 			event->data = peer->eventData;
 
@@ -1592,6 +1810,8 @@ static void enet_protocol_notify_connect(ENetHost* host, ENetPeer* peer, ENetEve
 		peer->totalDataReceived = 0;
 		peer->totalPacketsSent = 0;
 		peer->totalPacketsLost = 0;
+		peer->unreliablePacketsReceived = 0;
+		peer->unreliablePacketsLost = 0;
 		event->type = ENET_EVENT_TYPE_CONNECT;
 		event->peer = peer;
 		event->data = peer->eventData;
@@ -1638,6 +1858,7 @@ static void enet_protocol_notify_disconnect_timeout(ENetHost* host, ENetPeer* pe
 	}
 	else {
 		peer->eventData = 0;
+		peer->timedOut = 1;
 
 		enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
 	}
@@ -1724,8 +1945,10 @@ static ENetProtocolCommand enet_protocol_remove_sent_reliable_command(ENetPeer*
 	enet_list_remove(&outgoingCommand->outgoingCommandList);
 
 	if (outgoingCommand->packet != NULL) {
-		if (wasSent)
+		if (wasSent) {
 			peer->reliableDataInTransit -= outgoingCommand->fragmentLength;
+			peer->ccSampleAcked += commandSizes[commandNumber] + outgoingCommand->fragmentLength;
+		}
 
 		--outgoingCommand->packet->referenceCount;
 
@@ -1794,6 +2017,7 @@ static ENetPeer* enet_protocol_handle_connect(ENetHost* host, ENetProtocolHeader
 	peer->packetThrottleAcceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleAcceleration);
 	peer->packetThrottleDeceleration = ENET_NET_TO_HOST_32(command->connect.packetThrottleDeceleration);
 	peer->eventData = ENET_NET_TO_HOST_32(command->connect.data);
+	peer->checksum = (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_CHECKSUM) && host->checksumCallback != NULL;
 	incomingSessionID = command->connect.incomingSessionID == 0xFF ? peer->outgoingSessionID : command->connect.incomingSessionID;
 	incomingSessionID = (incomingSessionID + 1) & (ENET_PROTOCOL_HEADER_SESSION_MASK >> ENET_PROTOCOL_HEADER_SESSION_SHIFT);
 
@@ -1814,6 +2038,8 @@ static ENetPeer* enet_protocol_handle_connect(ENetHost* host, ENetProtocolHeader
 		channel->outgoingUnreliableSequenceNumber = 0;
 		channel->incomingReliableSequenceNumber = 0;
 		channel->incomingUnreliableSequenceNumber = 0;
+		channel->lastUnreliableReliableSequenceNumber = 0;
+		channel->lastUnreliableSequenceNumber = 0;
 
 		enet_list_clear(&channel->incomingReliableCommands);
 		enet_list_clear(&channel->incomingUnreliableCommands);
@@ -1858,6 +2084,9 @@ static ENetPeer* enet_protocol_handle_connect(ENetHost* host, ENetProtocolHeader
 		windowSize = ENET_PROTOCOL_MAXIMUM_WINDOW_SIZE;
 
 	verifyCommand.header.command = ENET_PROTOCOL_COMMAND_VERIFY_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+
+	if (peer->checksum)
+		verifyCommand.header.command |= ENET_PROTOCOL_COMMAND_FLAG_CHECKSUM;
 	verifyCommand.header.channelID = 0xFF;
 	verifyCommand.verifyConnect.outgoingPeerID = ENET_HOST_TO_NET_16(peer->incomingPeerID);
 	verifyCommand.verifyConnect.incomingSessionID = incomingSessionID;
@@ -2260,6 +2489,9 @@ static int enet_protocol_handle_acknowledge(ENetHost* host, ENetEvent* event, EN
 	if (peer->roundTripTimeVariance > peer->highestRoundTripTimeVariance)
 		peer->highestRoundTripTimeVariance = peer->roundTripTimeVariance;
 
+	if (host->congestionControl)
+		enet_peer_congestion_update(peer, roundTripTime);
+
 	if (peer->packetThrottleEpoch == 0 || ENET_TIME_DIFFERENCE(host->serviceTime, peer->packetThrottleEpoch) >= peer->packetThrottleInterval) {
 		peer->lastRoundTripTime = peer->lowestRoundTripTime;
 		peer->lastRoundTripTimeVariance = peer->highestRoundTripTimeVariance;
@@ -2311,9 +2543,13 @@ static int enet_protocol_handle_verify_connect(ENetHost* host, ENetEvent* event,
 	if (peer->state != ENET_PEER_STATE_CONNECTING)
 		return 0;
 
+	/* the answer to an older connect of this peer, the host still acknowledges the one we reset, it must not fail the new one */
+	if (command->verifyConnect.connectID != peer->connectID)
+		return 0;
+
 	channelCount = ENET_NET_TO_HOST_32(command->verifyConnect.channelCount);
 
-	if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleInterval) != peer->packetThrottleInterval || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleAcceleration) != peer->packetThrottleAcceleration || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleDeceleration) != peer->packetThrottleDeceleration || command->verifyConnect.connectID != peer->connectID) {
+	if (channelCount < ENET_PROTOCOL_MINIMUM_CHANNEL_COUNT || channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleInterval) != peer->packetThrottleInterval || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleAcceleration) != peer->packetThrottleAcceleration || ENET_NET_TO_HOST_32(command->verifyConnect.packetThrottleDeceleration) != peer->packetThrottleDeceleration) {
 		peer->eventData = 0;
 
 		enet_protocol_dispatch_state(host, peer, ENET_PEER_STATE_ZOMBIE);
@@ -2352,6 +2588,7 @@ static int enet_protocol_handle_verify_connect(ENetHost* host, ENetEvent* event,
 
 	peer->incomingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.incomingBandwidth);
 	peer->outgoingBandwidth = ENET_NET_TO_HOST_32(command->verifyConnect.outgoingBandwidth);
+	peer->checksum = (command->header.command & ENET_PROTOCOL_COMMAND_FLAG_CHECKSUM) && host->checksumCallback != NULL;
 
 	enet_protocol_notify_connect(host, peer, event);
 
@@ -2377,9 +2614,12 @@ static int enet_protocol_handle_incoming_commands(ENetHost* host, ENetEvent* eve
 	peerID &= ~(ENET_PROTOCOL_HEADER_FLAG_MASK | ENET_PROTOCOL_HEADER_SESSION_MASK);
 	headerSize = (flags & ENET_PROTOCOL_HEADER_FLAG_SENT_TIME ? sizeof(ENetProtocolHeader) : (size_t) & ((ENetProtocolHeader*)0)->sentTime);
 
-	if (host->checksumCallback != NULL)
+	if (flags & ENET_PROTOCOL_HEADER_FLAG_CHECKSUM)
 		headerSize += sizeof(enet_checksum);
 
+	if (host->receivedDataLength < headerSize)
+		return 0;
+
 	if (peerID == ENET_PROTOCOL_MAXIMUM_PEER_ID) {
 		peer = NULL;
 	}
@@ -2393,17 +2633,23 @@ static int enet_protocol_handle_incoming_commands(ENetHost* host, ENetEvent* eve
 			return 0;
 	}
 
-	if (host->checksumCallback != NULL) {
+	if (flags & ENET_PROTOCOL_HEADER_FLAG_CHECKSUM) {
 		enet_checksum* checksum = (enet_checksum*)&host->receivedData[headerSize - sizeof(enet_checksum)];
 		enet_checksum desiredChecksum = *checksum;
 		ENetBuffer buffer;
+
+		if (host->checksumCallback == NULL)
+			return 0;
+
 		*checksum = peer != NULL ? peer->connectID : 0;
 		buffer.data = host->receivedData;
 		buffer.dataLength = host->receivedDataLength;
 
-		if (host->checksumCallback(&buffer, 1) != desiredChecksum)
+		if ((enet_checksum)host->checksumCallback(&buffer, 1) != desiredChecksum)
 			return 0;
 	}
+	else if (peer != NULL && peer->checksum)
+		return 0; /* negotiated, the flag itself was damaged */
 
 	if (peer != NULL) {
 		peer->address.ipv6 = host->receivedAddress.ipv6;
@@ -2560,15 +2806,215 @@ commandError:
 	return 0;
 }
 
+#ifdef ENET_USE_MMSG
+/* Datagrams received and sent with a single system call each, the outgoing ones of a service pass are copied
+   here and sent together when the pass ends, the ones of a peer that have the same size as a segmentation offload */
+typedef struct _ENetMmsg {
+	uint8_t receiveData[ENET_MMSG_BATCH][ENET_PROTOCOL_MAXIMUM_MTU];
+	struct iovec receiveIov[ENET_MMSG_BATCH];
+	struct sockaddr_in6 receiveNames[ENET_MMSG_BATCH];
+	struct mmsghdr receiveHeaders[ENET_MMSG_BATCH];
+	size_t receiveCount;
+	size_t receiveIndex;
+	uint8_t sendData[ENET_MMSG_BATCH][ENET_PROTOCOL_MAXIMUM_MTU];
+	size_t sendLength[ENET_MMSG_BATCH];
+	ENetAddress sendAddress[ENET_MMSG_BATCH];
+	struct iovec sendIov[ENET_MMSG_BATCH];
+	struct sockaddr_in6 sendNames[ENET_MMSG_BATCH];
+	struct mmsghdr sendHeaders[ENET_MMSG_BATCH];
+	uint8_t sendControl[ENET_MMSG_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+	size_t sendCount;
+	int noGso;
+} ENetMmsg;
+
+#define ENET_MMSG_RECEIVE_PENDING(host) ((host)->mmsg->receiveIndex < (host)->mmsg->receiveCount)
+
+static int enet_host_receive_batched(ENetHost* host) {
+	ENetMmsg* batch = host->mmsg;
+	struct mmsghdr* msg;
+	int count;
+	size_t i;
+
+	if (batch->receiveIndex >= batch->receiveCount) {
+		for (i = 0; i < ENET_MMSG_BATCH; ++i) {
+			batch->receiveIov[i].iov_base = batch->receiveData[i];
+			batch->receiveIov[i].iov_len = sizeof(batch->receiveData[i]); // accept mtu probes larger than our mtu
+
+			memset(&batch->receiveHeaders[i], 0, sizeof(struct mmsghdr));
+			batch->receiveHeaders[i].msg_hdr.msg_name = &batch->receiveNames[i];
+			batch->receiveHeaders[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+			batch->receiveHeaders[i].msg_hdr.msg_iov = &batch->receiveIov[i];
+			batch->receiveHeaders[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		batch->receiveCount = 0;
+		batch->receiveIndex = 0;
+		count = recvmmsg(host->socket, batch->receiveHeaders, ENET_MMSG_BATCH, 0, NULL);
+
+		if (count < 0)
+			return (errno == EWOULDBLOCK || errno == EAGAIN) ? 0 : -1;
+
+		batch->receiveCount = (size_t)count;
+
+		if (count == 0)
+			return 0;
+	}
+
+	i = batch->receiveIndex++;
+	msg = &batch->receiveHeaders[i];
+
+	if (msg->msg_hdr.msg_flags & MSG_TRUNC)
+		return -2;
+
+	host->receivedAddress.ipv6 = batch->receiveNames[i].sin6_addr;
+	host->receivedAddress.port = ENET_NET_TO_HOST_16(batch->receiveNames[i].sin6_port);
+	host->receivedData = batch->receiveData[i];
+
+	return (int)msg->msg_len;
+}
+
+static int enet_host_flush_datagrams(ENetHost* host) {
+	ENetMmsg* batch = host->mmsg;
+	size_t i, count = 0, sent = 0;
+
+	for (i = 0; i < batch->sendCount;) {
+		struct mmsghdr* msg = &batch->sendHeaders[count];
+		size_t segments = 1, size = batch->sendLength[i], bytes = size, k;
+
+		if (!batch->noGso) {
+			/* every segment but the last one must be as big as the first */
+			while (i + segments < batch->sendCount && segments < ENET_MMSG_GSO_SEGMENTS && batch->sendLength[i + segments - 1] == size && batch->sendLength[i + segments] <= size &&
+				bytes + batch->sendLength[i + segments] <= ENET_MMSG_GSO_BYTES && batch->sendAddress[i + segments].port == batch->sendAddress[i].port &&
+				!memcmp(&batch->sendAddress[i + segments].ipv6, &batch->sendAddress[i].ipv6, sizeof(struct in6_addr))) {
+				bytes += batch->sendLength[i + segments];
+				segments++;
+			}
+		}
+
+		for (k = 0; k < segments; ++k) {
+			batch->sendIov[i + k].iov_base = batch->sendData[i + k];
+			batch->sendIov[i + k].iov_len = batch->sendLength[i + k];
+		}
+
+		memset(&batch->sendNames[count], 0, sizeof(struct sockaddr_in6));
+		batch->sendNames[count].sin6_family = AF_INET6;
+		batch->sendNames[count].sin6_port = ENET_HOST_TO_NET_16(batch->sendAddress[i].port);
+		batch->sendNames[count].sin6_addr = batch->sendAddress[i].ipv6;
+
+		memset(msg, 0, sizeof(struct mmsghdr));
+		msg->msg_hdr.msg_name = &batch->sendNames[count];
+		msg->msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+		msg->msg_hdr.msg_iov = &batch->sendIov[i];
+		msg->msg_hdr.msg_iovlen = segments;
+
+		if (segments > 1) {
+			struct cmsghdr* cmsg;
+			msg->msg_hdr.msg_control = batch->sendControl[count];
+			msg->msg_hdr.msg_controllen = sizeof(batch->sendControl[count]);
+			cmsg = CMSG_FIRSTHDR(&msg->msg_hdr);
+			cmsg->cmsg_level = SOL_UDP;
+			cmsg->cmsg_type = UDP_SEGMENT;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+			*(uint16_t*)CMSG_DATA(cmsg) = (uint16_t)size;
+		}
+
+		count++;
+		i += segments;
+	}
+
+	batch->sendCount = 0;
+
+	while (sent < count) {
+		int result = sendmmsg(host->socket, &batch->sendHeaders[sent], (unsigned int)(count - sent), MSG_NOSIGNAL);
+
+		if (result > 0) {
+			sent += (size_t)result;
+			continue;
+		}
+
+		if (result == 0)
+			break;
+
+		if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EMSGSIZE) { /* dropped, like enet_socket_send */
+			sent++;
+			continue;
+		}
+
+		if (batch->sendHeaders[sent].msg_hdr.msg_controllen && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+			/* no segmentation offload on this kernel or device, send the segments one by one from now on */
+			struct msghdr* hdr = &batch->sendHeaders[sent].msg_hdr;
+			struct iovec* iov = hdr->msg_iov;
+			size_t segments = hdr->msg_iovlen;
+
+			batch->noGso = 1;
+			hdr->msg_control = NULL;
+			hdr->msg_controllen = 0;
+			hdr->msg_iovlen = 1;
+
+			for (i = 0; i < segments; ++i) {
+				hdr->msg_iov = &iov[i];
+
+				if (sendmsg(host->socket, hdr, MSG_NOSIGNAL) < 0 && errno != EWOULDBLOCK && errno != EAGAIN && errno != EMSGSIZE)
+					return -1;
+			}
+
+			sent++;
+			continue;
+		}
+
+		return -1;
+	}
+
+	return 0;
+}
+
+static int enet_host_send_datagram(ENetHost* host, const ENetAddress* address, const ENetBuffer* buffers, size_t bufferCount) {
+	ENetMmsg* batch = host->mmsg;
+	size_t i, length = 0;
+
+	for (i = 0; i < bufferCount; ++i)
+		length += buffers[i].dataLength;
+
+	if (length > ENET_PROTOCOL_MAXIMUM_MTU) {
+		if (enet_host_flush_datagrams(host) < 0)
+			return -1;
+
+		return enet_socket_send(host->socket, address, buffers, bufferCount);
+	}
+
+	if (batch->sendCount >= ENET_MMSG_BATCH && enet_host_flush_datagrams(host) < 0)
+		return -1;
+
+	for (i = 0, length = 0; i < bufferCount; ++i) {
+		memcpy(&batch->sendData[batch->sendCount][length], buffers[i].data, buffers[i].dataLength);
+		length += buffers[i].dataLength;
+	}
+
+	batch->sendLength[batch->sendCount] = length;
+	batch->sendAddress[batch->sendCount] = *address;
+	batch->sendCount++;
+
+	return (int)length;
+}
+#else
+#define ENET_MMSG_RECEIVE_PENDING(host) 0
+#define enet_host_send_datagram(host, address, buffers, bufferCount) enet_socket_send((host)->socket, address, buffers, bufferCount)
+#define enet_host_flush_datagrams(host) 0
+#endif
+
 static int enet_protocol_receive_incoming_commands(ENetHost* host, ENetEvent* event) {
 	int packets;
 
-	for (packets = 0; packets < 256; ++packets) {
+	for (packets = 0; packets < 256 || ENET_MMSG_RECEIVE_PENDING(host); ++packets) { // the batched datagrams are not left behind, the host would wait on the socket
 		int receivedLength;
+#ifdef ENET_USE_MMSG
+		receivedLength = enet_host_receive_batched(host);
+#else
 		ENetBuffer buffer;
 		buffer.data = host->packetData[0];
-		buffer.dataLength = host->mtu;
+		buffer.dataLength = sizeof(host->packetData[0]); // accept mtu probes larger than our mtu
 		receivedLength = enet_socket_receive(host->socket, &host->receivedAddress, &buffer, 1);
+#endif
 
 		if (receivedLength == -2)
 			continue;
@@ -2579,13 +3025,15 @@ static int enet_protocol_receive_incoming_commands(ENetHost* host, ENetEvent* ev
 		if (receivedLength == 0)
 			return 0;
 
+#ifndef ENET_USE_MMSG
 		host->receivedData = host->packetData[0];
+#endif
 		host->receivedDataLength = receivedLength;
 		host->totalReceivedData += receivedLength;
 		host->totalReceivedPackets++;
 
 		if (host->interceptCallback != NULL) {
-			switch (host->interceptCallback(event, &host->receivedAddress, host->receivedData, host->receivedDataLength)) {
+			switch (host->interceptCallback(host, event, &host->receivedAddress, host->receivedData, host->receivedDataLength)) {
 			case 1:
 				if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
 					return 1;
@@ -2710,6 +3158,14 @@ static int enet_protocol_check_outgoing_commands(ENetHost* host, ENetPeer* peer)
 	while (currentCommand != enet_list_end(&peer->outgoingCommands)) {
 		outgoingCommand = (ENetOutgoingCommand*)currentCommand;
 
+		if (outgoingCommand->packet != NULL && peer->ccPacingRate != 0 && peer->ccPacingBudget <= 0) {
+			/* paced, the data waits for the next service */
+			peer->ccSampleLimited = 1;
+			currentCommand = enet_list_next(currentCommand);
+
+			continue;
+		}
+
 		if (outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE) {
 			channel = outgoingCommand->command.header.channelID < peer->channelCount ? &peer->channels[outgoingCommand->command.header.channelID] : NULL;
 			reliableWindow = outgoingCommand->reliableSequenceNumber / ENET_PEER_RELIABLE_WINDOW_SIZE;
@@ -2826,6 +3282,13 @@ static int enet_protocol_check_outgoing_commands(ENetHost* host, ENetPeer* peer)
 			buffer->data = outgoingCommand->packet->data + outgoingCommand->fragmentOffset;
 			buffer->dataLength = outgoingCommand->fragmentLength;
 			host->packetSize += outgoingCommand->fragmentLength;
+
+			if (host->congestionControl) {
+				peer->ccSampleSent += commandSize + outgoingCommand->fragmentLength;
+
+				if (peer->ccPacingRate != 0)
+					peer->ccPacingBudget -= (int32_t)(commandSize + outgoingCommand->fragmentLength);
+			}
 		}
 		else if (!(outgoingCommand->command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE)) {
 			enet_free(outgoingCommand);
@@ -2845,16 +3308,58 @@ static int enet_protocol_check_outgoing_commands(ENetHost* host, ENetPeer* peer)
 	return canPing;
 }
 
-static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event, int checkForTimeouts) {
+#define ENET_PEER_FROM_ACTIVE(node) ((ENetPeer*)((uint8_t*)(node) - (size_t) & ((ENetPeer*)0)->activeList))
+
+/* Moves the idle peers whose deadline passed back to the active list. Only the slots that ended since the last service
+   are checked, so a deadline is late by less than a slot, and a peer is only visited again if its deadline is a full turn away */
+static void enet_host_wake_idle_peers(ENetHost* host) {
+	uint32_t slot = host->idleWheelTime / ENET_HOST_IDLE_WHEEL_RESOLUTION;
+	uint32_t turns = host->serviceTime / ENET_HOST_IDLE_WHEEL_RESOLUTION - slot;
+	uint32_t i;
+
+	if (ENET_TIME_LESS(host->serviceTime, host->idleWheelTime) || turns == 0)
+		return;
+
+	if (turns > ENET_HOST_IDLE_WHEEL_SLOTS)
+		turns = ENET_HOST_IDLE_WHEEL_SLOTS;
+
+	for (i = 0; i < turns; ++i) {
+		ENetList* list = &host->idleWheel[(slot + i) % ENET_HOST_IDLE_WHEEL_SLOTS];
+		ENetListIterator currentNode = enet_list_begin(list), nextNode;
+
+		for (; currentNode != enet_list_end(list); currentNode = nextNode) {
+			ENetPeer* peer = ENET_PEER_FROM_ACTIVE(currentNode);
+			nextNode = enet_list_next(currentNode);
+
+			if (ENET_TIME_GREATER_EQUAL(host->serviceTime, peer->activityDeadline))
+				enet_peer_activate(peer);
+		}
+	}
+
+	host->idleWheelTime = host->serviceTime;
+}
+
+static int enet_protocol_send_outgoing_pass(ENetHost* host, ENetEvent* event, int checkForTimeouts) {
 	uint8_t headerData[sizeof(ENetProtocolHeader) + sizeof(enet_checksum)];
 	ENetProtocolHeader* header = (ENetProtocolHeader*)headerData;
 	ENetPeer* currentPeer;
+	ENetListIterator currentNode, nextNode;
 	int sentLength;
 	host->continueSending = 1;
 
+	enet_host_wake_idle_peers(host);
+
 	while (host->continueSending) {
-		for (host->continueSending = 0, currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
-			if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED || currentPeer->state == ENET_PEER_STATE_ZOMBIE)
+		for (host->continueSending = 0, currentNode = enet_list_begin(&host->activePeers); currentNode != enet_list_end(&host->activePeers); currentNode = nextNode) {
+			currentPeer = ENET_PEER_FROM_ACTIVE(currentNode);
+			nextNode = enet_list_next(currentNode); // the peer can leave the list while it's serviced
+
+			if (currentPeer->state == ENET_PEER_STATE_DISCONNECTED) {
+				enet_peer_deactivate(currentPeer);
+				continue;
+			}
+
+			if (currentPeer->state == ENET_PEER_STATE_ZOMBIE)
 				continue;
 
 			host->headerFlags = 0;
@@ -2862,12 +3367,15 @@ static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event
 			host->bufferCount = 1;
 			host->packetSize = sizeof(ENetProtocolHeader);
 
-			if (host->checksumCallback != NULL)
+			if (currentPeer->checksum)
 				host->packetSize += sizeof(enet_checksum);
 
 			if (!enet_list_empty(&currentPeer->acknowledgements))
 				enet_protocol_send_acknowledgements(host, currentPeer);
 
+			if (host->congestionControl)
+				enet_peer_pacing_refill(currentPeer);
+
 			if (checkForTimeouts != 0 && !enet_list_empty(&currentPeer->sentReliableCommands) && ENET_TIME_GREATER_EQUAL(host->serviceTime, currentPeer->nextTimeout) && enet_protocol_check_timeouts(host, currentPeer, event) == 1) {
 				if (event != NULL && event->type != ENET_EVENT_TYPE_NONE)
 					return 1;
@@ -2880,8 +3388,13 @@ static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event
 				enet_protocol_check_outgoing_commands(host, currentPeer);
 			}
 
-			if (host->commandCount == 0)
+			if (host->commandCount == 0) {
+				/* nothing to send until a timeout, a ping or new work, the peer is not serviced until then */
+				if (enet_list_empty(&currentPeer->acknowledgements) && enet_list_empty(&currentPeer->outgoingCommands))
+					enet_peer_idle(currentPeer, enet_list_empty(&currentPeer->sentReliableCommands) ? currentPeer->lastReceiveTime + currentPeer->pingInterval : currentPeer->nextTimeout);
+
 				continue;
+			}
 
 			host->buffers->data = headerData;
 
@@ -2896,17 +3409,20 @@ static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event
 			if (currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID)
 				host->headerFlags |= currentPeer->outgoingSessionID << ENET_PROTOCOL_HEADER_SESSION_SHIFT;
 
+			if (currentPeer->checksum)
+				host->headerFlags |= ENET_PROTOCOL_HEADER_FLAG_CHECKSUM;
+
 			header->peerID = ENET_HOST_TO_NET_16(currentPeer->outgoingPeerID | host->headerFlags);
 
-			if (host->checksumCallback != NULL) {
+			if (currentPeer->checksum) {
 				enet_checksum* checksum = (enet_checksum*)&headerData[host->buffers->dataLength];
 				*checksum = currentPeer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID ? currentPeer->connectID : 0;
 				host->buffers->dataLength += sizeof(enet_checksum);
-				*checksum = host->checksumCallback(host->buffers, host->bufferCount);
+				*checksum = (enet_checksum)host->checksumCallback(host->buffers, host->bufferCount);
 			}
 
 			currentPeer->lastSendTime = host->serviceTime;
-			sentLength = enet_socket_send(host->socket, &currentPeer->address, host->buffers, host->bufferCount);
+			sentLength = enet_host_send_datagram(host, &currentPeer->address, host->buffers, host->bufferCount);
 
 			enet_protocol_remove_sent_unreliable_commands(currentPeer);
 
@@ -2922,6 +3438,15 @@ static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event
 	return 0;
 }
 
+static int enet_protocol_send_outgoing_commands(ENetHost* host, ENetEvent* event, int checkForTimeouts) {
+	int result = enet_protocol_send_outgoing_pass(host, event, checkForTimeouts);
+
+	if (enet_host_flush_datagrams(host) < 0)
+		return -1;
+
+	return result;
+}
+
 void enet_host_flush(ENetHost* host) {
 	host->serviceTime = enet_time_get();
 
@@ -3104,6 +3629,108 @@ int enet_peer_throttle(ENetPeer* peer, uint32_t rtt) {
 	return 0;
 }
 
+/* Delay based congestion control: the bottleneck bandwidth is the highest rate that was delivered
+   recently and starts the pacing. When the rtt grows over the lowest one the link is queueing and the
+   pacing slows down by a fourth, while it holds data back on an empty link it speeds up by an eighth */
+void enet_peer_congestion_update(ENetPeer* peer, uint32_t rtt) {
+	ENetHost* host = peer->host;
+	uint32_t elapsed, sample, queueDelay, i;
+	int32_t drained;
+
+	if (peer->ccMinRoundTripTime == 0 || rtt < peer->ccMinRoundTripTime) {
+		peer->ccMinRoundTripTime = rtt;
+		peer->ccNextMinRoundTripTime = rtt;
+		peer->ccMinRoundTripTimeEpoch = host->serviceTime;
+	}
+	else if (ENET_TIME_DIFFERENCE(host->serviceTime, peer->ccMinRoundTripTimeEpoch) >= ENET_PEER_CC_MIN_RTT_WINDOW) {
+		/* the route might have changed, use the lowest rtt of the last window */
+		peer->ccMinRoundTripTime = ENET_MIN(peer->ccNextMinRoundTripTime, rtt);
+		peer->ccNextMinRoundTripTime = rtt;
+		peer->ccMinRoundTripTimeEpoch = host->serviceTime;
+	}
+	else if (rtt < peer->ccNextMinRoundTripTime)
+		peer->ccNextMinRoundTripTime = rtt;
+
+	if (peer->ccSampleMinRoundTripTime == 0 || rtt < peer->ccSampleMinRoundTripTime)
+		peer->ccSampleMinRoundTripTime = rtt;
+
+	++peer->ccSampleRoundTripTimes;
+
+	if (peer->ccSampleEpoch == 0) {
+		peer->ccSampleEpoch = host->serviceTime;
+		peer->ccSampleAcked = 0;
+		peer->ccSampleSent = 0;
+		return;
+	}
+
+	elapsed = ENET_TIME_DIFFERENCE(host->serviceTime, peer->ccSampleEpoch);
+
+	if (elapsed < ENET_MAX(peer->ccMinRoundTripTime, ENET_PEER_CC_SAMPLE_INTERVAL) || peer->ccSampleRoundTripTimes < ENET_PEER_CC_SAMPLE_RTTS)
+		return; /* with unreliable data only the pings are acked, a single late one is not a queue */
+
+	/* a queue on the path delays every packet, a peer that services late delays only some acks:
+	   the lowest rtt of the interval tells how much is queued, the smoothed one lags and follows the jitter */
+	queueDelay = peer->ccSampleMinRoundTripTime > peer->ccMinRoundTripTime ? peer->ccSampleMinRoundTripTime - peer->ccMinRoundTripTime : 0;
+	peer->ccQueueDelay = queueDelay;
+
+	/* acked data was delivered for sure. The unreliable data is never acked: what was sent went through
+	   the link, but if the queue grew by d ms during the t ms of the interval the link took t + d ms for it.
+	   The jitter of the services can only make the sample lower, a sample that is too high fills the queue */
+	drained = (int32_t)queueDelay - (int32_t)peer->ccSampleQueueDelay;
+	drained = (int32_t)elapsed + ENET_MAX(drained, 0); /* a queue that shrinks was drained by the link too, we cannot tell by how much */
+	sample = (uint32_t)ENET_MAX((uint64_t)peer->ccSampleAcked * 1000 / elapsed, (uint64_t)peer->ccSampleSent * 1000 / (uint32_t)drained);
+
+	/* when the game sent less than it could the sample says nothing about the link, keep the old estimate */
+	if (sample >= peer->ccBottleneckBandwidth || (uint64_t)peer->ccSampleSent * 2000 >= (uint64_t)peer->ccPacingRate * elapsed) {
+		peer->ccBandwidthSamples[peer->ccBandwidthSample++ % ENET_PEER_CC_BANDWIDTH_SAMPLES] = sample;
+		peer->ccBottleneckBandwidth = 0;
+
+		for (i = 0; i < ENET_PEER_CC_BANDWIDTH_SAMPLES; ++i)
+			peer->ccBottleneckBandwidth = ENET_MAX(peer->ccBottleneckBandwidth, peer->ccBandwidthSamples[i]);
+	}
+
+	peer->ccSampleEpoch = host->serviceTime;
+	peer->ccSampleAcked = 0;
+	peer->ccSampleSent = 0;
+	peer->ccSampleQueueDelay = queueDelay;
+	peer->ccSampleMinRoundTripTime = 0;
+	peer->ccSampleRoundTripTimes = 0;
+
+	if (peer->ccQueueDelay > ENET_PEER_CC_TARGET_DELAY)
+		peer->ccPacingRate = (peer->ccPacingRate != 0 ? ENET_MIN(peer->ccPacingRate, peer->ccBottleneckBandwidth) : peer->ccBottleneckBandwidth) / 4 * 3; /* drain the queue */
+	else if (peer->ccSampleLimited)
+		peer->ccPacingRate = peer->ccPacingRate != 0 ? peer->ccPacingRate + peer->ccPacingRate / 8 : peer->ccBottleneckBandwidth; /* the pacing held data back, probe for more without filling the queue */
+	else
+		peer->ccPacingRate = 0; /* nothing is queued, the bursts of the game go out as they come */
+
+	peer->ccSampleLimited = 0;
+
+	if (peer->ccPacingRate != 0 && peer->ccPacingRate < ENET_PEER_CC_MIN_RATE)
+		peer->ccPacingRate = ENET_PEER_CC_MIN_RATE;
+}
+
+/* Gives back the pacing budget for the time passed since the last send, keeping bursts short */
+void enet_peer_pacing_refill(ENetPeer* peer) {
+	ENetHost* host = peer->host;
+	uint32_t elapsed;
+	int32_t burst;
+
+	if (peer->ccPacingRate == 0)
+		return;
+
+	if (peer->ccPacingEpoch == 0)
+		peer->ccPacingEpoch = host->serviceTime;
+
+	elapsed = ENET_TIME_DIFFERENCE(host->serviceTime, peer->ccPacingEpoch);
+
+	if (elapsed == 0)
+		return;
+
+	burst = (int32_t)ENET_MAX((uint64_t)peer->ccPacingRate * ENET_PEER_CC_BURST_TIME / 1000, (uint64_t)peer->mtu * 2);
+	peer->ccPacingBudget = (int32_t)ENET_MIN((int64_t)peer->ccPacingBudget + (int64_t)peer->ccPacingRate * elapsed / 1000, (int64_t)burst);
+	peer->ccPacingEpoch = host->serviceTime;
+}
+
 int enet_peer_send(ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
 	ENetChannel* channel;
 	ENetProtocol command;
@@ -3115,7 +3742,7 @@ int enet_peer_send(ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
 	channel = &peer->channels[channelID];
 	fragmentLength = peer->mtu - sizeof(ENetProtocolHeader) - sizeof(ENetProtocolSendFragment) - sizeof(ENetProtocolAcknowledge);
 
-	if (peer->host->checksumCallback != NULL)
+	if (peer->checksum)
 		fragmentLength -= sizeof(enet_checksum);
 
 	if (packet->dataLength > fragmentLength) {
@@ -3205,6 +3832,136 @@ int enet_peer_send(ENetPeer* peer, uint8_t channelID, ENetPacket* packet) {
 	return 0;
 }
 
+/* Sends a single unsequenced datagram of exactly mtu bytes, bypassing the peer mtu, to probe the path mtu; data is padded with zeros */
+int enet_peer_send_probe(ENetPeer* peer, uint8_t channelID, const void* data, size_t dataLength, uint32_t mtu) {
+	ENetHost* host = peer->host;
+	uint8_t headerData[sizeof(ENetProtocolHeader) + sizeof(enet_checksum)];
+	ENetProtocolHeader* header = (ENetProtocolHeader*)headerData;
+	ENetProtocol command;
+	ENetBuffer buffers[3];
+	size_t headerLength = (size_t) & ((ENetProtocolHeader*)0)->sentTime;
+	size_t overhead, payloadLength;
+	uint16_t headerFlags = 0;
+	uint8_t* payload;
+	int sentLength;
+
+	if (peer->state != ENET_PEER_STATE_CONNECTED || channelID >= peer->channelCount || mtu > ENET_PROTOCOL_MAXIMUM_MTU)
+		return -1;
+
+	overhead = headerLength + sizeof(ENetProtocolSendUnsequenced);
+
+	if (peer->checksum)
+		overhead += sizeof(enet_checksum);
+
+	if (mtu < overhead + dataLength)
+		return -1;
+
+	payloadLength = mtu - overhead;
+	payload = (uint8_t*)enet_malloc(payloadLength);
+
+	if (payload == NULL)
+		return -1;
+
+	memset(payload, 0, payloadLength);
+	memcpy(payload, data, dataLength);
+
+	++peer->outgoingUnsequencedGroup;
+
+	command.header.command = ENET_PROTOCOL_COMMAND_SEND_UNSEQUENCED | ENET_PROTOCOL_COMMAND_FLAG_UNSEQUENCED;
+	command.header.channelID = channelID;
+	command.header.reliableSequenceNumber = 0;
+	command.sendUnsequenced.unsequencedGroup = ENET_HOST_TO_NET_16(peer->outgoingUnsequencedGroup);
+	command.sendUnsequenced.dataLength = ENET_HOST_TO_NET_16(payloadLength);
+
+	if (peer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID)
+		headerFlags |= peer->outgoingSessionID << ENET_PROTOCOL_HEADER_SESSION_SHIFT;
+
+	if (peer->checksum)
+		headerFlags |= ENET_PROTOCOL_HEADER_FLAG_CHECKSUM;
+
+	header->peerID = ENET_HOST_TO_NET_16(peer->outgoingPeerID | headerFlags);
+
+	buffers[0].data = headerData;
+	buffers[0].dataLength = headerLength;
+	buffers[1].data = &command;
+	buffers[1].dataLength = sizeof(ENetProtocolSendUnsequenced);
+	buffers[2].data = payload;
+	buffers[2].dataLength = payloadLength;
+
+	if (peer->checksum) {
+		enet_checksum* checksum = (enet_checksum*)&headerData[headerLength];
+		*checksum = peer->outgoingPeerID < ENET_PROTOCOL_MAXIMUM_PEER_ID ? peer->connectID : 0;
+		buffers[0].dataLength += sizeof(enet_checksum);
+		*checksum = (enet_checksum)host->checksumCallback(buffers, 3);
+	}
+
+	sentLength = enet_socket_send(host->socket, &peer->address, buffers, 3);
+	enet_free(payload);
+
+	if (sentLength <= 0)
+		return -1;
+
+	host->totalSentData += sentLength;
+	peer->totalDataSent += sentLength;
+	host->totalSentPackets++;
+
+	return 0;
+}
+
+/* Replaces the bits of mask in the data of the connect command of a peer that is still connecting and sends the command again at once, for the hosts that answer the first one with a challenge */
+int enet_peer_resend_connect(ENetPeer* peer, uint32_t mask, uint32_t data) {
+	ENetHost* host = peer->host;
+	ENetOutgoingCommand* outgoingCommand = NULL;
+	ENetListIterator currentCommand;
+	ENetProtocolHeader header;
+	ENetBuffer buffers[2];
+	int sentLength;
+
+	if (peer->state != ENET_PEER_STATE_CONNECTING)
+		return -1;
+
+	for (currentCommand = enet_list_begin(&peer->outgoingCommands); currentCommand != enet_list_end(&peer->outgoingCommands); currentCommand = enet_list_next(currentCommand)) {
+		if ((((ENetOutgoingCommand*)currentCommand)->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_CONNECT) {
+			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+			outgoingCommand->command.connect.data = ENET_HOST_TO_NET_32((ENET_NET_TO_HOST_32(outgoingCommand->command.connect.data) & ~mask) | (data & mask));
+
+			return 0; /* not sent yet, it leaves with the new data */
+		}
+	}
+
+	for (currentCommand = enet_list_begin(&peer->sentReliableCommands); currentCommand != enet_list_end(&peer->sentReliableCommands); currentCommand = enet_list_next(currentCommand)) {
+		if ((((ENetOutgoingCommand*)currentCommand)->command.header.command & ENET_PROTOCOL_COMMAND_MASK) == ENET_PROTOCOL_COMMAND_CONNECT) {
+			outgoingCommand = (ENetOutgoingCommand*)currentCommand;
+			break;
+		}
+	}
+
+	if (outgoingCommand == NULL)
+		return -1;
+
+	/* the retransmissions carry it too */
+	outgoingCommand->command.connect.data = ENET_HOST_TO_NET_32((ENET_NET_TO_HOST_32(outgoingCommand->command.connect.data) & ~mask) | (data & mask));
+
+	header.peerID = ENET_HOST_TO_NET_16(ENET_PROTOCOL_MAXIMUM_PEER_ID | ENET_PROTOCOL_HEADER_FLAG_SENT_TIME);
+	header.sentTime = ENET_HOST_TO_NET_16(enet_time_get() & 0xFFFF);
+
+	buffers[0].data = &header;
+	buffers[0].dataLength = sizeof(ENetProtocolHeader);
+	buffers[1].data = &outgoingCommand->command;
+	buffers[1].dataLength = sizeof(ENetProtocolConnect);
+
+	sentLength = enet_socket_send(host->socket, &peer->address, buffers, 2);
+
+	if (sentLength <= 0)
+		return -1;
+
+	host->totalSentData += sentLength;
+	peer->totalDataSent += sentLength;
+	host->totalSentPackets++;
+
+	return 0;
+}
+
 ENetPacket* enet_peer_receive(ENetPeer* peer, uint8_t* channelID) {
 	ENetIncomingCommand* incomingCommand;
 	ENetPacket* packet;
@@ -3326,8 +4083,41 @@ void enet_peer_on_disconnect(ENetPeer* peer) {
 	}
 }
 
+void enet_peer_activate(ENetPeer* peer) {
+	if (peer->activity == ENET_PEER_ACTIVITY_BUSY)
+		return;
+
+	if (peer->activity == ENET_PEER_ACTIVITY_IDLE)
+		enet_list_remove(&peer->activeList);
+
+	enet_list_insert(enet_list_end(&peer->host->activePeers), &peer->activeList);
+	peer->activity = ENET_PEER_ACTIVITY_BUSY;
+}
+
+void enet_peer_deactivate(ENetPeer* peer) {
+	if (peer->activity != ENET_PEER_ACTIVITY_NONE)
+		enet_list_remove(&peer->activeList);
+
+	peer->activity = ENET_PEER_ACTIVITY_NONE;
+}
+
+void enet_peer_idle(ENetPeer* peer, uint32_t deadline) {
+	ENetHost* host = peer->host;
+
+	if (ENET_TIME_LESS(deadline, host->serviceTime))
+		deadline = host->serviceTime;
+
+	if (peer->activity != ENET_PEER_ACTIVITY_NONE)
+		enet_list_remove(&peer->activeList);
+
+	enet_list_insert(enet_list_end(&host->idleWheel[(deadline / ENET_HOST_IDLE_WHEEL_RESOLUTION) % ENET_HOST_IDLE_WHEEL_SLOTS]), &peer->activeList);
+	peer->activity = ENET_PEER_ACTIVITY_IDLE;
+	peer->activityDeadline = deadline;
+}
+
 void enet_peer_reset(ENetPeer* peer) {
 	enet_peer_on_disconnect(peer);
+	enet_peer_deactivate(peer);
 
 	peer->outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
 	peer->state = ENET_PEER_STATE_DISCONNECTED;
@@ -3345,6 +4135,8 @@ void enet_peer_reset(ENetPeer* peer) {
 	peer->earliestTimeout = 0;
 	peer->totalPacketsSent = 0;
 	peer->totalPacketsLost = 0;
+	peer->unreliablePacketsReceived = 0;
+	peer->unreliablePacketsLost = 0;
 	peer->packetThrottle = ENET_PEER_DEFAULT_PACKET_THROTTLE;
 	peer->packetThrottleThreshold = ENET_PEER_PACKET_THROTTLE_THRESHOLD;
 	peer->packetThrottleLimit = ENET_PEER_PACKET_THROTTLE_SCALE;
@@ -3371,7 +4163,26 @@ void enet_peer_reset(ENetPeer* peer) {
 	peer->outgoingUnsequencedGroup = 0;
 	peer->eventData = 0;
 	peer->totalWaitingData = 0;
-
+	peer->checksum = 0;
+	peer->timedOut = 0;
+	peer->ccMinRoundTripTime = 0;
+	peer->ccNextMinRoundTripTime = 0;
+	peer->ccMinRoundTripTimeEpoch = 0;
+	peer->ccQueueDelay = 0;
+	peer->ccSampleEpoch = 0;
+	peer->ccSampleAcked = 0;
+	peer->ccSampleSent = 0;
+	peer->ccSampleQueueDelay = 0;
+	peer->ccSampleMinRoundTripTime = 0;
+	peer->ccSampleRoundTripTimes = 0;
+	peer->ccSampleLimited = 0;
+	peer->ccBandwidthSample = 0;
+	peer->ccBottleneckBandwidth = 0;
+	peer->ccPacingRate = 0;
+	peer->ccPacingBudget = 0;
+	peer->ccPacingEpoch = 0;
+
+	memset(peer->ccBandwidthSamples, 0, sizeof(peer->ccBandwidthSamples));
 	memset(peer->unsequencedWindow, 0, sizeof(peer->unsequencedWindow));
 
 	enet_peer_reset_queues(peer);
@@ -3391,12 +4202,19 @@ void enet_peer_ping(ENetPeer* peer) {
 
 void enet_peer_ping_interval(ENetPeer* peer, uint32_t pingInterval) {
 	peer->pingInterval = pingInterval ? pingInterval : ENET_PEER_PING_INTERVAL;
+
+	/* the deadline of an idle peer came from the old interval, the next service puts it back in the wheel */
+	if (peer->activity == ENET_PEER_ACTIVITY_IDLE)
+		enet_peer_activate(peer);
 }
 
 void enet_peer_timeout(ENetPeer* peer, uint32_t timeoutLimit, uint32_t timeoutMinimum, uint32_t timeoutMaximum) {
 	peer->timeoutLimit = timeoutLimit ? timeoutLimit : ENET_PEER_TIMEOUT_LIMIT;
 	peer->timeoutMinimum = timeoutMinimum ? timeoutMinimum : ENET_PEER_TIMEOUT_MINIMUM;
 	peer->timeoutMaximum = timeoutMaximum ? timeoutMaximum : ENET_PEER_TIMEOUT_MAXIMUM;
+
+	if (peer->activity == ENET_PEER_ACTIVITY_IDLE)
+		enet_peer_activate(peer);
 }
 
 void enet_peer_disconnect_now(ENetPeer* peer, uint32_t data) {
@@ -3484,6 +4302,7 @@ ENetAcknowledgement* enet_peer_queue_acknowledgement(ENetPeer* peer, const ENetP
 	acknowledgement->command = *command;
 
 	enet_list_insert(enet_list_end(&peer->acknowledgements), acknowledgement);
+	enet_peer_activate(peer);
 
 	return acknowledgement;
 }
@@ -3538,6 +4357,7 @@ void enet_peer_setup_outgoing_command(ENetPeer* peer, ENetOutgoingCommand* outgo
 	}
 
 	enet_list_insert(enet_list_end(&peer->outgoingCommands), outgoingCommand);
+	enet_peer_activate(peer);
 }
 
 ENetOutgoingCommand* enet_peer_queue_outgoing_command(ENetPeer* peer, const ENetProtocol* command, ENetPacket* packet, uint32_t offset, uint16_t length) {
@@ -3722,6 +4542,22 @@ ENetIncomingCommand* enet_peer_queue_incoming_command(ENetPeer* peer, const ENet
 		if (reliableSequenceNumber == channel->incomingReliableSequenceNumber && unreliableSequenceNumber <= channel->incomingUnreliableSequenceNumber)
 			goto discardCommand;
 
+		/* the sender numbers its unreliable packets from 1 after every reliable one, a gap is a loss.
+		   The ones lost right before a reliable packet go unnoticed, the fragments of a packet count once */
+		if (reliableSequenceNumber == channel->lastUnreliableReliableSequenceNumber) {
+			if (unreliableSequenceNumber > channel->lastUnreliableSequenceNumber) {
+				peer->unreliablePacketsLost += unreliableSequenceNumber - channel->lastUnreliableSequenceNumber - 1;
+				++peer->unreliablePacketsReceived;
+				channel->lastUnreliableSequenceNumber = (uint16_t)unreliableSequenceNumber;
+			}
+		}
+		else if ((int16_t)(reliableSequenceNumber - channel->lastUnreliableReliableSequenceNumber) > 0) {
+			peer->unreliablePacketsLost += unreliableSequenceNumber - 1;
+			++peer->unreliablePacketsReceived;
+			channel->lastUnreliableReliableSequenceNumber = (uint16_t)reliableSequenceNumber;
+			channel->lastUnreliableSequenceNumber = (uint16_t)unreliableSequenceNumber;
+		}
+
 		for (currentCommand = enet_list_previous(enet_list_end(&channel->incomingUnreliableCommands)); currentCommand != enet_list_end(&channel->incomingUnreliableCommands); currentCommand = enet_list_previous(currentCommand)) {
 			incomingCommand = (ENetIncomingCommand*)currentCommand;
 
@@ -3846,6 +4682,7 @@ notifyError:
 ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t channelLimit, uint32_t incomingBandwidth, uint32_t outgoingBandwidth, int bufferSize) {
 	ENetHost* host;
 	ENetPeer* currentPeer;
+	size_t slot;
 
 	if (peerCount > ENET_PROTOCOL_MAXIMUM_PEER_ID)
 		return NULL;
@@ -3865,6 +4702,19 @@ ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t
 		return NULL;
 	}
 
+#ifdef ENET_USE_MMSG
+	host->mmsg = (ENetMmsg*)enet_malloc(sizeof(ENetMmsg));
+
+	if (host->mmsg == NULL) {
+		enet_free(host->peers);
+		enet_free(host);
+
+		return NULL;
+	}
+
+	memset(host->mmsg, 0, sizeof(ENetMmsg));
+#endif
+
 	memset(host->peers, 0, peerCount * sizeof(ENetPeer));
 
 	host->socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
@@ -3876,6 +4726,9 @@ ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t
 		if (host->socket != ENET_SOCKET_NULL)
 			enet_socket_destroy(host->socket);
 
+#ifdef ENET_USE_MMSG
+		enet_free(host->mmsg);
+#endif
 		enet_free(host->peers);
 		enet_free(host);
 
@@ -3928,8 +4781,15 @@ ENetHost* enet_host_create(const ENetAddress* address, size_t peerCount, size_t
 	host->maximumPacketSize = ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE;
 	host->maximumWaitingData = ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA;
 	host->interceptCallback = NULL;
+	host->congestionControl = 0;
+	host->idleWheelTime = 0;
+	host->data = NULL;
 
 	enet_list_clear(&host->dispatchQueue);
+	enet_list_clear(&host->activePeers);
+
+	for (slot = 0; slot < ENET_HOST_IDLE_WHEEL_SLOTS; ++slot)
+		enet_list_clear(&host->idleWheel[slot]);
 
 	for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
 		currentPeer->host = host;
@@ -3960,6 +4820,9 @@ void enet_host_destroy(ENetHost* host) {
 		enet_peer_reset(currentPeer);
 	}
 
+#ifdef ENET_USE_MMSG
+	enet_free(host->mmsg);
+#endif
 	enet_free(host->peers);
 	enet_free(host);
 }
@@ -4014,6 +4877,8 @@ ENetPeer* enet_host_connect(ENetHost* host, const ENetAddress* address, size_t c
 		channel->outgoingUnreliableSequenceNumber = 0;
 		channel->incomingReliableSequenceNumber = 0;
 		channel->incomingUnreliableSequenceNumber = 0;
+		channel->lastUnreliableReliableSequenceNumber = 0;
+		channel->lastUnreliableSequenceNumber = 0;
 
 		enet_list_clear(&channel->incomingReliableCommands);
 		enet_list_clear(&channel->incomingUnreliableCommands);
@@ -4024,6 +4889,9 @@ ENetPeer* enet_host_connect(ENetHost* host, const ENetAddress* address, size_t c
 	}
 
 	command.header.command = ENET_PROTOCOL_COMMAND_CONNECT | ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE;
+
+	if (host->checksumCallback != NULL)
+		command.header.command |= ENET_PROTOCOL_COMMAND_FLAG_CHECKSUM; /* ignored by the builds without checksums */
 	command.header.channelID = 0xFF;
 	command.connect.outgoingPeerID = ENET_HOST_TO_NET_16(currentPeer->incomingPeerID);
 	command.connect.incomingSessionID = currentPeer->incomingSessionID;
@@ -4125,6 +4993,19 @@ void enet_host_bandwidth_limit(ENetHost* host, uint32_t incomingBandwidth, uint3
 	host->recalculateBandwidthLimits = 1;
 }
 
+/* Enables the delay based congestion control and pacing on all the peers of the host */
+void enet_host_congestion_control(ENetHost* host, int enable) {
+	ENetPeer* currentPeer;
+
+	host->congestionControl = enable;
+
+	if (enable)
+		return;
+
+	for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer)
+		currentPeer->ccPacingRate = 0;
+}
+
 void enet_host_bandwidth_throttle(ENetHost* host) {
 	uint32_t timeCurrent = enet_time_get();
 	uint32_t elapsedTime = timeCurrent - host->bandwidthThrottleEpoch;
@@ -4381,6 +5262,8 @@ int enet_address_get_hostname(const ENetAddress* address, char* name, size_t nam
 
 #ifndef _WIN32
 int enet_initialize(void) {
+	enet_crc32c_initialize();
+
 	return 0;
 }
 
@@ -4512,6 +5395,20 @@ int enet_socket_set_option(ENetSocket socket, ENetSocketOption option, int value
 
 		break;
 
+	case ENET_SOCKOPT_DONTFRAGMENT: {
+#if defined(IPV6_MTU_DISCOVER) && defined(IP_MTU_DISCOVER)
+		int discover6 = value ? IPV6_PMTUDISC_PROBE : IPV6_PMTUDISC_DONT;
+		int discover4 = value ? IP_PMTUDISC_PROBE : IP_PMTUDISC_DONT;
+
+		result = setsockopt(socket, IPPROTO_IPV6, IPV6_MTU_DISCOVER, (char*)&discover6, sizeof(int));
+		setsockopt(socket, IPPROTO_IP, IP_MTU_DISCOVER, (char*)&discover4, sizeof(int)); /* ipv4 mapped addresses */
+#elif defined(IPV6_DONTFRAG)
+		result = setsockopt(socket, IPPROTO_IPV6, IPV6_DONTFRAG, (char*)&value, sizeof(int));
+#endif
+
+		break;
+	}
+
 	default:
 		break;
 	}
@@ -4604,7 +5501,7 @@ int enet_socket_send(ENetSocket socket, const ENetAddress* address, const ENetBu
 	sentLength = sendmsg(socket, &msgHdr, MSG_NOSIGNAL);
 
 	if (sentLength == -1) {
-		if (errno == EWOULDBLOCK)
+		if (errno == EWOULDBLOCK || errno == EMSGSIZE) /* datagram larger than the path mtu, dropped */
 			return 0;
 
 		return -1;
@@ -4719,6 +5616,7 @@ int enet_initialize(void) {
 	}
 
 	timeBeginPeriod(1);
+	enet_crc32c_initialize();
 
 	return 0;
 }
@@ -4837,6 +5735,14 @@ int enet_socket_set_option(ENetSocket socket, ENetSocketOption option, int value
 
 		break;
 
+	case ENET_SOCKOPT_DONTFRAGMENT:
+#ifdef IPV6_DONTFRAG
+		result = setsockopt(socket, IPPROTO_IPV6, IPV6_DONTFRAG, (char*)&value, sizeof(int));
+#endif
+		setsockopt(socket, IPPROTO_IP, IP_DONTFRAGMENT, (char*)&value, sizeof(int)); /* ipv4 mapped addresses */
+
+		break;
+
 	default:
 		break;
 	}
@@ -4918,7 +5824,7 @@ int enet_socket_send(ENetSocket socket, const ENetAddress* address, const ENetBu
 	}
 
 	if (WSASendTo(socket, (LPWSABUF)buffers, (DWORD)bufferCount, &sentLength, 0, address != NULL ? (struct sockaddr*)&sin : NULL, address != NULL ? sizeof(struct sockaddr_in6) : 0, NULL, NULL) == SOCKET_ERROR)
-		return (WSAGetLastError() == WSAEWOULDBLOCK) ? 0 : -1;
+		return (WSAGetLastError() == WSAEWOULDBLOCK || WSAGetLastError() == WSAEMSGSIZE) ? 0 : -1;
 
 	return (int)sentLength;
 }
@@ -4933,6 +5839,9 @@ int enet_socket_receive(ENetSocket socket, ENetAddress* address, ENetBuffer* buf
 		case WSAEWOULDBLOCK:
 		case WSAECONNRESET:
 			return 0;
+
+		case WSAEMSGSIZE:
+			return -2;
 		}
 
 		return -1;
@@ -5098,6 +6007,10 @@ uint32_t enet_peer_get_last_rtt(const ENetPeer* peer) {
 	return peer->lastRoundTripTime;
 }
 
+uint32_t enet_peer_get_rtt_variance(const ENetPeer* peer) {
+	return peer->roundTripTimeVariance;
+}
+
 uint32_t enet_peer_get_lastsendtime(const ENetPeer* peer) {
 	return peer->lastSendTime;
 }
@@ -5114,6 +6027,14 @@ uint64_t enet_peer_get_packets_lost(const ENetPeer* peer) {
 	return peer->totalPacketsLost;
 }
 
+uint64_t enet_peer_get_unreliable_received(const ENetPeer* peer) {
+	return peer->unreliablePacketsReceived;
+}
+
+uint64_t enet_peer_get_unreliable_lost(const ENetPeer* peer) {
+	return peer->unreliablePacketsLost;
+}
+
 float enet_peer_get_packets_throttle(const ENetPeer* peer) {
 	return peer->packetThrottle / (float)ENET_PEER_PACKET_THROTTLE_SCALE * 100.0f;
 }
@@ -5126,6 +6047,29 @@ uint64_t enet_peer_get_bytes_received(const ENetPeer* peer) {
 	return peer->totalDataReceived;
 }
 
+/* Bytes queued for the peer and not acknowledged yet */
+size_t enet_peer_get_pending_data(const ENetPeer* peer) {
+	ENetListIterator currentCommand;
+	size_t pending = peer->reliableDataInTransit;
+
+	for (currentCommand = enet_list_begin(&peer->outgoingCommands); currentCommand != enet_list_end(&peer->outgoingCommands); currentCommand = enet_list_next(currentCommand))
+		pending += ((ENetOutgoingCommand*)currentCommand)->fragmentLength;
+
+	return pending;
+}
+
+uint32_t enet_peer_get_queue_delay(const ENetPeer* peer) {
+	return peer->ccQueueDelay;
+}
+
+uint32_t enet_peer_get_bottleneck_bandwidth(const ENetPeer* peer) {
+	return peer->ccBottleneckBandwidth;
+}
+
+uint32_t enet_peer_get_pacing_rate(const ENetPeer* peer) {
+	return peer->ccPacingRate;
+}
+
 void* enet_peer_get_data(const ENetPeer* peer) {
 	return (void*)peer->data;
 }
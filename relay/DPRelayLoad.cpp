@@ -0,0 +1,339 @@
+/*!
+	@author Arves100
+	@file DPRelayLoad.cpp
+	@date 19/10/2026
+	@brief Load test of the relay server: the same sessions and players on 1 to 8 workers
+*/
+#include "DPRelayServer.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DP_RELAY_LOAD_PORT 25100 // first session of the relay under test
+#define DP_RELAY_LOAD_JOIN_TIME 5000 // ms for every player to get its id
+
+/*!
+* @brief A player of a session, it joins like a game and sends game messages to everyone
+*/
+struct LoadPlayer
+{
+	ENetHost* host;
+	ENetPeer* peer;
+	DPFirewall firewall; // answers the cookies of the relay
+	bool joined;
+	ULONGLONG received;
+};
+
+struct LoadOptions
+{
+	unsigned sessions = 8;
+	unsigned players = 8; // per session, the first one is the game host
+	unsigned rate = 60; // game messages per second of every player
+	unsigned size = 200; // bytes of a game message
+	unsigned time = 5000; // ms measured
+	unsigned workers = 0; // 0 runs 1, 2, 4 and 8
+	const char* syscalls = nullptr; // DPSyscallCount library preloaded in the relay
+};
+
+struct LoadResult
+{
+	double forwarded; // game messages received by the players per second
+	double expected;
+	double cpu; // share of a core used by the relay
+};
+
+/*!
+* @brief Socket calls of the relay, written by DPSyscallCount when it exits
+*/
+struct LoadSyscalls
+{
+	unsigned long sendCalls;
+	unsigned long sendMsgs;
+	unsigned long recvCalls;
+	unsigned long recvMsgs;
+};
+
+/*!
+* @brief CPU time of a process, in clock ticks
+*/
+static ULONGLONG ProcessTicks(pid_t pid)
+{
+	char path[64], buf[1024];
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+
+	auto f = fopen(path, "r");
+
+	if (!f)
+		return 0;
+
+	auto len = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[len] = 0;
+
+	// the name of the process is in brackets and can have spaces, utime and stime are the 12th and 13th fields after it
+	auto p = strrchr(buf, ')');
+	unsigned long utime = 0, stime = 0;
+
+	if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+		return 0;
+
+	return utime + stime;
+}
+
+static std::string SyscallsPath(pid_t pid)
+{
+	return "/tmp/ffrelay-syscalls-" + std::to_string(pid);
+}
+
+static pid_t StartRelay(const char* relay, const LoadOptions& o, unsigned workers)
+{
+	auto pid = fork();
+
+	if (pid != 0)
+		return pid;
+
+	auto null = open("/dev/null", O_WRONLY);
+	dup2(null, STDOUT_FILENO);
+
+	if (o.syscalls)
+	{
+		setenv("LD_PRELOAD", o.syscalls, 1);
+		setenv("DP_SYSCALLS_OUT", SyscallsPath(getpid()).c_str(), 1);
+	}
+
+	auto port = std::to_string(DP_RELAY_LOAD_PORT), sessions = std::to_string(o.sessions), w = std::to_string(workers), players = std::to_string(o.players);
+	// all the players come from loopback, the limits of one address would measure the firewall and not the relay
+	execl(relay, relay, "-port", port.c_str(), "-sessions", sessions.c_str(), "-workers", w.c_str(), "-maxplayers", players.c_str(), "-trustloopback", (char*)nullptr);
+	_exit(1);
+}
+
+/*!
+* @brief Services every player once
+* @return Players that got their id so far
+*/
+static unsigned Service(std::vector<std::unique_ptr<LoadPlayer>>& players, uint32_t timeout)
+{
+	unsigned joined = 0;
+
+	for (auto& p : players)
+	{
+		ENetEvent evt;
+
+		while (p->host && enet_host_service(p->host, &evt, timeout) > 0)
+		{
+			if (evt.type == ENET_EVENT_TYPE_CONNECT)
+			{
+				DPPlayerInfo info = { 0 };
+				strcpy(info.name, "load");
+
+				DPMsg msg(0, 0, DPMSG_TYPE_CALL_NEWID);
+				msg.AddToSerialize(info);
+				enet_peer_send(evt.peer, ENET_CHANNEL_NORMAL, msg.Serialize());
+			}
+			else if (evt.type == ENET_EVENT_TYPE_RECEIVE)
+			{
+				if (evt.packet->dataLength >= DPMsg::GetHeaderSize())
+				{
+					DPMsg msg(evt.packet, false);
+
+					if (msg.GetType() == DPMSG_TYPE_NEWID)
+						p->joined = true;
+					else if (msg.GetType() == DPMSG_TYPE_GAME)
+						p->received++;
+				}
+
+				enet_packet_destroy(evt.packet);
+			}
+
+			timeout = 0;
+		}
+
+		joined += p->joined;
+	}
+
+	return joined;
+}
+
+static LoadResult Run(const char* relay, const LoadOptions& o, unsigned workers)
+{
+	LoadResult r = { 0, 0, 0 };
+	auto pid = StartRelay(relay, o, workers);
+
+	if (pid < 0)
+		return r;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+	std::vector<std::unique_ptr<LoadPlayer>> players;
+
+	// the first player of every session joins first, it is the game host
+	for (unsigned n = 0; n < o.players; n++)
+	{
+		for (unsigned s = 0; s < o.sessions; s++)
+		{
+			std::unique_ptr<LoadPlayer> p(new LoadPlayer());
+			p->host = enet_host_create(nullptr, 1, ENET_CHANNEL_MAX, 0, 0, ENET_HOST_BUFFER_SIZE_MAX);
+
+			if (!p->host)
+				continue;
+
+			p->firewall.Install(p->host);
+
+			ENetAddress addr;
+			memset(&addr, 0, sizeof(addr));
+			enet_address_set_ip(&addr, "127.0.0.1");
+			addr.port = (uint16_t)(DP_RELAY_LOAD_PORT + s);
+			p->peer = enet_host_connect(p->host, &addr, ENET_CHANNEL_MAX, ENET_CONNECT_JOIN);
+			players.push_back(std::move(p));
+		}
+
+		auto until = enet_time_get() + DP_RELAY_LOAD_JOIN_TIME;
+
+		while (Service(players, 1) < players.size() && (int32_t)(enet_time_get() - until) < 0)
+			;
+	}
+
+	auto joined = Service(players, 0);
+	std::vector<BYTE> data(o.size, 0xAB);
+	DWORD size = o.size;
+	ULONGLONG before = 0;
+
+	for (auto& p : players)
+		before += p->received;
+
+	auto ticks = ProcessTicks(pid);
+	auto start = std::chrono::steady_clock::now();
+	auto next = start;
+	auto period = std::chrono::microseconds(1000000 / o.rate);
+
+	while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(o.time))
+	{
+		if (std::chrono::steady_clock::now() >= next)
+		{
+			for (auto& p : players)
+			{
+				if (!p->joined)
+					continue;
+
+				DPMsg msg(0, DPID_ALLPLAYERS, DPMSG_TYPE_GAME);
+				msg.AddToSerialize(size);
+				msg.AddToSerialize(data.data(), data.size());
+				enet_peer_send(p->peer, ENET_CHANNEL_NORMAL, msg.Serialize(0));
+				enet_host_flush(p->host);
+			}
+
+			next += period;
+		}
+
+		Service(players, 0);
+	}
+
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ticks = ProcessTicks(pid) - ticks;
+	ULONGLONG after = 0;
+
+	for (auto& p : players)
+		after += p->received;
+
+	kill(pid, SIGTERM);
+	waitpid(pid, nullptr, 0);
+
+	LoadSyscalls calls = { 0, 0, 0, 0 };
+	auto path = SyscallsPath(pid);
+	auto f = o.syscalls ? fopen(path.c_str(), "r") : nullptr;
+
+	if (f)
+	{
+		if (fscanf(f, "%lu %lu %lu %lu", &calls.sendCalls, &calls.sendMsgs, &calls.recvCalls, &calls.recvMsgs) != 4)
+			memset(&calls, 0, sizeof(calls));
+
+		fclose(f);
+		remove(path.c_str());
+	}
+
+	for (auto& p : players)
+	{
+		if (p->host)
+			enet_host_destroy(p->host);
+	}
+
+	// the game host gets the messages of the others, they get its broadcasts
+	r.forwarded = (after - before) / elapsed;
+	r.expected = (double)o.sessions * o.rate * 2 * (o.players - 1);
+	r.cpu = ticks / (double)sysconf(_SC_CLK_TCK) / elapsed;
+
+	printf("%u workers: %u/%u players joined, %8.0f msgs/s forwarded of %8.0f (%5.1f%%), relay cpu %5.1f%% of a core, %5.2f us per message\n",
+		workers, joined, o.sessions * o.players, r.forwarded, r.expected, r.forwarded * 100 / r.expected, r.cpu * 100,
+		r.forwarded ? r.cpu * 1000000 / r.forwarded : 0);
+
+	if (calls.sendCalls)
+	{ // counted for the whole life of the relay, the joins add a few hundred
+		printf("           socket calls %8.0f/s: send %8.0f/s for %8.0f datagrams/s, receive %8.0f/s for %8.0f datagrams/s, %.2f calls per forwarded message\n",
+			(calls.sendCalls + calls.recvCalls) / elapsed, calls.sendCalls / elapsed, calls.sendMsgs / elapsed, calls.recvCalls / elapsed, calls.recvMsgs / elapsed,
+			after ? (double)(calls.sendCalls + calls.recvCalls) / after : 0);
+	}
+
+	return r;
+}
+
+int main(int argc, char* argv[])
+{
+	LoadOptions o;
+	const char* relay = "./ffrelay";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-relay") && i + 1 < argc)
+			relay = argv[++i];
+		else if (!strcmp(argv[i], "-sessions") && i + 1 < argc)
+			o.sessions = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-players") && i + 1 < argc)
+			o.players = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-rate") && i + 1 < argc)
+			o.rate = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-size") && i + 1 < argc)
+			o.size = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-time") && i + 1 < argc)
+			o.time = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-workers") && i + 1 < argc)
+			o.workers = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-syscalls") && i + 1 < argc)
+			o.syscalls = argv[++i];
+		else
+		{
+			printf("Usage: %s [-relay path] [-sessions number] [-players number] [-rate messages] [-size bytes] [-time ms] [-workers number] [-syscalls library]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!o.sessions || !o.players || o.players > DP_RELAY_SERVER_MAX_PLAYERS || !o.rate || o.size < sizeof(DWORD))
+		return 1;
+
+	if (enet_initialize() != 0)
+		return 1;
+
+	auto cores = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+	printf("%u sessions of %u players, %u messages/s of %u bytes each, %u cores; the load runs on the same machine and takes its cores too\n",
+		o.sessions, o.players, o.rate, o.size, cores);
+
+	if (o.workers)
+		Run(relay, o, o.workers);
+
+	for (unsigned w = 1; w <= 8 && !o.workers; w *= 2)
+	{
+		if (w > o.sessions)
+			break;
+
+		Run(relay, o, w);
+	}
+
+	enet_deinitialize();
+	return 0;
+}
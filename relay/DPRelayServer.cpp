@@ -0,0 +1,359 @@
+/*!
+	@author Arves100
+	@file DPRelayServer.cpp
+	@date 19/10/2026
+	@brief Headless server that hosts the matches in place of a player
+*/
+#include "DPRelayServer.h"
+#include <cstdio>
+#include <random>
+
+DPRelayServer::DPRelayServer() : m_pHost(nullptr), m_wPort(0), m_dwMaxPlayers(0), m_dwFlags(0), m_dwNextId(1), m_dwGameHost(0),
+	m_ullForwarded(0), m_ullForwardedBytes(0), m_ullReceivedBytes(0), m_dwJoins(0), m_dwHostChanges(0), m_dwDropped(0)
+{
+	memset(&m_gSession, 0, sizeof(m_gSession));
+	memset(m_adwUser, 0, sizeof(m_adwUser));
+}
+
+DPRelayServer::~DPRelayServer()
+{
+	if (m_pHost)
+	{
+		for (const auto& p : m_vPlayers)
+			enet_peer_disconnect_now(p.second.peer, 0);
+
+		enet_host_destroy(m_pHost);
+	}
+}
+
+bool DPRelayServer::Create(uint16_t port, DWORD maxPlayers, const char* sessionName)
+{
+	ENetAddress addr;
+	memset(&addr, 0, sizeof(addr));
+	enet_address_set_ip(&addr, "0.0.0.0");
+	addr.port = port;
+
+	m_pHost = enet_host_create(&addr, maxPlayers + DP_RELAY_SERVER_ENUM_PEERS, ENET_CHANNEL_MAX, 0, 0, ENET_HOST_BUFFER_SIZE_MAX);
+
+	if (!m_pHost)
+		return false;
+
+	enet_host_set_checksum_callback(m_pHost, enet_crc32c); // only the players that ask for it pay for it
+	m_firewall.Install(m_pHost);
+
+	std::random_device rd;
+	uint32_t g[4] = { rd(), rd(), rd(), rd() };
+	memcpy(&m_gSession, g, sizeof(m_gSession));
+
+	m_dwMaxPlayers = maxPlayers;
+	m_szGameName = sessionName;
+	m_wPort = port;
+
+	printf("[RELAY] Listening on port %u, %u players, session \"%s\"\n", port, maxPlayers, sessionName);
+	return true;
+}
+
+void DPRelayServer::Service(uint32_t timeout)
+{
+	ENetEvent evt;
+
+	if (enet_host_service(m_pHost, &evt, timeout) <= 0)
+		return;
+
+	do
+	{
+		switch (evt.type)
+		{
+		case ENET_EVENT_TYPE_CONNECT:
+			OnConnect(evt.peer, evt.data);
+			break;
+
+		case ENET_EVENT_TYPE_DISCONNECT:
+		case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+			OnDisconnect(evt.peer);
+			break;
+
+		case ENET_EVENT_TYPE_RECEIVE:
+			OnReceive(evt.peer, evt.channelID, evt.packet);
+			break;
+
+		default:
+			break;
+		}
+	} while (enet_host_check_events(m_pHost, &evt) > 0);
+
+	enet_host_flush(m_pHost); // the worker might wait on the other sessions before servicing this one again
+}
+
+void DPRelayServer::OnConnect(ENetPeer* peer, uint32_t data)
+{
+	peer->data = nullptr;
+
+	if (data == ENET_CONNECT_ENUM)
+	{
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::CreateRoomInfo(m_gSession, m_dwMaxPlayers, (DWORD)m_vPlayers.size(), m_szGameName.c_str(), m_adwUser, m_dwFlags));
+		return;
+	}
+
+	if (data != ENET_CONNECT_JOIN && data != ENET_CONNECT_RESUME && data != ENET_CONNECT_REJOIN)
+		enet_peer_disconnect(peer, 0); // the spectator relays are not used, the server feeds everyone
+}
+
+void DPRelayServer::OnDisconnect(ENetPeer* peer)
+{
+	auto p = GetPlayer(peer);
+	peer->data = nullptr;
+
+	if (!p)
+		return;
+
+	auto id = p->id;
+	auto remoteSize = (DWORD)p->remoteData.size();
+	auto flags = p->flags;
+	m_vPlayers.erase(id);
+
+	printf("[RELAY] Player %u left, %u players\n", id, (DWORD)m_vPlayers.size());
+
+	for (const auto& o : m_vPlayers)
+		enet_peer_send(o.second.peer, ENET_CHANNEL_CHAT, DPMsg::DestroyPlayer(id, 0, remoteSize, flags));
+
+	if (id == m_dwGameHost)
+		SetGameHost(m_vPlayers.empty() ? 0 : m_vPlayers.begin()->first);
+}
+
+void DPRelayServer::OnReceive(ENetPeer* peer, uint8_t channel, ENetPacket* pk)
+{
+	m_ullReceivedBytes += pk->dataLength;
+
+	if (pk->dataLength < DPMsg::GetHeaderSize())
+	{
+		enet_packet_destroy(pk);
+		return;
+	}
+
+	DPMsg msg(pk, false); // the packet itself is forwarded
+	auto p = GetPlayer(peer);
+
+	switch (msg.GetType())
+	{
+	case DPMSG_TYPE_CALL_NEWID:
+		OnCallNewId(peer, msg);
+		break;
+
+	case DPMSG_TYPE_GAME_INFO:
+		OnGameInfo(peer, msg);
+		break;
+
+	case DPMSG_TYPE_MTU_PROBE:
+	{
+		auto mtu = (DWORD*)msg.Read2(sizeof(DWORD));
+
+		if (mtu)
+			enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::MtuProbeAck(*mtu));
+
+		break;
+	}
+
+	case DPMSG_TYPE_RESUME:
+	case DPMSG_TYPE_REJOIN:
+	{ // no resume tokens are given, a player that lost the connection joins again
+		DWORD none[DP_RESUME_LOG_CHANNELS] = { 0 };
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::ResumeAck(DP_RESUME_REFUSED, none));
+		break;
+	}
+
+	case DPMSG_TYPE_FEC_DATA:
+	{ // unwrapped, the parity is not needed as the message is not rebuilt here
+		auto size = msg.GetRawSize() - sizeof(DPFecInfo);
+
+		if (msg.Read2(sizeof(DPFecInfo)) && size >= DPMsg::GetHeaderSize())
+			OnReceive(peer, channel, enet_packet_create(msg.Read2(size), size, pk->flags & ENET_PACKET_FLAG_RELIABLE));
+
+		break;
+	}
+
+	case DPMSG_TYPE_COMPRESSED:
+	case DPMSG_TYPE_DELTA:
+		m_dwDropped++; // never negotiated with us
+		break;
+
+	case DPMSG_TYPE_SYSTEM:
+	case DPMSG_TYPE_CHAT:
+	case DPMSG_TYPE_GAME:
+	case DPMSG_TYPE_REMOTEINFO:
+		if (!p)
+			break;
+
+		if (msg.GetType() == DPMSG_TYPE_REMOTEINFO)
+		{
+			DWORD len = 0;
+			auto l = (DWORD*)msg.Read2(sizeof(DWORD));
+			auto data = l ? msg.Read2(*l) : nullptr;
+
+			if (data)
+				len = *l;
+
+			p->remoteData.assign(data, data + len);
+		}
+
+		Route(*p, channel, pk, msg);
+		break;
+
+	default:
+		break; // the optional messages (dictionary, fec parity, acks, relay tree, shared memory) are not used by the server
+	}
+
+	if (pk->referenceCount == 0)
+		enet_packet_destroy(pk);
+}
+
+void DPRelayServer::OnCallNewId(ENetPeer* peer, DPMsg& msg)
+{
+	auto info = (DPPlayerInfo*)msg.Read2(sizeof(DPPlayerInfo));
+
+	if (!info || peer->data)
+		return;
+
+	if (m_vPlayers.size() >= m_dwMaxPlayers)
+	{
+		printf("[RELAY] Session full\n");
+		enet_peer_disconnect(peer, 0);
+		return;
+	}
+
+	Player p;
+	p.id = m_dwNextId++;
+	p.peer = peer;
+	p.shortName.assign(info->name, strnlen(info->name, sizeof(info->name)));
+	p.longName.assign(info->longName, strnlen(info->longName, sizeof(info->longName)));
+	p.flags = info->dwFlags & DPPLAYER_SPECTATOR;
+
+	auto caps = (DWORD*)msg.Read2(sizeof(DWORD)); // not sent by the older builds
+	p.msgFlags = caps && (*caps & DP_CAPS_MSG_FLAGS);
+	peer->data = (void*)(uintptr_t)p.id;
+
+	enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::NewId(p.id, 0)); // no token, the sessions are not resumed
+
+	for (const auto& o : m_vPlayers)
+		enet_peer_send(peer, ENET_CHANNEL_NORMAL, DPMsg::NewPlayer(o.first, o.second.shortName.c_str(), o.second.longName.c_str(), nullptr, 0, (DWORD)m_vPlayers.size()));
+
+	auto host = m_vPlayers.find(m_dwGameHost);
+
+	if (host != m_vPlayers.end())
+		enet_peer_send(host->second.peer, ENET_CHANNEL_NORMAL, DPMsg::NewPlayer(p.id, p.shortName.c_str(), p.longName.c_str(), nullptr, 0, (DWORD)m_vPlayers.size()));
+
+	m_vPlayers.insert({ p.id, p });
+	m_dwJoins++;
+
+	printf("[RELAY] Player %u \"%s\" joined%s, %u players\n", p.id, p.shortName.c_str(), p.flags & DPPLAYER_SPECTATOR ? " as spectator" : "", (DWORD)m_vPlayers.size());
+
+	if (host == m_vPlayers.end())
+		SetGameHost(p.id);
+}
+
+void DPRelayServer::OnGameInfo(ENetPeer* peer, DPMsg& msg)
+{
+	auto info = (DPGameInfo*)msg.Read2(sizeof(DPGameInfo));
+
+	if (!info)
+		return;
+
+	// only the game that creates the session, or its game host, sets it up
+	if (m_dwGameHost ? (DPID)(uintptr_t)peer->data != m_dwGameHost : !m_vPlayers.empty())
+		return;
+
+	m_gSession = info->session;
+	m_szGameName.assign(info->sessionName, strnlen(info->sessionName, sizeof(info->sessionName)));
+	memcpy(m_adwUser, info->user, sizeof(m_adwUser));
+	m_dwFlags = info->flags;
+
+	if (info->maxPlayers && info->maxPlayers <= m_pHost->peerCount - DP_RELAY_SERVER_ENUM_PEERS)
+		m_dwMaxPlayers = info->maxPlayers;
+
+	printf("[RELAY] Session \"%s\", %u players\n", m_szGameName.c_str(), m_dwMaxPlayers);
+}
+
+void DPRelayServer::Route(const Player& from, uint8_t channel, ENetPacket* pk, DPMsg& msg)
+{
+	if (!from.msgFlags)
+		DPMsg::SetLegacyFlags(pk); // the players get our caps, they trust the flags of what we forward
+
+	auto send = [this, channel, pk](const Player& to) {
+		if (enet_peer_send(to.peer, channel, pk) == 0)
+		{
+			m_ullForwarded++;
+			m_ullForwardedBytes += pk->dataLength;
+		}
+	};
+
+	if (msg.GetTo() != DPID_ALLPLAYERS)
+	{
+		auto to = m_vPlayers.find(msg.GetTo());
+
+		if (to != m_vPlayers.end() && to->first != from.id)
+			send(to->second);
+		else
+			m_dwDropped++;
+
+		return;
+	}
+
+	if (from.id != m_dwGameHost)
+	{ // the game host used to get them all
+		auto host = m_vPlayers.find(m_dwGameHost);
+
+		if (host != m_vPlayers.end())
+			send(host->second);
+
+		return;
+	}
+
+	for (const auto& p : m_vPlayers)
+	{ // the upload that the game host saves
+		if (p.first != from.id)
+			send(p.second);
+	}
+}
+
+void DPRelayServer::SetGameHost(DPID id)
+{
+	auto old = m_dwGameHost;
+	m_dwGameHost = id;
+
+	auto host = m_vPlayers.find(id);
+
+	if (host == m_vPlayers.end())
+		return;
+
+	m_dwHostChanges++;
+	printf("[RELAY] Player %u is the game host\n", id);
+
+	// the players that joined later were announced only to the old game host
+	for (const auto& p : m_vPlayers)
+	{
+		if (old && p.first > id)
+			enet_peer_send(host->second.peer, ENET_CHANNEL_NORMAL, DPMsg::NewPlayer(p.first, p.second.shortName.c_str(), p.second.longName.c_str(), nullptr, 0, (DWORD)m_vPlayers.size()));
+	}
+
+	enet_peer_send(host->second.peer, ENET_CHANNEL_NORMAL, DPMsg::HostChanged());
+}
+
+DPRelayServer::Player* DPRelayServer::GetPlayer(ENetPeer* peer)
+{
+	auto it = m_vPlayers.find((DPID)(uintptr_t)peer->data);
+	return it != m_vPlayers.end() && it->second.peer == peer ? &it->second : nullptr;
+}
+
+void DPRelayServer::Dump() const
+{
+	printf("[RELAY] Port %u: %u players (game host %u), %u joins %u host changes, %llu msgs forwarded (%llu bytes) for %llu bytes received, %u dropped\n",
+		m_wPort, (DWORD)m_vPlayers.size(), m_dwGameHost, m_dwJoins, m_dwHostChanges, (unsigned long long)m_ullForwarded, (unsigned long long)m_ullForwardedBytes,
+		(unsigned long long)m_ullReceivedBytes, m_dwDropped);
+
+	printf("[RELAY] Port %u firewall: %u passed, dropped", m_wPort, m_firewall.GetPassed());
+
+	for (int i = 0; i < DP_FIREWALL_DROP_MAX; i++)
+		printf(" %u %s", m_firewall.GetDrops((DPFirewallDrop)i), DPFirewall::GetDropName((DPFirewallDrop)i));
+
+	printf("\n");
+}
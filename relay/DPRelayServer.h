@@ -0,0 +1,96 @@
+/*!
+	@author Arves100
+	@file DPRelayServer.h
+	@date 19/10/2026
+	@brief Headless server that hosts the matches in place of a player
+*/
+#pragma once
+
+#include "DPMsg.h"
+#include "DPFirewall.h"
+#include <string>
+#include <map>
+
+#define DP_RELAY_SERVER_MAX_PLAYERS 16
+#define DP_RELAY_SERVER_ENUM_PEERS 8 // peers kept free for the session enumerations
+
+/*!
+	@class DPRelayServer
+	Speaks the NetLib protocol like a game that hosts a match: it gives the ids to the players, keeps
+	the roster and forwards the messages, so the uplink of a player does not limit the session.
+	The first player that joins is the game host, the broadcasts of the game host are sent by the
+	server to every player and the messages of the others to DPID_ALLPLAYERS go to the game host,
+	like they did when the game host was the server. When the game host leaves the oldest player
+	takes its place
+*/
+class DPRelayServer
+{
+public:
+	DPRelayServer();
+	~DPRelayServer();
+
+	/*!
+	* @brief Starts listening
+	* @param port UDP port
+	* @param maxPlayers Players that can join
+	* @param sessionName Name of the session until the game host sends its own
+	* @return false if the socket cannot be created
+	*/
+	bool Create(uint16_t port, DWORD maxPlayers, const char* sessionName);
+
+	void Service(uint32_t timeout);
+	void Dump() const;
+
+	/*!
+	* @brief See DPFirewall::SetTrustLoopback
+	*/
+	void SetTrustLoopback(bool trust) { m_firewall.SetTrustLoopback(trust); }
+
+	/*!
+	* @brief See DPFirewall::SetCookies
+	*/
+	void SetCookies(bool cookies) { m_firewall.SetCookies(cookies); }
+
+	ENetSocket GetSocket() const { return m_pHost->socket; }
+
+private:
+	struct Player
+	{
+		DPID id;
+		ENetPeer* peer;
+		std::string shortName;
+		std::string longName;
+		DWORD flags;
+		bool msgFlags; // its build fills the flags of the message header
+		std::vector<BYTE> remoteData;
+	};
+
+	void OnConnect(ENetPeer* peer, uint32_t data);
+	void OnDisconnect(ENetPeer* peer);
+	void OnReceive(ENetPeer* peer, uint8_t channel, ENetPacket* pk);
+	void OnCallNewId(ENetPeer* peer, DPMsg& msg);
+	void OnGameInfo(ENetPeer* peer, DPMsg& msg);
+	void Route(const Player& from, uint8_t channel, ENetPacket* pk, DPMsg& msg);
+	void SetGameHost(DPID id);
+	Player* GetPlayer(ENetPeer* peer);
+
+	ENetHost* m_pHost;
+	uint16_t m_wPort;
+	GUID m_gSession;
+	DWORD m_dwMaxPlayers;
+	std::string m_szGameName;
+	DWORD m_adwUser[4];
+	DWORD m_dwFlags;
+	DPID m_dwNextId;
+	DPID m_dwGameHost;
+	std::map<DPID, Player> m_vPlayers; // the ids grow, so this is the join order
+	DPFirewall m_firewall;
+
+	// Statistics
+	ULONGLONG m_ullForwarded;
+	ULONGLONG m_ullForwardedBytes;
+	ULONGLONG m_ullReceivedBytes;
+	DWORD m_dwJoins;
+	DWORD m_dwHostChanges;
+	DWORD m_dwDropped;
+};
@@ -0,0 +1,105 @@
+/*!
+	@author Arves100
+	@file DPRelayWorker.cpp
+	@date 19/10/2026
+	@brief Thread that services a part of the sessions of the relay server
+*/
+#include "DPRelayWorker.h"
+#include <cstdio>
+#include <pthread.h>
+#include <poll.h>
+
+DPRelayWorker::DPRelayWorker() : m_nCore(0), m_pRunning(nullptr)
+{
+}
+
+DPRelayWorker::~DPRelayWorker()
+{
+	Join();
+}
+
+bool DPRelayWorker::Add(uint16_t port, DWORD maxPlayers, const char* sessionName, bool trustLoopback, bool cookies)
+{
+	std::unique_ptr<DPRelayServer> server(new DPRelayServer());
+
+	if (!server->Create(port, maxPlayers, sessionName))
+		return false;
+
+	server->SetTrustLoopback(trustLoopback);
+	server->SetCookies(cookies);
+
+	m_vSessions.push_back(std::move(server));
+	return true;
+}
+
+void DPRelayWorker::Start(unsigned core, const std::atomic<bool>* running)
+{
+	m_nCore = core;
+	m_pRunning = running;
+	m_thread = std::thread(&DPRelayWorker::Run, this);
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+
+	if (pthread_setaffinity_np(m_thread.native_handle(), sizeof(set), &set) != 0)
+		printf("[RELAY] Cannot pin the worker to core %u\n", core);
+}
+
+void DPRelayWorker::Join()
+{
+	if (!m_thread.joinable())
+		return;
+
+	m_thread.join();
+	Dump();
+}
+
+void DPRelayWorker::Run()
+{
+	std::vector<pollfd> fds(m_vSessions.size());
+
+	for (size_t i = 0; i < m_vSessions.size(); i++)
+	{
+		fds[i].fd = m_vSessions[i]->GetSocket();
+		fds[i].events = POLLIN;
+	}
+
+	auto nextDump = enet_time_get() + DP_RELAY_SERVER_DUMP_TIME;
+	auto nextTimers = enet_time_get();
+
+	while (m_pRunning->load(std::memory_order_relaxed))
+	{
+		if (m_vSessions.size() == 1)
+			m_vSessions[0]->Service(100); // enet waits on the socket by itself
+		else
+		{
+			poll(fds.data(), fds.size(), DP_RELAY_WORKER_WAIT);
+
+			// the idle ones only now and then, for the retransmissions and the timeouts: a service
+			// that finds nothing still costs a receive call
+			auto timers = (int32_t)(enet_time_get() - nextTimers) >= 0;
+
+			if (timers)
+				nextTimers = enet_time_get() + DP_RELAY_WORKER_WAIT;
+
+			for (size_t i = 0; i < m_vSessions.size(); i++)
+			{
+				if (timers || (fds[i].revents & POLLIN))
+					m_vSessions[i]->Service(0);
+			}
+		}
+
+		if ((int32_t)(enet_time_get() - nextDump) >= 0)
+		{ // from this thread, the counters are not shared
+			Dump();
+			nextDump += DP_RELAY_SERVER_DUMP_TIME;
+		}
+	}
+}
+
+void DPRelayWorker::Dump() const
+{
+	for (const auto& s : m_vSessions)
+		s->Dump();
+}
@@ -0,0 +1,60 @@
+/*!
+	@author Arves100
+	@file DPRelayWorker.h
+	@date 19/10/2026
+	@brief Thread that services a part of the sessions of the relay server
+*/
+#pragma once
+
+#include "DPRelayServer.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#define DP_RELAY_WORKER_WAIT 10 // ms a worker with many sessions waits for their sockets
+#define DP_RELAY_SERVER_DUMP_TIME 60000 // ms between two statistics dumps
+
+/*!
+	@class DPRelayWorker
+	Owns some sessions, each one with its own host and port, and services them from one thread
+	pinned to a core. A session never moves from its worker and the workers share nothing, so
+	forwarding a message takes no lock and the sessions carried by a box grow with its cores
+*/
+class DPRelayWorker
+{
+public:
+	DPRelayWorker();
+	~DPRelayWorker();
+
+	/*!
+	* @brief Creates a session of this worker
+	* @param port UDP port of the session
+	* @param maxPlayers Players that can join
+	* @param sessionName Name of the session until the game host sends its own
+	* @param trustLoopback The firewall does not limit the players of this machine
+	* @param cookies The firewall challenges the connects with a cookie
+	* @return false if the socket cannot be created
+	*/
+	bool Add(uint16_t port, DWORD maxPlayers, const char* sessionName, bool trustLoopback, bool cookies);
+
+	/*!
+	* @brief Starts the thread
+	* @param core Core the thread is pinned to
+	* @param running Flag that stops the thread when cleared
+	*/
+	void Start(unsigned core, const std::atomic<bool>* running);
+
+	/*!
+	* @brief Waits for the thread to stop and dumps the final statistics
+	*/
+	void Join();
+
+private:
+	void Run();
+	void Dump() const;
+
+	std::vector<std::unique_ptr<DPRelayServer>> m_vSessions;
+	std::thread m_thread;
+	unsigned m_nCore;
+	const std::atomic<bool>* m_pRunning;
+};
@@ -0,0 +1,307 @@
+/*!
+	@author Arves100
+	@file DPRendezvousServer.cpp
+	@date 19/10/2026
+	@brief Rendezvous service for the game hosts behind a NAT
+*/
+#include "DPRendezvousServer.h"
+#include <cstdio>
+#include <poll.h>
+
+DPRendezvousServer::DPRendezvousServer() : m_socket(ENET_SOCKET_NULL), m_wPort(0), m_dwNextExpire(0),
+	m_dwRegistrations(0), m_dwLookups(0), m_dwUnknown(0), m_dwRelays(0), m_ullRelayed(0)
+{
+}
+
+DPRendezvousServer::~DPRendezvousServer()
+{
+	for (const auto& r : m_vRelays)
+		enet_socket_destroy(r->socket);
+
+	if (m_socket != ENET_SOCKET_NULL)
+		enet_socket_destroy(m_socket);
+}
+
+bool DPRendezvousServer::Create(uint16_t port)
+{
+	m_socket = CreateSocket(port);
+
+	if (m_socket == ENET_SOCKET_NULL)
+		return false;
+
+	m_wPort = port;
+	printf("[RELAY] Rendezvous service on port %u\n", port);
+	return true;
+}
+
+ENetSocket DPRendezvousServer::CreateSocket(uint16_t port)
+{
+	ENetAddress addr;
+	memset(&addr, 0, sizeof(addr));
+	enet_address_set_ip(&addr, "0.0.0.0");
+	addr.port = port;
+
+	auto s = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+
+	if (s == ENET_SOCKET_NULL)
+		return s;
+
+	enet_socket_set_option(s, ENET_SOCKOPT_IPV6_V6ONLY, 0);
+
+	if (enet_socket_bind(s, &addr) < 0)
+	{
+		enet_socket_destroy(s);
+		return ENET_SOCKET_NULL;
+	}
+
+	enet_socket_set_option(s, ENET_SOCKOPT_NONBLOCK, 1);
+	return s;
+}
+
+void DPRendezvousServer::Service(uint32_t timeout)
+{
+	std::vector<pollfd> fds(m_vRelays.size() + 1);
+	fds[0].fd = m_socket;
+	fds[0].events = POLLIN;
+
+	for (size_t i = 0; i < m_vRelays.size(); i++)
+	{
+		fds[i + 1].fd = m_vRelays[i]->socket;
+		fds[i + 1].events = POLLIN;
+	}
+
+	if (poll(fds.data(), fds.size(), (int)timeout) > 0)
+	{
+		if (fds[0].revents & POLLIN)
+		{
+			DPRendezvousMsg msg;
+			ENetAddress from;
+			ENetBuffer buf;
+			buf.data = &msg;
+			buf.dataLength = sizeof(msg);
+
+			int len;
+
+			while ((len = enet_socket_receive(m_socket, &from, &buf, 1)) > 0)
+			{
+				if (len == sizeof(msg) && msg.peerID == 0xFFFF && msg.magic == ENET_HOST_TO_NET_32(DP_RENDEZVOUS_MAGIC))
+					OnMessage(from, msg);
+			}
+		}
+
+		for (size_t i = 0; i < m_vRelays.size(); i++)
+		{ // the vector does not change while we forward
+			if (fds[i + 1].revents & POLLIN)
+				OnRelay(*m_vRelays[i]);
+		}
+	}
+
+	auto now = enet_time_get();
+
+	if ((int32_t)(now - m_dwNextExpire) >= 0)
+	{
+		Expire(now);
+		m_dwNextExpire = now + 1000;
+	}
+}
+
+void DPRendezvousServer::OnMessage(const ENetAddress& from, const DPRendezvousMsg& msg)
+{
+	std::string code(msg.code, strnlen(msg.code, DP_SESSION_CODE_SIZE));
+
+	if (code.empty())
+		return;
+
+	auto now = enet_time_get();
+	auto it = m_vCodes.find(code);
+
+	switch (ENET_NET_TO_HOST_16(msg.type))
+	{
+	case DP_RENDEZVOUS_REGISTER:
+		if (it != m_vCodes.end())
+		{ // the code stays with its game host until it expires, the port can change when its NAT maps again
+			if (!IsSameHost(it->second.address, from))
+				return;
+
+			it->second.address = from;
+			it->second.lastSeen = now;
+			return;
+		}
+
+		if (m_vCodes.size() >= DP_RENDEZVOUS_SERVER_CODES)
+			return;
+
+		m_vCodes[code] = { from, now };
+		m_dwRegistrations++;
+		break;
+
+	case DP_RENDEZVOUS_LOOKUP:
+		m_dwLookups++;
+
+		if (it == m_vCodes.end())
+		{
+			m_dwUnknown++;
+			Send(from, DP_RENDEZVOUS_UNKNOWN, code, nullptr, 0);
+			return;
+		}
+
+		// both punch at the same time
+		Send(from, DP_RENDEZVOUS_PEER, code, &it->second.address, it->second.address.port);
+		Send(it->second.address, DP_RENDEZVOUS_PEER, code, &from, from.port);
+		break;
+
+	case DP_RENDEZVOUS_RELAY:
+	{
+		if (it == m_vCodes.end())
+		{
+			Send(from, DP_RENDEZVOUS_UNKNOWN, code, nullptr, 0);
+			return;
+		}
+
+		auto r = GetRelay(from, code);
+
+		if (!r)
+			return;
+
+		// the address of the relay is ours, the game host punches it like it would punch the player
+		Send(from, DP_RENDEZVOUS_PEER, code, nullptr, r->port);
+		Send(it->second.address, DP_RENDEZVOUS_PEER, code, nullptr, r->port);
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+DPRendezvousServer::Relay* DPRendezvousServer::GetRelay(const ENetAddress& player, const std::string& code)
+{
+	for (const auto& r : m_vRelays)
+	{
+		if (r->code == code && IsSame(r->requester, player))
+			return r.get(); // the answer was lost, the player asks again
+	}
+
+	if (m_vRelays.size() >= DP_RENDEZVOUS_SERVER_RELAYS)
+		return nullptr;
+
+	auto s = CreateSocket(0);
+
+	if (s == ENET_SOCKET_NULL)
+		return nullptr;
+
+	ENetAddress local;
+
+	if (enet_socket_get_address(s, &local) < 0)
+	{
+		enet_socket_destroy(s);
+		return nullptr;
+	}
+
+	std::unique_ptr<Relay> r(new Relay());
+	r->socket = s;
+	r->port = local.port;
+	r->code = code;
+	r->requester = player;
+	memset(r->ends, 0, sizeof(r->ends));
+	r->known[0] = r->known[1] = false;
+	r->lastSeen = enet_time_get();
+
+	m_dwRelays++;
+	m_vRelays.push_back(std::move(r));
+	return m_vRelays.back().get();
+}
+
+void DPRendezvousServer::OnRelay(Relay& relay)
+{
+	uint8_t data[ENET_PROTOCOL_MAXIMUM_MTU];
+	ENetAddress from;
+	ENetBuffer buf;
+	buf.data = data;
+	buf.dataLength = sizeof(data);
+
+	int len;
+
+	while ((len = enet_socket_receive(relay.socket, &from, &buf, 1)) > 0)
+	{
+		auto msg = (DPRendezvousMsg*)data;
+
+		if (len == sizeof(DPRendezvousMsg) && msg->peerID == 0xFFFF && msg->magic == ENET_HOST_TO_NET_32(DP_RENDEZVOUS_MAGIC) &&
+			msg->type == ENET_HOST_TO_NET_16(DP_RENDEZVOUS_PUNCH) && !strncmp(msg->code, relay.code.c_str(), DP_SESSION_CODE_SIZE))
+		{ // the punches tell us the two ends, they go through like the rest
+			auto end = (ENET_NET_TO_HOST_16(msg->flags) & DP_RENDEZVOUS_FLAG_HOST) ? 1 : 0;
+			relay.ends[end] = from;
+			relay.known[end] = true;
+		}
+
+		int end;
+
+		if (relay.known[0] && IsSame(from, relay.ends[0]))
+			end = 1;
+		else if (relay.known[1] && IsSame(from, relay.ends[1]))
+			end = 0;
+		else
+			continue; // only the two ends use a relay
+
+		if (!relay.known[end])
+			continue; // the other one did not punch the relay yet
+
+		const ENetAddress* to = &relay.ends[end];
+
+		ENetBuffer out;
+		out.data = data;
+		out.dataLength = (size_t)len;
+		enet_socket_send(relay.socket, to, &out, 1);
+
+		relay.lastSeen = enet_time_get();
+		m_ullRelayed++;
+	}
+}
+
+void DPRendezvousServer::Expire(uint32_t now)
+{
+	for (auto it = m_vCodes.begin(); it != m_vCodes.end();)
+	{
+		if ((int32_t)(now - it->second.lastSeen) >= DP_RENDEZVOUS_SERVER_EXPIRE)
+			it = m_vCodes.erase(it);
+		else
+			++it;
+	}
+
+	for (auto it = m_vRelays.begin(); it != m_vRelays.end();)
+	{
+		if ((int32_t)(now - (*it)->lastSeen) >= DP_RENDEZVOUS_SERVER_RELAY_IDLE)
+		{
+			enet_socket_destroy((*it)->socket);
+			it = m_vRelays.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void DPRendezvousServer::Send(const ENetAddress& to, WORD type, const std::string& code, const ENetAddress* peer, uint16_t port)
+{
+	DPRendezvousMsg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.peerID = 0xFFFF;
+	msg.type = ENET_HOST_TO_NET_16(type);
+	msg.magic = ENET_HOST_TO_NET_32(DP_RENDEZVOUS_MAGIC);
+	memcpy(msg.code, code.data(), code.size());
+
+	if (peer)
+		memcpy(msg.address, &peer->ipv6, sizeof(msg.address));
+
+	msg.port = ENET_HOST_TO_NET_16(port);
+
+	ENetBuffer buf;
+	buf.data = &msg;
+	buf.dataLength = sizeof(msg);
+	enet_socket_send(m_socket, &to, &buf, 1);
+}
+
+void DPRendezvousServer::Dump() const
+{
+	printf("[RELAY] Rendezvous port %u: %u sessions, %u registrations, %u lookups (%u unknown), %u relays (%u open), %llu datagrams relayed\n",
+		m_wPort, (DWORD)m_vCodes.size(), m_dwRegistrations, m_dwLookups, m_dwUnknown, m_dwRelays, (DWORD)m_vRelays.size(), (unsigned long long)m_ullRelayed);
+}
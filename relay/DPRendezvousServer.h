@@ -0,0 +1,82 @@
+/*!
+	@author Arves100
+	@file DPRendezvousServer.h
+	@date 19/10/2026
+	@brief Rendezvous service for the game hosts behind a NAT
+*/
+#pragma once
+
+#include "DPProtocol.h"
+#include <string>
+#include <map>
+#include <memory>
+
+#define DP_RENDEZVOUS_SERVER_CODES 4096 // registered sessions
+#define DP_RENDEZVOUS_SERVER_EXPIRE 45000 // ms a registration lives without being renewed
+#define DP_RENDEZVOUS_SERVER_RELAYS 64 // connections forwarded at the same time
+#define DP_RENDEZVOUS_SERVER_RELAY_IDLE 60000 // ms a forwarded connection lives without datagrams
+
+/*!
+	@class DPRendezvousServer
+	Keeps the public endpoint every game host registers with its session code and tells it to the
+	players that look the code up, and the endpoint of the player to the game host, so both can punch
+	their NATs at the same time. When the punches do not meet the player asks for a relay: a socket of
+	the service that forwards between the two, the game host sees the relay as the player
+*/
+class DPRendezvousServer
+{
+public:
+	DPRendezvousServer();
+	~DPRendezvousServer();
+
+	/*!
+	* @brief Starts listening
+	* @param port UDP port of the service
+	* @return false if the socket cannot be created
+	*/
+	bool Create(uint16_t port);
+
+	void Service(uint32_t timeout);
+	void Dump() const;
+
+private:
+	struct Registration
+	{
+		ENetAddress address;
+		uint32_t lastSeen;
+	};
+
+	struct Relay
+	{
+		ENetSocket socket;
+		uint16_t port;
+		std::string code;
+		ENetAddress requester; // endpoint of the player toward the service
+		ENetAddress ends[2]; // player and game host, learnt from their punches, a NAT can map the relay to another port
+		bool known[2];
+		uint32_t lastSeen;
+	};
+
+	void OnMessage(const ENetAddress& from, const DPRendezvousMsg& msg);
+	void OnRelay(Relay& relay);
+	Relay* GetRelay(const ENetAddress& player, const std::string& code);
+	void Expire(uint32_t now);
+	void Send(const ENetAddress& to, WORD type, const std::string& code, const ENetAddress* peer, uint16_t port);
+
+	static ENetSocket CreateSocket(uint16_t port);
+	static bool IsSameHost(const ENetAddress& a, const ENetAddress& b) { return memcmp(&a.ipv6, &b.ipv6, sizeof(in6_addr)) == 0; }
+	static bool IsSame(const ENetAddress& a, const ENetAddress& b) { return IsSameHost(a, b) && a.port == b.port; }
+
+	ENetSocket m_socket;
+	uint16_t m_wPort;
+	std::map<std::string, Registration> m_vCodes;
+	std::vector<std::unique_ptr<Relay>> m_vRelays;
+	uint32_t m_dwNextExpire;
+
+	// Statistics
+	DWORD m_dwRegistrations;
+	DWORD m_dwLookups;
+	DWORD m_dwUnknown;
+	DWORD m_dwRelays;
+	ULONGLONG m_ullRelayed;
+};
@@ -0,0 +1,77 @@
+/*!
+	@author Arves100
+	@file DPSyscallCount.c
+	@date 19/10/2026
+	@brief Preloaded in the relay by the load test, it counts the socket calls and writes them to DP_SYSCALLS_OUT at exit
+*/
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+static atomic_ulong s_sendCalls, s_sendMsgs, s_recvCalls, s_recvMsgs;
+
+#define DP_NEXT(name) static __typeof__(name)* next; if (!next) next = (__typeof__(name)*)dlsym(RTLD_NEXT, #name)
+
+ssize_t sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+	DP_NEXT(sendmsg);
+	ssize_t r = next(fd, msg, flags);
+	atomic_fetch_add(&s_sendCalls, 1);
+
+	if (r >= 0)
+		atomic_fetch_add(&s_sendMsgs, 1);
+
+	return r;
+}
+
+int sendmmsg(int fd, struct mmsghdr* msgs, unsigned int count, int flags)
+{
+	DP_NEXT(sendmmsg);
+	int r = next(fd, msgs, count, flags);
+	atomic_fetch_add(&s_sendCalls, 1);
+
+	if (r > 0)
+		atomic_fetch_add(&s_sendMsgs, (unsigned long)r);
+
+	return r;
+}
+
+ssize_t recvmsg(int fd, struct msghdr* msg, int flags)
+{
+	DP_NEXT(recvmsg);
+	ssize_t r = next(fd, msg, flags);
+	atomic_fetch_add(&s_recvCalls, 1);
+
+	if (r >= 0)
+		atomic_fetch_add(&s_recvMsgs, 1);
+
+	return r;
+}
+
+int recvmmsg(int fd, struct mmsghdr* msgs, unsigned int count, int flags, struct timespec* timeout)
+{
+	DP_NEXT(recvmmsg);
+	int r = next(fd, msgs, count, flags, timeout);
+	atomic_fetch_add(&s_recvCalls, 1);
+
+	if (r > 0)
+		atomic_fetch_add(&s_recvMsgs, (unsigned long)r);
+
+	return r;
+}
+
+__attribute__((destructor)) static void DPSyscallCountWrite(void)
+{
+	const char* path = getenv("DP_SYSCALLS_OUT");
+	FILE* f = path ? fopen(path, "w") : NULL;
+
+	if (!f)
+		return;
+
+	// a sendmsg with UDP_SEGMENT counts as one datagram, the kernel splits it
+	fprintf(f, "%lu %lu %lu %lu\n", atomic_load(&s_sendCalls), atomic_load(&s_sendMsgs), atomic_load(&s_recvCalls), atomic_load(&s_recvMsgs));
+	fclose(f);
+}
@@ -0,0 +1,146 @@
+/*!
+	@author Arves100
+	@file main.cpp
+	@date 19/10/2026
+	@brief Entrypoint of the relay server
+*/
+#include "DPRelayWorker.h"
+#include "DPRendezvousServer.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <unistd.h>
+
+static std::atomic<bool> s_bRunning(true);
+
+static void OnSignal(int)
+{
+	s_bRunning = false;
+}
+
+int main(int argc, char* argv[])
+{
+	uint16_t port = (uint16_t)FURFIGHTERS_PORT;
+	DWORD maxPlayers = 8;
+	const char* gameName = "Fur Fighters";
+	unsigned sessions = 1;
+	unsigned workers = 0;
+	uint16_t rendezvousPort = 0;
+	bool trustLoopback = false;
+	bool cookies = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-port") && i + 1 < argc)
+			port = (uint16_t)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-maxplayers") && i + 1 < argc)
+			maxPlayers = (DWORD)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-gamename") && i + 1 < argc)
+			gameName = argv[++i];
+		else if (!strcmp(argv[i], "-sessions") && i + 1 < argc)
+			sessions = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-workers") && i + 1 < argc)
+			workers = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-rendezvous") && i + 1 < argc)
+			rendezvousPort = (uint16_t)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-trustloopback"))
+			trustLoopback = true; // for the load tests, the players on this machine share one address
+		else if (!strcmp(argv[i], "-cookie"))
+			cookies = true; // the players of older builds cannot answer the challenge
+		else
+		{
+			printf("Usage: %s [-port port] [-maxplayers number] [-gamename name] [-sessions number] [-workers number] [-rendezvous port] [-trustloopback] [-cookie]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!maxPlayers || maxPlayers > DP_RELAY_SERVER_MAX_PLAYERS)
+		maxPlayers = DP_RELAY_SERVER_MAX_PLAYERS;
+
+	if (!sessions || sessions > 65535U - port + 1)
+		sessions = 1;
+
+	auto cores = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (!cores)
+		cores = 1;
+
+	if (!workers)
+		workers = cores;
+
+	if (workers > sessions)
+		workers = sessions; // a worker without sessions would just spin
+
+	if (enet_initialize() != 0)
+	{
+		printf("[RELAY] Cannot initialize enet\n");
+		return 1;
+	}
+
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+
+	{
+		std::vector<std::unique_ptr<DPRelayWorker>> pool(workers);
+
+		for (auto& w : pool)
+			w.reset(new DPRelayWorker());
+
+		// every session has its own port, the port picks the worker so the players of a session always meet on the same thread
+		for (unsigned i = 0; i < sessions; i++)
+		{
+			auto p = (uint16_t)(port + i);
+
+			if (!pool[i % workers]->Add(p, maxPlayers, gameName, trustLoopback, cookies))
+			{
+				printf("[RELAY] Cannot listen on port %u\n", p);
+				enet_deinitialize();
+				return 1;
+			}
+		}
+
+		printf("[RELAY] %u sessions on %u workers, %u cores\n", sessions, workers, cores);
+
+		// the rendezvous service is light, it runs on the main thread
+		DPRendezvousServer rendezvous;
+
+		if (rendezvousPort && !rendezvous.Create(rendezvousPort))
+		{
+			printf("[RELAY] Cannot listen on port %u\n", rendezvousPort);
+			enet_deinitialize();
+			return 1;
+		}
+
+		for (unsigned i = 0; i < workers; i++)
+			pool[i]->Start(i % cores, &s_bRunning);
+
+		auto nextDump = enet_time_get() + DP_RELAY_SERVER_DUMP_TIME;
+
+		while (s_bRunning)
+		{
+			if (!rendezvousPort)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				continue;
+			}
+
+			rendezvous.Service(100);
+
+			if ((int32_t)(enet_time_get() - nextDump) >= 0)
+			{
+				rendezvous.Dump();
+				nextDump += DP_RELAY_SERVER_DUMP_TIME;
+			}
+		}
+
+		if (rendezvousPort)
+			rendezvous.Dump();
+
+		for (auto& w : pool)
+			w->Join();
+	}
+
+	enet_deinitialize();
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*!
+	@author Arves100
+	@file BufferTest.cpp
+	@date 19/10/2026
+	@brief Receive drops of a host under bursts on loopback, with the smallest and the largest socket buffers
+*/
+#include "DPTest.h"
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#define BUFFER_TEST_BURST 400 // datagrams of a burst, what a full session sends the host in one go
+#define BUFFER_TEST_SIZE 1200 // bytes of a datagram
+#define BUFFER_TEST_BURSTS 10
+#define BUFFER_TEST_PERIOD 100 // ms between two bursts
+
+/*!
+* @brief Datagrams the socket of the host drops while the session is flooded by bursts
+* @param maxPlayers Size of the session, the socket buffers are sized from it
+* @return Dropped share of the bursts
+*/
+static double Run(DWORD maxPlayers)
+{
+	DPTestGame host("host"), game("game");
+	std::atomic<DWORD> received(0);
+
+	if (!DP_CHECK(host.Host(maxPlayers)))
+		return 1;
+
+	host.Start(nullptr, [&](DPTestGame&, DPID, const BYTE*, DWORD) { received++; });
+
+	if (!DP_CHECK(game.Join("127.0.0.1")))
+		return 1;
+
+	double next = 0;
+	DWORD sent = 0;
+
+	// the game keeps sending while the bursts arrive, its messages must get through
+	game.Start([&](DPTestGame& g) {
+		if (DPTest::Now() >= next)
+		{
+			if (g.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, 64) == DP_OK)
+				sent++;
+
+			next = DPTest::Now() + 10;
+		}
+	});
+
+	// the bursts come from the kernel in one go, the enet pacing of our peers would spread them
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in to = {};
+	to.sin_family = AF_INET;
+	to.sin_port = htons(FURFIGHTERS_PORT);
+	to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	std::vector<BYTE> data(BUFFER_TEST_SIZE, 0xAA);
+	auto before = DPTest::SocketDrops(FURFIGHTERS_PORT);
+
+	for (int b = 0; b < BUFFER_TEST_BURSTS; b++)
+	{
+		for (int i = 0; i < BUFFER_TEST_BURST; i++)
+			sendto(fd, data.data(), data.size(), 0, (sockaddr*)&to, sizeof(to));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(BUFFER_TEST_PERIOD));
+	}
+
+	close(fd);
+
+	auto drops = DPTest::SocketDrops(FURFIGHTERS_PORT) - before;
+	auto share = (double)drops / (BUFFER_TEST_BURST * BUFFER_TEST_BURSTS);
+
+	printf("session of %2u players: %4u/%u datagrams of the bursts dropped by the socket (%.1f%%), game messages %u/%u, lost sessions %u\n",
+		maxPlayers, drops, BUFFER_TEST_BURST * BUFFER_TEST_BURSTS, share * 100, received.load(), sent, game.SessionLost.load());
+
+	DP_CHECK(game.SessionLost == 0);
+
+	game.Close();
+	host.Close();
+	return share;
+}
+
+/*!
+* @brief The largest message of GetCaps gets through, a larger one is refused
+*/
+static void RunLargest()
+{
+	DPTestGame host("host"), game("game");
+	std::atomic<DWORD> largest(0);
+
+	if (!DP_CHECK(host.Host(4)))
+		return;
+
+	host.Start(nullptr, [&](DPTestGame&, DPID, const BYTE*, DWORD size) { largest = size; });
+
+	if (!DP_CHECK(game.Join("127.0.0.1")))
+		return;
+
+	DPCAPS caps = { sizeof(caps) };
+	game.GetDP().GetCaps(&caps, 0);
+
+	auto tooBig = game.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, caps.dwMaxBufferSize + 1);
+	auto sent = game.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, caps.dwMaxBufferSize);
+	game.Start();
+
+	auto start = DPTest::Now();
+
+	while (largest != caps.dwMaxBufferSize && DPTest::Now() - start < 5000)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	printf("largest message %u bytes: arrived after %.0f ms, one more byte refused %s\n", caps.dwMaxBufferSize, DPTest::Now() - start, tooBig == DPERR_SENDTOOBIG ? "yes" : "no");
+
+	DP_CHECK(tooBig == DPERR_SENDTOOBIG);
+	DP_CHECK(sent == DP_OK);
+	DP_CHECK(largest == caps.dwMaxBufferSize);
+
+	game.Close();
+	host.Close();
+}
+
+int main()
+{
+	RunLargest();
+
+	auto small = Run(4); // ENET_HOST_BUFFER_SIZE_MIN, what the 1 KB buffers became
+	auto large = Run(32); // ENET_HOST_BUFFER_SIZE_MAX
+
+	DP_CHECK(large < small);
+	DP_CHECK(large < 0.01);
+	return DPTest::Result();
+}
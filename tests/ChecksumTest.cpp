@@ -0,0 +1,153 @@
+/*!
+	@author Arves100
+	@file ChecksumTest.cpp
+	@date 19/10/2026
+	@brief CRC32C of the enet datagrams against known values and a bitwise reference, with its cost
+*/
+#include "DPTest.h"
+
+#define CHECKSUM_TEST_MTU 1200 // bytes of a full datagram
+#define CHECKSUM_TEST_MB 64 // MB checksummed to measure the cost
+
+static uint32_t Crc(const void* data, size_t len)
+{
+	ENetBuffer b;
+	b.data = (void*)data;
+	b.dataLength = len;
+	return ENET_NET_TO_HOST_32((uint32_t)enet_crc32c(&b, 1));
+}
+
+// one bit at a time, the definition of the CRC
+static uint32_t Reference(const BYTE* data, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (len--)
+	{
+		crc ^= *data++;
+
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+/*!
+* @brief Known values, and every length, alignment and split of the buffers against the reference
+*/
+static void RunValues()
+{
+	// RFC 3720 B.4
+	std::vector<BYTE> zeros(32, 0), ones(32, 0xFF), up(32), down(32);
+
+	for (int i = 0; i < 32; i++)
+	{
+		up[i] = (BYTE)i;
+		down[i] = (BYTE)(31 - i);
+	}
+
+	DP_CHECK(Crc("123456789", 9) == 0xE3069283);
+	DP_CHECK(Crc("", 0) == 0);
+	DP_CHECK(Crc(zeros.data(), zeros.size()) == 0x8A9136AA);
+	DP_CHECK(Crc(ones.data(), ones.size()) == 0x62A8AB43);
+	DP_CHECK(Crc(up.data(), up.size()) == 0x46DD794E);
+	DP_CHECK(Crc(down.data(), down.size()) == 0x113FDB5C);
+
+	std::vector<BYTE> data(CHECKSUM_TEST_MTU + 16);
+	DWORD seed = 3, wrong = 0;
+
+	for (auto& b : data)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (BYTE)(seed >> 16);
+	}
+
+	for (size_t offset = 0; offset < 8; offset++)
+	{
+		for (size_t len = 0; len <= CHECKSUM_TEST_MTU; len++)
+		{
+			auto p = data.data() + offset;
+			auto ref = Reference(p, len);
+
+			if (Crc(p, len) != ref)
+				wrong++;
+
+			// a datagram is sent as the header and the commands, in many buffers
+			ENetBuffer b[3];
+			b[0].data = p;
+			b[0].dataLength = len / 3;
+			b[1].data = p + len / 3;
+			b[1].dataLength = len / 2 - len / 3;
+			b[2].data = p + len / 2;
+			b[2].dataLength = len - len / 2;
+
+			if (ENET_NET_TO_HOST_32((uint32_t)enet_crc32c(b, 3)) != ref)
+				wrong++;
+		}
+	}
+
+	DP_CHECK(wrong == 0);
+
+	// every flipped bit of a datagram is seen
+	auto crc = Crc(data.data(), CHECKSUM_TEST_MTU);
+	DWORD missed = 0;
+
+	for (size_t bit = 0; bit < CHECKSUM_TEST_MTU * 8; bit++)
+	{
+		data[bit / 8] ^= (BYTE)(1 << (bit % 8));
+
+		if (Crc(data.data(), CHECKSUM_TEST_MTU) == crc)
+			missed++;
+
+		data[bit / 8] ^= (BYTE)(1 << (bit % 8));
+	}
+
+	printf("values: %u wrong against the reference, %u flipped bits missed\n", wrong, missed);
+	DP_CHECK(missed == 0);
+}
+
+/*!
+* @brief Cost of the checksum, per MB and per full datagram: both the sender and the receiver compute it
+*/
+static void RunCost()
+{
+	std::vector<BYTE> data(1024 * 1024, 0x5A);
+	volatile uint32_t sink = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < CHECKSUM_TEST_MB; i++)
+		sink = sink + Crc(data.data(), data.size());
+
+	double mb = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / CHECKSUM_TEST_MB;
+	DWORD datagrams = CHECKSUM_TEST_MB * 1024 * 1024 / CHECKSUM_TEST_MTU;
+
+	start = std::chrono::steady_clock::now();
+
+	for (DWORD i = 0; i < datagrams; i++)
+		sink = sink + Crc(data.data(), CHECKSUM_TEST_MTU);
+
+	double datagram = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / datagrams;
+	double reference = 0;
+
+	start = std::chrono::steady_clock::now();
+	sink = sink + Reference(data.data(), data.size());
+	reference = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("cost: %.3f ms/MB (bitwise %.1f ms/MB), %.0f ns per datagram of %u bytes, %.0f ns added to the latency of a datagram\n",
+		mb, reference, datagram, CHECKSUM_TEST_MTU, datagram * 2);
+
+	DP_CHECK(mb < reference);
+}
+
+int main()
+{
+	if (!DP_CHECK(enet_initialize() == 0))
+		return DPTest::Result();
+
+	RunValues();
+	RunCost();
+	enet_deinitialize();
+	return DPTest::Result();
+}
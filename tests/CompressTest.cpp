@@ -0,0 +1,125 @@
+/*!
+	@author Arves100
+	@file CompressTest.cpp
+	@date 19/10/2026
+	@brief Round trips of the dictionary compression over the traffic of a match, with its ratio and cost
+*/
+#include "DPTest.h"
+#include "DPCompressor.h"
+
+#define COMPRESS_TEST_PLAYERS 8
+#define COMPRESS_TEST_FRAMES 3000 // a bit less than two minutes of a match
+
+/*!
+* @brief Compresses and decompresses every message of the traffic
+* @param dict Dictionary of both sides
+* @return Bytes sent, a message that does not pay off is sent as it is
+*/
+static size_t Run(const char* name, const std::vector<DPTest::Recorded>& traffic, const std::vector<BYTE>& dict)
+{
+	DPCompressor sender, receiver;
+	sender.SetDictionary(dict);
+	receiver.SetDictionary(dict);
+
+	size_t raw = 0, sent = 0;
+	DWORD packed = 0, mismatches = 0;
+	std::vector<BYTE> out, back;
+	std::chrono::nanoseconds encode(0), decode(0);
+
+	for (const auto& r : traffic)
+	{
+		raw += r.raw.size();
+
+		auto start = std::chrono::steady_clock::now();
+		bool ok = sender.Compress(r.raw.data(), r.raw.size(), out);
+		encode += std::chrono::steady_clock::now() - start;
+
+		if (!ok)
+		{
+			sent += r.raw.size();
+			continue;
+		}
+
+		packed++;
+		sent += out.size();
+		back.assign(r.raw.size(), 0);
+
+		start = std::chrono::steady_clock::now();
+		ok = receiver.Decompress(out.data(), out.size(), back.data(), back.size());
+		decode += std::chrono::steady_clock::now() - start;
+
+		if (!ok || back != r.raw)
+			mismatches++;
+	}
+
+	printf("%-7s dictionary of %5zu bytes: %zu -> %zu bytes (%.1f%%), %u/%zu compressed, encode %lld ns/msg, decode %lld ns/msg, mismatches %u\n",
+		name, dict.size(), raw, sent, sent * 100.0 / raw, packed, traffic.size(), (long long)(encode.count() / traffic.size()),
+		packed ? (long long)(decode.count() / packed) : 0, mismatches);
+
+	DP_CHECK(mismatches == 0);
+	return sent;
+}
+
+/*!
+* @brief Data that cannot be compressed, and corrupted data
+*/
+static void RunInvalid(const std::vector<BYTE>& dict)
+{
+	DPCompressor c;
+	c.SetDictionary(dict);
+
+	std::vector<BYTE> noise(256), out;
+	DWORD seed = 1;
+
+	for (auto& b : noise)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (BYTE)(seed >> 16);
+	}
+
+	DP_CHECK(!c.Compress(noise.data(), noise.size(), out)); // sent as it is
+
+	auto traffic = DPTest::Record(1, 1);
+	const auto& raw = traffic[0].raw;
+	std::vector<BYTE> back(raw.size());
+
+	if (!DP_CHECK(c.Compress(raw.data(), raw.size(), out)))
+		return;
+
+	DP_CHECK(c.Decompress(out.data(), out.size(), back.data(), back.size()) && back == raw);
+
+	// the size of the message is sent apart, both a shorter and a longer one are refused
+	DP_CHECK(!c.Decompress(out.data(), out.size(), back.data(), back.size() - 1));
+	back.resize(raw.size() + 1);
+	DP_CHECK(!c.Decompress(out.data(), out.size(), back.data(), back.size()));
+	back.resize(raw.size());
+
+	for (size_t len = 0; len < out.size(); len++)
+		c.Decompress(out.data(), len, back.data(), back.size()); // truncated, it must not read or write out of the buffers
+
+	DPCompressor other; // another dictionary
+	other.SetDictionary(std::vector<BYTE>(dict.begin(), dict.begin() + dict.size() / 2));
+	other.Decompress(out.data(), out.size(), back.data(), back.size());
+	DP_CHECK(other.GetId() != c.GetId());
+}
+
+int main()
+{
+	auto traffic = DPTest::Record(COMPRESS_TEST_PLAYERS, COMPRESS_TEST_FRAMES);
+
+	// trained like the game does, from the first messages of a session
+	std::deque<std::vector<BYTE>> samples;
+
+	for (size_t i = 0; i < traffic.size() && samples.size() < DP_DICT_MAX_SAMPLES; i++)
+		samples.push_back(traffic[i].raw);
+
+	auto dict = DPCompressor::Train(samples);
+	DP_CHECK(!dict.empty() && dict.size() <= DP_DICT_MAX_SIZE);
+
+	auto none = Run("empty", traffic, {});
+	auto trained = Run("trained", traffic, dict);
+	DP_CHECK(trained < none);
+
+	RunInvalid(dict);
+	return DPTest::Result();
+}
@@ -0,0 +1,124 @@
+/*!
+	@author Arves100
+	@file CongestionBench.cpp
+	@date 19/10/2026
+	@brief Queueing delay and goodput of a game that sends more than its 1 Mbit uplink, with and without congestion control
+*/
+#include "DPTest.h"
+#include <algorithm>
+
+#define CONGESTION_BENCH_PORT 24970
+#define CONGESTION_BENCH_RATE 1000000 // bits per second of the uplink of the game
+#define CONGESTION_BENCH_QUEUE (128 * 1024) // bytes of the buffer of the modem, a second at that rate
+#define CONGESTION_BENCH_DELAY 20 // ms of propagation each way
+#define CONGESTION_BENCH_SIZE 1000 // bytes of a bulk update
+#define CONGESTION_BENCH_PERIOD 4 // ms between two bulk updates, 2 Mbit/s offered
+#define CONGESTION_BENCH_PROBE 50 // ms between two guaranteed probes
+#define CONGESTION_BENCH_WARMUP 2000 // ms before the measures start
+#define CONGESTION_BENCH_TIME 8000 // ms measured
+#define CONGESTION_BENCH_MAX_QUEUEING 100 // ms of queueing the probes can meet with congestion control
+
+struct CongestionResult
+{
+	double latency; // ms, mean of the probes
+	double goodput; // kbit/s of bulk updates
+};
+
+static CongestionResult Run(bool cc)
+{
+	Globals::Get()->NetCongestionControl = cc;
+
+	DPTestGame host("host"), game("game");
+	DPTestLink link;
+	std::atomic<bool> measuring(false);
+	std::atomic<ULONGLONG> bulk(0);
+	std::vector<double> probes;
+
+	DPTestLink::Direction up, down;
+	up.rate = CONGESTION_BENCH_RATE;
+	up.queue = CONGESTION_BENCH_QUEUE;
+	up.delay = CONGESTION_BENCH_DELAY;
+	down.delay = CONGESTION_BENCH_DELAY;
+	link.SetUp(up, down);
+
+	if (!DP_CHECK(host.Host(4)) || !DP_CHECK(link.Start(CONGESTION_BENCH_PORT, FURFIGHTERS_PORT)))
+		return {};
+
+	host.Start(nullptr, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) {
+		auto p = (const DPTest::Payload*)data;
+
+		if (!measuring)
+			return;
+
+		if (p->stream == 2)
+			probes.push_back(DPTest::Now() - p->sentAt);
+		else
+			bulk += size;
+	});
+
+	char addr[32];
+	snprintf(addr, sizeof(addr), "127.0.0.1:%u", CONGESTION_BENCH_PORT);
+
+	if (!DP_CHECK(game.Join(addr)))
+		return {};
+
+	double nextBulk = 0, nextProbe = 0;
+
+	game.Start([&](DPTestGame& g) {
+		auto now = DPTest::Now();
+
+		if (now >= nextBulk)
+		{
+			g.SendSeq(host.GetId(), 0, 1, CONGESTION_BENCH_SIZE);
+			nextBulk = now + CONGESTION_BENCH_PERIOD;
+		}
+
+		if (now >= nextProbe)
+		{
+			g.SendSeq(host.GetId(), DPSEND_GUARANTEED, 2, 64);
+			nextProbe = now + CONGESTION_BENCH_PROBE;
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(CONGESTION_BENCH_WARMUP));
+	DWORD dropped = link.Dropped;
+	measuring = true;
+	std::this_thread::sleep_for(std::chrono::milliseconds(CONGESTION_BENCH_TIME));
+	measuring = false;
+	dropped = link.Dropped - dropped;
+
+	game.Stop();
+	host.Stop();
+
+	double mean = 0;
+
+	for (auto p : probes)
+		mean += p;
+
+	mean = probes.empty() ? 0 : mean / probes.size();
+	std::sort(probes.begin(), probes.end());
+	auto p95 = probes.empty() ? 0 : probes[(probes.size() - 1) * 95 / 100];
+
+	printf("congestion control %-3s: probes %3zu, one-way %6.1f ms mean %6.1f ms p95 (base %u ms), goodput %4.0f kbit/s, %4u datagrams dropped by the modem, lost sessions %u\n",
+		cc ? "on" : "off", probes.size(), mean, p95, CONGESTION_BENCH_DELAY, bulk * 8.0 / CONGESTION_BENCH_TIME, dropped, game.SessionLost.load());
+
+	DP_CHECK(!probes.empty());
+	DP_CHECK(game.SessionLost == 0);
+
+	game.Close();
+	host.Close();
+	link.Stop();
+	return { mean, bulk * 8.0 / CONGESTION_BENCH_TIME };
+}
+
+int main()
+{
+	auto off = Run(false);
+	auto on = Run(true);
+
+	// pacing under the rate of the uplink keeps its buffer empty and nothing is lost in it
+	DP_CHECK(on.latency < CONGESTION_BENCH_DELAY + CONGESTION_BENCH_MAX_QUEUEING);
+	DP_CHECK(on.latency * 4 < off.latency);
+	DP_CHECK(on.goodput > off.goodput);
+	return DPTest::Result();
+}
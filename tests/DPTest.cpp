@@ -0,0 +1,577 @@
+/*!
+	@author Arves100
+	@file DPTest.cpp
+	@date 19/10/2026
+	@brief Helpers of the loopback tests and benchmarks of the network code
+*/
+#include "DPTest.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+
+// the configuration of the game, without the loader: the tests change it before creating their objects
+Globals* Globals::ms_pSingleton = nullptr;
+
+Globals::Globals()
+{
+	ms_pSingleton = this;
+
+	TheLoader = nullptr;
+	LoaderUseFullFunctions = false;
+	GameWindow = nullptr;
+	GamePID = 0;
+	GameProcess = nullptr;
+	GameModule = nullptr;
+	memset(GameDiskPath, 0, sizeof(GameDiskPath));
+	BaseAddress = nullptr;
+	WindowedMode = false;
+	NetArenaSize = 1024 * 1024; // many objects in one process
+	NetFlushPolicy = 0; // DP_FLUSH_SERVICE
+	NetCongestionControl = false;
+	NetFec = false;
+	NetDictTrain = false;
+	NetDelta = false;
+	NetSpectatorDelay = 0;
+	NetSpectatorBuffer = 4 * 1024 * 1024; // DP_RING_DEFAULT_SIZE
+	memset(NetRelayServer, 0, sizeof(NetRelayServer));
+	NetChecksum = false;
+	memset(NetRendezvousServer, 0, sizeof(NetRendezvousServer));
+	memset(NetSessionCode, 0, sizeof(NetSessionCode));
+	NetSharedMemory = false; // the tests that want it turn it on
+	NetTrustLoopback = false; // the firewall is tested like a player runs it
+	NetFirewallCookie = false;
+}
+
+Globals::~Globals()
+{
+	ms_pSingleton = nullptr;
+}
+
+void Globals::Fatal(const wchar_t* error, const wchar_t* file, size_t line)
+{
+	fprintf(stderr, "FATAL: %ls\n", error);
+	abort();
+}
+
+static std::atomic<int> s_failed(0);
+static const auto s_start = std::chrono::steady_clock::now();
+
+bool DPTest::Check(bool ok, const char* expr, const char* file, int line)
+{
+	if (!ok)
+	{
+		printf("FAIL %s:%d: %s\n", file, line, expr);
+		s_failed++;
+	}
+
+	return ok;
+}
+
+int DPTest::Result()
+{
+	printf(s_failed ? "%d checks FAILED\n" : "OK\n", s_failed.load());
+	return s_failed ? 1 : 0;
+}
+
+double DPTest::Now()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+std::vector<BYTE> DPTest::Address(const char* host)
+{
+	auto len = (DWORD)strlen(host) + 1;
+	std::vector<BYTE> v(sizeof(DPADDRESS) + sizeof(DWORD) + sizeof(DPADDRESS) + len);
+
+	auto total = (LPDPADDRESS)v.data();
+	total->guidDataType = DPAID_TotalSize;
+	total->dwDataSize = sizeof(DWORD);
+	*(DWORD*)(v.data() + sizeof(DPADDRESS)) = sizeof(DPADDRESS) + len;
+
+	auto inet = (LPDPADDRESS)(v.data() + sizeof(DPADDRESS) + sizeof(DWORD));
+	inet->guidDataType = DPAID_INet;
+	inet->dwDataSize = len;
+	memcpy(inet + 1, host, len);
+	return v;
+}
+
+DWORD DPTest::SocketDrops(uint16_t port)
+{
+	DWORD drops = 0;
+
+	for (auto path : { "/proc/net/udp", "/proc/net/udp6" }) // enet binds dual stack sockets
+	{
+		auto f = fopen(path, "r");
+
+		if (!f)
+			continue;
+
+		char line[512];
+
+		while (fgets(line, sizeof(line), f))
+		{ // sl local rem st tx:rx tr:when retrnsmt uid timeout inode ref pointer drops
+			unsigned local = 0;
+			unsigned long d = 0;
+
+			if (sscanf(line, " %*u: %*[0-9A-Fa-f]:%x %*[0-9A-Fa-f]:%*x %*x %*x:%*x %*x:%*x %*x %*u %*u %*u %*u %*x %lu", &local, &d) == 2 && local == port)
+				drops += (DWORD)d;
+		}
+
+		fclose(f);
+	}
+
+	return drops;
+}
+
+std::vector<DPTest::Recorded> DPTest::Record(DWORD players, DWORD frames)
+{
+#pragma pack(push, 1)
+	struct State
+	{
+		WORD kind;
+		WORD player;
+		DWORD frame;
+		float pos[3];
+		float dir[3];
+		WORD anim;
+		WORD animFrame;
+		BYTE health;
+		BYTE weapon;
+		WORD ammo;
+		DWORD flags;
+		BYTE reserved[12];
+	};
+
+	struct Event
+	{
+		WORD kind;
+		WORD player;
+		DWORD frame;
+		WORD target;
+		WORD damage;
+		BYTE weapon;
+		BYTE reserved[7];
+	};
+#pragma pack(pop)
+
+	DWORD seed = 12345;
+	auto random = [&seed](DWORD n) {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % n;
+	};
+
+	std::vector<State> states(players);
+
+	for (DWORD i = 0; i < players; i++)
+	{
+		auto& s = states[i];
+		memset(&s, 0, sizeof(s));
+		s.kind = 1;
+		s.player = (WORD)i;
+		s.pos[0] = (float)random(1000);
+		s.pos[2] = (float)random(1000);
+		s.dir[0] = 1;
+		s.health = 100;
+		s.weapon = 1;
+		s.ammo = 50;
+		s.flags = 0x00010003;
+	}
+
+	std::vector<Recorded> v;
+
+	auto add = [&v](DWORD player, bool reliable, const void* data, DWORD size) {
+		Recorded r = { 2 + player, DPID_ALLPLAYERS, reliable, std::vector<BYTE>(sizeof(size) + size) };
+		memcpy(r.raw.data(), &size, sizeof(size));
+		memcpy(r.raw.data() + sizeof(size), data, size);
+		v.push_back(std::move(r));
+	};
+
+	for (DWORD f = 0; f < frames; f++)
+	{
+		for (DWORD i = 0; i < players; i++)
+		{
+			auto& s = states[i];
+			s.frame = f;
+
+			if (!random(20))
+			{ // turns
+				s.dir[0] = (float)random(3) - 1;
+				s.dir[2] = (float)random(3) - 1;
+				s.anim = (WORD)random(8);
+				s.animFrame = 0;
+			}
+
+			s.pos[0] += s.dir[0] * 0.25f;
+			s.pos[2] += s.dir[2] * 0.25f;
+			s.animFrame++;
+			add(i, false, &s, sizeof(s));
+
+			if (!random(30))
+			{
+				Event e = {};
+				e.kind = 2;
+				e.player = (WORD)i;
+				e.frame = f;
+				e.target = (WORD)random(players);
+				e.damage = (WORD)(5 + random(20));
+				e.weapon = s.weapon;
+				add(i, true, &e, sizeof(e));
+
+				s.ammo = s.ammo ? s.ammo - 1 : 50;
+				auto& t = states[e.target];
+				t.health = t.health > e.damage ? t.health - (BYTE)e.damage : 100;
+			}
+		}
+	}
+
+	return v;
+}
+
+DPTestGame::DPTestGame(const char* name) : SessionLost(0), PlayersCreated(0), PlayersDestroyed(0), HostChanged(0), GameReceived(0), Frames(0),
+	m_id(0), m_szName(name), m_vBuffer(64 * 1024), m_bRun(false), m_bOpen(false)
+{
+}
+
+DPTestGame::~DPTestGame()
+{
+	Close();
+}
+
+bool DPTestGame::Host(DWORD maxPlayers)
+{
+	DPSESSIONDESC2 sd;
+	memset(&sd, 0, sizeof(sd));
+	sd.dwSize = sizeof(sd);
+	sd.dwMaxPlayers = maxPlayers;
+	sd.lpszSessionNameA = (char*)"test";
+
+	if (m_dp.Open(&sd, DPOPEN_CREATE) != DP_OK)
+		return false;
+
+	m_bOpen = true;
+
+	DPNAME nm;
+	memset(&nm, 0, sizeof(nm));
+	nm.dwSize = sizeof(nm);
+	nm.lpszShortNameA = nm.lpszLongNameA = (char*)m_szName.c_str();
+	return m_dp.CreatePlayer(&m_id, &nm, nullptr, nullptr, 0, 0) == DP_OK;
+}
+
+bool DPTestGame::Join(const char* address, DWORD flags)
+{
+	auto addr = DPTest::Address(address);
+
+	if (m_dp.InitializeConnection(addr.data(), 0) != DP_OK)
+		return false;
+
+	m_bOpen = true;
+
+	DPSESSIONDESC2 sd;
+	memset(&sd, 0, sizeof(sd));
+	sd.dwSize = sizeof(sd);
+
+	HRESULT hr = DPERR_NOCONNECTION;
+
+	for (int i = 0; i < DP_TEST_JOIN_TRIES && hr != DP_OK; i++)
+		hr = m_dp.Open(&sd, DPOPEN_JOIN);
+
+	if (hr != DP_OK)
+		return false;
+
+	DPNAME nm;
+	memset(&nm, 0, sizeof(nm));
+	nm.dwSize = sizeof(nm);
+	nm.lpszShortNameA = nm.lpszLongNameA = (char*)m_szName.c_str();
+	return m_dp.CreatePlayer(&m_id, &nm, nullptr, nullptr, 0, flags) == DP_OK;
+}
+
+void DPTestGame::Start(FrameFn frame, GameFn game, SystemFn system)
+{
+	m_frame = frame;
+	m_game = game;
+	m_system = system;
+	m_bRun = true;
+	m_thread = std::thread(&DPTestGame::Loop, this);
+}
+
+void DPTestGame::Stop()
+{
+	m_bRun = false;
+
+	if (m_thread.joinable())
+		m_thread.join();
+}
+
+void DPTestGame::Close()
+{
+	Stop();
+
+	if (m_bOpen)
+	{
+		m_dp.Close();
+		m_bOpen = false;
+	}
+}
+
+void DPTestGame::Crash()
+{
+	Stop();
+	m_bOpen = false;
+}
+
+HRESULT DPTestGame::SendSeq(DPID to, DWORD flags, DWORD stream, DWORD size, DWORD priority, DWORD timeout)
+{
+	std::vector<BYTE> data(size < sizeof(DPTest::Payload) ? sizeof(DPTest::Payload) : size);
+	auto p = (DPTest::Payload*)data.data();
+	p->stream = stream;
+	p->seq = m_vNextSeq[stream];
+	p->sentAt = DPTest::Now();
+
+	HRESULT hr;
+
+	if (priority || timeout || (flags & DPSEND_ASYNC))
+		hr = m_dp.SendEx(m_id, to, flags, data.data(), (DWORD)data.size(), priority, timeout, nullptr, nullptr);
+	else
+		hr = m_dp.Send(m_id, to, flags, data.data(), (DWORD)data.size());
+
+	if (hr == DP_OK || hr == DPERR_PENDING)
+		m_vNextSeq[stream]++;
+
+	return hr;
+}
+
+void DPTestGame::Loop()
+{
+	while (m_bRun)
+	{
+		if (m_frame)
+			m_frame(*this);
+
+		Drain();
+		Frames++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(DP_TEST_FRAME));
+	}
+}
+
+void DPTestGame::Drain()
+{
+	for (;;)
+	{
+		DPID from = 0, to = 0;
+		auto size = (DWORD)m_vBuffer.size();
+		auto hr = m_dp.Receive(&from, &to, DPRECEIVE_ALL, m_vBuffer.data(), &size);
+
+		if (hr == DPERR_BUFFERTOOSMALL)
+		{
+			m_vBuffer.resize(size);
+			continue;
+		}
+
+		if (hr != DP_OK)
+			return;
+
+		if (from != DPID_SYSMSG)
+		{
+			GameReceived++;
+
+			if (m_game)
+				m_game(*this, from, m_vBuffer.data(), size);
+
+			continue;
+		}
+
+		auto type = *(DWORD*)m_vBuffer.data();
+
+		switch (type)
+		{
+		case DPSYS_SESSIONLOST:
+			SessionLost++;
+			break;
+		case DPSYS_CREATEPLAYERORGROUP:
+			PlayersCreated++;
+			break;
+		case DPSYS_DESTROYPLAYERORGROUP:
+			PlayersDestroyed++;
+			break;
+		case DPSYS_HOST:
+			HostChanged++;
+			break;
+		default:
+			break;
+		}
+
+		if (m_system)
+			m_system(*this, type, m_vBuffer.data());
+	}
+}
+
+DPTestLink::DPTestLink() : Forwarded(0), Dropped(0), BytesToHost(0), BytesToGame(0), m_front(-1), m_back(-1), m_bGameKnown(false),
+	m_rng(1234), m_bRun(false), m_bDown(false)
+{
+	memset(&m_game, 0, sizeof(m_game));
+	memset(&m_host, 0, sizeof(m_host));
+}
+
+DPTestLink::~DPTestLink()
+{
+	Stop();
+}
+
+static int OpenSocket(uint16_t port)
+{
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+
+	if (s < 0)
+		return -1;
+
+	sockaddr_in a;
+	memset(&a, 0, sizeof(a));
+	a.sin_family = AF_INET;
+	a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	a.sin_port = htons(port);
+
+	int size = 4 * 1024 * 1024;
+	setsockopt(s, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	setsockopt(s, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+	if (bind(s, (sockaddr*)&a, sizeof(a)) < 0)
+	{
+		close(s);
+		return -1;
+	}
+
+	fcntl(s, F_SETFL, O_NONBLOCK);
+	return s;
+}
+
+bool DPTestLink::Start(uint16_t port, uint16_t target)
+{
+	m_front = OpenSocket(port);
+	m_back = OpenSocket(0);
+
+	if (m_front < 0 || m_back < 0)
+		return false;
+
+	m_host.sin_family = AF_INET;
+	m_host.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	m_host.sin_port = htons(target);
+
+	m_bRun = true;
+	m_thread = std::thread(&DPTestLink::Loop, this);
+	return true;
+}
+
+void DPTestLink::Stop()
+{
+	m_bRun = false;
+
+	if (m_thread.joinable())
+		m_thread.join();
+
+	if (m_front >= 0)
+		close(m_front);
+
+	if (m_back >= 0)
+		close(m_back);
+
+	m_front = m_back = -1;
+}
+
+void DPTestLink::SetUp(const Direction& toHost, const Direction& toGame)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_toHost.dir = toHost;
+	m_toGame.dir = toGame;
+}
+
+void DPTestLink::Push(Queue& q, const BYTE* data, size_t size, double now)
+{
+	if (m_bDown || (q.dir.loss > 0 && std::uniform_real_distribution<double>(0, 1)(m_rng) < q.dir.loss))
+	{
+		Dropped++;
+		return;
+	}
+
+	double at = now;
+
+	if (q.dir.rate)
+	{ // the bottleneck sends one datagram at a time, the rest waits in its queue
+		auto start = q.busyUntil > now ? q.busyUntil : now;
+		auto backlog = (start - now) * q.dir.rate / 8000.0;
+
+		if (backlog + size > q.dir.queue)
+		{
+			Dropped++;
+			return;
+		}
+
+		q.busyUntil = start + size * 8000.0 / q.dir.rate;
+		at = q.busyUntil;
+	}
+
+	q.pending.push_back({ at + q.dir.delay, std::vector<BYTE>(data, data + size) });
+}
+
+void DPTestLink::Pop(Queue& q, int fd, const sockaddr_in& to, std::atomic<ULONGLONG>& bytes, double now)
+{
+	while (!q.pending.empty() && q.pending.front().at <= now)
+	{
+		auto& d = q.pending.front();
+		sendto(fd, d.data.data(), d.data.size(), 0, (const sockaddr*)&to, sizeof(to));
+		bytes += d.data.size();
+		Forwarded++;
+		q.pending.pop_front();
+	}
+}
+
+void DPTestLink::Loop()
+{
+	BYTE buf[65536];
+
+	while (m_bRun)
+	{
+		int timeout = 1;
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			if (m_toHost.pending.empty() && m_toGame.pending.empty())
+				timeout = 5;
+		}
+
+		pollfd fds[2] = { { m_front, POLLIN, 0 }, { m_back, POLLIN, 0 } };
+		poll(fds, 2, timeout);
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto now = DPTest::Now();
+
+		for (;;)
+		{
+			sockaddr_in from;
+			socklen_t len = sizeof(from);
+			auto n = recvfrom(m_front, buf, sizeof(buf), 0, (sockaddr*)&from, &len);
+
+			if (n < 0)
+				break;
+
+			m_game = from;
+			m_bGameKnown = true;
+			Push(m_toHost, buf, (size_t)n, now);
+		}
+
+		for (;;)
+		{
+			auto n = recv(m_back, buf, sizeof(buf), 0);
+
+			if (n < 0)
+				break;
+
+			Push(m_toGame, buf, (size_t)n, now);
+		}
+
+		Pop(m_toHost, m_back, m_host, BytesToHost, now);
+
+		if (m_bGameKnown)
+			Pop(m_toGame, m_front, m_game, BytesToGame, now);
+	}
+}
@@ -0,0 +1,228 @@
+/*!
+	@author Arves100
+	@file DPTest.h
+	@date 19/10/2026
+	@brief Helpers of the loopback tests and benchmarks of the network code
+*/
+#pragma once
+
+#include "StdAfx.h"
+#include "Globals.h"
+#include "FakeDP.h"
+#include "DPMsg.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <netinet/in.h>
+
+#define DP_TEST_FRAME 1 // ms between two frames of a game loop
+#define DP_TEST_JOIN_TRIES 20 // Open gives up after a second without the host
+
+/*!
+* @brief Checks a condition of a test, the test fails at the end if one is false
+*/
+#define DP_CHECK(x) DPTest::Check((x), #x, __FILE__, __LINE__)
+
+namespace DPTest
+{
+	bool Check(bool ok, const char* expr, const char* file, int line);
+
+	/*!
+	* @brief Exit code of the test
+	*/
+	int Result();
+
+	/*!
+	* @brief Milliseconds since the start of the process
+	*/
+	double Now();
+
+	/*!
+	* @brief DirectPlay address of a game host, as the game passes it to InitializeConnection
+	* @param host ip, ip:port or session code
+	*/
+	std::vector<BYTE> Address(const char* host);
+
+	/*!
+	* @brief Datagrams the kernel dropped because the receive buffer of a UDP socket was full
+	* @param port Local port of the socket
+	*/
+	DWORD SocketDrops(uint16_t port);
+
+	/*!
+	* @brief Header of the game messages of the tests, so the receiver can check order and latency
+	*/
+	struct Payload
+	{
+		DWORD stream; // one per sender and kind of message
+		DWORD seq;
+		double sentAt; // Now() of the sender, the tests run in one process
+	};
+
+	/*!
+	* @brief Game message of a recorded match
+	*/
+	struct Recorded
+	{
+		DPID from;
+		DPID to;
+		bool reliable;
+		std::vector<BYTE> raw; // the payload of the game message, the size of the data and the data
+	};
+
+	/*!
+	* @brief Traffic of a match, made up like the game sends it: the state of every player every frame,
+	* and a guaranteed event now and then. The same arguments give the same traffic
+	* @param players Players of the match
+	* @param frames Frames of the match
+	*/
+	std::vector<Recorded> Record(DWORD players, DWORD frames);
+}
+
+/*!
+	@class DPTestGame
+	One DirectPlay object with a game loop on its own thread, like the game runs it: every frame
+	it sends what the test wants and reads every message. The object is only used by its thread
+	once started
+*/
+class DPTestGame
+{
+public:
+	using FrameFn = std::function<void(DPTestGame&)>;
+	using GameFn = std::function<void(DPTestGame&, DPID from, const BYTE* data, DWORD size)>;
+	using SystemFn = std::function<void(DPTestGame&, DWORD type, const void* msg)>;
+
+	explicit DPTestGame(const char* name);
+	~DPTestGame();
+
+	/*!
+	* @brief Creates a session and its player
+	*/
+	bool Host(DWORD maxPlayers);
+
+	/*!
+	* @brief Joins a session and creates the player, the host must be running
+	* @param address Passed to Address
+	*/
+	bool Join(const char* address, DWORD flags = 0);
+
+	/*!
+	* @brief Starts the game loop
+	*/
+	void Start(FrameFn frame = nullptr, GameFn game = nullptr, SystemFn system = nullptr);
+
+	void Stop();
+	void Close();
+
+	/*!
+	* @brief Stops the game without closing the session, the peers are dropped silently once the object is destroyed
+	*/
+	void Crash();
+
+	/*!
+	* @brief Sends a Payload with the next sequence of a stream, the rest of the message is zeros
+	*/
+	HRESULT SendSeq(DPID to, DWORD flags, DWORD stream, DWORD size, DWORD priority = 0, DWORD timeout = 0);
+
+	FakeDP& GetDP() { return m_dp; }
+	DPID GetId() const { return m_id; }
+	const char* GetName() const { return m_szName.c_str(); }
+
+	// Statistics of the loop
+	std::atomic<DWORD> SessionLost;
+	std::atomic<DWORD> PlayersCreated;
+	std::atomic<DWORD> PlayersDestroyed;
+	std::atomic<DWORD> HostChanged;
+	std::atomic<DWORD> GameReceived;
+	std::atomic<DWORD> Frames;
+
+private:
+	void Loop();
+	void Drain();
+
+	FakeDP m_dp;
+	DPID m_id;
+	std::string m_szName;
+	std::vector<BYTE> m_vBuffer;
+	std::unordered_map<DWORD, DWORD> m_vNextSeq;
+	FrameFn m_frame;
+	GameFn m_game;
+	SystemFn m_system;
+	std::thread m_thread;
+	std::atomic<bool> m_bRun;
+	bool m_bOpen;
+};
+
+/*!
+	@class DPTestLink
+	UDP proxy between one game and a game host on loopback, the game connects to the port of the
+	link instead of the host. Every direction can lose datagrams, delay them, or go through a
+	bottleneck of a given rate with a drop-tail queue, and the link can go down for a while
+*/
+class DPTestLink
+{
+public:
+	struct Direction
+	{
+		double loss = 0; // 0..1
+		DWORD delay = 0; // ms
+		DWORD rate = 0; // bits per second, 0 is unlimited
+		DWORD queue = 64 * 1024; // bytes waiting for the bottleneck before the tail is dropped
+	};
+
+	DPTestLink();
+	~DPTestLink();
+
+	/*!
+	* @brief Starts forwarding
+	* @param port Local port of the link
+	* @param target Port of the game host on loopback
+	*/
+	bool Start(uint16_t port, uint16_t target);
+	void Stop();
+
+	/*!
+	* @brief Both directions drop everything while down
+	*/
+	void SetDown(bool down) { m_bDown = down; }
+
+	void SetUp(const Direction& toHost, const Direction& toGame);
+
+	// Statistics
+	std::atomic<DWORD> Forwarded;
+	std::atomic<DWORD> Dropped;
+	std::atomic<ULONGLONG> BytesToHost;
+	std::atomic<ULONGLONG> BytesToGame;
+
+private:
+	struct Datagram
+	{
+		double at; // Now() when it leaves the link
+		std::vector<BYTE> data;
+	};
+
+	struct Queue
+	{
+		Direction dir;
+		std::deque<Datagram> pending;
+		double busyUntil = 0; // the bottleneck sends the last datagram until then
+	};
+
+	void Loop();
+	void Push(Queue& q, const BYTE* data, size_t size, double now);
+	void Pop(Queue& q, int fd, const sockaddr_in& to, std::atomic<ULONGLONG>& bytes, double now);
+
+	int m_front; // toward the game
+	int m_back; // toward the host
+	sockaddr_in m_game;
+	bool m_bGameKnown;
+	sockaddr_in m_host;
+	Queue m_toHost;
+	Queue m_toGame;
+	std::mutex m_lock;
+	std::mt19937 m_rng;
+	std::thread m_thread;
+	std::atomic<bool> m_bRun;
+	std::atomic<bool> m_bDown;
+};
@@ -0,0 +1,334 @@
+/*!
+	@author Arves100
+	@file DPTestNat.cpp
+	@date 19/10/2026
+	@brief NAT of a game on loopback, for the tests of the rendezvous service
+*/
+#include "DPTestNat.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unordered_map>
+
+#define DP_TEST_NAT_WAIT 5 // ms the NAT waits for datagrams before it looks for new public sockets
+
+extern "C" ssize_t __real_sendmsg(int fd, const struct msghdr* msg, int flags);
+extern "C" ssize_t __real_recvmsg(int fd, struct msghdr* msg, int flags);
+
+static std::mutex s_lock;
+static std::unordered_map<int, DPTestNat*> s_vSockets; // behind a NAT
+static thread_local DPTestNat* t_pEntering = nullptr;
+
+/*!
+* @brief A dual stack socket on loopback, its endpoints are v4 mapped like the ones of enet
+*/
+static int OpenPublic(uint16_t* port)
+{
+	int s = socket(AF_INET6, SOCK_DGRAM, 0);
+
+	if (s < 0)
+		return -1;
+
+	int off = 0;
+	setsockopt(s, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+
+	sockaddr_in6 a;
+	memset(&a, 0, sizeof(a));
+	a.sin6_family = AF_INET6;
+	inet_pton(AF_INET6, "::ffff:127.0.0.1", &a.sin6_addr);
+
+	socklen_t len = sizeof(a);
+
+	if (bind(s, (sockaddr*)&a, sizeof(a)) < 0 || getsockname(s, (sockaddr*)&a, &len) < 0)
+	{
+		close(s);
+		return -1;
+	}
+
+	fcntl(s, F_SETFL, O_NONBLOCK);
+	*port = ntohs(a.sin6_port);
+	return s;
+}
+
+static bool IsSame(const sockaddr_in6& a, const sockaddr_in6& b)
+{
+	return a.sin6_port == b.sin6_port && memcmp(&a.sin6_addr, &b.sin6_addr, sizeof(a.sin6_addr)) == 0;
+}
+
+DPTestNat::DPTestNat(Mapping mapping) : Forwarded(0), Dropped(0), Mappings(0), m_mapping(mapping), m_inside(-1), m_wInsidePort(0), m_bRun(false)
+{
+}
+
+DPTestNat::~DPTestNat()
+{
+	Stop();
+}
+
+bool DPTestNat::Start()
+{
+	m_inside = OpenPublic(&m_wInsidePort);
+
+	if (m_inside < 0)
+		return false;
+
+	m_bRun = true;
+	m_thread = std::thread(&DPTestNat::Loop, this);
+	return true;
+}
+
+void DPTestNat::Stop()
+{
+	m_bRun = false;
+
+	if (m_thread.joinable())
+		m_thread.join();
+
+	{
+		std::lock_guard<std::mutex> lock(s_lock);
+
+		for (auto it = s_vSockets.begin(); it != s_vSockets.end();)
+		{
+			if (it->second == this)
+				it = s_vSockets.erase(it);
+			else
+				++it;
+		}
+	}
+
+	for (auto& p : m_vPublic)
+		close(p->fd);
+
+	m_vPublic.clear();
+	m_vMap.clear();
+
+	if (m_inside >= 0)
+		close(m_inside);
+
+	m_inside = -1;
+}
+
+void DPTestNat::Enter()
+{
+	t_pEntering = this;
+}
+
+void DPTestNat::Leave()
+{
+	t_pEntering = nullptr;
+}
+
+DPTestNat* DPTestNat::Get(int fd)
+{
+	std::lock_guard<std::mutex> lock(s_lock);
+	auto it = s_vSockets.find(fd);
+
+	if (it != s_vSockets.end())
+		return it->second;
+
+	if (!t_pEntering)
+		return nullptr;
+
+	s_vSockets[fd] = t_pEntering;
+	return t_pEntering;
+}
+
+DPTestNat::Public* DPTestNat::GetPublic(int inside, const sockaddr_in6& to)
+{
+	std::string dest;
+
+	if (m_mapping == MAPPING_SYMMETRIC)
+		dest.assign((const char*)&to.sin6_addr, sizeof(to.sin6_addr)).append((const char*)&to.sin6_port, sizeof(to.sin6_port));
+
+	auto key = std::make_pair(inside, dest);
+	auto it = m_vMap.find(key);
+
+	if (it != m_vMap.end())
+		return it->second;
+
+	sockaddr_in6 local;
+	socklen_t len = sizeof(local);
+	uint16_t port;
+
+	if (getsockname(inside, (sockaddr*)&local, &len) < 0)
+		return nullptr;
+
+	if (!local.sin6_port)
+	{ // a client host is bound by its first send, and the NAT sends for it
+		local.sin6_addr = in6addr_any;
+
+		if (bind(inside, (sockaddr*)&local, sizeof(local)) < 0 || getsockname(inside, (sockaddr*)&local, &len) < 0)
+			return nullptr;
+	}
+
+	std::unique_ptr<Public> p(new Public());
+	p->fd = OpenPublic(&port);
+	p->inside = inside;
+	p->insidePort = ntohs(local.sin6_port);
+
+	if (p->fd < 0)
+		return nullptr;
+
+	Mappings++;
+	m_vMap[key] = p.get();
+	m_vPublic.push_back(std::move(p));
+	return m_vPublic.back().get();
+}
+
+bool DPTestNat::Send(int fd, const sockaddr_in6& to, const BYTE* data, size_t size)
+{
+	auto nat = Get(fd);
+
+	if (!nat)
+		return false;
+
+	std::lock_guard<std::mutex> lock(nat->m_lock);
+	auto p = nat->GetPublic(fd, to);
+
+	if (!p)
+		return true; // lost on the way out
+
+	bool known = false;
+
+	for (const auto& a : p->allowed)
+		known |= IsSame(a, to);
+
+	if (!known)
+		p->allowed.push_back(to);
+
+	sendto(p->fd, data, size, 0, (const sockaddr*)&to, sizeof(to));
+	return true;
+}
+
+void DPTestNat::Loop()
+{
+	std::vector<BYTE> buf(sizeof(sockaddr_in6) + 65536);
+
+	while (m_bRun)
+	{
+		std::vector<pollfd> fds;
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			for (const auto& p : m_vPublic)
+				fds.push_back({ p->fd, POLLIN, 0 });
+		}
+
+		if (fds.empty())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(DP_TEST_NAT_WAIT));
+			continue;
+		}
+
+		if (poll(fds.data(), fds.size(), DP_TEST_NAT_WAIT) <= 0)
+			continue;
+
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		for (size_t i = 0; i < fds.size(); i++)
+		{
+			if (!(fds[i].revents & POLLIN))
+				continue;
+
+			auto p = m_vPublic[i].get(); // only Stop removes them
+			sockaddr_in6 from;
+			socklen_t len;
+			ssize_t n;
+
+			while (len = sizeof(from), (n = recvfrom(p->fd, buf.data() + sizeof(from), buf.size() - sizeof(from), 0, (sockaddr*)&from, &len)) >= 0)
+			{
+				bool allowed = false;
+
+				for (const auto& a : p->allowed)
+					allowed |= IsSame(a, from);
+
+				if (!allowed)
+				{
+					Dropped++;
+					continue;
+				}
+
+				// the real source goes in front, the wrapped recvmsg takes it out
+				memcpy(buf.data(), &from, sizeof(from));
+
+				sockaddr_in6 to;
+				memset(&to, 0, sizeof(to));
+				to.sin6_family = AF_INET6;
+				to.sin6_port = htons(p->insidePort);
+				inet_pton(AF_INET6, "::ffff:127.0.0.1", &to.sin6_addr);
+
+				sendto(m_inside, buf.data(), sizeof(from) + (size_t)n, 0, (const sockaddr*)&to, sizeof(to));
+				Forwarded++;
+			}
+		}
+	}
+}
+
+extern "C" ssize_t __wrap_sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+	if (!msg->msg_name || msg->msg_namelen < sizeof(sockaddr_in6) || !DPTestNat::Get(fd))
+		return __real_sendmsg(fd, msg, flags);
+
+	std::vector<BYTE> data;
+
+	for (size_t i = 0; i < msg->msg_iovlen; i++)
+		data.insert(data.end(), (const BYTE*)msg->msg_iov[i].iov_base, (const BYTE*)msg->msg_iov[i].iov_base + msg->msg_iov[i].iov_len);
+
+	DPTestNat::Send(fd, *(const sockaddr_in6*)msg->msg_name, data.data(), data.size());
+	return (ssize_t)data.size();
+}
+
+extern "C" ssize_t __wrap_recvmsg(int fd, struct msghdr* msg, int flags)
+{
+	auto nat = DPTestNat::Get(fd);
+
+	if (!nat)
+		return __real_recvmsg(fd, msg, flags);
+
+	std::vector<BYTE> buf(sizeof(sockaddr_in6) + 65536);
+
+	for (;;)
+	{
+		sockaddr_in6 from;
+		iovec iov = { buf.data(), buf.size() };
+		msghdr hdr;
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.msg_name = &from;
+		hdr.msg_namelen = sizeof(from);
+		hdr.msg_iov = &iov;
+		hdr.msg_iovlen = 1;
+
+		auto n = __real_recvmsg(fd, &hdr, flags);
+
+		if (n < 0)
+			return n;
+
+		if (n < (ssize_t)sizeof(sockaddr_in6) || ntohs(from.sin6_port) != nat->GetInsidePort())
+		{ // straight to the private endpoint, a NAT has no mapping for it
+			nat->Dropped++;
+			continue;
+		}
+
+		if (msg->msg_name)
+		{
+			msg->msg_namelen = std::min<socklen_t>(msg->msg_namelen, sizeof(sockaddr_in6));
+			memcpy(msg->msg_name, buf.data(), msg->msg_namelen);
+		}
+
+		size_t size = (size_t)n - sizeof(sockaddr_in6), copied = 0;
+		msg->msg_flags = 0;
+
+		for (size_t i = 0; i < msg->msg_iovlen && copied < size; i++)
+		{
+			auto len = std::min(size - copied, msg->msg_iov[i].iov_len);
+			memcpy(msg->msg_iov[i].iov_base, buf.data() + sizeof(sockaddr_in6) + copied, len);
+			copied += len;
+		}
+
+		if (copied < size)
+			msg->msg_flags |= MSG_TRUNC;
+
+		return (ssize_t)copied;
+	}
+}
@@ -0,0 +1,84 @@
+/*!
+	@author Arves100
+	@file DPTestNat.h
+	@date 19/10/2026
+	@brief NAT of a game on loopback, for the tests of the rendezvous service
+*/
+#pragma once
+
+#include "DPTest.h"
+#include <map>
+
+/*!
+	@class DPTestNat
+	Userspace NAT in front of the enet sockets of the games that join it. The test links with
+	--wrap=sendmsg --wrap=recvmsg: a datagram of a socket behind the NAT leaves from a public socket
+	of the NAT, one per socket behind it (cone) or one per socket and destination (symmetric), and
+	a public socket only lets in the datagrams of the endpoints it sent to (port restricted).
+	What comes in reaches the socket behind the NAT from the NAT, the wrapped recvmsg gives enet the
+	real source and drops everything that did not go through the NAT.
+	The tests build enet without ENET_USE_MMSG, sendmsg and recvmsg are its only socket calls
+*/
+class DPTestNat
+{
+public:
+	enum Mapping
+	{
+		MAPPING_CONE, // one public endpoint for every destination
+		MAPPING_SYMMETRIC, // one public endpoint per destination
+	};
+
+	explicit DPTestNat(Mapping mapping);
+	~DPTestNat();
+
+	bool Start();
+	void Stop();
+
+	/*!
+	* @brief The sockets that first send from the calling thread go behind the NAT until Leave
+	*/
+	void Enter();
+	static void Leave();
+
+	// Statistics
+	std::atomic<DWORD> Forwarded; // to a socket behind the NAT
+	std::atomic<DWORD> Dropped; // unsolicited
+	std::atomic<DWORD> Mappings;
+
+	/*!
+	* @brief Sends the datagram of a socket behind the NAT from its public endpoint
+	* @return false if the socket is not behind a NAT
+	*/
+	static bool Send(int fd, const sockaddr_in6& to, const BYTE* data, size_t size);
+
+	/*!
+	* @return The NAT in front of a socket, nullptr if there is none
+	*/
+	static DPTestNat* Get(int fd);
+
+	/*!
+	* @brief Source of the datagrams the NAT hands to the sockets behind it
+	*/
+	uint16_t GetInsidePort() const { return m_wInsidePort; }
+
+private:
+	struct Public
+	{
+		int fd;
+		int inside; // socket behind the NAT
+		uint16_t insidePort;
+		std::vector<sockaddr_in6> allowed; // the endpoints it sent to
+	};
+
+	void Loop();
+	Public* GetPublic(int inside, const sockaddr_in6& to);
+
+	Mapping m_mapping;
+	int m_inside; // sends to the sockets behind the NAT
+	uint16_t m_wInsidePort;
+	std::map<std::pair<int, std::string>, Public*> m_vMap; // socket behind the NAT and destination, the destination is empty for a cone
+	std::vector<std::unique_ptr<Public>> m_vPublic;
+	std::mutex m_lock;
+	std::thread m_thread;
+	std::atomic<bool> m_bRun;
+};
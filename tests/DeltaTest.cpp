@@ -0,0 +1,148 @@
+/*!
+	@author Arves100
+	@file DeltaTest.cpp
+	@date 19/10/2026
+	@brief Round trips of the delta encoding over the traffic of a match with lost messages, with the bandwidth it saves and its cost
+*/
+#include "DPTest.h"
+#include "DPDelta.h"
+
+#define DELTA_TEST_PLAYERS 8
+#define DELTA_TEST_FRAMES 600
+#define DELTA_TEST_FRAME_TIME 3 // ms, so the acks come back every few frames like in a match
+
+/*!
+* @brief Sends the traffic of a match through a sender and a receiver
+* @param loss Per mille of the unreliable messages and of the acks that are lost
+*/
+static void Run(DWORD loss)
+{
+	auto traffic = DPTest::Record(DELTA_TEST_PLAYERS, DELTA_TEST_FRAMES);
+	DPDelta sender, receiver;
+
+	size_t raw = 0, sent = 0;
+	DWORD deltas = 0, lost = 0, delivered = 0, failed = 0, mismatches = 0, acks = 0;
+	std::chrono::nanoseconds encode(0), decode(0);
+	DWORD seed = 7;
+
+	auto drop = [&seed, loss]() {
+		seed = seed * 1103515245 + 12345;
+		return (seed >> 16) % 1000 < loss;
+	};
+
+	DWORD states = 0;
+
+	for (const auto& r : traffic)
+	{
+		if (!r.reliable && states++ % DELTA_TEST_PLAYERS == 0 && states > 1)
+		{ // a new frame, the acks of the previous one come back
+			receiver.UpdateAcks([&](ENetPacket* ack) {
+				if (drop())
+				{
+					enet_packet_destroy(ack);
+					return;
+				}
+
+				DPMsg am(ack, true);
+				sender.OnAck(am);
+				acks++;
+			});
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(DELTA_TEST_FRAME_TIME));
+		}
+
+		DPMsg msg(r.from, r.to, DPMSG_TYPE_GAME);
+		msg.SetFlags(r.reliable ? DPMSG_FLAG_GUARANTEED : 0);
+		msg.AddToSerialize((LPVOID)r.raw.data(), r.raw.size());
+		auto pk = msg.Serialize(r.reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
+
+		auto start = std::chrono::steady_clock::now();
+		auto out = sender.Encode(pk);
+		encode += std::chrono::steady_clock::now() - start;
+
+		raw += pk->dataLength;
+
+		if (!out)
+		{ // sent as it is
+			sent += pk->dataLength;
+			enet_packet_destroy(pk);
+			continue;
+		}
+
+		sent += out->dataLength;
+
+		if (out->dataLength < pk->dataLength + sizeof(DPDeltaInfo))
+			deltas++;
+
+		enet_packet_destroy(pk);
+
+		if (!r.reliable && drop())
+		{
+			lost++;
+			enet_packet_destroy(out);
+			continue;
+		}
+
+		DPMsg dm(out, true);
+
+		start = std::chrono::steady_clock::now();
+		auto m = receiver.Decode(dm);
+		decode += std::chrono::steady_clock::now() - start;
+
+		delivered++;
+
+		if (!m)
+			failed++;
+		else if (m->GetType() != DPMSG_TYPE_GAME || m->GetRawSize() != r.raw.size() || memcmp(m->GetRaw(), r.raw.data(), r.raw.size()) ||
+			m->IsReliable() != r.reliable)
+			mismatches++;
+	}
+
+	printf("%2u.%u%% lost: %zu -> %zu bytes (%.1f%%), %u/%zu sent as delta, %u lost, %u acks, encode %lld ns/msg, decode %lld ns/msg, failed %u, mismatches %u\n",
+		loss / 10, loss % 10, raw, sent, sent * 100.0 / raw, deltas, traffic.size(), lost, acks, (long long)(encode.count() / traffic.size()),
+		(long long)(decode.count() / delivered), failed, mismatches);
+
+	DP_CHECK(failed == 0); // a lost message is never the base of another one
+	DP_CHECK(mismatches == 0);
+	DP_CHECK(sent < raw);
+	DP_CHECK(deltas > traffic.size() / 2);
+}
+
+/*!
+* @brief A delta whose base the receiver does not have is refused
+*/
+static void RunUnknownBase()
+{
+	auto r = DPTest::Record(1, 1)[0];
+	DPDelta sender, receiver;
+	ENetPacket* out[2];
+
+	for (auto& o : out)
+	{ // the second one is sent against the first one
+		DPMsg msg(r.from, r.to, DPMSG_TYPE_GAME);
+		msg.SetFlags(DPMSG_FLAG_GUARANTEED);
+		msg.AddToSerialize(r.raw.data(), r.raw.size());
+		auto pk = msg.Serialize(ENET_PACKET_FLAG_RELIABLE);
+		o = sender.Encode(pk);
+		enet_packet_destroy(pk);
+	}
+
+	if (!DP_CHECK(out[0] && out[1]))
+		return;
+
+	DPMsg first(out[0], true), second(out[1], true);
+	DP_CHECK(second.GetRawSize() < first.GetRawSize());
+	DP_CHECK(receiver.Decode(second) == nullptr);
+
+	auto m = receiver.Decode(first);
+	DP_CHECK(m && m->GetRawSize() == r.raw.size() && !memcmp(m->GetRaw(), r.raw.data(), r.raw.size()));
+}
+
+int main()
+{
+	Run(0);
+	Run(50);
+	Run(200);
+	RunUnknownBase();
+	return DPTest::Result();
+}
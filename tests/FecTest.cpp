@@ -0,0 +1,101 @@
+/*!
+	@author Arves100
+	@file FecTest.cpp
+	@date 19/10/2026
+	@brief The parity turns on when a link loses unreliable messages, and rebuilds most of them
+*/
+#include "DPTest.h"
+#include "DPFlushPolicy.h"
+#include <algorithm>
+
+#define FEC_TEST_PORT 24980
+#define FEC_TEST_LOSS 0.05 // of the datagrams toward the host
+#define FEC_TEST_FRAME 16 // ms between two frames of the game
+#define FEC_TEST_MSGS 4 // unreliable updates sent every frame
+#define FEC_TEST_WARMUP 3000 // ms for the first reports to arrive and the group size to follow
+#define FEC_TEST_TIME 4000 // ms measured
+
+/*!
+* @brief Sends unreliable updates only, the loss enet sees on its reliable packets is the one of a few pings
+* @return Updates lost in the measured time, per mille
+*/
+static DWORD Run(bool fec)
+{
+	Globals::Get()->NetFec = fec;
+	Globals::Get()->NetFlushPolicy = DP_FLUSH_IMMEDIATE; // one update per datagram, a frame flush puts a whole group in a few of them
+
+	DPTestGame host("host"), game("game");
+	DPTestLink link;
+	std::atomic<bool> measuring(false);
+	DWORD first = 0, last = 0, received = 0; // written by the host thread only
+
+	DPTestLink::Direction up, down;
+	up.loss = FEC_TEST_LOSS;
+	link.SetUp(up, down);
+
+	if (!DP_CHECK(host.Host(4)) || !DP_CHECK(link.Start(FEC_TEST_PORT, FURFIGHTERS_PORT)))
+		return 1000;
+
+	host.Start(nullptr, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) {
+		auto p = (const DPTest::Payload*)data;
+
+		if (!measuring)
+			return;
+
+		if (received++ == 0)
+			first = last = p->seq;
+
+		first = std::min(first, p->seq); // a rebuilt one comes after the next of its group
+		last = std::max(last, p->seq);
+	});
+
+	char addr[32];
+	snprintf(addr, sizeof(addr), "127.0.0.1:%u", FEC_TEST_PORT);
+
+	if (!DP_CHECK(game.Join(addr)))
+		return 1000;
+
+	double next = 0;
+
+	game.Start([&](DPTestGame& g) {
+		if (DPTest::Now() < next)
+			return;
+
+		next = DPTest::Now() + FEC_TEST_FRAME;
+
+		for (int i = 0; i < FEC_TEST_MSGS; i++)
+			g.SendSeq(host.GetId(), 0, 1, 64);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(FEC_TEST_WARMUP));
+	measuring = true;
+	std::this_thread::sleep_for(std::chrono::milliseconds(FEC_TEST_TIME));
+	game.Stop();
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	measuring = false;
+	host.Stop();
+
+	DWORD sent = last - first + 1, lost = sent > received ? sent - received : 0;
+	DWORD loss = sent ? lost * 1000 / sent : 1000;
+
+	printf("fec %-3s: %u%% of the datagrams lost, %u updates of %u lost (%u per mille), lost sessions %u\n",
+		fec ? "on" : "off", (DWORD)(FEC_TEST_LOSS * 100), lost, sent, loss, game.SessionLost.load());
+
+	DP_CHECK(received > 0);
+	DP_CHECK(game.SessionLost == 0);
+
+	game.Close();
+	host.Close();
+	link.Stop();
+	return loss;
+}
+
+int main()
+{
+	auto off = Run(false);
+	auto on = Run(true);
+
+	// one update lost in a group is rebuilt, two are not: a fourth of the loss at most is left
+	DP_CHECK(on * 2 < off);
+	return DPTest::Result();
+}
@@ -0,0 +1,271 @@
+/*!
+	@author Arves100
+	@file FirewallTest.cpp
+	@date 19/10/2026
+	@brief Drops of the firewall of a host by reason, the cookie challenge with new and old clients, and the cost of the filter
+*/
+#include "DPTest.h"
+#include "DPFirewall.h"
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#define FIREWALL_TEST_PORT 47700
+#define FIREWALL_TEST_CONNECT 1000 // ms a client waits for the host
+#define FIREWALL_TEST_FLOOD 8000 // datagrams from one address, over the burst of the data rate
+#define FIREWALL_TEST_BATCH 100 // datagrams sent before the host reads them, they fit the socket buffer
+#define FIREWALL_TEST_FILTERED 1000000 // datagrams filtered to measure the cost
+
+/*!
+	Host with a firewall on loopback
+*/
+struct FirewallHost
+{
+	explicit FirewallHost(bool cookies)
+	{
+		ENetAddress address = {};
+		address.ipv6 = ENET_HOST_ANY;
+		address.port = FIREWALL_TEST_PORT;
+		host = enet_host_create(&address, 4, 1, 0, 0, 0);
+
+		if (host)
+		{
+			firewall.SetCookies(cookies);
+			firewall.Install(host);
+		}
+	}
+
+	~FirewallHost()
+	{
+		if (host)
+			enet_host_destroy(host);
+	}
+
+	void Service(DWORD ms)
+	{
+		ENetEvent e;
+		auto until = DPTest::Now() + ms;
+
+		do
+		{
+			while (enet_host_service(host, &e, 1) > 0)
+			{
+				if (e.type == ENET_EVENT_TYPE_CONNECT)
+					connects++;
+			}
+		} while (DPTest::Now() < until);
+	}
+
+	ENetHost* host;
+	DPFirewall firewall;
+	DWORD connects = 0;
+};
+
+/*!
+* @brief Connects a client to the host
+* @param answers The client has the firewall that answers the cookies, an older build does not
+* @param data Connect data, a wrong cookie goes over the connect type
+* @return true if the client connected
+*/
+static bool Connect(FirewallHost& h, bool answers, uint32_t data)
+{
+	auto client = enet_host_create(nullptr, 1, 1, 0, 0, 0);
+	DPFirewall firewall;
+
+	if (!DP_CHECK(client != nullptr))
+		return false;
+
+	if (answers)
+		firewall.Install(client);
+
+	ENetAddress to = {};
+	enet_address_set_ip(&to, "127.0.0.1");
+	to.port = FIREWALL_TEST_PORT;
+	enet_host_connect(client, &to, 1, data);
+
+	bool connected = false;
+	auto until = DPTest::Now() + FIREWALL_TEST_CONNECT;
+	ENetEvent e;
+
+	while (!connected && DPTest::Now() < until)
+	{
+		while (enet_host_service(client, &e, 0) > 0)
+		{
+			if (e.type == ENET_EVENT_TYPE_CONNECT)
+				connected = true;
+		}
+
+		h.Service(1);
+	}
+
+	enet_host_destroy(client);
+	h.Service(10);
+	return connected;
+}
+
+/*!
+* @brief A host without the cookies takes every client, one with the cookies only the ones that answer them
+*/
+static void RunCookies()
+{
+	{
+		FirewallHost h(false);
+
+		if (!DP_CHECK(h.host != nullptr))
+			return;
+
+		DP_CHECK(Connect(h, false, 0));
+		DP_CHECK(Connect(h, true, 0));
+		DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED) == 0);
+
+		printf("cookies off: %u connects, %u challenged\n", h.connects, h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED));
+		DP_CHECK(h.connects == 2);
+	}
+
+	FirewallHost h(true);
+
+	if (!DP_CHECK(h.host != nullptr))
+		return;
+
+	DP_CHECK(Connect(h, true, 0));
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED) >= 1); // again if enet sends the connect again before the answer
+
+	// the connect type survives the cookie
+	DP_CHECK(Connect(h, true, 0x1234 << DP_FIREWALL_COOKIE_SHIFT | 3));
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_COOKIE) >= 1);
+
+	auto challenged = h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED);
+	DP_CHECK(!Connect(h, false, 0)); // an older build cannot answer
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED) > challenged);
+
+	printf("cookies on: %u connects, %u challenged, %u bad cookies\n", h.connects, h.firewall.GetDrops(DP_FIREWALL_DROP_CHALLENGED),
+		h.firewall.GetDrops(DP_FIREWALL_DROP_COOKIE));
+	DP_CHECK(h.connects == 2);
+}
+
+/*!
+* @brief Datagrams that cannot come from the game, and a flood from one address
+*/
+static void RunDrops()
+{
+	FirewallHost h(false);
+
+	if (!DP_CHECK(h.host != nullptr))
+		return;
+
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in to = {};
+	to.sin_family = AF_INET;
+	to.sin_port = htons(FIREWALL_TEST_PORT);
+	to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	auto send = [&](const void* data, size_t len) { sendto(fd, data, len, 0, (sockaddr*)&to, sizeof(to)); };
+
+	// shorter than the enet header
+	BYTE shortHeader = 0;
+	send(&shortHeader, 1);
+
+	// a command past the end of the datagram
+	BYTE truncated[4] = { 0, 0, ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE, 0 };
+	send(truncated, sizeof(truncated));
+
+	// a message smaller than the header of the messages
+	BYTE tiny[offsetof(ENetProtocolHeader, sentTime) + sizeof(ENetProtocolSendUnreliable) + 1] = {};
+	auto cmd = (ENetProtocolSendUnreliable*)(tiny + offsetof(ENetProtocolHeader, sentTime));
+	cmd->header.command = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE;
+	cmd->dataLength = ENET_HOST_TO_NET_16(1);
+	send(tiny, sizeof(tiny));
+
+	h.Service(50);
+
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_MALFORMED) == 2);
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_MESSAGE) == 1);
+
+	for (int i = 0; i < FIREWALL_TEST_FLOOD; i += FIREWALL_TEST_BATCH)
+	{
+		for (int k = 0; k < FIREWALL_TEST_BATCH; k++)
+			send(tiny, sizeof(tiny));
+
+		h.Service(0);
+	}
+
+	h.Service(50);
+	close(fd);
+
+	DWORD total = 0;
+	printf("drops:");
+
+	for (int i = 0; i < DP_FIREWALL_DROP_MAX; i++)
+	{
+		printf(" %u %s", h.firewall.GetDrops((DPFirewallDrop)i), DPFirewall::GetDropName((DPFirewallDrop)i));
+		total += h.firewall.GetDrops((DPFirewallDrop)i);
+	}
+
+	printf(", %u passed\n", h.firewall.GetPassed());
+
+	// the bucket lets the burst through, the rest of the flood is over the rate
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_DATA_RATE) > 0);
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_MESSAGE) + h.firewall.GetDrops(DP_FIREWALL_DROP_DATA_RATE) <= FIREWALL_TEST_FLOOD + 1);
+	DP_CHECK(h.firewall.GetPassed() == 0);
+	DP_CHECK(total <= FIREWALL_TEST_FLOOD + 3);
+}
+
+/*!
+* @brief Cost of the filter per datagram, for a message that passes and for one dropped by the rate
+*/
+static void RunCost()
+{
+	FirewallHost h(false);
+
+	if (!DP_CHECK(h.host != nullptr))
+		return;
+
+	BYTE msg[offsetof(ENetProtocolHeader, sentTime) + sizeof(ENetProtocolSendUnreliable) + 64] = {};
+	auto cmd = (ENetProtocolSendUnreliable*)(msg + offsetof(ENetProtocolHeader, sentTime));
+	cmd->header.command = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE;
+	cmd->dataLength = ENET_HOST_TO_NET_16(64);
+
+	ENetAddress from = {};
+	enet_address_set_ip(&from, "10.0.0.1");
+	ENetEvent e;
+	DWORD passed = 0;
+
+	// a new address every datagram, so every one is looked up and passes
+	auto start = std::chrono::steady_clock::now();
+
+	for (DWORD i = 0; i < FIREWALL_TEST_FILTERED; i++)
+	{
+		from.ipv4.ip.s_addr = htonl(0x0A000000 | i);
+		h.host->serviceTime = i / 1000;
+
+		if (h.host->interceptCallback(h.host, &e, &from, msg, sizeof(msg)) == 0)
+			passed++;
+	}
+
+	double pass = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / FIREWALL_TEST_FILTERED;
+
+	// one address flooding, dropped by the rate after the burst
+	from.ipv4.ip.s_addr = htonl(0x0A000001);
+	start = std::chrono::steady_clock::now();
+
+	for (DWORD i = 0; i < FIREWALL_TEST_FILTERED; i++)
+		h.host->interceptCallback(h.host, &e, &from, msg, sizeof(msg));
+
+	double drop = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / FIREWALL_TEST_FILTERED;
+
+	printf("cost: %.0f ns per datagram that passes, %.0f ns per datagram dropped, %u rate drops\n", pass, drop, h.firewall.GetDrops(DP_FIREWALL_DROP_DATA_RATE));
+
+	DP_CHECK(passed == FIREWALL_TEST_FILTERED);
+	DP_CHECK(h.firewall.GetDrops(DP_FIREWALL_DROP_DATA_RATE) >= FIREWALL_TEST_FILTERED - DP_FIREWALL_DATA_BURST - 1);
+}
+
+int main()
+{
+	if (!DP_CHECK(enet_initialize() == 0))
+		return DPTest::Result();
+
+	RunCookies();
+	RunDrops();
+	RunCost();
+	enet_deinitialize();
+	return DPTest::Result();
+}
@@ -0,0 +1,125 @@
+/*!
+	@author Arves100
+	@file FlushBench.cpp
+	@date 19/10/2026
+	@brief One-way latency and datagrams of a game running at 60 fps with every flush policy
+*/
+#include "DPTest.h"
+#include "DPFlushPolicy.h"
+#include <algorithm>
+
+#define FLUSH_BENCH_PORT 24960
+#define FLUSH_BENCH_FRAME 16 // ms of a frame of the game
+#define FLUSH_BENCH_WORK 14 // ms of the frame the game spends without calling Receive
+#define FLUSH_BENCH_MSGS 4 // updates sent every frame
+#define FLUSH_BENCH_URGENT 4 // one urgent message every this many frames
+#define FLUSH_BENCH_TIME 3000 // ms of every run
+
+/*!
+* @brief Latencies of the messages of one stream, written by the receiving thread only
+*/
+struct FlushLatency
+{
+	std::vector<double> samples;
+
+	double Mean() const
+	{
+		double sum = 0;
+
+		for (auto s : samples)
+			sum += s;
+
+		return samples.empty() ? 0 : sum / samples.size();
+	}
+
+	double Percentile(double p)
+	{
+		if (samples.empty())
+			return 0;
+
+		std::sort(samples.begin(), samples.end());
+		return samples[(size_t)(p * (samples.size() - 1))];
+	}
+};
+
+struct FlushResult
+{
+	double normal;
+	double urgent;
+	double datagrams; // per second, both directions
+};
+
+static FlushResult Run(DWORD policy)
+{
+	static const char* names[DP_FLUSH_MAX] = { "service", "frame", "immediate" };
+
+	Globals::Get()->NetFlushPolicy = policy;
+
+	DPTestGame host("host"), game("game");
+	DPTestLink link;
+	FlushLatency normal, urgent;
+
+	if (!DP_CHECK(host.Host(4)) || !DP_CHECK(link.Start(FLUSH_BENCH_PORT, FURFIGHTERS_PORT)))
+		return {};
+
+	host.Start(nullptr, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) {
+		auto p = (const DPTest::Payload*)data;
+		(p->stream == 2 ? urgent : normal).samples.push_back(DPTest::Now() - p->sentAt);
+	});
+
+	char addr[32];
+	snprintf(addr, sizeof(addr), "127.0.0.1:%u", FLUSH_BENCH_PORT);
+
+	if (!DP_CHECK(game.Join(addr)))
+		return {};
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500)); // the join traffic is not counted
+	DWORD frames = 0;
+	double next = 0;
+
+	game.Start([&](DPTestGame& g) {
+		if (DPTest::Now() < next)
+			return;
+
+		next = DPTest::Now() + FLUSH_BENCH_FRAME;
+
+		for (int i = 0; i < FLUSH_BENCH_MSGS; i++)
+			g.SendSeq(host.GetId(), 0, 1, 64);
+
+		if (frames++ % FLUSH_BENCH_URGENT == 0)
+			g.SendSeq(host.GetId(), DPSEND_ASYNC, 2, 64, DPSEND_MAX_PRIORITY); // DirectPlay honours the priority of async sends only
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_BENCH_WORK)); // update and render
+	});
+
+	DWORD before = link.Forwarded;
+	std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_BENCH_TIME));
+	game.Stop();
+	auto datagrams = (double)(link.Forwarded - before) * 1000 / FLUSH_BENCH_TIME;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	host.Stop();
+
+	printf("%-9s: updates %5zu, one-way %5.1f ms mean %5.1f ms p99; urgent %4zu, %5.1f ms mean %5.1f ms p99; %4.0f datagrams/s\n",
+		names[policy], normal.samples.size(), normal.Mean(), normal.Percentile(0.99), urgent.samples.size(), urgent.Mean(), urgent.Percentile(0.99), datagrams);
+
+	DP_CHECK(!normal.samples.empty() && !urgent.samples.empty());
+
+	game.Close();
+	host.Close();
+	link.Stop();
+	return { normal.Mean(), urgent.Mean(), datagrams };
+}
+
+int main()
+{
+	FlushResult r[DP_FLUSH_MAX];
+
+	for (DWORD p = 0; p < DP_FLUSH_MAX; p++)
+		r[p] = Run(p);
+
+	// the frame policy sends one coalesced datagram per frame, but the urgent messages as soon as immediate does
+	DP_CHECK(r[DP_FLUSH_FRAME].datagrams < r[DP_FLUSH_IMMEDIATE].datagrams);
+	DP_CHECK(r[DP_FLUSH_FRAME].urgent < r[DP_FLUSH_FRAME].normal);
+	return DPTest::Result();
+}
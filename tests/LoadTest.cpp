@@ -0,0 +1,101 @@
+/*!
+	@author Arves100
+	@file LoadTest.cpp
+	@date 19/10/2026
+	@brief A host and 64 clients in one process, every DirectPlay object with its own network context
+*/
+#include "DPTest.h"
+#include "DPContext.h"
+#include <memory>
+
+#define LOAD_TEST_CLIENTS 64
+#define LOAD_TEST_MSGS 1000 // guaranteed messages every client sends to the host
+#define LOAD_TEST_SIZE 64 // bytes of a message
+#define LOAD_TEST_FRAME 16 // ms between two frames of a client, a game at 60 fps
+#define LOAD_TEST_PER_FRAME 4 // messages a client sends every frame
+#define LOAD_TEST_TIME 60000 // ms for the host to get them all
+
+static void Run(bool shared)
+{
+	Globals::Get()->NetSharedMemory = shared;
+
+	DPTestGame host("host");
+	std::vector<std::unique_ptr<DPTestGame>> clients;
+
+	if (!DP_CHECK(host.Host(LOAD_TEST_CLIENTS + 1)))
+		return;
+
+	host.Start();
+
+	auto start = DPTest::Now();
+
+	for (int i = 0; i < LOAD_TEST_CLIENTS; i++)
+	{
+		clients.emplace_back(new DPTestGame("client"));
+
+		if (!DP_CHECK(clients.back()->Join("127.0.0.1")))
+			return;
+	}
+
+	auto joined = DPTest::Now() - start;
+	auto contexts = DPContext::GetContexts();
+
+	start = DPTest::Now();
+
+	for (auto& c : clients)
+	{
+		auto sent = std::make_shared<DWORD>(0);
+		auto next = std::make_shared<double>(0);
+
+		c->Start([sent, next, &host](DPTestGame& g) {
+			if (DPTest::Now() < *next)
+				return;
+
+			*next = DPTest::Now() + LOAD_TEST_FRAME;
+
+			for (int i = 0; i < LOAD_TEST_PER_FRAME && *sent < LOAD_TEST_MSGS; i++)
+			{
+				if (g.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, LOAD_TEST_SIZE) == DP_OK)
+					(*sent)++;
+			}
+		});
+	}
+
+	const DWORD expected = LOAD_TEST_CLIENTS * LOAD_TEST_MSGS;
+	auto until = DPTest::Now() + LOAD_TEST_TIME;
+
+	while (host.GameReceived < expected && DPTest::Now() < until)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	auto elapsed = DPTest::Now() - start;
+	DWORD lost = 0;
+
+	for (auto& c : clients)
+		lost += c->SessionLost;
+
+	printf("%-6s: %u clients joined in %.2f s, %zu contexts alive, %u/%u messages received in %.2f s (%.0f msgs/s), lost sessions %u\n",
+		shared ? "shared" : "enet", LOAD_TEST_CLIENTS, joined / 1000, contexts, host.GameReceived.load(), expected, elapsed / 1000,
+		host.GameReceived * 1000.0 / elapsed, lost);
+
+	DP_CHECK(contexts == LOAD_TEST_CLIENTS + 1);
+	DP_CHECK(host.GameReceived == expected);
+	DP_CHECK(lost == 0);
+
+	for (auto& c : clients)
+		c->Close();
+
+	host.Close();
+}
+
+int main()
+{
+	// every client comes from 127.0.0.1, the connect limit of one address would let 4 of them join per second
+	Globals::Get()->NetTrustLoopback = true;
+
+	Run(false);
+	Run(true);
+
+	printf("%zu contexts alive after the teardown\n", DPContext::GetContexts());
+	DP_CHECK(DPContext::GetContexts() == 0);
+	return DPTest::Result();
+}
@@ -0,0 +1,151 @@
+/*!
+	@author Arves100
+	@file MigrateTest.cpp
+	@date 19/10/2026
+	@brief A session of four players survives the loss of its host
+*/
+#include "DPTest.h"
+
+#define MIGRATE_TEST_CLIENTS 3
+#define MIGRATE_TEST_INTERVAL 50 // ms between the guaranteed broadcasts of every player
+#define MIGRATE_TEST_BEFORE 1000 // ms of traffic before the host goes
+#define MIGRATE_TEST_QUIT_LIMIT 3000 // switch-over allowed when the host quits
+#define MIGRATE_TEST_CRASH_LIMIT 20000 // when it crashes: the peer timeout (TIMEOUT3 at most), the resume attempts and the rejoin
+
+/*!
+* @brief What one player got from the others since the host left
+*/
+struct MigratePlayer
+{
+	std::unique_ptr<DPTestGame> game;
+	std::mutex lock;
+	std::unordered_map<DPID, double> firstAfter; // first broadcast of every other player sent after the loss
+	std::unordered_map<DPID, DWORD> next; // next sequence from every other player
+	DWORD wrong = 0;
+};
+
+static void Run(bool crash)
+{
+	std::unique_ptr<DPTestGame> host(new DPTestGame("host"));
+	MigratePlayer players[MIGRATE_TEST_CLIENTS];
+	std::atomic<double> lostAt(1e300);
+	std::atomic<bool> sending(true);
+
+	if (!DP_CHECK(host->Host(MIGRATE_TEST_CLIENTS + 1)))
+		return;
+
+	host->Start();
+
+	for (int i = 0; i < MIGRATE_TEST_CLIENTS; i++)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "player%d", i + 1);
+		players[i].game.reset(new DPTestGame(name));
+
+		if (!DP_CHECK(players[i].game->Join("127.0.0.1")))
+			return;
+	}
+
+	for (auto& p : players)
+	{
+		auto pp = &p;
+		auto nextSend = std::make_shared<double>(0);
+
+		p.game->Start([&sending, nextSend](DPTestGame& g) {
+			if (sending && DPTest::Now() >= *nextSend)
+			{
+				g.SendSeq(DPID_ALLPLAYERS, DPSEND_GUARANTEED, g.GetId(), 64);
+				*nextSend = DPTest::Now() + MIGRATE_TEST_INTERVAL;
+			}
+		}, [pp, &lostAt](DPTestGame&, DPID from, const BYTE* data, DWORD size) {
+			auto m = (const DPTest::Payload*)data;
+			std::lock_guard<std::mutex> lock(pp->lock);
+
+			if (!pp->next.count(from))
+				pp->next[from] = m->seq; // the stream started before we joined
+
+			if (m->seq != pp->next[from])
+				pp->wrong++;
+
+			pp->next[from] = m->seq + 1;
+
+			if (m->sentAt > lostAt && !pp->firstAfter.count(from))
+				pp->firstAfter[from] = DPTest::Now();
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(MIGRATE_TEST_BEFORE));
+
+	// the host goes away
+	lostAt = DPTest::Now();
+
+	if (crash)
+		host->Crash();
+
+	host.reset();
+
+	auto limit = crash ? MIGRATE_TEST_CRASH_LIMIT : MIGRATE_TEST_QUIT_LIMIT;
+	double switched = 0;
+	auto successor = &players[0]; // the lowest id
+
+	while (!switched && DPTest::Now() - lostAt < limit + 5000)
+	{
+		double last = 0;
+		bool all = true;
+
+		for (auto& p : players)
+		{
+			std::lock_guard<std::mutex> lock(p.lock);
+
+			for (auto& o : players)
+			{ // the session is a star, the players only hear the host
+				if (&o == &p || (&p != successor && &o != successor))
+					continue;
+
+				auto it = p.firstAfter.find(o.game->GetId());
+
+				if (it == p.firstAfter.end())
+					all = false;
+				else if (it->second > last)
+					last = it->second;
+			}
+		}
+
+		if (all)
+			switched = last - lostAt;
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	sending = false;
+
+	DWORD lost = 0, changed = 0, destroyed = 0, wrong = 0;
+
+	for (auto& p : players)
+	{
+		lost += p.game->SessionLost;
+		changed += p.game->HostChanged;
+		destroyed += p.game->PlayersDestroyed;
+		std::lock_guard<std::mutex> lock(p.lock);
+		wrong += p.wrong;
+	}
+
+	printf("host %-7s: the new host and the players hear each other %5.0f ms later (limit %u), new hosts %u, lost sessions %u, destroyed players %u, gaps %u\n",
+		crash ? "crashes" : "quits", switched, limit, changed, lost, destroyed, wrong);
+
+	DP_CHECK(switched > 0 && switched < limit);
+	DP_CHECK(changed == 1);
+	DP_CHECK(lost == 0);
+	DP_CHECK(destroyed == MIGRATE_TEST_CLIENTS); // only the player of the old host
+	DP_CHECK(wrong == 0); // what was sent while migrating is replayed to the new host
+
+	for (auto& p : players)
+		p.game->Close();
+}
+
+int main()
+{
+	Run(false);
+	Run(true);
+	return DPTest::Result();
+}
@@ -0,0 +1,113 @@
+/*!
+	@author Arves100
+	@file NatTest.cpp
+	@date 19/10/2026
+	@brief A player joins a game host with its session code through cone and symmetric NATs
+*/
+#include "DPTest.h"
+#include "DPTestNat.h"
+#include "DPRendezvous.h"
+#include "../relay/DPRendezvousServer.h"
+
+#define NAT_TEST_CODE "NATTEST"
+#define NAT_TEST_MSGS 50 // reliable messages the player sends once joined
+#define NAT_TEST_WAIT 1000 // ms for them to arrive
+
+static const char* MappingName(DPTestNat::Mapping m)
+{
+	return m == DPTestNat::MAPPING_CONE ? "cone" : "symmetric";
+}
+
+/*!
+* @return ms the join took, 0 if it failed
+*/
+static double Run(DPTestNat::Mapping hostMapping, DPTestNat::Mapping playerMapping, const char* code)
+{
+	DPTestNat hostNat(hostMapping), playerNat(playerMapping);
+	DPTestGame host("host"), game("game");
+
+	if (!DP_CHECK(hostNat.Start() && playerNat.Start()))
+		return 0;
+
+	hostNat.Enter();
+	auto hosting = host.Host(4);
+	DPTestNat::Leave();
+
+	if (!DP_CHECK(hosting))
+		return 0;
+
+	host.Start();
+
+	auto start = DPTest::Now();
+	playerNat.Enter();
+	auto joined = game.Join(code);
+	DPTestNat::Leave();
+	auto elapsed = DPTest::Now() - start;
+
+	DWORD sent = 0;
+
+	if (joined)
+	{
+		game.Start([&](DPTestGame& g) {
+			if (sent < NAT_TEST_MSGS && g.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, 64) == DP_OK)
+				sent++;
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(NAT_TEST_WAIT));
+		game.Stop();
+	}
+
+	printf("%-9s host, %-9s player, code %-8s: %s in %6.0f ms, %u of %u messages, public endpoints %u and %u, unsolicited datagrams dropped %u and %u\n",
+		MappingName(hostMapping), MappingName(playerMapping), code, joined ? "joined" : "failed", elapsed, host.GameReceived.load(), NAT_TEST_MSGS,
+		hostNat.Mappings.load(), playerNat.Mappings.load(), hostNat.Dropped.load(), playerNat.Dropped.load());
+
+	if (joined)
+	{
+		DP_CHECK(host.GameReceived == NAT_TEST_MSGS);
+		DP_CHECK(game.SessionLost == 0);
+	}
+
+	game.Close();
+	host.Close();
+	hostNat.Stop();
+	playerNat.Stop();
+	return joined ? elapsed : 0;
+}
+
+int main()
+{
+	strcpy(Globals::Get()->NetRendezvousServer, "127.0.0.1"); // on DP_RENDEZVOUS_PORT
+	strcpy(Globals::Get()->NetSessionCode, NAT_TEST_CODE);
+
+	enet_initialize();
+
+	DPRendezvousServer server;
+
+	if (!DP_CHECK(server.Create(DP_RENDEZVOUS_PORT)))
+		return DPTest::Result();
+
+	std::atomic<bool> run(true);
+	std::thread service([&]() {
+		while (run)
+			server.Service(5);
+	});
+
+	auto cone = Run(DPTestNat::MAPPING_CONE, DPTestNat::MAPPING_CONE, NAT_TEST_CODE);
+	auto symPlayer = Run(DPTestNat::MAPPING_CONE, DPTestNat::MAPPING_SYMMETRIC, NAT_TEST_CODE);
+	auto symHost = Run(DPTestNat::MAPPING_SYMMETRIC, DPTestNat::MAPPING_CONE, NAT_TEST_CODE);
+	auto symBoth = Run(DPTestNat::MAPPING_SYMMETRIC, DPTestNat::MAPPING_SYMMETRIC, NAT_TEST_CODE);
+	auto unknown = Run(DPTestNat::MAPPING_CONE, DPTestNat::MAPPING_CONE, "NOSUCH");
+
+	run = false;
+	service.join();
+	server.Dump();
+	enet_deinitialize();
+
+	// the punches of two cones meet, a symmetric NAT needs the relay of the service once the punching timed out
+	DP_CHECK(cone > 0 && cone < DP_RENDEZVOUS_PUNCH_TIME);
+	DP_CHECK(symPlayer >= DP_RENDEZVOUS_PUNCH_TIME);
+	DP_CHECK(symHost >= DP_RENDEZVOUS_PUNCH_TIME);
+	DP_CHECK(symBoth >= DP_RENDEZVOUS_PUNCH_TIME);
+	DP_CHECK(unknown == 0);
+	return DPTest::Result();
+}
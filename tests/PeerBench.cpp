@@ -0,0 +1,167 @@
+/*!
+	@author Arves100
+	@file PeerBench.cpp
+	@date 19/10/2026
+	@brief Cost of a service of an enet host with 64, 512 and 4000 connected peers, of which only a few send
+*/
+#include "DPTest.h"
+
+#define PEER_BENCH_PORT 24990
+#define PEER_BENCH_ACTIVE 8 // peers that send every loop, the others are idle
+#define PEER_BENCH_CONNECT_BATCH 256 // connections started at once, the socket buffers hold their handshakes
+#define PEER_BENCH_LOOPS 5000
+#define PEER_BENCH_IDLE 60000 // ms between two pings, the idle peers stay idle while measured
+#define PEER_BENCH_PING 100 // ms, the interval a peer switches to while it's idle
+
+/*!
+* @brief Services a host and throws its events away
+*/
+static void Drain(ENetHost* host)
+{
+	ENetEvent evt;
+
+	while (enet_host_service(host, &evt, 0) > 0)
+	{
+		if (evt.type == ENET_EVENT_TYPE_RECEIVE)
+			enet_packet_destroy(evt.packet);
+	}
+}
+
+/*!
+* @return Microseconds of a service of the server
+*/
+static double Run(size_t peers)
+{
+	ENetAddress addr;
+	memset(&addr, 0, sizeof(addr));
+	enet_address_set_ip(&addr, "127.0.0.1");
+	addr.port = PEER_BENCH_PORT;
+
+	// both ends in one host each, the client connects to the server many times
+	auto server = enet_host_create(&addr, peers, 1, 0, 0, ENET_HOST_BUFFER_SIZE_MAX);
+	auto client = enet_host_create(nullptr, peers, 1, 0, 0, ENET_HOST_BUFFER_SIZE_MAX);
+
+	if (!DP_CHECK(server && client))
+		return 0;
+
+	std::vector<ENetPeer*> out;
+
+	for (size_t i = 0; i < peers; i++)
+	{
+		out.push_back(enet_host_connect(client, &addr, 1, 0));
+
+		if (out.size() % PEER_BENCH_CONNECT_BATCH == 0 || out.size() == peers)
+		{
+			auto until = DPTest::Now() + 5000;
+
+			while (DPTest::Now() < until && server->connectedPeers < out.size())
+			{
+				Drain(client);
+				Drain(server);
+			}
+		}
+	}
+
+	DP_CHECK(server->connectedPeers == peers);
+
+	for (size_t i = 0; i < peers; i++)
+	{
+		enet_peer_ping_interval(out[i], PEER_BENCH_IDLE);
+		enet_peer_timeout(out[i], 0, PEER_BENCH_IDLE * 2, PEER_BENCH_IDLE * 2);
+		enet_peer_ping_interval(&server->peers[i], PEER_BENCH_IDLE);
+		enet_peer_timeout(&server->peers[i], 0, PEER_BENCH_IDLE * 2, PEER_BENCH_IDLE * 2);
+	}
+
+	BYTE data[64] = { 0 };
+	double busy = 0;
+
+	for (int loop = 0; loop < PEER_BENCH_LOOPS; loop++)
+	{
+		for (size_t i = 0; i < PEER_BENCH_ACTIVE && i < peers; i++)
+			enet_peer_send(out[i], 0, enet_packet_create(data, sizeof(data), ENET_PACKET_FLAG_RELIABLE));
+
+		Drain(client);
+
+		// the server acks what it got, the acks and the sends are the only work
+		auto start = DPTest::Now();
+		Drain(server);
+		busy += DPTest::Now() - start;
+	}
+
+	auto us = busy * 1000 / PEER_BENCH_LOOPS;
+	printf("%4zu peers, %u sending: %6.1f us per service of the server\n", peers, PEER_BENCH_ACTIVE, us);
+
+	enet_host_destroy(client);
+	enet_host_destroy(server);
+	return us;
+}
+
+/*!
+* @brief An idle peer whose ping interval gets shorter pings on the new interval, not on the deadline it was idle for
+*/
+static void RunRebucket()
+{
+	ENetAddress addr;
+	memset(&addr, 0, sizeof(addr));
+	enet_address_set_ip(&addr, "127.0.0.1");
+	addr.port = PEER_BENCH_PORT;
+
+	auto server = enet_host_create(&addr, 1, 1, 0, 0, 0);
+	auto client = enet_host_create(nullptr, 1, 1, 0, 0, 0);
+
+	if (!DP_CHECK(server && client))
+		return;
+
+	auto peer = enet_host_connect(client, &addr, 1, 0);
+	auto until = DPTest::Now() + 1000;
+
+	while (DPTest::Now() < until && server->connectedPeers < 1)
+	{
+		Drain(client);
+		Drain(server);
+	}
+
+	// only the client pings, the server gets nothing else
+	enet_peer_ping_interval(peer, PEER_BENCH_IDLE);
+	enet_peer_ping_interval(&server->peers[0], PEER_BENCH_IDLE);
+
+	// past the deadline of the default interval, so the client is idle until the long one
+	for (until = DPTest::Now() + ENET_PEER_PING_INTERVAL * 2; DPTest::Now() < until; std::this_thread::sleep_for(std::chrono::milliseconds(1)))
+	{
+		Drain(client);
+		Drain(server);
+	}
+
+	auto before = server->totalReceivedPackets;
+	enet_peer_ping_interval(peer, PEER_BENCH_PING); // like the timeout policy on a fast link
+
+	for (until = DPTest::Now() + PEER_BENCH_PING * 5; DPTest::Now() < until; std::this_thread::sleep_for(std::chrono::milliseconds(1)))
+	{
+		Drain(client);
+		Drain(server);
+	}
+
+	auto pings = server->totalReceivedPackets - before;
+	printf("ping interval from %u to %u ms on an idle peer: %u pings in %u ms\n", PEER_BENCH_IDLE, PEER_BENCH_PING, pings, PEER_BENCH_PING * 5);
+	DP_CHECK(pings >= 3);
+
+	enet_host_destroy(client);
+	enet_host_destroy(server);
+}
+
+int main()
+{
+	enet_initialize();
+
+	RunRebucket();
+
+	auto few = Run(64);
+	Run(512);
+	auto many = Run(4000);
+
+	enet_deinitialize();
+
+	// the idle peers wait in the timer wheel, a service walks only the active ones
+	DP_CHECK(many < few * 3);
+	return DPTest::Result();
+}
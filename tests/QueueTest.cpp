@@ -0,0 +1,274 @@
+/*!
+	@author Arves100
+	@file QueueTest.cpp
+	@date 19/10/2026
+	@brief The receive queue keeps the guaranteed messages, drops the others and stops growing when the game does not read
+*/
+#include "DPTest.h"
+#include "DPMsgQueue.h"
+#include "DPTimeoutPolicy.h"
+
+#define QUEUE_TEST_SIZE 1000
+#define QUEUE_TEST_MSGS 200000
+#define QUEUE_TEST_FULL_TIME (TIMEOUT3 + 2000) // ms the queue stays full, longer than the peer timeout
+#define QUEUE_TEST_BURST 5 // guaranteed messages the host sends every 5 ms, the queue is full in about 4 s
+#define QUEUE_TEST_FILL 10000 // ms for the queue to fill
+#define QUEUE_TEST_DRAIN 10000 // ms for the game to read them all
+
+/*!
+* @brief A chatty host: every message of a broadcast arrives in a reliable packet, only one in ten is guaranteed
+*/
+static void RunChatty()
+{
+	DPMsgPool pool;
+	DPMsgQueue queue;
+	std::vector<BYTE> data(QUEUE_TEST_SIZE);
+	DWORD guaranteed = 0, pushed = 0;
+
+	auto start = DPTest::Now();
+
+	while (!queue.IsFull() && pushed < QUEUE_TEST_MSGS)
+	{
+		bool g = (pushed % 10) == 0;
+		queue.push_back(std::make_shared<DPMsg>(1, 0, g, data.data(), QUEUE_TEST_SIZE, &pool));
+		guaranteed += g;
+		pushed++;
+	}
+
+	auto full = DPTest::Now() - start;
+
+	// once full only unreliable ones can come, the session leaves the rest in enet
+	start = DPTest::Now();
+
+	for (int i = 0; i < QUEUE_TEST_MSGS; i++)
+		queue.push_back(std::make_shared<DPMsg>(1, 0, false, data.data(), QUEUE_TEST_SIZE, &pool));
+
+	auto unreliable = DPTest::Now() - start;
+
+	printf("full after %u messages in %.0f ms: %u guaranteed kept of %u, %u unreliable kept, %u dropped, %u more unreliable in %.0f ms\n",
+		pushed, full, (DWORD)queue.GetCount(DP_MSG_CATEGORY_RELIABLE), guaranteed, (DWORD)queue.GetCount(DP_MSG_CATEGORY_UNRELIABLE),
+		queue.GetDropped(DP_MSG_CATEGORY_UNRELIABLE), QUEUE_TEST_MSGS, unreliable);
+
+	DP_CHECK(queue.IsFull());
+	DP_CHECK(queue.GetCount(DP_MSG_CATEGORY_RELIABLE) == guaranteed);
+	DP_CHECK(queue.GetBytes(DP_MSG_CATEGORY_UNRELIABLE) <= DP_QUEUE_MAX_UNRELIABLE_BYTES);
+	DP_CHECK(queue.GetCount(DP_MSG_CATEGORY_RELIABLE) <= DP_QUEUE_MAX_GUARANTEED_MSGS);
+	DP_CHECK(queue.GetTotalBytes() <= DP_QUEUE_MAX_GUARANTEED_BYTES + DP_QUEUE_MAX_UNRELIABLE_BYTES + QUEUE_TEST_SIZE * 2);
+	DP_CHECK(unreliable < 2000); // no walk over the kept messages for every push
+
+	// the game reads some, in order, and there is room again
+	DWORD next = 0, wrong = 0;
+
+	for (auto it = queue.begin(); it != queue.end() && queue.IsFull();)
+	{
+		if ((*it)->IsGuaranteed() && (*it)->GetRaw() && next++ > guaranteed)
+			wrong++;
+
+		it = queue.erase(it);
+	}
+
+	DP_CHECK(!queue.IsFull());
+	DP_CHECK(wrong == 0);
+
+	queue.clear();
+	DP_CHECK(queue.size() == 0 && queue.GetTotalBytes() == 0);
+}
+
+/*!
+* @brief The older builds leave garbage in the byte of the header flags, their messages are classified on the reliability of the packet
+*/
+static void RunLegacyFlags()
+{
+	for (bool reliable : { false, true })
+	{
+		auto pk = DPMsg(1, 0, DPMSG_TYPE_GAME).Serialize(reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
+		pk->data[sizeof(DPID) * 2 + 1] = 0xFF; // what was the padding after the type
+
+		DPMsg msg(pk, false);
+		DP_CHECK(msg.IsGuaranteed()); // read as is
+		msg.SetLegacyFlags();
+		DP_CHECK(msg.IsGuaranteed() == reliable);
+
+		DPMsg::SetLegacyFlags(pk); // the relay forwards the packet
+		DP_CHECK(DPMsg(pk, false).IsGuaranteed() == reliable);
+
+		enet_packet_destroy(pk);
+	}
+}
+
+/*!
+* @brief A host that broadcasts unreliable messages keeps sending while the game does not read for a while
+*/
+static void RunStall()
+{
+	DPTestGame host("host"), game("game");
+	std::atomic<bool> sending(true);
+
+	if (!DP_CHECK(host.Host(4)))
+		return;
+
+	double next = 0;
+	std::atomic<DWORD> sent(0);
+
+	host.Start([&](DPTestGame& g) {
+		if (sending && DPTest::Now() >= next)
+		{
+			for (int i = 0; i < 10; i++)
+				g.SendSeq(DPID_ALLPLAYERS, 0, 1, QUEUE_TEST_SIZE);
+
+			if (g.SendSeq(DPID_ALLPLAYERS, DPSEND_GUARANTEED, 2, 64) == DP_OK)
+				sent++;
+			next = DPTest::Now() + 5;
+		}
+	});
+
+	if (!DP_CHECK(game.Join("127.0.0.1")))
+		return;
+
+	auto joined = sent.load();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(2000)); // the game is loading, nobody reads
+	sending = false;
+
+	std::atomic<DWORD> guaranteed(0), wrong(0), first(0);
+	DWORD expected = 0;
+
+	game.Start(nullptr, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) {
+		auto p = (const DPTest::Payload*)data;
+
+		if (p->stream != 2)
+			return;
+
+		if (guaranteed == 0)
+			first = expected = p->seq; // what the host sent before we joined is not for us
+
+		if (p->seq != expected++)
+			wrong++;
+
+		guaranteed++;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(8000));
+
+	printf("game stalled for 2 s: %u guaranteed messages received of the %u sent since the first one, out of order %u, lost sessions %u\n",
+		guaranteed.load(), sent - first, wrong.load(), game.SessionLost.load());
+
+	DP_CHECK(first <= joined); // everything sent once the game joined
+	DP_CHECK(guaranteed == sent - first);
+	DP_CHECK(wrong == 0);
+	DP_CHECK(game.SessionLost == 0);
+
+	game.Close();
+	host.Close();
+}
+
+/*!
+* @brief A game that keeps calling Receive but only looks for the messages of a player it does not have: its queue stays full
+* for longer than the peer timeout, the session goes on and the guaranteed messages wait in enet
+*/
+static void RunFull()
+{
+	DPTestGame host("host"), game("game");
+	std::atomic<bool> sending(true);
+	std::atomic<DWORD> sent(0);
+
+	if (!DP_CHECK(host.Host(4)))
+		return;
+
+	double next = 0;
+
+	host.Start([&](DPTestGame& g) {
+		if (sending && DPTest::Now() >= next)
+		{
+			for (int i = 0; i < QUEUE_TEST_BURST; i++)
+			{
+				if (g.SendSeq(DPID_ALLPLAYERS, DPSEND_GUARANTEED, 2, 64) == DP_OK)
+					sent++;
+			}
+
+			next = DPTest::Now() + 5;
+		}
+	});
+
+	if (!DP_CHECK(game.Join("127.0.0.1")))
+		return;
+
+	auto joined = sent.load();
+	auto until = DPTest::Now() + QUEUE_TEST_FILL;
+	auto nextSend = DPTest::Now();
+	std::vector<BYTE> buf(64 * 1024);
+	DWORD toHost = 0, queued = 0;
+	bool full = false;
+
+	while (DPTest::Now() < until)
+	{
+		if (!full && game.GetDP().GetMessageQueue(0, 0, DPMESSAGEQUEUE_RECEIVE, &queued, nullptr) == DP_OK && queued >= DP_QUEUE_MAX_GUARANTEED_MSGS)
+		{
+			full = true;
+			until = DPTest::Now() + QUEUE_TEST_FULL_TIME;
+		}
+
+ // the game sends too, the host gets it only while the session is serviced
+		if (DPTest::Now() >= nextSend && game.SendSeq(host.GetId(), DPSEND_GUARANTEED, 3, 64) == DP_OK)
+		{
+			toHost++;
+			nextSend = DPTest::Now() + 100;
+		}
+
+		DPID from = 0, to = 0xFFFFFFF0; // nobody
+		auto size = (DWORD)buf.size();
+		game.GetDP().Receive(&from, &to, DPRECEIVE_TOPLAYER, buf.data(), &size);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	game.GetDP().GetMessageQueue(0, 0, DPMESSAGEQUEUE_RECEIVE, &queued, nullptr);
+	sending = false;
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	auto hostGot = host.GameReceived.load();
+
+	std::atomic<DWORD> guaranteed(0), wrong(0), first(0);
+	DWORD expected = 0;
+
+	game.Start(nullptr, [&](DPTestGame&, DPID, const BYTE* data, DWORD) {
+		auto p = (const DPTest::Payload*)data;
+
+		if (p->stream != 2)
+			return;
+
+		if (guaranteed == 0)
+			first = expected = p->seq;
+
+		if (p->seq != expected++)
+			wrong++;
+
+		guaranteed++;
+	});
+
+	auto drain = DPTest::Now() + QUEUE_TEST_DRAIN;
+
+	while ((guaranteed == 0 || guaranteed < sent - first) && DPTest::Now() < drain)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	printf("queue full for %u s: %u messages queued, host got %u of %u from the game meanwhile, then %u guaranteed received of the %u sent since the first one, out of order %u, lost sessions %u, players destroyed %u\n",
+		QUEUE_TEST_FULL_TIME / 1000, queued, hostGot, toHost, guaranteed.load(), sent - first, wrong.load(), game.SessionLost.load(), host.PlayersDestroyed.load());
+
+	DP_CHECK(queued >= DP_QUEUE_MAX_GUARANTEED_MSGS);
+	DP_CHECK(hostGot == toHost); // a full queue does not stop the acks and the sends
+	DP_CHECK(first <= joined);
+	DP_CHECK(guaranteed == sent - first);
+	DP_CHECK(wrong == 0);
+	DP_CHECK(game.SessionLost == 0);
+	DP_CHECK(host.PlayersDestroyed == 0);
+
+	game.Close();
+	host.Close();
+}
+
+int main()
+{
+	RunChatty();
+	RunLegacyFlags();
+	RunStall();
+	RunFull();
+	return DPTest::Result();
+}
@@ -0,0 +1,126 @@
+/*!
+	@author Arves100
+	@file ResumeTest.cpp
+	@date 19/10/2026
+	@brief A player survives outages of its link of 2 to 8 seconds
+*/
+#include "DPTest.h"
+
+#define RESUME_TEST_PORT 24950
+#define RESUME_TEST_INTERVAL 50 // ms between the guaranteed messages of each side
+#define RESUME_TEST_BEFORE 1000 // ms of traffic before the outage
+#define RESUME_TEST_AFTER 2000 // ms of traffic after it
+#define RESUME_TEST_DRAIN 15000 // ms the replayed messages have to arrive
+
+/*!
+* @brief Receiver side of a stream of guaranteed messages, they must arrive once and in order
+*/
+struct ResumeStream
+{
+	std::atomic<DWORD> next{ 0 };
+	std::atomic<DWORD> wrong{ 0 };
+	std::atomic<double> lastAt{ 0 };
+
+	void Receive(const BYTE* data, DWORD size)
+	{
+		auto p = (const DPTest::Payload*)data;
+
+		if (size < sizeof(*p) || p->seq != next)
+			wrong++;
+		else
+			next++;
+
+		lastAt = DPTest::Now();
+	}
+};
+
+static void RunOutage(DWORD outage)
+{
+	DPTestGame host("host"), game("game");
+	DPTestLink link;
+	ResumeStream toHost, toGame;
+	std::atomic<DPID> gameId(0);
+	std::atomic<bool> sending(true);
+	std::atomic<DWORD> sentToHost(0), sentToGame(0);
+
+	if (!DP_CHECK(host.Host(4)) || !DP_CHECK(link.Start(RESUME_TEST_PORT, FURFIGHTERS_PORT)))
+		return;
+
+	double nextHost = 0, nextGame = 0;
+
+	host.Start([&](DPTestGame& g) {
+		if (sending && gameId && DPTest::Now() >= nextHost)
+		{
+			if (g.SendSeq(gameId, DPSEND_GUARANTEED, 1, 64) == DP_OK)
+				sentToGame++;
+
+			nextHost = DPTest::Now() + RESUME_TEST_INTERVAL;
+		}
+	}, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) { toHost.Receive(data, size); });
+
+	char addr[32];
+	snprintf(addr, sizeof(addr), "127.0.0.1:%u", RESUME_TEST_PORT);
+
+	if (!DP_CHECK(game.Join(addr)))
+		return;
+
+	gameId = game.GetId();
+
+	game.Start([&](DPTestGame& g) {
+		if (sending && DPTest::Now() >= nextGame)
+		{
+			if (g.SendSeq(host.GetId(), DPSEND_GUARANTEED, 1, 64) == DP_OK)
+				sentToHost++;
+
+			nextGame = DPTest::Now() + RESUME_TEST_INTERVAL;
+		}
+	}, [&](DPTestGame&, DPID, const BYTE* data, DWORD size) { toGame.Receive(data, size); });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(RESUME_TEST_BEFORE));
+
+	link.SetDown(true);
+	std::this_thread::sleep_for(std::chrono::milliseconds(outage));
+	link.SetDown(false);
+
+	auto up = DPTest::Now();
+	double resumed = 0;
+
+	while (DPTest::Now() - up < RESUME_TEST_AFTER + RESUME_TEST_DRAIN)
+	{
+		if (!resumed && toGame.lastAt > up && toHost.lastAt > up)
+			resumed = DPTest::Now() - up;
+
+		if (DPTest::Now() - up >= RESUME_TEST_AFTER)
+		{
+			sending = false;
+
+			if (toHost.next == sentToHost && toGame.next == sentToGame)
+				break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	printf("outage %5u ms: resumed %5.0f ms after the link came back, to host %u/%u, to game %u/%u, out of order %u, lost sessions %u, destroyed players %u\n",
+		outage, resumed, toHost.next.load(), sentToHost.load(), toGame.next.load(), sentToGame.load(), toHost.wrong + toGame.wrong,
+		game.SessionLost.load(), host.PlayersDestroyed.load());
+
+	DP_CHECK(resumed > 0);
+	DP_CHECK(game.SessionLost == 0);
+	DP_CHECK(host.PlayersDestroyed == 0);
+	DP_CHECK(toHost.wrong == 0 && toGame.wrong == 0);
+	DP_CHECK(toHost.next == sentToHost);
+	DP_CHECK(toGame.next == sentToGame);
+
+	game.Close();
+	host.Close();
+	link.Stop();
+}
+
+int main()
+{
+	for (DWORD outage : { 2000, 4000, 8000 })
+		RunOutage(outage);
+
+	return DPTest::Result();
+}
@@ -0,0 +1,105 @@
+/*!
+	@author Arves100
+	@file SelfBench.cpp
+	@date 19/10/2026
+	@brief Throughput of the messages a player sends to another player of the same instance
+*/
+#include "DPTest.h"
+#include <new>
+
+#define SELF_BENCH_MSGS 512000 // sent and read back for every size, batches of SELF_BENCH_BATCH
+#define SELF_BENCH_BATCH 64 // sent before the game reads them, the queue holds many
+
+static std::atomic<ULONGLONG> g_allocations(0);
+
+/*!
+* @brief Every allocation of the process is counted, the bench reads how many a message costs
+*/
+void* operator new(size_t size)
+{
+	g_allocations++;
+
+	if (auto p = malloc(size ? size : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+/*!
+* @return Messages per second
+*/
+static double Run(FakeDP& dp, DPID from, DPID to, DWORD size)
+{
+	std::vector<BYTE> data(size, 0xAB), buf(64 * 1024);
+	DWORD received = 0, wrong = 0;
+
+	auto allocations = g_allocations.load();
+	auto start = DPTest::Now();
+
+	for (DWORD sent = 0; sent < SELF_BENCH_MSGS; sent += SELF_BENCH_BATCH)
+	{
+		for (DWORD i = 0; i < SELF_BENCH_BATCH; i++)
+			dp.Send(from, to, DPSEND_GUARANTEED, data.data(), size);
+
+		for (;;)
+		{
+			DPID f = 0, t = 0;
+			auto len = (DWORD)buf.size();
+
+			if (dp.Receive(&f, &t, DPRECEIVE_ALL, buf.data(), &len) != DP_OK)
+				break;
+
+			if (f == DPID_SYSMSG)
+				continue;
+
+			received++;
+			wrong += f != from || t != to || len != size;
+		}
+	}
+
+	auto elapsed = DPTest::Now() - start;
+	allocations = g_allocations - allocations;
+	auto rate = received * 1000.0 / elapsed;
+
+	printf("%5u bytes: %8.0f msgs/s, %.2f us per message, %.2f allocations per message\n", size, rate, elapsed * 1000 / received, (double)allocations / received);
+
+	DP_CHECK(received == SELF_BENCH_MSGS);
+	DP_CHECK(wrong == 0);
+	DP_CHECK(allocations < received * 5 / 2); // no buffer, the pool gives them back
+	return rate;
+}
+
+int main()
+{
+	DPTestGame host("host");
+
+	if (!DP_CHECK(host.Host(4)))
+		return DPTest::Result();
+
+	DPID second = 0;
+	DPNAME nm;
+	memset(&nm, 0, sizeof(nm));
+	nm.dwSize = sizeof(nm);
+	nm.lpszShortNameA = nm.lpszLongNameA = (char*)"second";
+
+	if (!DP_CHECK(host.GetDP().CreatePlayer(&second, &nm, nullptr, nullptr, 0, 0) == DP_OK))
+		return DPTest::Result();
+
+	// Send and Receive of the game, every Receive services the socket of the host too; the buffers come from the pool of the instance,
+	// the DPMsg of the queue and the node of its list are the allocations left
+	for (DWORD size : { 16, 64, 256, 1024 })
+		Run(host.GetDP(), host.GetId(), second, size);
+
+	host.Close();
+	return DPTest::Result();
+}
@@ -0,0 +1,231 @@
+/*!
+	@author Arves100
+	@file SharedTest.cpp
+	@date 19/10/2026
+	@brief The shared-memory rings of two games on one machine: latency, and a burst larger than a ring
+*/
+#include "DPTest.h"
+#include "DPFlushPolicy.h"
+#include "DPSharedMemory.h"
+#include <sys/socket.h>
+
+#define SHARED_TEST_SWITCH 300 // ms for the peers to offer, accept and switch to the rings
+#define SHARED_TEST_PINGS 2000 // round trips measured
+#define SHARED_TEST_BURST 500 // reliable messages sent while the reader does not read
+#define SHARED_TEST_BURST_SIZE 8192 // bytes of one, the burst is four rings
+#define SHARED_TEST_SEND_LIMIT 5 // ms a send of the burst may take, the game thread must not block
+#define SHARED_TEST_DRAIN 5000 // ms for the reader to get the whole burst
+#define SHARED_TEST_LEAVE 500 // ms for the host to see a game that closed
+
+static std::atomic<ULONGLONG> g_hostSent(0);
+
+extern "C" ssize_t __real_sendmsg(int fd, const struct msghdr* msg, int flags);
+
+/*!
+* @brief The test links with --wrap=sendmsg to count what the host still sends on its socket
+*/
+extern "C" ssize_t __wrap_sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+	auto sent = __real_sendmsg(fd, msg, flags);
+	sockaddr_in local = {};
+	socklen_t len = sizeof(local);
+
+	if (sent > 0 && getsockname(fd, (sockaddr*)&local, &len) == 0 && ntohs(local.sin_port) == FURFIGHTERS_PORT)
+		g_hostSent += sent;
+
+	return sent;
+}
+
+/*!
+* @brief Joins a game to a host, both loops run
+*/
+static bool Connect(DPTestGame& host, DPTestGame& game, bool shared, DPTestGame::GameFn onGame = nullptr)
+{
+	Globals::Get()->NetSharedMemory = shared;
+	Globals::Get()->NetFlushPolicy = DP_FLUSH_IMMEDIATE; // a message leaves with its send, not at the end of a frame
+
+	if (!DP_CHECK(host.Host(2)))
+		return false;
+
+	host.Start();
+
+	if (!DP_CHECK(game.Join("127.0.0.1")))
+		return false;
+
+	game.Start(nullptr, onGame);
+	std::this_thread::sleep_for(std::chrono::milliseconds(SHARED_TEST_SWITCH));
+	return true;
+}
+
+/*!
+* @brief Takes the next game message, spins on Receive like a game that polls every frame
+*/
+static bool ReceiveGame(DPTestGame& g, std::vector<BYTE>& buf, DPID* from, DWORD* size, const std::atomic<bool>& run)
+{
+	while (run)
+	{
+		DPID to = 0;
+		*size = (DWORD)buf.size();
+
+		if (g.GetDP().Receive(from, &to, DPRECEIVE_ALL, buf.data(), size) == DP_OK && *from != DPID_SYSMSG)
+			return true;
+
+		std::this_thread::yield(); // one core can run both ends
+	}
+
+	return false;
+}
+
+/*!
+* @brief Round trips of a small reliable message, the game loops stopped so the two threads spin
+* @return One way latency in microseconds
+*/
+static double Latency(bool shared)
+{
+	DPTestGame host("host"), game("game");
+
+	if (!Connect(host, game, shared))
+		return 0;
+
+	host.Stop();
+	game.Stop();
+
+	std::atomic<bool> run(true);
+	std::thread echo([&]() {
+		std::vector<BYTE> buf(64 * 1024);
+		DPID from;
+		DWORD size;
+
+		while (ReceiveGame(host, buf, &from, &size, run))
+			host.GetDP().Send(host.GetId(), from, DPSEND_GUARANTEED, buf.data(), size);
+	});
+
+	std::vector<BYTE> buf(64 * 1024);
+	DPTest::Payload p = { 1, 0, 0 };
+	double total = 0;
+	DWORD done = 0;
+
+	for (; done < SHARED_TEST_PINGS; done++)
+	{
+		p.seq = done;
+		p.sentAt = DPTest::Now();
+
+		if (game.GetDP().Send(game.GetId(), host.GetId(), DPSEND_GUARANTEED, &p, sizeof(p)) != DP_OK)
+			break;
+
+		DPID from;
+		DWORD size;
+
+		if (!ReceiveGame(game, buf, &from, &size, run))
+			break;
+
+		total += DPTest::Now() - ((const DPTest::Payload*)buf.data())->sentAt;
+	}
+
+	run = false;
+	echo.join();
+
+	auto us = done ? total * 1000 / 2 / done : 0;
+	printf("shared memory %-3s: %u round trips, %6.1f us one way\n", shared ? "on" : "off", done, us);
+	DP_CHECK(done == SHARED_TEST_PINGS);
+
+	game.Close();
+	host.Close();
+	return us;
+}
+
+/*!
+* @brief The host sends four rings of reliable messages to a game that does not read, none of them is dropped
+*/
+static void Burst()
+{
+	DPTestGame host("host"), game("game");
+	std::atomic<DWORD> next(0), outOfOrder(0);
+
+	DPTestGame::GameFn onGame = [&](DPTestGame&, DPID, const BYTE* data, DWORD) {
+		auto p = (const DPTest::Payload*)data;
+
+		if (p->seq != next)
+			outOfOrder++;
+
+		next = p->seq + 1;
+	};
+
+	if (!Connect(host, game, true, onGame))
+		return;
+
+	// the rings hold a megabyte, the rest of the burst waits in the queue of the host until the game reads again
+	game.Stop();
+	host.Stop();
+
+	auto bytes = g_hostSent.load();
+	auto start = DPTest::Now();
+	double slowest = 0;
+
+	for (DWORD i = 0; i < SHARED_TEST_BURST; i++)
+	{
+		auto t = DPTest::Now();
+		DP_CHECK(host.SendSeq(game.GetId(), DPSEND_GUARANTEED, 1, SHARED_TEST_BURST_SIZE) == DP_OK);
+		slowest = std::max(slowest, DPTest::Now() - t);
+	}
+
+	auto sending = DPTest::Now() - start;
+	game.Start(nullptr, onGame);
+	host.Start();
+
+	auto until = DPTest::Now() + SHARED_TEST_DRAIN;
+
+	while (game.GameReceived < SHARED_TEST_BURST && DPTest::Now() < until)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	bytes = g_hostSent - bytes;
+
+	printf("burst of %u x %u bytes: sent in %.1f ms (slowest send %.2f ms), %u received, %u out of order, %llu bytes on the socket of the host\n",
+		SHARED_TEST_BURST, SHARED_TEST_BURST_SIZE, sending, slowest, game.GameReceived.load(), outOfOrder.load(), (unsigned long long)bytes);
+
+	DP_CHECK(slowest < SHARED_TEST_SEND_LIMIT);
+	DP_CHECK(game.GameReceived == SHARED_TEST_BURST);
+	DP_CHECK(outOfOrder == 0);
+	DP_CHECK(bytes < SHARED_TEST_BURST * SHARED_TEST_BURST_SIZE / 10); // the burst went through the rings
+
+	game.Close();
+	host.Close();
+}
+
+/*!
+* @brief A game that leaves while its messages go through the rings, Close waits for the handshake on the socket
+*/
+static void Leave()
+{
+	DPTestGame host("host"), game("game");
+
+	if (!Connect(host, game, true))
+		return;
+
+	auto start = DPTest::Now();
+	game.Close();
+	auto closing = DPTest::Now() - start;
+
+	// a disconnect the host missed would only be seen by its timeout, seconds later
+	auto until = DPTest::Now() + SHARED_TEST_LEAVE;
+
+	while (host.PlayersDestroyed == 0 && DPTest::Now() < until)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	printf("leave: closed in %.1f ms, players destroyed on the host %u after %.0f ms\n", closing, host.PlayersDestroyed.load(), DPTest::Now() - start);
+
+	DP_CHECK(host.PlayersDestroyed == 1);
+
+	host.Close();
+}
+
+int main()
+{
+	auto socket = Latency(false);
+	auto shared = Latency(true);
+	Burst();
+	Leave();
+
+	DP_CHECK(shared > 0 && shared < socket);
+	return DPTest::Result();
+}
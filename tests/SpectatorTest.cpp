@@ -0,0 +1,122 @@
+/*!
+	@author Arves100
+	@file SpectatorTest.cpp
+	@date 19/10/2026
+	@brief The upload of a host stays flat while spectators join, they get the broadcasts through the relay tree
+*/
+#include "DPTest.h"
+#include <memory>
+#include <sys/socket.h>
+
+#define SPECTATOR_TEST_FRAME 16 // ms between two frames of the host
+#define SPECTATOR_TEST_MSGS 4 // broadcasts sent every frame
+#define SPECTATOR_TEST_SIZE 200 // bytes of a broadcast
+#define SPECTATOR_TEST_SETTLE 1000 // ms for the tree to attach the last spectators
+#define SPECTATOR_TEST_TIME 3000 // ms measured
+
+static std::atomic<ULONGLONG> g_hostSent(0);
+
+extern "C" ssize_t __real_sendmsg(int fd, const struct msghdr* msg, int flags);
+
+/*!
+* @brief enet sends every datagram with sendmsg, the test links with --wrap=sendmsg to count the ones of the host socket
+*/
+extern "C" ssize_t __wrap_sendmsg(int fd, const struct msghdr* msg, int flags)
+{
+	auto sent = __real_sendmsg(fd, msg, flags);
+	sockaddr_in local = {};
+	socklen_t len = sizeof(local);
+
+	if (sent > 0 && getsockname(fd, (sockaddr*)&local, &len) == 0 && ntohs(local.sin_port) == FURFIGHTERS_PORT)
+		g_hostSent += sent;
+
+	return sent;
+}
+
+struct SpectatorResult
+{
+	double upload; // kbit/s of the host
+	DWORD fewest; // broadcasts received by the spectator that got the fewest
+	DWORD sent;
+};
+
+static SpectatorResult Run(DWORD spectators)
+{
+	DPTestGame host("host");
+	std::vector<std::unique_ptr<DPTestGame>> specs;
+	DWORD sent = 0;
+	double next = 0;
+
+	if (!DP_CHECK(host.Host(spectators + 1)))
+		return {};
+
+	host.Start([&](DPTestGame& g) {
+		if (DPTest::Now() < next)
+			return;
+
+		next = DPTest::Now() + SPECTATOR_TEST_FRAME;
+
+		for (int i = 0; i < SPECTATOR_TEST_MSGS; i++)
+			g.SendSeq(DPID_ALLPLAYERS, 0, 1, SPECTATOR_TEST_SIZE);
+
+		sent += SPECTATOR_TEST_MSGS;
+	});
+
+	for (DWORD i = 0; i < spectators; i++)
+	{
+		specs.emplace_back(new DPTestGame("spectator"));
+
+		if (!DP_CHECK(specs.back()->Join("127.0.0.1", DPPLAYER_SPECTATOR)))
+			return {};
+
+		specs.back()->Start();
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(SPECTATOR_TEST_SETTLE));
+
+	std::vector<DWORD> before;
+
+	for (auto& s : specs)
+		before.push_back(s->GameReceived);
+
+	DWORD first = sent;
+	ULONGLONG bytes = g_hostSent;
+	std::this_thread::sleep_for(std::chrono::milliseconds(SPECTATOR_TEST_TIME));
+	bytes = g_hostSent - bytes;
+	host.Stop();
+	DWORD count = sent - first;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200)); // the last ones go down the tree
+	DWORD fewest = count, lost = 0;
+
+	for (size_t i = 0; i < specs.size(); i++)
+	{
+		fewest = std::min(fewest, specs[i]->GameReceived - before[i]);
+		lost += specs[i]->SessionLost;
+	}
+
+	SpectatorResult r = { bytes * 8.0 / SPECTATOR_TEST_TIME, fewest, count };
+	printf("%2u spectators: host upload %5.0f kbit/s, broadcasts %u, the spectator with the fewest got %u, lost sessions %u\n",
+		spectators, r.upload, count, fewest, lost);
+
+	DP_CHECK(lost == 0);
+
+	for (auto& s : specs)
+		s->Close();
+
+	host.Close();
+	return r;
+}
+
+int main()
+{
+	auto one = Run(1);
+	auto few = Run(4);
+	auto many = Run(32);
+
+	// the host feeds two spectators, the others get the stream from them
+	DP_CHECK(many.upload < few.upload * 1.5);
+	DP_CHECK(few.upload < one.upload * 2.5);
+	DP_CHECK(many.fewest >= many.sent * 9 / 10);
+	return DPTest::Result();
+}
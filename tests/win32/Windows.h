@@ -0,0 +1,163 @@
+/*!
+	@author Arves100
+	@file Windows.h
+	@date 19/10/2026
+	@brief Linux stand-in of the Windows API used by the network code, for the tests
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <ctime>
+#include <random>
+#include <unistd.h>
+
+typedef uint8_t BYTE, *LPBYTE;
+typedef uint16_t WORD, USHORT;
+typedef uint32_t DWORD, *LPDWORD;
+typedef int32_t LONG;
+typedef int64_t LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef int BOOL;
+typedef unsigned UINT;
+typedef int32_t HRESULT;
+typedef long RPC_STATUS;
+typedef void *LPVOID, *HANDLE, *HWND, *HINSTANCE;
+typedef const void* LPCVOID;
+typedef char CHAR, *LPSTR;
+typedef wchar_t WCHAR, TCHAR;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM, LRESULT;
+typedef BOOL (*DLGPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef LRESULT (*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+
+typedef struct { LONG left, top, right, bottom; } RECT;
+typedef struct { LONGLONG QuadPart; } LARGE_INTEGER;
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+
+typedef GUID UUID;
+typedef const GUID* LPCGUID;
+typedef const GUID& REFGUID;
+
+#define DEFINE_GUID(n, ...) static const GUID n = { __VA_ARGS__ }
+#define __declspec(x)
+#define WINAPI
+#define CALLBACK
+#define _In_
+#define __FILEW__ L""
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define INFINITE 0xFFFFFFFF
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define FAILED(x) ((HRESULT)(x) < 0)
+#define SUCCEEDED(x) ((HRESULT)(x) >= 0)
+#define MB_OK 0
+#define MB_ICONERROR 0x10
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define MAXIMUM_WAIT_OBJECTS 64
+#define ERROR_ALREADY_EXISTS 183
+#define FILE_MAP_ALL_ACCESS 0xF001F
+#define PAGE_READWRITE 4
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 1
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+
+// Secure CRT
+
+inline int memcpy_s(void* dest, size_t size, const void* src, size_t count) { memcpy(dest, src, count < size ? count : size); return 0; }
+inline int memmove_s(void* dest, size_t size, const void* src, size_t count) { memmove(dest, src, count < size ? count : size); return 0; }
+inline int strcpy_s(char* dest, size_t size, const char* src) { snprintf(dest, size, "%s", src); return 0; }
+inline int strncpy_s(char* dest, size_t size, const char* src, size_t count) { size_t n = strnlen(src, count < size - 1 ? count : size - 1); memcpy(dest, src, n); dest[n] = 0; return 0; }
+#define sprintf_s(b, n, ...) snprintf(b, n, __VA_ARGS__)
+#define _snprintf_s(b, n, c, ...) snprintf(b, n, __VA_ARGS__)
+
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask)
+{
+	if (!mask)
+		return 0;
+
+	*index = (unsigned long)__builtin_ctzl(mask);
+	return 1;
+}
+
+// Time
+
+inline ULONGLONG GetTickCount64()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000ULL + t.tv_nsec / 1000000;
+}
+
+inline DWORD GetTickCount() { return (DWORD)GetTickCount64(); }
+inline void Sleep(DWORD ms) { usleep(ms * 1000); }
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	counter->QuadPart = t.tv_sec * 1000000000LL + t.tv_nsec;
+	return TRUE;
+}
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* freq) { freq->QuadPart = 1000000000LL; return TRUE; }
+
+// Objects, the tests do not use the events of the players nor files
+
+inline HANDLE CreateEventA(void*, BOOL, BOOL, const char*) { return nullptr; }
+inline HANDLE CreateEventW(void*, BOOL, BOOL, const wchar_t*) { return nullptr; }
+inline BOOL SetEvent(HANDLE) { return TRUE; }
+inline BOOL ResetEvent(HANDLE) { return TRUE; }
+inline DWORD WaitForSingleObject(HANDLE, DWORD) { return WAIT_OBJECT_0; }
+inline BOOL CloseHandle(HANDLE) { return TRUE; }
+inline DWORD GetLastError() { return 0; }
+inline DWORD GetCurrentProcessId() { return (DWORD)getpid(); }
+inline HANDLE CreateFileW(const wchar_t*, DWORD, DWORD, void*, DWORD, DWORD, HANDLE) { return INVALID_HANDLE_VALUE; }
+inline BOOL ReadFile(HANDLE, void*, DWORD, DWORD*, void*) { return FALSE; }
+inline BOOL WriteFile(HANDLE, const void*, DWORD, DWORD*, void*) { return FALSE; }
+inline HANDLE CreateFileMappingA(HANDLE, void*, DWORD, DWORD, DWORD, const char*) { return nullptr; }
+inline HANDLE OpenFileMappingA(DWORD, BOOL, const char*) { return nullptr; }
+inline LPVOID MapViewOfFile(HANDLE, DWORD, DWORD, DWORD, size_t) { return nullptr; }
+inline BOOL UnmapViewOfFile(LPCVOID) { return TRUE; }
+inline int MessageBoxW(HWND, const wchar_t* text, const wchar_t*, UINT) { fprintf(stderr, "%ls\n", text); return 0; }
+
+// COM
+
+inline HRESULT CoCreateGuid(GUID* guid)
+{
+	static thread_local std::mt19937_64 rng(std::random_device{}());
+
+	for (size_t i = 0; i < sizeof(GUID); i++)
+		((uint8_t*)guid)[i] = (uint8_t)rng();
+
+	return 0;
+}
+
+inline bool IsEqualGUID(const GUID& a, const GUID& b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool InlineIsEqualGUID(const GUID& a, const GUID& b) { return IsEqualGUID(a, b); }
+
+inline unsigned short UuidHash(UUID* uuid, RPC_STATUS* status)
+{
+	unsigned short h = 0;
+
+	for (size_t i = 0; i < sizeof(UUID); i++)
+		h = (unsigned short)(h * 31 + ((uint8_t*)uuid)[i]);
+
+	*status = 0;
+	return h;
+}
@@ -0,0 +1,3 @@
+#pragma once
+// Linux stand-in for the tests, the network code does not use DirectDraw
+typedef void* LPDDSURFACEDESC2;
@@ -0,0 +1,3 @@
+#pragma once
+// Linux stand-in for the tests, the network code does not use DirectInput
+typedef void* LPDIRECTINPUTDEVICE7A;
@@ -0,0 +1,195 @@
+/*!
+	@author Arves100
+	@file dplay.h
+	@date 19/10/2026
+	@brief Linux stand-in of the DirectPlay 4 declarations used by the network code, for the tests
+*/
+#pragma once
+
+typedef DWORD DPID, *LPDPID;
+
+#define DPID_SYSMSG 0
+#define DPID_ALLPLAYERS 0
+#define DPID_SERVERPLAYER 1
+
+#define MAKE_DPHRESULT(code) ((HRESULT)(0x88770000u | (code)))
+#define DP_OK 0
+#define DPERR_ALREADYINITIALIZED MAKE_DPHRESULT(5)
+#define DPERR_ACCESSDENIED MAKE_DPHRESULT(10)
+#define DPERR_BUFFERTOOSMALL MAKE_DPHRESULT(30)
+#define DPERR_CANTCREATEPLAYER MAKE_DPHRESULT(60)
+#define DPERR_INVALIDOBJECT MAKE_DPHRESULT(130)
+#define DPERR_INVALIDPLAYER MAKE_DPHRESULT(150)
+#define DPERR_NOCONNECTION MAKE_DPHRESULT(170)
+#define DPERR_NOMESSAGES MAKE_DPHRESULT(190)
+#define DPERR_SENDTOOBIG MAKE_DPHRESULT(230)
+#define DPERR_TIMEOUT MAKE_DPHRESULT(240)
+#define DPERR_UNAVAILABLE MAKE_DPHRESULT(250)
+#define DPERR_BUSY MAKE_DPHRESULT(270)
+#define DPERR_CONNECTING MAKE_DPHRESULT(330)
+#define DPERR_CONNECTIONLOST MAKE_DPHRESULT(340)
+#define DPERR_UNINITIALIZED MAKE_DPHRESULT(350)
+#define DPERR_CANNOTCREATESERVER MAKE_DPHRESULT(390)
+#define DPERR_ABORTED MAKE_DPHRESULT(450)
+#define DPERR_CANCELLED MAKE_DPHRESULT(460)
+#define DPERR_GENERIC ((HRESULT)0x80004005)
+#define DPERR_PENDING ((HRESULT)0x8000000A)
+#define DPERR_INVALIDPARAMS ((HRESULT)0x80070057)
+#define DPERR_OUTOFMEMORY ((HRESULT)0x8007000E)
+
+#define DPCAPS_ISHOST 0x2
+#define DPCAPS_ASYNCSUPPORTED 0x10
+#define DPCAPS_SENDPRIORITYSUPPORTED 0x20
+#define DPCAPS_SENDTIMEOUTSUPPORTED 0x40
+#define DPCAPS_ASYNCCANCELSUPPORTED 0x80
+
+#define DPENUMSESSIONS_ASYNC 0x10
+#define DPENUMSESSIONS_STOPASYNC 0x20
+
+#define DPSEND_GUARANTEED 0x1
+#define DPSEND_ASYNC 0x200
+#define DPSEND_NOSENDCOMPLETEMSG 0x400
+#define DPSEND_MAX_PRIORITY 0xFFFF
+
+#define DPMESSAGEQUEUE_SEND 0x1
+#define DPMESSAGEQUEUE_RECEIVE 0x2
+
+#define DPRECEIVE_ALL 0x1
+#define DPRECEIVE_TOPLAYER 0x2
+#define DPRECEIVE_FROMPLAYER 0x4
+#define DPRECEIVE_PEEK 0x8
+
+#define DPPLAYER_SPECTATOR 0x1
+#define DPPLAYER_SERVERPLAYER 0x100
+#define DPPLAYERTYPE_PLAYER 0x1
+
+#define DPSET_LOCAL 0x1
+#define DPSET_GUARANTEED 0x2
+#define DPGET_LOCAL 0x1
+
+#define DPOPEN_JOIN 0x1
+#define DPOPEN_CREATE 0x2
+
+#define DPSYS_CREATEPLAYERORGROUP 0x0003
+#define DPSYS_DESTROYPLAYERORGROUP 0x0005
+#define DPSYS_SESSIONLOST 0x0031
+#define DPSYS_HOST 0x0101
+#define DPSYS_SETPLAYERORGROUPDATA 0x0102
+#define DPSYS_CHAT 0x0109
+#define DPSYS_SENDCOMPLETE 0x010d
+
+typedef struct
+{
+	DWORD dwSize;
+	DWORD dwFlags;
+	char* lpszShortNameA;
+	char* lpszLongNameA;
+} DPNAME, *LPDPNAME;
+
+typedef struct
+{
+	DWORD dwSize;
+	DWORD dwFlags;
+	GUID guidInstance;
+	GUID guidApplication;
+	DWORD dwMaxPlayers;
+	DWORD dwCurrentPlayers;
+	char* lpszSessionNameA;
+	char* lpszPasswordA;
+	DWORD dwReserved1;
+	DWORD dwReserved2;
+	DWORD dwUser1;
+	DWORD dwUser2;
+	DWORD dwUser3;
+	DWORD dwUser4;
+} DPSESSIONDESC2, *LPDPSESSIONDESC2;
+
+typedef struct
+{
+	DWORD dwSize;
+	DWORD dwFlags;
+	DWORD dwMaxBufferSize;
+	DWORD dwMaxQueueSize;
+	DWORD dwMaxPlayers;
+	DWORD dwHundredBaud;
+	DWORD dwLatency;
+	DWORD dwMaxLocalPlayers;
+	DWORD dwHeaderLength;
+	DWORD dwTimeout;
+} DPCAPS, *LPDPCAPS;
+
+typedef struct
+{
+	DWORD dwSize;
+	DWORD dwFlags;
+	char* lpszMessageA;
+} DPCHAT, *LPDPCHAT;
+
+typedef struct
+{
+	GUID guidDataType;
+	DWORD dwDataSize;
+} DPADDRESS, *LPDPADDRESS;
+
+typedef struct { DWORD dwType; } DPMSG_GENERIC, DPMSG_SESSIONLOST, DPMSG_HOST;
+
+typedef struct
+{
+	DWORD dwType;
+	DWORD dwPlayerType;
+	DPID dpId;
+	DWORD dwCurrentPlayers;
+	LPVOID lpData;
+	DWORD dwDataSize;
+	DPNAME dpnName;
+	DPID dpIdParent;
+	DWORD dwFlags;
+} DPMSG_CREATEPLAYERORGROUP;
+
+typedef struct
+{
+	DWORD dwType;
+	DWORD dwPlayerType;
+	DPID dpId;
+	LPVOID lpLocalData;
+	DWORD dwLocalDataSize;
+	LPVOID lpRemoteData;
+	DWORD dwRemoteDataSize;
+	DPNAME dpnName;
+	DPID dpIdParent;
+	DWORD dwFlags;
+} DPMSG_DESTROYPLAYERORGROUP, *LPDPMSG_DESTROYPLAYERORGROUP;
+
+typedef struct
+{
+	DWORD dwType;
+	DWORD dwFlags;
+	DPID idFromPlayer;
+	DPID idToPlayer;
+	DPID idToGroup;
+	LPDPCHAT lpChat;
+} DPMSG_CHAT;
+
+typedef struct
+{
+	DWORD dwType;
+	DPID idFrom;
+	DPID idTo;
+	DWORD dwFlags;
+	DWORD dwPriority;
+	DWORD dwTimeout;
+	LPVOID lpvContext;
+	DWORD dwMsgID;
+	HRESULT hr;
+	DWORD dwSendTime;
+} DPMSG_SENDCOMPLETE;
+
+typedef BOOL (*LPDPENUMSESSIONSCALLBACK2)(LPDPSESSIONDESC2, LPDWORD, DWORD, LPVOID);
+typedef BOOL (*LPDPENUMCONNECTIONSCALLBACK)(LPCGUID, LPVOID, DWORD, LPDPNAME, DWORD, LPVOID);
+
+// {1318F560-912C-11d0-9DAA-00A0C90A43CB}
+DEFINE_GUID(DPAID_TotalSize, 0x1318f560, 0x912c, 0x11d0, 0x9d, 0xaa, 0x0, 0xa0, 0xc9, 0xa, 0x43, 0xcb);
+// {C4A54DA0-E0AF-11cf-9C4E-00A0C905425E}
+DEFINE_GUID(DPAID_INet, 0xc4a54da0, 0xe0af, 0x11cf, 0x9c, 0x4e, 0x0, 0xa0, 0xc9, 0x5, 0x42, 0x5e);
+// {E4524541-8EA5-11d1-8A96-006097B01411}
+DEFINE_GUID(DPAID_INetPort, 0xe4524541, 0x8ea5, 0x11d1, 0x8a, 0x96, 0x0, 0x60, 0x97, 0xb0, 0x14, 0x11);
@@ -0,0 +1,2 @@
+#pragma once
+// Linux stand-in for the tests, the network code does not use the lobby
@@ -0,0 +1,3 @@
+#pragma once
+// the network sources include it in lower case
+#include "../../StdAfx.h"